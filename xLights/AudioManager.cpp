@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -1363,58 +1364,97 @@ AudioManager::AudioManager(const std::string& audio_file, int step, int block)
     AddAudioDeviceChangeListener(this);
 }
 
-std::list<float> AudioManager::CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const
+// FFT config, output buffer and note buckets for one FFT size. kiss_fftr uses the config as scratch space
+// so a plan can only be used by one thread at a time.
+struct AudioManager::SpectrumPlan
 {
-	std::list<float> res;
-	int outcount = n / 2 + 1;
-	kiss_fftr_cfg cfg;
-	kiss_fft_cpx* out = (kiss_fft_cpx*)malloc(sizeof(kiss_fft_cpx) * (outcount));
-	if (out != nullptr)
-	{
-		if ((cfg = kiss_fftr_alloc(n, 0/*is_inverse_fft*/, nullptr, nullptr)) != nullptr)
-		{
-			kiss_fftr(cfg, in, out);
-			free(cfg);
-		}
+    kiss_fftr_cfg cfg = nullptr;
+    long rate = 0;
+    std::vector<kiss_fft_cpx> out;
+    int start[SPECTRUM_NOTES];
+    int end[SPECTRUM_NOTES];
 
-		for (int j = 0; j < 127; j++)
-		{
+    SpectrumPlan(int n, long r) : rate(r), out(n / 2 + 1)
+    {
+        cfg = kiss_fftr_alloc(n, 0/*is_inverse_fft*/, nullptr, nullptr);
+
+        for (int j = 0; j < SPECTRUM_NOTES; j++)
+        {
             // choose the right bucket for this MIDI note
             double freq = 440.0 * exp2f(((double)j - 69.0) / 12.0);
-            int start = freq * (double)n / (double)_rate;
+            start[j] = freq * (double)n / (double)rate;
             double freqnext = 440.0 * exp2f(((double)j + 1.0 - 69.0) / 12.0);
-            int end = freqnext * (double)n / (double)_rate;
+            end[j] = freqnext * (double)n / (double)rate;
+        }
+    }
+    ~SpectrumPlan()
+    {
+        if (cfg != nullptr)
+        {
+            free(cfg);
+        }
+    }
+    SpectrumPlan(const SpectrumPlan&) = delete;
+    SpectrumPlan& operator=(const SpectrumPlan&) = delete;
+};
 
-            float val = 0.0;
+// Plans are cached per thread and per size so they are built once rather than for every frame
+AudioManager::SpectrumPlan& AudioManager::GetSpectrumPlan(int n) const
+{
+    static thread_local std::map<int, std::unique_ptr<SpectrumPlan>> plans;
 
-            // got through all buckets up to the next note and take the maximums
-            if (end < outcount-1)
+    auto& plan = plans[n];
+    if (plan == nullptr || plan->rate != _rate)
+    {
+        plan = std::make_unique<SpectrumPlan>(n, _rate);
+    }
+    return *plan;
+}
+
+// fills res with SPECTRUM_NOTES values
+bool AudioManager::CalculateSpectrumAnalysis(const float* in, int n, float& max, int id, float* res) const
+{
+    SpectrumPlan& plan = GetSpectrumPlan(n);
+    if (plan.cfg == nullptr)
+    {
+        return false;
+    }
+
+    int outcount = n / 2 + 1;
+    kiss_fft_cpx* out = plan.out.data();
+    kiss_fftr(plan.cfg, in, out);
+
+    for (int j = 0; j < SPECTRUM_NOTES; j++)
+    {
+        int start = plan.start[j];
+        int end = plan.end[j];
+
+        float val = 0.0;
+
+        // got through all buckets up to the next note and take the maximums
+        if (end < outcount - 1)
+        {
+            for (int k = start; k <= end; k++)
             {
-                for (int k = start; k <= end; k++)
-                {
-                    kiss_fft_cpx* cur = out + k;
-                    val = std::max(val, sqrtf(cur->r * cur->r + cur->i * cur->i));
-                    //float valscaled = valnew * scaling;
-                }
+                kiss_fft_cpx* cur = out + k;
+                val = std::max(val, sqrtf(cur->r * cur->r + cur->i * cur->i));
             }
+        }
 
-			float db = log10(val);
-			if (db < 0.0)
-			{
-				db = 0.0;
-			}
-
-			res.push_back(db);
-			if (db > max)
-			{
-				max = db;
-			}
-		}
+        float db = log10(val);
+        if (db < 0.0)
+        {
+            db = 0.0;
+        }
 
-		free(out);
-	}
+        res[j] = db;
+        if (db > max)
+        {
+            max = db;
+        }
+    }
 
-	return res;
+    return true;
 }
 
 void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManagerProgressCallback fn)
@@ -1511,6 +1551,7 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
         try
         {
             unsigned int total = 0;
+            std::vector<std::vector<float>> notes(frames);
             logger_pianodata.debug("About to extract Polyphonic Transcription result.");
             Vamp::Plugin::FeatureSet features = pt->getRemainingFeatures();
             logger_pianodata.debug("Polyphonic Transcription result retrieved.");
@@ -1537,23 +1578,35 @@ void AudioManager::DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManager
                     sframe++;
                 }
                 int eframe = currentend / _intervalMS;
+                eframe = std::min(eframe, (int)notes.size() - 1);
                 while (sframe <= eframe) {
-                    _frameData[sframe][4].push_back(features[0][j].values[0]);
+                    notes[sframe].push_back(features[0][j].values[0]);
                     sframe++;
                 }
             }
 
             fn(dlg, 100);
 
+            // flatten the notes into a single array
+            _frameNotes.clear();
+            _frameNotesStart.clear();
+            _frameNotesStart.reserve(notes.size() + 1);
+            for (const auto& it : notes)
+            {
+                _frameNotesStart.push_back((uint32_t)_frameNotes.size());
+                _frameNotes.insert(_frameNotes.end(), it.begin(), it.end());
+            }
+            _frameNotesStart.push_back((uint32_t)_frameNotes.size());
+
             if (logger_pianodata.isDebugEnabled())
             {
                 logger_pianodata.debug("Piano data calculated:");
                 logger_pianodata.debug("Time MS, Keys");
-                for (size_t i = 0; i < _frameData.size(); i++)
+                for (size_t i = 0; i < notes.size(); i++)
                 {
                     long ms = i * _intervalMS;
                     std::string keys = "";
-                    for (const auto& it2 : _frameData[i][4])
+                    for (const auto& it2 : notes[i])
                     {
                         keys += " " + std::string(wxString::Format("%f", it2).c_str());
                     }
@@ -1624,166 +1677,202 @@ void AudioManager::DoPrepareFrameData()
     logger_base.info("    Frames %d", frames);
     logger_base.info("    Total samples %d", totalsamples);
 
-	// these are used to normalise output
-	_bigmax = -1;
-	_bigspread = -1;
-	_bigmin = 1;
-	_bigspectogrammax = -1;
-
-	size_t step = 2048;
-	float *pdata[2];
+    _frameDataFrames = frames;
+    _frameHigh.assign(frames, 0.0f);
+    _frameLow.assign(frames, 0.0f);
+    _frameSpread.assign(frames, 0.0f);
+    _frameSpectrum.assign((size_t)frames * SPECTRUM_STRIDE, 0.0f);
+    _frameSpectrumSize.assign(frames, 0);
+    _frameLevelsReady = 0;
+    _frameSpectrumReady = 0;
+
+    // the arrays are sized so readers can now wait for the frames they need. Nothing else changes them
+    // while we fill them in and the destructor waits for us to finish
+    _frameDataPrepared = true;
+    locker.unlock();
+
+    // frames are processed in time slices spread across the cores. Both the levels and the spectrum are
+    // normalised against their maximum across the whole song so a frame can only be published once every
+    // frame has been measured. The levels are cheap so they are measured and published first and the
+    // effects can use them while the spectrum is calculated
+    const float* left = _data[0];
+    long trackSize = _trackSize;
+
+    struct Levels
+    {
+        float max;
+        float min;
+        float spread;
+    };
+    Levels levels = parallel_reduce<Levels>(0, frames, { -1, 1, -1 }, [&](int begin, int end, Levels l) {
+        for (int i = begin; i < end; i++)
+        {
+            // accumulators
+            float max = -100.0;
+            float min = 100.0;
+            float spread = -100;
 
-	int pos = 0;
-	std::list<float> spectrogram;
+            for (int j = 0; j < samplesperframe; j++)
+            {
+                long offset = (long)i * samplesperframe + j;
+                float data = offset > trackSize ? 0 : left[offset];
 
-	// process each frome of the song
-	for (int i = 0; i < frames; i++)
-	{
-		std::vector<std::list<float>> aFrameData;
-		aFrameData.resize(5); // preallocate the spots we will need
-
-		// accumulators
-		float max = -100.0;
-		float min = 100.0;
-		float spread = -100;
-
-		// clear the data if we are about to get new data ... dont clear it if we wont
-		// this happens because the spectrogram function has a fixed window based on the parameters we set and it
-		// does not match our time slices exactly so we have to select which one to use
-		if (pos < i * samplesperframe + samplesperframe  && pos + step < totalsamples)
-		{
-			spectrogram.clear();
-		}
+                // Max data
+                if (data > max)
+                {
+                    max = data;
+                }
 
-		// only get the data if we are not ahead of the music
-		while (pos < i * samplesperframe + samplesperframe && pos + step < totalsamples)
-		{
-			std::list<float> subspectrogram;
-			pdata[0] = GetLeftDataPtr(pos);
-			pdata[1] = GetRightDataPtr(pos);
-			float max2 = 0;
+                // Min data
+                if (data < min)
+                {
+                    min = data;
+                }
 
-			if (pdata[0] == nullptr)
-			{
-				subspectrogram.clear();
-			}
-			else
-			{
-				subspectrogram = CalculateSpectrumAnalysis(pdata[0], step, max2, i);
-			}
+                // Spread data
+                if (max - min > spread)
+                {
+                    spread = max - min;
+                }
+            }
 
-			// and keep track of the larges value so we can normalise it
-			if (max2 > _bigspectogrammax)
-			{
-				_bigspectogrammax = max2;
-			}
-			pos += step;
+            _frameHigh[i] = max;
+            _frameLow[i] = min;
+            _frameSpread[i] = spread;
+            l.max = std::max(l.max, max);
+            l.min = std::min(l.min, min);
+            l.spread = std::max(l.spread, spread);
+        }
+        return l;
+    }, [](const Levels& a, const Levels& b) {
+        return Levels { std::max(a.max, b.max), std::min(a.min, b.min), std::max(a.spread, b.spread) };
+    }, 64);
+
+    // normalise data ... basically scale the data so the highest value is the scale value.
+    float scale = 1.0; // 0-1 ... where 0.x means that the max value displayed would be x0% of model size
+    _bigmax = levels.max;
+    _bigmin = levels.min;
+    _bigspread = levels.spread;
+    float bigmaxscale = 1 / (_bigmax * scale);
+    float bigminscale = 1 / (_bigmin * scale);
+    float bigspreadscale = 1 / (_bigspread * scale);
+    for (int s = 0; s < frames; s += FRAME_PUBLISH_SLICE)
+    {
+        int e = std::min(s + FRAME_PUBLISH_SLICE, frames);
+        for (int i = s; i < e; i++)
+        {
+            _frameHigh[i] *= bigmaxscale;
+            _frameLow[i] *= bigminscale;
+            _frameSpread[i] *= bigspreadscale;
+        }
+        PublishFrames(_frameLevelsReady, e);
+    }
+    logger_base.info("DoPrepareFrameData: Audio frame levels complete in %ld.", sw.Time());
 
-			// either take the newly calculated values or if we are merging two results take the maximum of each value
-			if (spectrogram.size() == 0)
-			{
-				spectrogram = subspectrogram;
-			}
-			else
-			{
-				if (subspectrogram.size() > 0)
-				{
-					std::list<float>::iterator sub = subspectrogram.begin();
-					for (std::list<float>::iterator fr = spectrogram.begin(); fr != spectrogram.end(); ++fr)
-					{
-						if (*sub > *fr)
-						{
-							*fr = *sub;
-						}
-						++sub;
-					}
-				}
-			}
-		}
+    // the spectrogram function has a fixed window which does not match our time slices exactly. A frame
+    // takes the maximum of the windows that start within it and a frame with no windows repeats the
+    // previous frame. Window k starts at k * step and is only used if it ends before the last frame.
+    const int step = 2048;
+    int windows = totalsamples > step ? (totalsamples - 1) / step : 0;
+    auto firstWindow = [samplesperframe, windows](int frame) {
+        return (int)std::min(((long long)frame * samplesperframe + step - 1) / step, (long long)windows);
+    };
 
-		// now do the raw data analysis for the frame
-		for (int j = 0; j < samplesperframe; j++)
-		{
-			float data = GetLeftData(i * samplesperframe + j);
+    // adds the windows [first, last) into spectrogram ... returns true if spectrogram holds a result
+    auto addWindows = [this](int first, int last, float* spectrogram, bool haveSpectrogram, float& spectrumMax) {
+        float subspectrogram[SPECTRUM_NOTES];
+        for (int k = first; k < last; k++)
+        {
+            float* pdata = GetLeftDataPtr((long)k * step);
+            float max2 = 0;
 
-			// Max data
-			if (data > max)
-			{
-				max = data;
-			}
+            bool haveSub = pdata != nullptr && CalculateSpectrumAnalysis(pdata, step, max2, k, subspectrogram);
 
-			// Min data
-			if (data < min)
-			{
-				min = data;
-			}
+            // and keep track of the larges value so we can normalise it
+            spectrumMax = std::max(spectrumMax, max2);
 
-			// Spread data
-			if (max - min > spread)
-			{
-				spread = max - min;
-			}
-		}
+            // either take the newly calculated values or if we are merging two results take the maximum of each value
+            if (!haveSpectrogram)
+            {
+                if (haveSub)
+                {
+                    std::copy(subspectrogram, subspectrogram + SPECTRUM_NOTES, spectrogram);
+                    haveSpectrogram = true;
+                }
+            }
+            else if (haveSub)
+            {
+                for (int j = 0; j < SPECTRUM_NOTES; j++)
+                {
+                    spectrogram[j] = std::max(spectrogram[j], subspectrogram[j]);
+                }
+            }
+        }
+        return haveSpectrogram;
+    };
 
-		if (max > _bigmax)
-		{
-			_bigmax = max;
-		}
-		if (min < _bigmin)
-		{
-			_bigmin = min;
-		}
-		if (spread > _bigspread)
-		{
-			_bigspread = spread;
-		}
+    _bigspectogrammax = -1;
+    if (samplesperframe > 0)
+    {
+        _bigspectogrammax = parallel_reduce<float>(0, frames, -1, [&](int begin, int end, float spectrumMax) {
+            float spectrogram[SPECTRUM_NOTES];
+            bool haveSpectrogram = false;
 
-		// Now save the results for the frame
-		std::list<float> maxlist;
-		maxlist.push_back(max);
-		std::list<float> minlist;
-		minlist.push_back(min);
-		std::list<float> spreadlist;
-		spreadlist.push_back(spread);
-		aFrameData[0] = maxlist;
-		aFrameData[1] = minlist;
-		aFrameData[2] = spreadlist;
-		aFrameData[3] = spectrogram;
-
-		_frameData.push_back(aFrameData);
-	}
+            // if the first frame has no windows of its own it repeats the frame that owns the window before it
+            int first = firstWindow(begin);
+            if (first > 0 && first == firstWindow(begin + 1))
+            {
+                int owner = (int)((long long)(first - 1) * step / samplesperframe);
+                haveSpectrogram = addWindows(firstWindow(owner), first, spectrogram, false, spectrumMax);
+            }
 
-	// normalise data ... basically scale the data so the highest value is the scale value.
-	float scale = 1.0; // 0-1 ... where 0.x means that the max value displayed would be x0% of model size
-	float bigmaxscale = 1 / (_bigmax * scale);
-	float bigminscale = 1 / (_bigmin * scale);
-	float bigspreadscale = 1 / (_bigspread * scale);
-	float bigspectrogramscale = 1 / (_bigspectogrammax * scale);
-	for (std::vector<std::vector<std::list<float>>>::iterator itframe = _frameData.begin(); itframe != _frameData.end(); ++itframe)
-	{
-		std::list<float>* fl = &(*itframe)[0];
-		std::list<float>::iterator f = fl->begin();
-		*f = (*f * bigmaxscale);
+            for (int i = begin; i < end; i++)
+            {
+                int next = firstWindow(i + 1);
 
-		fl = &(*itframe)[1];
-		f = fl->begin();
-		*f = (*f * bigminscale);
+                // clear the data if we are about to get new data ... dont clear it if we wont
+                if (first < next)
+                {
+                    haveSpectrogram = addWindows(first, next, spectrogram, false, spectrumMax);
+                }
+                first = next;
 
-		fl = &(*itframe)[2];
-		f = fl->begin();
-		*f = (*f * bigspreadscale);
+                if (haveSpectrogram)
+                {
+                    std::copy(spectrogram, spectrogram + SPECTRUM_NOTES, &_frameSpectrum[(size_t)i * SPECTRUM_STRIDE]);
+                    _frameSpectrumSize[i] = SPECTRUM_NOTES;
+                }
+            }
+            return spectrumMax;
+        }, [](const float& a, const float& b) {
+            return std::max(a, b);
+        }, 16);
+    }
 
-		fl = &(*itframe)[3];
-		for (std::list<float>::iterator ff = fl->begin(); ff != fl->end(); ++ff)
-		{
-			*ff = *ff * bigspectrogramscale;
-		}
-	}
+    float bigspectrogramscale = 1 / (_bigspectogrammax * scale);
+    for (int s = 0; s < frames; s += FRAME_PUBLISH_SLICE)
+    {
+        int e = std::min(s + FRAME_PUBLISH_SLICE, frames);
+        float* p = _frameSpectrum.data() + (size_t)s * SPECTRUM_STRIDE;
+        float* pe = _frameSpectrum.data() + (size_t)e * SPECTRUM_STRIDE;
+        for (; p < pe; ++p)
+        {
+            *p *= bigspectrogramscale;
+        }
+        PublishFrames(_frameSpectrumReady, e);
+    }
 
-	// flag the fact that the data is all ready
-	_frameDataPrepared = true;
+    logger_base.info("DoPrepareFrameData: Audio frame data processing complete in %ld. Frames: %d", sw.Time(), frames);
+}
 
-	logger_base.info("DoPrepareFrameData: Audio frame data processing complete in %ld. Frames: %d", sw.Time(), frames);
+// Moves a watermark forward and wakes anyone waiting for frames below it
+void AudioManager::PublishFrames(std::atomic_int& ready, int frames)
+{
+    {
+        std::unique_lock<std::mutex> lock(_frameReadyLock);
+        ready = frames;
+    }
+    _frameReadySignal.notify_all();
 }
 
 // Called to trigger frame data creation
@@ -1822,16 +1911,15 @@ void ProgressFunction(wxProgressDialog* pd, int p)
 }
 
 // Get the pre-prepared data for this frame
-const std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
+FrameDataSpan AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing)
 {
     log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    std::list<float>* rc = nullptr;
 
     // Grab the lock so we can safely access the frame data
     std::shared_lock<std::shared_timed_mutex> lock(_mutex);
 
     // make sure we have audio data
-    if (_data[0] == nullptr) return rc;
+    if (_data[0] == nullptr) return FrameDataSpan();
 
     // if the frame data has not been prepared
     if (!_frameDataPrepared)
@@ -1850,6 +1938,20 @@ const std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt,
             lock.lock();
         }
     }
+    // wait for the frame we want to be published ... the spectrum is finished after the levels
+    if (fdt == FRAMEDATA_HIGH || fdt == FRAMEDATA_LOW || fdt == FRAMEDATA_SPREAD || fdt == FRAMEDATA_VU)
+    {
+        std::atomic_int& ready = fdt == FRAMEDATA_VU ? _frameSpectrumReady : _frameLevelsReady;
+        if (frame >= 0 && frame < _frameDataFrames && ready <= frame)
+        {
+            lock.unlock();
+            {
+                std::unique_lock<std::mutex> readyLock(_frameReadyLock);
+                _frameReadySignal.wait(readyLock, [&ready, frame] { return ready > frame; });
+            }
+            lock.lock();
+        }
+    }
     if (fdt == FRAMEDATA_NOTES && !_polyphonicTranscriptionDone) {
         //need to do the polyphonic stuff
         wxProgressDialog dlg("Processing Audio", "");
@@ -1857,49 +1959,36 @@ const std::list<float>* AudioManager::GetFrameData(int frame, FRAMEDATATYPE fdt,
     }
 
     // now we can grab the data we need
-    try
+    if (frame < 0 || frame >= _frameDataFrames)
     {
-        if (frame < (int)_frameData.size())
-        {
-            std::vector<std::list<float>>* framedata = &_frameData[frame];
-
-            if (framedata == nullptr)
-            {
-                logger_base.crit("AudioManager::GetFrameData framedata is nullptr ... this is going to crash.");
-            }
-
-            switch (fdt)
-            {
-            case FRAMEDATA_HIGH:
-                rc = &framedata->at(0);
-                break;
-            case FRAMEDATA_LOW:
-                rc = &framedata->at(1);
-                break;
-            case FRAMEDATA_SPREAD:
-                rc = &framedata->at(2);
-                break;
-            case FRAMEDATA_VU:
-                rc = &framedata->at(3);
-                break;
-            case FRAMEDATA_ISTIMINGMARK:
-                // we dont need to do anything here
-                break;
-            case FRAMEDATA_NOTES:
-                rc = &framedata->at(4);
-                break;
-            }
-        }
+        return FrameDataSpan();
     }
-    catch (...)
+
+    switch (fdt)
     {
-        rc = nullptr;
+    case FRAMEDATA_HIGH:
+        return FrameDataSpan(&_frameHigh[frame], 1);
+    case FRAMEDATA_LOW:
+        return FrameDataSpan(&_frameLow[frame], 1);
+    case FRAMEDATA_SPREAD:
+        return FrameDataSpan(&_frameSpread[frame], 1);
+    case FRAMEDATA_VU:
+        return FrameDataSpan(&_frameSpectrum[(size_t)frame * SPECTRUM_STRIDE], _frameSpectrumSize[frame]);
+    case FRAMEDATA_ISTIMINGMARK:
+        // we dont need to do anything here
+        break;
+    case FRAMEDATA_NOTES:
+        if (frame + 1 < (int)_frameNotesStart.size())
+        {
+            return FrameDataSpan(_frameNotes.data() + _frameNotesStart[frame], _frameNotesStart[frame + 1] - _frameNotesStart[frame]);
+        }
+        break;
     }
 
-    return rc;
+    return FrameDataSpan();
 }
 
-const std::list<float>* AudioManager::GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms)
+FrameDataSpan AudioManager::GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms)
 {
     int frame = ms / _intervalMS;
     return GetFrameData(frame, fdt, timing);
@@ -2158,6 +2247,12 @@ AudioManager::~AudioManager()
     // wait for prepare frame data to finish ... if i delete the data before it is done we will crash
     // this is only tripped if we try to open a new song too soon after opening another one
 
+    // the spectrum is calculated without holding the lock so wait for the background process to finish
+    if (_prepFrameData.valid())
+    {
+        _prepFrameData.wait();
+    }
+
     // Grab the lock so we know the background process isnt runnning
     std::shared_lock<std::shared_timed_mutex> lock(_mutex);
 
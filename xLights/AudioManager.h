@@ -16,6 +16,9 @@
 #include <shared_mutex>
 #include <vector>
 #include <future>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 extern "C"
 {
@@ -85,6 +88,28 @@ typedef enum FRAMEDATATYPE {
 	FRAMEDATA_NOTES
 } FRAMEDATATYPE;
 
+// Read only view over the values AudioManager holds for one frame. The values are contiguous so it
+// can be walked like a container without pointer chasing. An empty view means there is no data.
+class FrameDataSpan
+{
+    const float* _data = nullptr;
+    size_t _size = 0;
+
+public:
+    FrameDataSpan() {}
+    FrameDataSpan(const float* data, size_t size) : _data(data), _size(size) {}
+
+    const float* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const float* begin() const { return _data; }
+    const float* end() const { return _data + _size; }
+    const float* cbegin() const { return _data; }
+    const float* cend() const { return _data + _size; }
+    float front() const { return *_data; }
+    float operator[](size_t i) const { return _data[i]; }
+};
+
 typedef enum MEDIAPLAYINGSTATE {
 	PLAYING,
 	PAUSED,
@@ -200,7 +225,19 @@ class AudioManager
     std::shared_timed_mutex _mutex;
     std::shared_timed_mutex _mutexAudioLoad;
     long _loadedData = 0;
-    std::vector<std::vector<std::list<float>>> _frameData;
+
+    // frame data is held as one flat array per type indexed by frame
+    static const int SPECTRUM_NOTES = 127;
+    static const int SPECTRUM_STRIDE = 128; // values per spectrum row, SPECTRUM_NOTES rounded up
+    static const int FRAME_PUBLISH_SLICE = 256; // frames published to readers at a time
+    int _frameDataFrames = 0;
+    std::vector<float> _frameHigh;
+    std::vector<float> _frameLow;
+    std::vector<float> _frameSpread;
+    std::vector<float> _frameSpectrum; // SPECTRUM_STRIDE values per frame
+    std::vector<uint8_t> _frameSpectrumSize; // 0 if there is no spectrum for the frame
+    std::vector<float> _frameNotes; // notes for all frames, frame n uses [_frameNotesStart[n], _frameNotesStart[n + 1])
+    std::vector<uint32_t> _frameNotesStart;
 	std::string _audio_file;
 	xLightsVamp _vamp;
 	long _rate = 44100;
@@ -218,7 +255,13 @@ class AudioManager
 	std::string _album;
 	int _intervalMS = 50;
 	long _lengthMS = 0;
-	bool _frameDataPrepared = false;
+	std::atomic_bool _frameDataPrepared = { false }; // frame data arrays are sized and being filled
+	// frames [0, n) of the levels and spectrum can be read. Frames are published a slice at a time as soon
+	// as their values are final so readers only wait for the frames they need
+	std::atomic_int _frameLevelsReady = { 0 };
+	std::atomic_int _frameSpectrumReady = { 0 };
+	std::mutex _frameReadyLock;
+	std::condition_variable _frameReadySignal;
 	float _bigmax = 0;
 	float _bigspread = 0;
 	float _bigmin = 0;
@@ -240,10 +283,13 @@ class AudioManager
     static void NormalizeMonoTrackData(signed short* trackData, long trackSize, float* leftData);
 	int OpenMediaFile();
 	void PrepareFrameData(bool separateThread);
+	void PublishFrames(std::atomic_int& ready, int frames);
     static int decodebitrateindex(int bitrateindex, int version, int layertype);
 	int decodesamplerateindex(int samplerateindex, int version) const;
     static int decodesideinfosize(int version, int mono);
-	std::list<float> CalculateSpectrumAnalysis(const float* in, int n, float& max, int id) const;
+	struct SpectrumPlan;
+	SpectrumPlan& GetSpectrumPlan(int n) const;
+	bool CalculateSpectrumAnalysis(const float* in, int n, float& max, int id, float* res) const;
 
     void LoadAudioFromFrame( AVFormatContext* formatContext, AVCodecContext* codecContext, AVPacket* decodingPacket, AVFrame* frame, SwrContext* au_convert_ctx,
                              bool receivedEOF, int out_channels, uint8_t* out_buffer, long& read, int& lastpct );
@@ -302,8 +348,8 @@ public:
 	void SetStepBlock(int step, int block);
 	void SetFrameInterval(int intervalMS);
 	int GetFrameInterval() const { return _intervalMS; }
-	const std::list<float>* GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
-	const std::list<float>* GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms);
+	FrameDataSpan GetFrameData(int frame, FRAMEDATATYPE fdt, std::string timing);
+	FrameDataSpan GetFrameData(FRAMEDATATYPE fdt, std::string timing, long ms);
 	void DoPrepareFrameData();
 	void DoPolyphonicTranscription(wxProgressDialog* dlg, AudioManagerProgressCallback progresscallback);
 	bool IsPolyphonicTranscriptionDone() const { return _polyphonicTranscriptionDone; };
@@ -0,0 +1,90 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+// SIMD support for the pixel and blend kernels in xLights and xSchedule. Kernels are processed in 16 byte
+// (SSE2) or 32 byte (AVX2) blocks using unaligned loads with scalar code handling whatever is left over.
+// SSE2 is available whenever the compiler targets it, AVX2 only when the CPU we are running on reports it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPU_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(CPU_SSE2) && (defined(__x86_64__) || defined(_M_X64))
+#define CPU_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CPU_AVX2_TARGET
+#else
+#define CPU_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+enum class SIMDLEVEL
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+namespace CPUFeatures
+{
+    inline SIMDLEVEL DetectSIMD()
+    {
+#ifdef CPU_AVX2
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] >= 7) {
+            // the OS must also be saving the YMM registers
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (osxsave && avx && (_xgetbv(0) & 0x06) == 0x06) {
+                __cpuidex(info, 7, 0);
+                if ((info[1] & (1 << 5)) != 0) return SIMDLEVEL::AVX2;
+            }
+        }
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SIMDLEVEL::AVX2;
+#endif
+#endif
+#ifdef CPU_SSE2
+        return SIMDLEVEL::SSE2;
+#else
+        return SIMDLEVEL::SCALAR;
+#endif
+    }
+
+    // the best this build can run on this machine and what the kernels are currently using
+    inline const SIMDLEVEL __supportedSIMD = DetectSIMD();
+    inline SIMDLEVEL __simd = __supportedSIMD;
+
+    inline SIMDLEVEL GetSupportedSIMD() { return __supportedSIMD; }
+    inline SIMDLEVEL GetSIMD() { return __simd; }
+    // Drop the kernels back to a lower level, used to compare each level against the scalar code.
+    // Asking for more than is supported gives what is supported. Not safe while kernels are running.
+    inline void SetSIMD(SIMDLEVEL level) { __simd = level < __supportedSIMD ? level : __supportedSIMD; }
+
+    inline bool UseSSE2() { return __simd >= SIMDLEVEL::SSE2; }
+    inline bool UseAVX2() { return __simd >= SIMDLEVEL::AVX2; }
+
+    inline const char* GetSIMDName(SIMDLEVEL level)
+    {
+        switch (level) {
+        case SIMDLEVEL::AVX2: return "AVX2";
+        case SIMDLEVEL::SSE2: return "SSE2";
+        default: return "scalar";
+        }
+    }
+}
@@ -4,8 +4,15 @@
 
 
 #include <vector>
+#include <deque>
+#include <algorithm>
 #include <cstring>
 #include <memory>
+#include <future>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <condition_variable>
 
 #include <stdio.h>
 #include <inttypes.h>
@@ -91,6 +98,10 @@ template<typename... Args> static void LogDebug(int i, const char *fmt, Args...
 }
 #define VB_SEQUENCE 1
 #define VB_ALL 0
+
+//compress blocks on the shared pool rather than starting a thread for each one
+#include "Parallel.h"
+#define FSEQ_COMPRESS_ON_POOL
 #endif
 
 
@@ -495,6 +506,16 @@ void FSEQFile::parseVariableHeaders(const std::vector<uint8_t> &header, int read
         }
     }
 }
+bool FSEQFile::readFrame(uint32_t frame, uint8_t *data, uint32_t maxChannels) {
+    FrameData *fd = getFrame(frame);
+    if (fd == nullptr) {
+        return false;
+    }
+    bool res = fd->readFrame(data, maxChannels);
+    delete fd;
+    return res;
+}
+
 void FSEQFile::finalize() {
     fflush(m_seqFile);
 }
@@ -728,6 +749,15 @@ public:
 
     virtual uint8_t getCompressionType() = 0;
     virtual FrameData *getFrame(uint32_t frame) = 0;
+    virtual bool readFrame(uint32_t frame, uint8_t *data, uint32_t maxChannels) {
+        FrameData *fd = getFrame(frame);
+        if (fd == nullptr) {
+            return false;
+        }
+        bool res = fd->readFrame(data, maxChannels);
+        delete fd;
+        return res;
+    }
 
     virtual uint32_t computeMaxBlocks(int max = 255) { return 0; }
     virtual void addFrame(uint32_t frame, const uint8_t *data) = 0;
@@ -751,6 +781,8 @@ public:
     }
 
     virtual void prepareRead(uint32_t frame) {}
+    virtual void setReadAhead(int blocks) {}
+    virtual FSEQFile::ReadAheadStats getReadAheadStats() { return FSEQFile::ReadAheadStats(); }
 
     V2FSEQFile *m_file;
     uint64_t   m_seqChanDataOffset;
@@ -802,6 +834,30 @@ public:
         }
         return data;
     }
+    virtual bool readFrame(uint32_t frame, uint8_t *data, uint32_t maxChannels) override {
+        uint64_t offset = m_file->getChannelCount();
+        offset *= frame;
+        offset += m_seqChanDataOffset;
+        // sparse files hold the sparse ranges packed one after the other, otherwise read the ranges straight from the frame
+        uint64_t pos = offset;
+        for (auto &rng : m_file->m_rangesToRead) {
+            uint64_t doffset = m_file->m_sparseRanges.empty() ? offset + rng.first : pos;
+            pos += rng.second;
+            if (rng.first >= maxChannels) {
+                continue;
+            }
+            uint32_t toRead = std::min(rng.second, maxChannels - rng.first);
+            if (seek(doffset, SEEK_SET)) {
+                LogErr(VB_SEQUENCE, "Failed to seek to proper offset for channel data! %" PRIu64 "\n", doffset);
+                return false;
+            }
+            size_t bread = read(&data[rng.first], toRead);
+            if (bread != toRead) {
+                LogErr(VB_SEQUENCE, "Failed to read channel data!   Needed to read %d but read %d\n", toRead, (int)bread);
+            }
+        }
+        return true;
+    }
     virtual void addFrame(uint32_t frame, const uint8_t *data) override {
         if (m_file->m_sparseRanges.empty()) {
             write(data, m_file->getChannelCount());
@@ -817,12 +873,287 @@ public:
 };
 class V2CompressedHandler : public V2Handler {
 public:
-    V2CompressedHandler(V2FSEQFile *f) : V2Handler(f), m_maxBlocks(0), m_curBlock(99999), m_framesPerBlock(0), m_curFrameInBlock(0) {
+    V2CompressedHandler(V2FSEQFile *f) : V2Handler(f), m_maxBlocks(0), m_curBlock(99999), m_framesPerBlock(0), m_curFrameInBlock(0),
+        m_readAheadBlocks(0), m_readAheadStop(false), m_readAheadGeneration(0),
+        m_readAheadBusy(NO_BLOCK), m_readAheadBusyGeneration(0), m_readAheadDataBlock(NO_BLOCK) {
         if (!m_file->m_frameOffsets.empty()) {
             m_maxBlocks = m_file->m_frameOffsets.size() - 1;
         }
     }
-    virtual ~V2CompressedHandler() {}
+    // subclasses must call stopReadAhead in their destructor as the read ahead
+    // thread calls back into decompressBlock
+    virtual ~V2CompressedHandler() {
+        stopReadAhead();
+    }
+
+    // decompress an entire block into out, safe to call from any thread
+    virtual void decompressBlock(uint32_t block, std::vector<uint8_t> &out) = 0;
+
+    uint32_t getBlockForFrame(uint32_t frame) const {
+        uint32_t block = 0;
+        while (frame >= m_file->m_frameOffsets[block + 1].first) {
+            block++;
+        }
+        return block;
+    }
+    uint32_t getFramesInBlock(uint32_t block) const {
+        return (m_file->m_frameOffsets[block + 1].first > m_file->getNumFrames() ? m_file->getNumFrames() : m_file->m_frameOffsets[block + 1].first) - m_file->m_frameOffsets[block].first;
+    }
+    void readCompressedBlock(uint32_t block, std::vector<uint8_t> &in) {
+        uint64_t len = m_file->m_frameOffsets[block + 1].second;
+        len -= m_file->m_frameOffsets[block].second;
+        uint64_t max = m_file->getNumFrames();
+        max *= m_file->getChannelCount();
+        if (len > max) {
+            len = max;
+        }
+        in.resize(len);
+        if (len == 0) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_fileLock);
+        seek(m_file->m_frameOffsets[block].second, SEEK_SET);
+        uint64_t bread = read(&in[0], len);
+        if (bread != len) {
+            LogErr(VB_SEQUENCE, "Failed to read channel data for block %d!   Needed to read %" PRIu64 " but read %d\n", block, len, (int)bread);
+        }
+        if (block + 2 < m_file->m_frameOffsets.size()) {
+            //let the kernel know that we'll likely need the next block in the near future
+            uint64_t len2 = m_file->m_frameOffsets[block + 2].second;
+            len2 -= m_file->m_frameOffsets[block + 1].second;
+            preload(tell(), len2);
+        }
+    }
+
+    // returns a pointer to the start of the frame within the decompressed block, nullptr on error
+    virtual const uint8_t *decodeFrame(uint32_t frame) = 0;
+
+    virtual FrameData *getFrame(uint32_t frame) override {
+        const uint8_t *fdata = isReadAhead() ? decodeFrameReadAhead(frame) : decodeFrame(frame);
+        if (fdata == nullptr) {
+            return new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        }
+        return createFrameData(frame, fdata);
+    }
+    // copies the ranges being read straight out of the decompressed block into the callers buffer
+    virtual bool readFrame(uint32_t frame, uint8_t *data, uint32_t maxChannels) override {
+        const uint8_t *fdata = isReadAhead() ? decodeFrameReadAhead(frame) : decodeFrame(frame);
+        if (fdata == nullptr) {
+            return false;
+        }
+        uint32_t offset = 0;
+        for (auto &rng : m_file->m_rangesToRead) {
+            // sparse files only hold the sparse ranges packed together, otherwise we have the full frame
+            uint32_t src = m_file->m_sparseRanges.empty() ? rng.first : offset;
+            offset += rng.second;
+            if (rng.first >= maxChannels || src >= m_file->getChannelCount()) {
+                continue;
+            }
+            uint32_t toCopy = std::min(rng.second, maxChannels - rng.first);
+            toCopy = std::min(toCopy, m_file->getChannelCount() - src);
+            memcpy(&data[rng.first], &fdata[src], toCopy);
+        }
+        return true;
+    }
+
+    // fdata points at the start of the frame within the decompressed block
+    FrameData *createFrameData(uint32_t frame, const uint8_t *fdata) {
+        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        if (!m_file->m_sparseRanges.empty()) {
+            memcpy(data->m_data, fdata, m_file->getChannelCount());
+        } else {
+            uint32_t sz = 0;
+            //read the ranges into the buffer
+            for (auto &rng : data->m_ranges) {
+                if (rng.first < m_file->getChannelCount()) {
+                    memcpy(&data->m_data[sz], &fdata[rng.first], rng.second);
+                    sz += rng.second;
+                }
+            }
+        }
+        return data;
+    }
+
+    virtual void setReadAhead(int blocks) override {
+        stopReadAhead();
+        m_readAheadBlocks = blocks < 0 ? 0 : blocks;
+        if (m_readAheadBlocks > 0 && m_file->m_frameOffsets.size() > 1) {
+            m_readAheadStop = false;
+            m_readAheadThread = std::thread(&V2CompressedHandler::readAheadThread, this);
+        }
+    }
+    void stopReadAhead() {
+        if (m_readAheadThread.joinable()) {
+            {
+                std::unique_lock<std::mutex> lock(m_readAheadLock);
+                m_readAheadStop = true;
+                m_readAheadQueue.clear();
+            }
+            m_readAheadSignal.notify_all();
+            m_readAheadThread.join();
+        }
+        m_readAheadReady.clear();
+        m_readAheadData.reset();
+        m_readAheadDataBlock = NO_BLOCK;
+    }
+    bool isReadAhead() const {
+        return m_readAheadThread.joinable();
+    }
+    virtual FSEQFile::ReadAheadStats getReadAheadStats() override {
+        std::unique_lock<std::mutex> lock(m_readAheadLock);
+        return m_readAheadStats;
+    }
+    virtual void prepareRead(uint32_t frame) override {
+        if (!isReadAhead() || frame >= m_file->getNumFrames()) {
+            return;
+        }
+        // throw away anything we have and start decompressing from the start frame
+        uint32_t block = getBlockForFrame(frame);
+        std::unique_lock<std::mutex> lock(m_readAheadLock);
+        m_readAheadData.reset();
+        m_readAheadDataBlock = NO_BLOCK;
+        cancelReadAhead();
+        queueReadAhead(block, block + m_readAheadBlocks);
+    }
+    const uint8_t *decodeFrameReadAhead(uint32_t frame) {
+        uint32_t block = getBlockForFrame(frame);
+        if (m_readAheadData == nullptr || block != m_readAheadDataBlock) {
+            m_readAheadData = getReadAheadBlock(block);
+            m_readAheadDataBlock = block;
+        }
+        uint64_t fidx = frame - m_file->m_frameOffsets[block].first;
+        fidx *= m_file->getChannelCount();
+        if (fidx + m_file->getChannelCount() > m_readAheadData->size()) {
+            LogErr(VB_SEQUENCE, "Block %d does not contain data for frame %d.\n", block, frame);
+            return nullptr;
+        }
+        return &(*m_readAheadData)[fidx];
+    }
+
+    // for compressed files, this is the compression data
+    uint32_t m_framesPerBlock;
+    uint32_t m_curFrameInBlock;
+    uint32_t m_curBlock;
+    uint32_t m_maxBlocks;
+
+private:
+    static const uint32_t NO_BLOCK = 0xFFFFFFFF;
+
+    // must be called with m_readAheadLock held
+    void cancelReadAhead() {
+        m_readAheadStats.cancelled += m_readAheadReady.size() + m_readAheadQueue.size();
+        m_readAheadGeneration++;
+        m_readAheadQueue.clear();
+        m_readAheadReady.clear();
+    }
+    // must be called with m_readAheadLock held
+    void queueReadAhead(uint32_t first, uint32_t last) {
+        uint32_t numBlocks = m_file->m_frameOffsets.size() - 1;
+        for (uint32_t b = first; b <= last && b < numBlocks; b++) {
+            if (m_readAheadReady.find(b) == m_readAheadReady.end()
+                && !(b == m_readAheadBusy && m_readAheadBusyGeneration == m_readAheadGeneration)
+                && std::find(m_readAheadQueue.begin(), m_readAheadQueue.end(), b) == m_readAheadQueue.end()) {
+                m_readAheadQueue.push_back(b);
+            }
+        }
+        m_readAheadSignal.notify_all();
+    }
+    std::shared_ptr<std::vector<uint8_t>> getReadAheadBlock(uint32_t block) {
+        std::unique_lock<std::mutex> lock(m_readAheadLock);
+        m_readAheadStats.blocks++;
+
+        std::shared_ptr<std::vector<uint8_t>> data;
+        auto it = m_readAheadReady.find(block);
+        if (it != m_readAheadReady.end()) {
+            m_readAheadStats.hits++;
+            data = it->second;
+        } else if ((block == m_readAheadBusy && m_readAheadBusyGeneration == m_readAheadGeneration)
+                   || std::find(m_readAheadQueue.begin(), m_readAheadQueue.end(), block) != m_readAheadQueue.end()) {
+            // it is on its way, wait for it
+            uint64_t start = GetTime();
+            m_readAheadStats.stalls++;
+            while (!m_readAheadStop && (it = m_readAheadReady.find(block)) == m_readAheadReady.end()) {
+                m_readAheadSignal.wait(lock);
+            }
+            if (it != m_readAheadReady.end()) {
+                data = it->second;
+            }
+            m_readAheadStats.stallTimeUS += GetTime() - start;
+        }
+        if (data == nullptr) {
+            // we seeked somewhere we were not expecting, anything queued is now useless
+            uint64_t start = GetTime();
+            m_readAheadStats.stalls++;
+            cancelReadAhead();
+            lock.unlock();
+            data = std::make_shared<std::vector<uint8_t>>();
+            decompressBlock(block, *data);
+            lock.lock();
+            m_readAheadStats.stallTimeUS += GetTime() - start;
+        }
+
+        // drop blocks we have moved past and queue up the ones after this
+        for (auto it2 = m_readAheadReady.begin(); it2 != m_readAheadReady.end(); ) {
+            if (it2->first <= block || it2->first > block + m_readAheadBlocks) {
+                it2 = m_readAheadReady.erase(it2);
+            } else {
+                ++it2;
+            }
+        }
+        queueReadAhead(block + 1, block + m_readAheadBlocks);
+        return data;
+    }
+    void readAheadThread() {
+        std::unique_lock<std::mutex> lock(m_readAheadLock);
+        while (!m_readAheadStop) {
+            if (m_readAheadQueue.empty()) {
+                m_readAheadSignal.wait(lock);
+                continue;
+            }
+            uint32_t block = m_readAheadQueue.front();
+            m_readAheadQueue.pop_front();
+            uint32_t generation = m_readAheadGeneration;
+            m_readAheadBusy = block;
+            m_readAheadBusyGeneration = generation;
+            lock.unlock();
+
+            std::shared_ptr<std::vector<uint8_t>> data = std::make_shared<std::vector<uint8_t>>();
+            try {
+                decompressBlock(block, *data);
+            } catch (...) {
+                LogErr(VB_SEQUENCE, "Error decompressing block %d in read ahead thread.\n", block);
+            }
+
+            lock.lock();
+            m_readAheadBusy = NO_BLOCK;
+            if (generation == m_readAheadGeneration) {
+                m_readAheadReady[block] = data;
+            } else {
+                m_readAheadStats.cancelled++;
+            }
+            m_readAheadSignal.notify_all();
+        }
+    }
+
+    int m_readAheadBlocks;
+    bool m_readAheadStop;
+    uint32_t m_readAheadGeneration;
+    uint32_t m_readAheadBusy;
+    uint32_t m_readAheadBusyGeneration;
+    std::thread m_readAheadThread;
+    std::mutex m_readAheadLock;
+    std::condition_variable m_readAheadSignal;
+    std::deque<uint32_t> m_readAheadQueue;
+    std::map<uint32_t, std::shared_ptr<std::vector<uint8_t>>> m_readAheadReady;
+    FSEQFile::ReadAheadStats m_readAheadStats;
+    std::mutex m_fileLock;
+
+    // block currently being played, only touched by the playback thread
+    std::shared_ptr<std::vector<uint8_t>> m_readAheadData;
+    uint32_t m_readAheadDataBlock;
+
+public:
 
     virtual uint32_t computeMaxBlocks(int maxNumBlocks) override {
         if (m_maxBlocks > 0) {
@@ -895,13 +1226,6 @@ public:
         m_file->m_frameOffsets.pop_back();
         seek(curr, SEEK_SET);
     }
-
-
-    // for compressed files, this is the compression data
-    uint32_t m_framesPerBlock;
-    uint32_t m_curFrameInBlock;
-    uint32_t m_curBlock;
-    uint32_t m_maxBlocks;
 };
 
 #ifndef NO_ZSTD
@@ -909,7 +1233,11 @@ class V2ZSTDCompressionHandler : public V2CompressedHandler {
 public:
     V2ZSTDCompressionHandler(V2FSEQFile *f) : V2CompressedHandler(f),
     m_cctx(nullptr),
-    m_dctx(nullptr)
+    m_dctx(nullptr),
+    m_blockStartFrame(0),
+    m_blockCompressionLevel(0),
+    m_uncompressedBytes(0),
+    m_compressStartTime(0)
     {
         m_outBuffer.pos = 0;
         m_outBuffer.size = V2FSEQ_OUT_BUFFER_SIZE;
@@ -920,6 +1248,7 @@ public:
         LogDebug(VB_SEQUENCE, "  Prepared to read/write a ZSTD compress fseq file.\n");
     }
     virtual ~V2ZSTDCompressionHandler() {
+        stopReadAhead();
         free(m_outBuffer.dst);
         if (m_inBuffer.src != nullptr) {
             free((void*)m_inBuffer.src);
@@ -934,7 +1263,31 @@ public:
     virtual uint8_t getCompressionType() override { return 1;}
     virtual std::string GetType() const override { return "Compressed ZSTD"; }
 
-    virtual FrameData *getFrame(uint32_t frame) override {
+    virtual void decompressBlock(uint32_t block, std::vector<uint8_t> &out) override {
+        std::vector<uint8_t> in;
+        readCompressedBlock(block, in);
+        out.resize((size_t)getFramesInBlock(block) * m_file->getChannelCount());
+        if (in.empty() || out.empty()) {
+            return;
+        }
+        ZSTD_DStream *dctx = ZSTD_createDStream();
+        ZSTD_initDStream(dctx);
+        ZSTD_inBuffer_s input = { &in[0], in.size(), 0 };
+        ZSTD_outBuffer_s output = { &out[0], out.size(), 0 };
+        while (input.pos < input.size && output.pos < output.size) {
+            size_t r = ZSTD_decompressStream(dctx, &output, &input);
+            if (ZSTD_isError(r)) {
+                LogErr(VB_SEQUENCE, "Error decompressing block %d: %s\n", block, ZSTD_getErrorName(r));
+                break;
+            }
+            if (r == 0) {
+                break;
+            }
+        }
+        ZSTD_freeDStream(dctx);
+    }
+
+    virtual const uint8_t *decodeFrame(uint32_t frame) override {
         if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
             //frame is not in the current block
             m_curBlock = 0;
@@ -988,30 +1341,33 @@ public:
         
         fidx *= m_file->getChannelCount();
         uint8_t *fdata = (uint8_t*)m_outBuffer.dst;
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
 
         // This stops the crash on load ... but it is not the root cause.
         // But better to not load completely than crashing
         if (fidx < 0) {
             // this is not going to end well ... best to give up here
             LogErr(VB_SEQUENCE, "Frame index calculated as a negative number. Aborting frame %d load.\n", (int)frame);
-            return data;
+            return nullptr;
         }
-
-        if (!m_file->m_sparseRanges.empty()) {
-            memcpy(data->m_data, &fdata[fidx], m_file->getChannelCount());
-        } else {
-            uint32_t sz = 0;
-            //read the ranges into the buffer
-            for (auto &rng : data->m_ranges) {
-                if (rng.first < m_file->getChannelCount()) {
-                    int start = fidx + rng.first;
-                    memcpy(&data->m_data[sz], &fdata[start], rng.second);
-                    sz += rng.second;
-                }
-            }
+        return &fdata[fidx];
+    }
+    int getCompressionLevel(uint32_t frame) {
+        int clevel = m_file->m_compressionLevel == -99 ? 2 : m_file->m_compressionLevel;
+        if (clevel < -25 || clevel > 25) {
+            clevel = 2;
         }
-        return data;
+        if (frame == 0 && (ZSTD_versionNumber() > 10305)) {
+            // first frame needs to be grabbed as fast as possible
+            // or remotes may be off by a few frames at start.  Thus,
+            // if using recent zstd, we'll use the negative levels
+            // for the first block so the decompression can
+            // be as fast as possible
+            clevel = -10;
+        }
+        if (ZSTD_versionNumber() <= 10305 && clevel < 0) {
+            clevel = 0;
+        }
+        return clevel;
     }
     void compressData(ZSTD_CStream* m_cctx, ZSTD_inBuffer_s &input, ZSTD_outBuffer_s &output) {
         ZSTD_compressStream(m_cctx, &output, &input);
@@ -1032,7 +1388,101 @@ public:
             count += input.pos;
         }
     }
+
+    // Each block is an independent zstd frame so blocks can be compressed on separate
+    // threads and then written out in order.  The file layout is identical to the
+    // single threaded stream so readers can't tell the difference.
+    static std::vector<uint8_t> compressBlock(const std::vector<uint8_t> &in, int clevel) {
+        std::vector<uint8_t> out(ZSTD_compressBound(in.size()));
+        size_t sz = ZSTD_compress(&out[0], out.size(), &in[0], in.size(), clevel);
+        if (ZSTD_isError(sz)) {
+            LogErr(VB_SEQUENCE, "Error compressing fseq block: %s\n", ZSTD_getErrorName(sz));
+            sz = 0;
+        }
+        out.resize(sz);
+        return out;
+    }
+#ifdef FSEQ_COMPRESS_ON_POOL
+    class CompressBlockJob : public Job {
+    public:
+        CompressBlockJob(std::vector<uint8_t> &&in, int clevel) : m_in(std::move(in)), m_clevel(clevel) {}
+        virtual void Process() override { m_result.set_value(compressBlock(m_in, m_clevel)); }
+        virtual bool DeleteWhenComplete() override { return true; }
+        virtual bool SetThreadName() override { return false; }
+
+        std::vector<uint8_t> m_in;
+        int m_clevel;
+        std::promise<std::vector<uint8_t>> m_result;
+    };
+#endif
+    void queueBlock() {
+        m_pendingBlocks.push_back(PendingBlock());
+        m_pendingBlocks.back().startFrame = m_blockStartFrame;
+#ifdef FSEQ_COMPRESS_ON_POOL
+        CompressBlockJob *job = new CompressBlockJob(std::move(m_blockBuffer), m_blockCompressionLevel);
+        m_pendingBlocks.back().data = job->m_result.get_future();
+        ParallelJobPool::POOL.PushJob(job);
+#else
+        m_pendingBlocks.back().data = std::async(std::launch::async, compressBlock, std::move(m_blockBuffer), m_blockCompressionLevel);
+#endif
+        m_blockBuffer = std::vector<uint8_t>();
+        m_curFrameInBlock = 0;
+        m_curBlock++;
+    }
+    void writeCompressedBlocks(bool wait) {
+        // write out any blocks at the front of the queue that are done, if there are more
+        // blocks queued than threads we wait for the oldest so memory use stays bounded
+        while (!m_pendingBlocks.empty()) {
+            PendingBlock &b = m_pendingBlocks.front();
+            if (!wait && m_pendingBlocks.size() <= (size_t)m_file->m_compressionThreads
+                && b.data.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return;
+            }
+#ifdef FSEQ_COMPRESS_ON_POOL
+            //rather than block, help with whatever the pool has queued which may well be this block
+            while (b.data.wait_for(std::chrono::seconds(0)) != std::future_status::ready
+                   && ParallelJobPool::POOL.RunPendingJob()) {
+            }
+#endif
+            std::vector<uint8_t> d = b.data.get();
+            m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(b.startFrame, tell()));
+            if (!d.empty()) {
+                write(&d[0], d.size());
+            }
+            m_pendingBlocks.pop_front();
+        }
+    }
+    void addFrameThreaded(uint32_t frame, const uint8_t *data) {
+        if (m_curFrameInBlock == 0) {
+            m_blockStartFrame = frame;
+            m_blockCompressionLevel = getCompressionLevel(frame);
+            m_blockBuffer.reserve((m_curBlock == 0 ? 10 : m_framesPerBlock) * (size_t)m_file->getChannelCount());
+        }
+        if (m_file->m_sparseRanges.empty()) {
+            m_blockBuffer.insert(m_blockBuffer.end(), data, data + m_file->getChannelCount());
+        } else {
+            for (auto &a : m_file->m_sparseRanges) {
+                m_blockBuffer.insert(m_blockBuffer.end(), &data[a.first], &data[a.first + a.second]);
+            }
+        }
+        m_curFrameInBlock++;
+        //same block boundaries as the single threaded stream, m_curBlock + 1 is the number of blocks started
+        if ((m_curBlock == 0 && m_curFrameInBlock == 10)
+            || (m_curFrameInBlock >= m_framesPerBlock && (m_curBlock + 1) < m_maxBlocks)) {
+            queueBlock();
+        }
+        writeCompressedBlocks(false);
+    }
     virtual void addFrame(uint32_t frame, const uint8_t *data) override {
+        if (m_compressStartTime == 0) {
+            m_compressStartTime = GetTime();
+        }
+        m_uncompressedBytes += m_file->getChannelCount();
+
+        if (m_file->m_compressionThreads > 1) {
+            addFrameThreaded(frame, data);
+            return;
+        }
 
         if (m_cctx == nullptr) {
             m_cctx = ZSTD_createCStream();
@@ -1041,22 +1491,7 @@ public:
             uint64_t offset = tell();
             //LogDebug(VB_SEQUENCE, "  Preparing to create a compressed block of data starting at frame %d, offset  %" PRIu64 ".\n", frame, offset);
             m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(frame, offset));
-            int clevel = m_file->m_compressionLevel == -99 ? 2 : m_file->m_compressionLevel;
-            if (clevel < -25 || clevel > 25) {
-                clevel = 2;
-            }
-            if (frame == 0 && (ZSTD_versionNumber() > 10305)) {
-                // first frame needs to be grabbed as fast as possible
-                // or remotes may be off by a few frames at start.  Thus,
-                // if using recent zstd, we'll use the negative levels
-                // for the first block so the decompression can
-                // be as fast as possible
-                clevel = -10;
-            }
-            if (ZSTD_versionNumber() <= 10305 && clevel < 0) {
-                clevel = 0;
-            }
-            ZSTD_initCStream(m_cctx, clevel);
+            ZSTD_initCStream(m_cctx, getCompressionLevel(frame));
         }
 
         uint8_t *curData = (uint8_t *)data;
@@ -1102,7 +1537,10 @@ public:
         }
     }
     virtual void finalize() override {
-        if (m_curFrameInBlock) {
+        if (m_curFrameInBlock && m_file->m_compressionThreads > 1) {
+            LogDebug(VB_SEQUENCE, "  Finalized last block of data.  Frames in block: %d.\n", m_curFrameInBlock);
+            queueBlock();
+        } else if (m_curFrameInBlock) {
             while(ZSTD_endStream(m_cctx, &m_outBuffer) > 0) {
                 write(m_outBuffer.dst, m_outBuffer.pos);
                 m_outBuffer.pos = 0;
@@ -1113,6 +1551,14 @@ public:
             m_curFrameInBlock = 0;
             m_curBlock++;
         }
+        writeCompressedBlocks(true);
+        if (m_compressStartTime != 0) {
+            double secs = (GetTime() - m_compressStartTime) / 1000000.0;
+            if (secs > 0) {
+                LogDebug(VB_SEQUENCE, "  Compressed %" PRIu64 " bytes in %.3fs using %d thread(s): %.2f MB/s.\n",
+                         m_uncompressedBytes, secs, m_file->m_compressionThreads, m_uncompressedBytes / (1024.0 * 1024.0) / secs);
+            }
+        }
         V2CompressedHandler::finalize();
     }
 
@@ -1120,6 +1566,19 @@ public:
     ZSTD_DStream* m_dctx;
     ZSTD_outBuffer_s m_outBuffer;
     ZSTD_inBuffer_s m_inBuffer;
+
+    // state for block parallel compression
+    class PendingBlock {
+    public:
+        uint32_t startFrame;
+        std::future<std::vector<uint8_t>> data;
+    };
+    std::deque<PendingBlock> m_pendingBlocks;
+    std::vector<uint8_t> m_blockBuffer;
+    uint32_t m_blockStartFrame;
+    int m_blockCompressionLevel;
+    uint64_t m_uncompressedBytes;
+    uint64_t m_compressStartTime;
 };
 #endif
 
@@ -1129,6 +1588,7 @@ public:
     V2ZLIBCompressionHandler(V2FSEQFile *f) : V2CompressedHandler(f), m_stream(nullptr), m_outBuffer(nullptr), m_inBuffer(nullptr) {
     }
     virtual ~V2ZLIBCompressionHandler() {
+        stopReadAhead();
         if (m_outBuffer) {
             free(m_outBuffer);
         }
@@ -1139,7 +1599,25 @@ public:
     virtual uint8_t getCompressionType() override { return 2; }
     virtual std::string GetType() const override { return "Compressed ZLIB"; }
 
-    virtual FrameData *getFrame(uint32_t frame) override {
+    virtual void decompressBlock(uint32_t block, std::vector<uint8_t> &out) override {
+        std::vector<uint8_t> in;
+        readCompressedBlock(block, in);
+        out.resize((size_t)getFramesInBlock(block) * m_file->getChannelCount());
+        if (in.empty() || out.empty()) {
+            return;
+        }
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        inflateInit(&stream);
+        stream.next_in = &in[0];
+        stream.avail_in = in.size();
+        stream.next_out = &out[0];
+        stream.avail_out = out.size();
+        inflate(&stream, Z_SYNC_FLUSH);
+        inflateEnd(&stream);
+    }
+
+    virtual const uint8_t *decodeFrame(uint32_t frame) override {
         if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
             //frame is not in the current block
             m_curBlock = 0;
@@ -1189,20 +1667,7 @@ public:
         int fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
         fidx *= m_file->getChannelCount();
         uint8_t *fdata = (uint8_t*)m_outBuffer;
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
-        if (!m_file->m_sparseRanges.empty()) {
-            memcpy(data->m_data, &fdata[fidx], m_file->getChannelCount());
-        } else {
-            uint32_t sz = 0;
-            //read the ranges into the buffer
-            for (auto &rng : data->m_ranges) {
-                if (rng.first < m_file->getChannelCount()) {
-                    memcpy(&data->m_data[sz], &fdata[fidx + rng.first], rng.second);
-                    sz += rng.second;
-                }
-            }
-        }
-        return data;
+        return &fdata[fidx];
     }
     virtual void addFrame(uint32_t frame, const uint8_t *data) override {
         if (m_outBuffer == nullptr) {
@@ -1329,6 +1794,7 @@ V2FSEQFile::V2FSEQFile(const std::string &fn, CompressionType ct, int cl)
     : FSEQFile(fn),
     m_compressionType(ct),
     m_compressionLevel(cl),
+    m_compressionThreads(1),
     m_handler(nullptr),
     m_allowExtendedBlocks(false)
 {
@@ -1468,6 +1934,7 @@ void V2FSEQFile::writeHeader() {
 V2FSEQFile::V2FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header)
 : FSEQFile(fn, file, header),
 m_compressionType(none),
+m_compressionThreads(1),
 m_handler(nullptr)
 {
     if (m_seqVersionMajor == 2 && m_seqVersionMinor > 1) {
@@ -1640,6 +2107,33 @@ void V2FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &r
     }
     m_handler->prepareRead(startFrame);
 }
+void V2FSEQFile::setReadAheadBlocks(int blocks) {
+    if (m_handler != nullptr) {
+        m_handler->setReadAhead(blocks);
+    }
+}
+FSEQFile::ReadAheadStats V2FSEQFile::getReadAheadStats() const {
+    if (m_handler != nullptr) {
+        return m_handler->getReadAheadStats();
+    }
+    return ReadAheadStats();
+}
+bool V2FSEQFile::readFrame(uint32_t frame, uint8_t *data, uint32_t maxChannels) {
+    if (m_rangesToRead.empty()) {
+        std::vector<std::pair<uint32_t, uint32_t>> range;
+        range.push_back(std::pair<uint32_t, uint32_t>(0, getMaxChannel() + 1));
+        prepareRead(range, frame);
+    }
+    if (frame >= m_seqNumFrames || m_handler == nullptr) {
+        return false;
+    }
+    try {
+        return m_handler->readFrame(frame, data, maxChannels);
+    } catch(...) {
+        LogErr(VB_SEQUENCE, "Error reading frame from handler %s.\n", m_handler->GetType().c_str());
+    }
+    return false;
+}
 FrameData *V2FSEQFile::getFrame(uint32_t frame) {
     if (m_rangesToRead.empty()) {
         std::vector<std::pair<uint32_t, uint32_t>> range;
@@ -36,6 +36,16 @@ public:
         zlib
     };
 
+    //counters describing how well read ahead is keeping up with playback
+    class ReadAheadStats {
+        public:
+        uint32_t blocks = 0;      //number of blocks playback has moved into
+        uint32_t hits = 0;        //blocks that were already decompressed when needed
+        uint32_t stalls = 0;      //blocks playback had to wait for
+        uint32_t cancelled = 0;   //prefetched blocks thrown away because of a seek
+        uint64_t stallTimeUS = 0; //total time spent waiting
+    };
+
 protected:
     //open file for reading
     FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header);
@@ -69,9 +79,21 @@ public:
     //provide the necessary data in a timely fassion for the given frame
     //It may not be used right away and will be deleted at some point in the future
     virtual FrameData *getFrame(uint32_t frame) = 0;
+
+    //Reads the frame straight into data (which must hold maxChannels channels) without
+    //allocating.  Only the ranges passed to prepareRead are written.
+    virtual bool readFrame(uint32_t frame, uint8_t *data, uint32_t maxChannels);
+
+    //For compressed files, decompress up to this many blocks ahead of the current
+    //frame on a background thread.  0 (the default) disables read ahead.
+    //Must be called before prepareRead.
+    virtual void setReadAheadBlocks(int blocks) {}
+    virtual ReadAheadStats getReadAheadStats() const { return ReadAheadStats(); }
     
     //For writing to the fseq file
     virtual void enableMinorVersionFeatures(uint8_t ver) {}
+    //number of threads that can be used to compress blocks in parallel, 1 compresses on the calling thread
+    virtual void setCompressionThreads(int threads) {}
     virtual void initializeFromFSEQ(const FSEQFile& fseq);
     virtual void writeHeader() = 0;
     virtual void addFrame(uint32_t frame,
@@ -165,6 +187,9 @@ public:
     
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t startFrame = 0) override;
     virtual FrameData *getFrame(uint32_t frame) override;
+    virtual bool readFrame(uint32_t frame, uint8_t *data, uint32_t maxChannels) override;
+    virtual void setReadAheadBlocks(int blocks) override;
+    virtual ReadAheadStats getReadAheadStats() const override;
     
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
@@ -186,8 +211,13 @@ public:
         }
     }
 
+    virtual void setCompressionThreads(int threads) override {
+        m_compressionThreads = threads < 1 ? 1 : threads;
+    }
+
     CompressionType m_compressionType;
     int             m_compressionLevel;
+    int             m_compressionThreads;
     std::vector<std::pair<uint32_t, uint32_t>> m_sparseRanges;
     std::vector<std::pair<uint32_t, uint32_t>> m_rangesToRead;
     std::vector<std::pair<uint32_t, uint64_t>> m_frameOffsets;
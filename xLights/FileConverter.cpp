@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <map>
+#include <thread>
 
 #include <wx/app.h>
 #include <wx/arrstr.h>
@@ -1653,6 +1654,8 @@ void FileConverter::WriteFalconPiFile(ConvertParameters& params)
     file->setChannelCount(stepSize);
     file->setStepTime(stepTime);
     file->setNumFrames(params.seq_data.NumFrames());
+    // compress the blocks in parallel ... this is the bulk of the time spent saving large sequences
+    file->setCompressionThreads(std::thread::hardware_concurrency());
     if (params.media_filename) {
         if ((*params.media_filename).length() > 0) {
             FSEQFile::VariableHeader header;
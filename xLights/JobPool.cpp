@@ -53,6 +53,7 @@ class JobPoolWorker
     std::atomic<STATUS_TYPE> status;
     std::thread *thread;
     std::thread::id tid;
+    JobQueue *queue;
 public:
     JobPoolWorker(JobPool *p);
     virtual ~JobPoolWorker();
@@ -64,8 +65,55 @@ public:
     std::string GetStatus();
     
     std::string GetThreadName() const;
+
+    JobPool *GetPool() const { return pool; }
+    JobQueue *GetQueue() const { return queue; }
 };
 
+// the worker running on the current thread so jobs it pushes go onto its own queue
+static thread_local JobPoolWorker *__currentWorker = nullptr;
+
+#pragma region JobQueue
+void JobQueue::Push(Job *job, int copies)
+{
+    std::unique_lock<std::mutex> locker(lock);
+    size_t c = count;
+    if (c + copies > jobs.size()) {
+        // grow and unwrap the ring so the jobs start at 0 again
+        std::vector<Job*> newJobs(std::max((size_t)16, (c + copies) * 2), nullptr);
+        for (size_t x = 0; x < c; x++) {
+            newJobs[x] = jobs[(head + x) % jobs.size()];
+        }
+        jobs.swap(newJobs);
+        head = 0;
+    }
+    for (int x = 0; x < copies; x++) {
+        jobs[(head + c + x) % jobs.size()] = job;
+    }
+    count += copies;
+}
+
+Job *JobQueue::PopFront()
+{
+    if (count == 0) return nullptr;
+    std::unique_lock<std::mutex> locker(lock);
+    if (count == 0) return nullptr;
+    Job *job = jobs[head];
+    head = (head + 1) % jobs.size();
+    --count;
+    return job;
+}
+
+Job *JobQueue::PopBack()
+{
+    if (count == 0) return nullptr;
+    std::unique_lock<std::mutex> locker(lock);
+    if (count == 0) return nullptr;
+    --count;
+    return jobs[(head + count) % jobs.size()];
+}
+#pragma endregion
+
 static void startFunc(JobPoolWorker *jpw) {
 #ifdef LINUX
     XInitThreads();
@@ -74,7 +122,7 @@ static void startFunc(JobPoolWorker *jpw) {
     delete jpw;
 }
 JobPoolWorker::JobPoolWorker(JobPool *p)
-: pool(p), stopped(false), currentJob(nullptr), status(STARTING), thread(nullptr)
+: pool(p), stopped(false), currentJob(nullptr), status(STARTING), thread(nullptr), queue(p->ClaimQueue())
 {
     static log4cpp::Category& logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
     //static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -208,10 +256,11 @@ void JobPoolWorker::Entry()
 
     try {
         SetThreadName(pool->threadNameBase);
+        __currentWorker = this;
         while ( !stopped ) {
             status = IDLE;
 
-            Job *job = pool->GetNextJob();
+            Job *job = pool->GetNextJob(queue, stopped);
             if (job != nullptr) {
                 logger_jobpool.debug("JobPoolWorker::Entry processing job.   %X", this);
                 status = RUNNING_JOB;
@@ -263,14 +312,17 @@ void JobPoolWorker::ProcessJob(Job *job)
 		logger_jobpool.debug("Starting job on background thread.");
 		currentJob = job;
         
+        // the job may be owned by a thread waiting for it to finish so it must not be
+        // touched once Process returns unless we are deleting it
         std::string origName;
-        if (job->SetThreadName()) {
+        bool setThreadName = job->SetThreadName();
+        if (setThreadName) {
             origName = OriginalThreadName();
             SetThreadName(job->GetName());
         }
         bool deleteWhenComplete = job->DeleteWhenComplete();
         job->Process();
-        if (job->SetThreadName()) {
+        if (setThreadName) {
             SetThreadName(origName);
         }
         currentJob = nullptr;
@@ -286,7 +338,7 @@ void JobPoolWorker::ProcessJob(Job *job)
 	}
 }
 
-JobPool::JobPool(const std::string &n) : threadLock(), queueLock(), signal(), queue(), numThreads(0), maxNumThreads(8), minNumThreads(2), idleThreads(0), inFlight(0), threadNameBase(n)
+JobPool::JobPool(const std::string &n) : threadLock(), queueLock(), signal(), queue(), numThreads(0), maxNumThreads(8), minNumThreads(2), idleThreads(0), inFlight(0), pendingJobs(0), threadNameBase(n)
 {
 }
 
@@ -295,15 +347,18 @@ JobPool::~JobPool()
 {
     static log4cpp::Category& logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
     //static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    if ( !queue.empty() ) {
-        std::deque<Job*>::iterator iter = queue.begin();
-        for (; iter != queue.end(); ++iter) {
-            delete (*iter);
-        }
+    if (pendingJobs > 0) {
         logger_jobpool.debug("Clearing JobPool queue.");
-        queue.clear();
+        Job *job;
+        while ((job = TakeJob(nullptr)) != nullptr) {
+            delete job;
+        }
     }
     Stop();
+    for (auto q : workerQueues) {
+        delete q;
+    }
+    workerQueues.clear();
 }
 
 void JobPool::LockThreads() {
@@ -321,35 +376,126 @@ void JobPool::RemoveWorker(JobPoolWorker *w) {
     if (loc != threads.end()) {
         threads.erase(loc);
     }
+    ReleaseQueue(w->GetQueue());
     UnlockThreads();
+    if (__currentWorker == w) {
+        __currentWorker = nullptr;
+    }
+}
+
+// must be called with the threads locked
+JobQueue *JobPool::ClaimQueue() {
+    for (auto q : workerQueues) {
+        if (!q->inUse) {
+            q->inUse = true;
+            return q;
+        }
+    }
+    // no spare queue so jobs this worker pushes go on the shared queue
+    return nullptr;
+}
+
+// must be called with the threads locked
+void JobPool::ReleaseQueue(JobQueue *q) {
+    if (q == nullptr) return;
+
+    // a worker only leaves jobs behind if it died so hand them to the others
+    Job *job;
+    while ((job = q->PopFront()) != nullptr) {
+        queue.Push(job);
+    }
+    q->inUse = false;
+}
+
+JobQueue *JobPool::GetCurrentQueue() const {
+    if (__currentWorker != nullptr && __currentWorker->GetPool() == this) {
+        return __currentWorker->GetQueue();
+    }
+    return nullptr;
+}
+
+Job *JobPool::TakeJob(JobQueue *own) {
+    if (pendingJobs <= 0) {
+        return nullptr;
+    }
+
+    // newest of our own jobs first as its data is most likely still in cache, then the oldest shared job
+    Job *job = own != nullptr ? own->PopBack() : nullptr;
+    if (job == nullptr) {
+        job = queue.PopFront();
+    }
+    if (job == nullptr && !workerQueues.empty()) {
+        // steal the oldest job from another worker, starting at a different worker each time to spread the load
+        static std::atomic_uint victim(0);
+        size_t count = workerQueues.size();
+        size_t start = victim++;
+        for (size_t x = 0; x < count && job == nullptr; x++) {
+            JobQueue *q = workerQueues[(start + x) % count];
+            if (q != own && !q->Empty()) {
+                job = q->PopFront();
+            }
+        }
+    }
+    if (job != nullptr) {
+        --pendingJobs;
+    }
+    return job;
 }
 
-Job *JobPool::GetNextJob() {
-    std::unique_lock<std::mutex> mutLock(queueLock);
-    Job *req = nullptr;
-    if (queue.empty()) {
+Job *JobPool::GetNextJob(JobQueue *own, const std::atomic_bool &stopped) {
+    Job *req = TakeJob(own);
+    if (req == nullptr) {
+        std::unique_lock<std::mutex> mutLock(queueLock);
         idleThreads++;
-        signal.wait_for(mutLock, std::chrono::milliseconds(30000));
+        signal.wait_for(mutLock, std::chrono::milliseconds(30000), [this, &stopped] { return pendingJobs > 0 || stopped; });
         idleThreads--;
-    }
-    if ( !queue.empty() ) {
-        req = queue.front();
-        queue.pop_front();
+        mutLock.unlock();
+        req = TakeJob(own);
     }
     return req;
 }
 
+bool JobPool::RunPendingJob()
+{
+    Job *job = TakeJob(GetCurrentQueue());
+    if (job == nullptr) {
+        return false;
+    }
+    bool deleteWhenComplete = job->DeleteWhenComplete();
+    try {
+        job->Process();
+    } catch (...) {
+        //nothing
+    }
+    if (deleteWhenComplete) {
+        delete job;
+    }
+    --inFlight;
+    return true;
+}
+
 void JobPool::PushJob(Job *job)
 {
-	std::unique_lock<std::mutex> locker(queueLock);
-    queue.push_back(job);
-    inFlight++;
-    
+    PushJobs(job, 1);
+}
+
+void JobPool::PushJobs(Job *job, int copies)
+{
+    if (copies <= 0) return;
+
+    JobQueue *own = GetCurrentQueue();
+    if (own != nullptr) {
+        own->Push(job, copies);
+    } else {
+        queue.Push(job, copies);
+    }
+    inFlight += copies;
+    pendingJobs += copies;
+
     int count = inFlight;
     count -= idleThreads;
     count -= numThreads;
     count = std::min(count, maxNumThreads - numThreads);
-    locker.unlock();
     
     if (count > 0) {
         LockThreads();
@@ -363,7 +509,16 @@ void JobPool::PushJob(Job *job)
         }
         UnlockThreads();
     }
-    signal.notify_one();
+    if (idleThreads > 0) {
+        // taking the lock makes sure an idle worker is either waiting or will see pendingJobs
+        std::unique_lock<std::mutex> locker(queueLock);
+        locker.unlock();
+        if (copies == 1) {
+            signal.notify_one();
+        } else {
+            signal.notify_all();
+        }
+    }
 }
 
 void JobPool::Start(size_t poolSize, size_t minPoolSize)
@@ -377,6 +532,13 @@ void JobPool::Start(size_t poolSize, size_t minPoolSize)
     minNumThreads = minPoolSize < 4 ? 4 : minPoolSize;
     idleThreads = 0;
     numThreads = 0;
+
+    // the worker queues are read without the thread lock so they can only be created before any jobs are pushed
+    LockThreads();
+    while (workerQueues.size() < (size_t)maxNumThreads) {
+        workerQueues.push_back(new JobQueue());
+    }
+    UnlockThreads();
     logger_jobpool.info("Background thread pool started with %d threads", poolSize);
 }
 
@@ -389,6 +551,9 @@ void JobPool::Stop()
     
     while (!threads.empty()) {
         UnlockThreads();
+        {
+            std::unique_lock<std::mutex> locker(queueLock);
+        }
         signal.notify_all();
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
         LockThreads();
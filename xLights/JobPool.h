@@ -31,6 +31,25 @@ public:
 };
 
 
+// Jobs waiting to run. The storage is a ring buffer that is reused once it has grown so pushing
+// jobs does not allocate. The owning worker pops from the back, everyone else takes from the front.
+class JobQueue
+{
+    std::mutex lock;
+    std::vector<Job*> jobs;
+    size_t head;
+    std::atomic_int count;
+public:
+    JobQueue() : head(0), count(0), inUse(false) {}
+
+    void Push(Job *job, int copies = 1);
+    Job *PopFront();
+    Job *PopBack();
+    bool Empty() const { return count == 0; }
+
+    bool inUse;
+};
+
 class JobPoolWorker;
 class JobPool
 {
@@ -38,10 +57,12 @@ class JobPool
     std::mutex queueLock;
     std::condition_variable signal;
     std::vector<JobPoolWorker*> threads;
-    std::deque<Job*> queue;
+    JobQueue queue; // jobs pushed from threads outside the pool
+    std::vector<JobQueue*> workerQueues; // one per worker, jobs pushed by the worker itself
     std::atomic_int numThreads;
     std::atomic_int idleThreads;
     std::atomic_int inFlight;
+    std::atomic_int pendingJobs;
     std::string threadNameBase;
 
     int maxNumThreads;
@@ -51,6 +72,10 @@ public:
     virtual ~JobPool();
     
     virtual void PushJob(Job *job);
+    // queue the same job to be processed multiple times, the job must cope with concurrent calls to Process
+    virtual void PushJobs(Job *job, int copies);
+    // take a queued job and run it on the calling thread, used to help rather than spin while waiting for jobs
+    bool RunPendingJob();
     int size() const { return (int)threads.size(); }
     int maxSize() const { return maxNumThreads; }
     virtual void Start(size_t poolSize = 1, size_t minPoolSize = 0);
@@ -63,5 +88,9 @@ private:
     void RemoveWorker(JobPoolWorker*);
     void LockThreads();
     void UnlockThreads();
-    Job *GetNextJob();
+    JobQueue *ClaimQueue();
+    void ReleaseQueue(JobQueue *q);
+    JobQueue *GetCurrentQueue() const;
+    Job *TakeJob(JobQueue *own);
+    Job *GetNextJob(JobQueue *own, const std::atomic_bool &stopped);
 };
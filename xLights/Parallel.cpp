@@ -37,52 +37,94 @@ int ParallelJobPool::calcSteps(int minStep, int total) {
     return 1;
 }
 
+int ParallelJobPool::calcGrain(int minStep, int total) {
+    int steps = calcSteps(minStep, total);
+    if (steps == 1) {
+        return std::max(total, 1);
+    }
+    // do about 5% of each thread's share at a time, reduces contention on the atomic_int yet keeps unit of
+    // work small enough to allow work stealing for faster cores/threads
+    int grain = total / (steps * 20);
+    return std::max(grain, 1);
+}
+
 ParallelJobPool ParallelJobPool::POOL;
 
 
 class ParallelJob : public Job {
     int max;
-    std::function<void(int)>& func;
+    std::function<void(int, int)>& func;
     std::atomic_int &doneCount;
     std::atomic_int &iteration;
     const int calcSteps;
     const int blockSize;
 public:
-    ParallelJob(int m, std::function<void(int)>& f,
+    ParallelJob(int m, std::function<void(int, int)>& f,
                 std::atomic_int &dc,
                 std::atomic_int &it,
                 int cs,
                 int bs)
         : max(m), func(f), iteration(it), doneCount(dc), calcSteps(cs), blockSize(bs) {}
     virtual ~ParallelJob() {};
+    // the same job is queued once per step and processed concurrently so it must not modify itself
     virtual void Process() override {
         try {
             int x;
-            if (blockSize > 1) {
-                while ((x = iteration.fetch_add(blockSize, std::memory_order_relaxed)) < max) {
-                    int newM = std::min(x + blockSize, max);
-                    while (x < newM) {
-                        func(x);
-                        x++;
-                    }
-                }
-            } else {
-                while ((x = iteration.fetch_add(1, std::memory_order_relaxed)) < max) {
-                    func(x);
-                }
+            while ((x = iteration.fetch_add(blockSize, std::memory_order_relaxed)) < max) {
+                func(x, std::min(x + blockSize, max));
             }
         } catch (...) {
             //nothing
         }
+        // the job lives on the waiting thread's stack so nothing in it can be used once doneCount is updated
+        int steps = calcSteps;
         int newDoneCount = ++doneCount;
-        if (newDoneCount >= calcSteps) {
-            ParallelJobPool::POOL.poolSignal.notify_all();
+        if (newDoneCount >= steps) {
+            ParallelJobPool::POOL.NotifyDone();
         }
     };
-    virtual bool DeleteWhenComplete() override { return true; };
     virtual bool SetThreadName() override { return false; }
 };
 
+void ParallelJobPool::NotifyDone() {
+    std::unique_lock<std::mutex> lock(poolLock);
+    poolSignal.notify_all();
+}
+
+void ParallelJobPool::WaitForDone(std::atomic_int &doneCount, int steps) {
+    while (doneCount < steps) {
+        // rather than sleep, run any queued jobs, likely the remaining steps of our own loop
+        if (!RunPendingJob()) {
+            std::unique_lock<std::mutex> lock(poolLock);
+            poolSignal.wait_for(lock, std::chrono::milliseconds(1), [&doneCount, steps] { return doneCount >= steps; });
+        }
+    }
+}
+
+void parallel_for_range(int min, int max, std::function<void(int, int)>&& func, int minStep, int grain) {
+    if (max <= min) {
+        return;
+    }
+    int calcSteps = ParallelJobPool::POOL.calcSteps(minStep, max - min);
+    if (grain <= 0) {
+        grain = ParallelJobPool::POOL.calcGrain(minStep, max - min);
+    }
+    if (calcSteps == 1) {
+        for (int x = min; x < max; x += grain) {
+            func(x, std::min(x + grain, max));
+        }
+    } else {
+        std::function<void(int, int)> f(func);
+        std::atomic_int doneCount(0);
+        std::atomic_int iteration(min);
+
+        ParallelJob job(max, f, doneCount, iteration, calcSteps, grain);
+        ParallelJobPool::POOL.PushJobs(&job, calcSteps - 1);
+        job.Process();
+        ParallelJobPool::POOL.WaitForDone(doneCount, calcSteps);
+    }
+}
+
 void parallel_for(int min, int max, std::function<void(int)>&& func, int minStep) {
     int calcSteps = ParallelJobPool::POOL.calcSteps(minStep, max - min);
     if (calcSteps == 1) {
@@ -90,22 +132,10 @@ void parallel_for(int min, int max, std::function<void(int)>&& func, int minStep
             func(x);
         }
     } else {
-        std::function<void(int)> f(func);
-        std::atomic_int doneCount = 0;
-        std::atomic_int iteration(min);
-        
-        // do about 5% at a time, reduces contention on the atomic_int yet keeps unit of
-        // work small enough to allow work stealing for faster cores/threads
-        int blockSize = (max - min) / (calcSteps * 20);
-        if (blockSize < 1) blockSize = 1;
-        for (int x = 0; x < calcSteps-1; x++) {
-            ParallelJobPool::POOL.PushJob(new ParallelJob(max, f, doneCount, iteration, calcSteps, blockSize));
-        }
-        ParallelJob(max, f, doneCount, iteration, calcSteps, blockSize).Process();
-        std::unique_lock<std::mutex> lock(ParallelJobPool::POOL.poolLock);
-        while (doneCount < calcSteps) {
-            ParallelJobPool::POOL.poolSignal.wait_for(lock, std::chrono::nanoseconds(1000000));
-        }
+        parallel_for_range(min, max, [&func](int begin, int end) {
+            for (int x = begin; x < end; x++) {
+                func(x);
+            }
+        }, minStep);
     }
 }
-
@@ -12,6 +12,7 @@
 
 #include <functional>
 #include <list>
+#include <vector>
 #include <mutex>
 #include <thread>
 
@@ -25,7 +26,14 @@ public:
     static ParallelJobPool POOL;
     
     int calcSteps(int minStep, int size);
-    
+    // number of iterations each thread claims at a time, small enough that faster threads pick up the
+    // slack from slower ones but large enough to keep contention on the shared counter low
+    int calcGrain(int minStep, int size);
+
+    // called by the last step of a parallel loop to wake the thread waiting on it
+    void NotifyDone();
+    // help process queued jobs until doneCount reaches steps
+    void WaitForDone(std::atomic_int &doneCount, int steps);
     
     std::mutex poolLock;
     std::condition_variable poolSignal;
@@ -42,6 +50,36 @@ public:
 void parallel_for(int start, int max, std::function<void(int)>&& f, int minStep = 1);
 
 
+/**
+ * Same as parallel_for but f is called once per chunk of iterations [begin, end) so per iteration
+ * overhead can be hoisted out of the loop:
+ * parallel_for_range(start, max, [&] (int begin, int end) { for (int x = begin; x < end; ++x) { ... use x ...} });
+ *
+ * Chunks start at start + n * grain. If grain is 0 it is calculated from the size of the range.
+ */
+void parallel_for_range(int start, int max, std::function<void(int, int)>&& f, int minStep = 1, int grain = 0);
+
+
+/**
+ * Traditional for loop:
+ * std::vector<T> vec;
+ * for(int idx = 0; idx < vec.size(); ++idx) { T &t = vec[idx]; ... use t and idx ...}
+ *
+ * would convert to:
+ * std::function<void(T&, int)> f = [&](T &t, int idx) { ... use t and idx...}
+ * parallel_for(vec, f);
+ */
+template <typename T>
+void parallel_for(std::vector<T> &vec, std::function<void(T&, int)>& f, int minStep = 1) {
+    T *data = vec.data();
+    parallel_for_range(0, (int)vec.size(), [data, &f](int begin, int end) {
+        for (int idx = begin; idx < end; ++idx) {
+            f(data[idx], idx);
+        }
+    }, minStep);
+}
+
+
 /**
  * Traditional for loop:
  * std::list<T> list;
@@ -52,47 +90,11 @@ void parallel_for(int start, int max, std::function<void(int)>&& f, int minStep
  * std::list<T> list;
  * std::function<void(T&, int)> f = [&](T &t, int idx) { ... use t and idx...}
  * parallel_for(list, f);
+ *
+ * The list is copied into a vector of pointers first so prefer a std::vector where possible.
  */
 template <typename T>
 void parallel_for(std::list<T> &list, std::function<void(T&, int)>& f, int minStep = 1) {
-    class ParallelListJob : public Job {
-        std::atomic_int &doneCount;
-        std::function<void(T&, int)>& func;
-        std::mutex &lock;
-        std::atomic_int &index;
-        typename std::list<T>::iterator &iterator;
-        const int max;
-    public:
-        ParallelListJob(std::atomic_int &dc,
-                        std::function<void(T&, int)>& f,
-                        typename std::list<T>::iterator &it,
-                        std::mutex &l,
-                        std::atomic_int &idx,
-                        int m)
-            : Job(), doneCount(dc), func(f), iterator(it), lock(l), index(idx), max(m) {}
-        void Process() {
-            try {
-                while (true) {
-                    lock.lock();
-                    int idx = index.fetch_add(1);
-                    if (idx < max) {
-                        T &t = *iterator;
-                        ++iterator;
-                        lock.unlock();
-                        func(t, idx);
-                    } else {
-                        lock.unlock();
-                        doneCount++;
-                        return;
-                    }
-                }
-            } catch (...) {
-                //nothing
-                doneCount++;
-            }
-        }
-    };
-    
     int size = list.size();
     int calcSteps = ParallelJobPool::POOL.calcSteps(minStep, size);
     if (calcSteps == 1) {
@@ -102,18 +104,75 @@ void parallel_for(std::list<T> &list, std::function<void(T&, int)>& f, int minSt
             idx++;
         }
     } else {
-        std::atomic_int doneCount(0);
-        std::mutex lock;
-        std::atomic_int idx(0);
-        typename std::list<T>::iterator it = list.begin();
-        
-        for (int x = 0; x < calcSteps-1; x++) {
-            ParallelJobPool::POOL.PushJob(new ParallelListJob(doneCount, f, it, lock, idx, size));
-        }
-        ParallelListJob(doneCount, f, it, lock, idx, size).Process();
-        while (doneCount < calcSteps) {
-            std::this_thread::yield();
+        std::vector<T*> items;
+        items.reserve(size);
+        for (auto &a : list) {
+            items.push_back(&a);
         }
+        T **data = items.data();
+        parallel_for_range(0, size, [data, &f](int begin, int end) {
+            for (int idx = begin; idx < end; ++idx) {
+                f(*data[idx], idx);
+            }
+        }, minStep);
+    }
+}
+
+
+/**
+ * Traditional loop:
+ * R result = identity;
+ * for(int x = start; x < max; ++x) { result = ... combine x into result ...}
+ *
+ * would convert to:
+ * R result = parallel_reduce<R>(start, max, identity,
+ *     [&](int begin, int end, R r) { for (int x = begin; x < end; ++x) { ... combine x into r ...} return r; },
+ *     [](const R &a, const R &b) { return ... a combined with b ...; });
+ *
+ * The chunk results are combined in order so the result does not depend on how the threads ran.
+ */
+template <typename R>
+R parallel_reduce(int start, int max, const R &identity,
+                  std::function<R(int, int, R)>&& f,
+                  std::function<R(const R&, const R&)>&& combine,
+                  int minStep = 1) {
+    if (max <= start) {
+        return identity;
+    }
+    int grain = ParallelJobPool::POOL.calcGrain(minStep, max - start);
+    int chunks = (max - start + grain - 1) / grain;
+    if (chunks == 1) {
+        return f(start, max, identity);
+    }
+    std::vector<R> partials(chunks, identity);
+    parallel_for_range(start, max, [start, grain, &partials, &f, &identity](int begin, int end) {
+        partials[(begin - start) / grain] = f(begin, end, identity);
+    }, minStep, grain);
+
+    R result = identity;
+    for (const auto &p : partials) {
+        result = combine(result, p);
     }
+    return result;
 }
 
+
+/**
+ * Traditional loop:
+ * out.resize(in.size());
+ * for(size_t x = 0; x < in.size(); ++x) { out[x] = ... in[x] ...; }
+ *
+ * would convert to:
+ * parallel_transform<In, Out>(in, out, [](const In &i) { return ... i ...; });
+ */
+template <typename In, typename Out>
+void parallel_transform(const std::vector<In> &in, std::vector<Out> &out, std::function<Out(const In&)>&& f, int minStep = 1) {
+    out.resize(in.size());
+    const In *src = in.data();
+    Out *dest = out.data();
+    parallel_for_range(0, (int)in.size(), [src, dest, &f](int begin, int end) {
+        for (int x = begin; x < end; ++x) {
+            dest[x] = f(src[x]);
+        }
+    }, minStep);
+}
@@ -20,10 +20,13 @@
 #include <log4cpp/Category.hh>
 
 #include <cmath>
+#include <algorithm>
 #include <random>
+#include <typeinfo>
 #include "Parallel.h"
 #include "UtilFunctions.h"
 #include "DissolveTransitionPattern.h"
+#include "CPUFeatures.h"
 
 // This is needed for visual studio
 #ifdef _MSC_VER
@@ -719,10 +722,10 @@ void PixelBufferClass::reset(int nlayers, int timing, bool isNode)
         if (x == (numLayers-1)) {
             // for the model "blend" layer, use the "Single Line" style so none of the nodes will overlap with others
             // in the renderbuff which can occur if the group defaults to per-preview or similar
-            model->InitRenderBufferNodes("Single Line", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
+            model->GetRenderBufferNodes("Single Line", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
             layers[x]->bufferType = "Single Line";
         } else {
-            model->InitRenderBufferNodes("Default", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
+            model->GetRenderBufferNodes("Default", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
             layers[x]->bufferType = "Default";
         }
         layers[x]->camera = "2D";
@@ -754,6 +757,50 @@ void PixelBufferClass::reset(int nlayers, int timing, bool isNode)
         layers[x]->ModelBufferHt = layers[x]->BufferHt;
         layers[x]->ModelBufferWi = layers[x]->BufferWi;
         layers[x]->buffer.InitBuffer(layers[x]->BufferHt, layers[x]->BufferWi, layers[x]->ModelBufferHt, layers[x]->ModelBufferWi, layers[x]->bufferTransform, isNode);
+        UpdateNodeTables(x);
+    }
+}
+
+void PixelBufferClass::UpdateNodeTables(int layer)
+{
+    layers[layer]->buffer.UpdateNodeCoords();
+    if (layer != 0) {
+        return;
+    }
+
+    const std::vector<NodeBaseClassPtr> &nodes = layers[0]->buffer.Nodes;
+    size_t count = nodes.size();
+    nodeOutput.startChannel.resize(count);
+    nodeOutput.type.resize(count);
+    nodeOutput.offsets.resize(count * 4);
+    nodeOutput.modelRuns.clear();
+    nodeOutput.sparkle.resize(count);
+    nodeOutput.colors.assign(count, xlBLACK);
+    for (size_t n = 0; n < count; ++n) {
+        const NodeBaseClass *node = nodes[n].get();
+        const std::type_info &nodeClass = typeid(*node);
+        uint8_t *offsets = &nodeOutput.offsets[n * 4];
+        for (int x = 0; x < 3; ++x) {
+            offsets[x] = node->GetChannelOffset(x);
+        }
+        offsets[3] = 0;
+        nodeOutput.startChannel[n] = node->ActChan;
+        nodeOutput.sparkle[n] = node->sparkle;
+        if (nodeOutput.modelRuns.empty() || nodeOutput.modelRuns.back().second != node->model) {
+            nodeOutput.modelRuns.emplace_back((uint32_t)n, node->model);
+        }
+        if (nodeClass == typeid(NodeBaseClass) && offsets[0] < 3 && offsets[1] < 3 && offsets[2] < 3) {
+            nodeOutput.type[n] = NodeOutputType::RGB;
+        } else if (nodeClass == typeid(NodeClassRGBW)) {
+            const NodeClassRGBW *rgbw = static_cast<const NodeClassRGBW*>(node);
+            nodeOutput.type[n] = NodeOutputType::RGBW;
+            offsets[3] = rgbw->GetRGBWHandling() | (rgbw->IsWhiteLast() ? RGBW_WHITE_LAST : 0);
+        } else if (nodeClass == typeid(NodeClassRed) || nodeClass == typeid(NodeClassGreen) || nodeClass == typeid(NodeClassBlue)) {
+            nodeOutput.type[n] = NodeOutputType::SINGLE_COLOR;
+            offsets[0] = offsets[0] == 0 ? 0 : (offsets[1] == 0 ? 1 : 2);
+        } else {
+            nodeOutput.type[n] = NodeOutputType::OTHER;
+        }
     }
 }
 
@@ -763,7 +810,7 @@ void PixelBufferClass::InitPerModelBuffers(const ModelGroup &model, int layer, i
         wxASSERT(m != nullptr);
         RenderBuffer* buf = new RenderBuffer(frame);
         buf->SetFrameTimeInMs(timing);
-        m->InitRenderBufferNodes("Default", "2D", "None", buf->Nodes, buf->BufferWi, buf->BufferHt);
+        m->GetRenderBufferNodes("Default", "2D", "None", buf->Nodes, buf->BufferWi, buf->BufferHt);
         buf->InitBuffer(buf->BufferHt, buf->BufferWi, buf->BufferHt, buf->BufferWi, "None");
         layers[layer]->modelBuffers.push_back(std::unique_ptr<RenderBuffer>(buf));
     }
@@ -817,20 +864,37 @@ void PixelBufferClass::Clear(int which)
     }
 }
 
+// the layer 0 colours are kept in nodeOutput, the node objects are only used to convert to and from channels
 void PixelBufferClass::GetNodeChannelValues(size_t nodenum, unsigned char *buf)
 {
-    layers[0]->buffer.Nodes[nodenum]->GetForChannels(buf);
+    NodeBaseClass *node = layers[0]->buffer.Nodes[nodenum].get();
+    if (nodenum < nodeOutput.colors.size()) {
+        node->SetColor(nodeOutput.colors[nodenum]);
+    }
+    node->GetForChannels(buf);
 }
 void PixelBufferClass::SetNodeChannelValues(size_t nodenum, const unsigned char *buf)
 {
-    layers[0]->buffer.Nodes[nodenum]->SetFromChannels(buf);
+    NodeBaseClass *node = layers[0]->buffer.Nodes[nodenum].get();
+    node->SetFromChannels(buf);
+    if (nodenum < nodeOutput.colors.size()) {
+        node->GetColor(nodeOutput.colors[nodenum]);
+    }
 }
 xlColor PixelBufferClass::GetNodeColor(size_t nodenum) const
 {
+    if (nodenum < nodeOutput.colors.size()) {
+        return nodeOutput.colors[nodenum];
+    }
     xlColor color;
     layers[0]->buffer.Nodes[nodenum]->GetColor(color);
     return color;
 }
+void PixelBufferClass::CopyNodeColorsToPixels(int layer, std::vector<bool> &done)
+{
+    RenderBuffer &buffer = layers[layer]->buffer;
+    buffer.CopyNodeColorsToPixels(done, layer == 0 && nodeOutput.colors.size() == buffer.Nodes.size() ? nodeOutput.colors.data() : nullptr);
+}
 xlColor PixelBufferClass::GetNodeMaskColor(size_t nodenum) const
 {
     xlColor color;
@@ -906,10 +970,359 @@ double ColourDistance(xlColor e1, xlColor e2)
     return sqrt((((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8));
 }
 
-void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer)
+#pragma region Mix Kernels
+// Span versions of the layer mix types that only look at the colour bytes. Each works on whole arrays of fg and
+// bg colours and must give exactly what mixColors gives one node at a time. threshold is the smallest
+// max(r, g, b) whose HSV value is above the layer's effect mix threshold, so no HSV conversion is needed.
+static_assert(sizeof(xlColor) == 4, "the mix kernels treat an xlColor as one 32 bit word");
+
+typedef void (*MIXSPANFUNCTION)(const xlColor *fg, xlColor *bg, int n, int threshold);
+
+static inline int MaxRGB(const xlColor &c) { return std::max(c.red, std::max(c.green, c.blue)); }
+
+static int MixValueThreshold(float threshold)
+{
+    if (threshold >= 1.0f) {
+        return 256;
+    }
+    int t = std::max(0, (int)(threshold * 255.0f) - 1);
+    while (t < 256 && !(t / 255.0 > threshold)) {
+        ++t;
+    }
+    return t;
+}
+
+#ifdef CPU_SSE2
+static inline __m128i SelectSSE2(__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+static inline __m128i BlackSSE2(__m128i p) { return _mm_cmpeq_epi32(_mm_and_si128(p, _mm_set1_epi32(0x00FFFFFF)), _mm_setzero_si128()); }
+static inline __m128i OpaqueSSE2(__m128i p) { return _mm_or_si128(p, _mm_set1_epi32((int)0xFF000000)); }
+// sets FFFFFFFF for pixels whose largest colour component is above threshold, which is passed less one
+static inline __m128i AboveSSE2(__m128i p, __m128i threshold)
+{
+    __m128i m = _mm_max_epu8(p, _mm_srli_epi32(p, 8));
+    m = _mm_and_si128(_mm_max_epu8(m, _mm_srli_epi32(p, 16)), _mm_set1_epi32(0xFF));
+    return _mm_cmpgt_epi32(m, threshold);
+}
+#endif
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static inline __m256i SelectAVX2(__m256i mask, __m256i a, __m256i b) { return _mm256_or_si256(_mm256_and_si256(mask, a), _mm256_andnot_si256(mask, b)); }
+CPU_AVX2_TARGET static inline __m256i BlackAVX2(__m256i p) { return _mm256_cmpeq_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0x00FFFFFF)), _mm256_setzero_si256()); }
+CPU_AVX2_TARGET static inline __m256i OpaqueAVX2(__m256i p) { return _mm256_or_si256(p, _mm256_set1_epi32((int)0xFF000000)); }
+CPU_AVX2_TARGET static inline __m256i AboveAVX2(__m256i p, __m256i threshold)
+{
+    __m256i m = _mm256_max_epu8(p, _mm256_srli_epi32(p, 8));
+    m = _mm256_and_si256(_mm256_max_epu8(m, _mm256_srli_epi32(p, 16)), _mm256_set1_epi32(0xFF));
+    return _mm256_cmpgt_epi32(m, threshold);
+}
+#endif
+
+struct NormalMix
+{
+    // the layer's fade has already been applied to fg's alpha
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int) { bg.AlphaBlendForgroundOnto(fg); }
+    // AlphaBlendForgroundOnto in single precision with the same operations in the same order. An alpha of 0
+    // leaves the colour as it was, 255 also makes bg opaque. This only matches while the compiler is not fusing
+    // the scalar multiply and add, which it wont without FMA enabled in the build flags.
+#ifdef CPU_SSE2
+    static inline __m128i BlendSSE2(__m128i f, __m128i b)
+    {
+        __m128 fp = _mm_cvtepi32_ps(f);
+        __m128 a = _mm_div_ps(_mm_shuffle_ps(fp, fp, _MM_SHUFFLE(3, 3, 3, 3)), _mm_set1_ps(255.0f));
+        __m128 d = _mm_add_ps(_mm_mul_ps(fp, a), _mm_mul_ps(_mm_cvtepi32_ps(b), _mm_sub_ps(_mm_set1_ps(1.0f), a)));
+        return _mm_cvttps_epi32(d);
+    }
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i)
+    {
+        __m128i z = _mm_setzero_si128();
+        __m128i f0 = _mm_unpacklo_epi8(f, z);
+        __m128i f1 = _mm_unpackhi_epi8(f, z);
+        __m128i b0 = _mm_unpacklo_epi8(b, z);
+        __m128i b1 = _mm_unpackhi_epi8(b, z);
+        __m128i d0 = _mm_packs_epi32(BlendSSE2(_mm_unpacklo_epi16(f0, z), _mm_unpacklo_epi16(b0, z)),
+                                     BlendSSE2(_mm_unpackhi_epi16(f0, z), _mm_unpackhi_epi16(b0, z)));
+        __m128i d1 = _mm_packs_epi32(BlendSSE2(_mm_unpacklo_epi16(f1, z), _mm_unpacklo_epi16(b1, z)),
+                                     BlendSSE2(_mm_unpackhi_epi16(f1, z), _mm_unpackhi_epi16(b1, z)));
+        __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        __m128i opaque = _mm_cmpeq_epi32(_mm_and_si128(f, alphaMask), alphaMask);
+        __m128i alpha = SelectSSE2(opaque, alphaMask, _mm_and_si128(b, alphaMask));
+        return _mm_or_si128(_mm_andnot_si128(alphaMask, _mm_packus_epi16(d0, d1)), alpha);
+    }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i BlendAVX2(__m256i f, __m256i b)
+    {
+        __m256 fp = _mm256_cvtepi32_ps(f);
+        __m256 a = _mm256_div_ps(_mm256_shuffle_ps(fp, fp, _MM_SHUFFLE(3, 3, 3, 3)), _mm256_set1_ps(255.0f));
+        __m256 d = _mm256_add_ps(_mm256_mul_ps(fp, a), _mm256_mul_ps(_mm256_cvtepi32_ps(b), _mm256_sub_ps(_mm256_set1_ps(1.0f), a)));
+        return _mm256_cvttps_epi32(d);
+    }
+    // the unpacks and packs work within each 128 bit half so the pixels come back out in the order they went in
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i)
+    {
+        __m256i z = _mm256_setzero_si256();
+        __m256i f0 = _mm256_unpacklo_epi8(f, z);
+        __m256i f1 = _mm256_unpackhi_epi8(f, z);
+        __m256i b0 = _mm256_unpacklo_epi8(b, z);
+        __m256i b1 = _mm256_unpackhi_epi8(b, z);
+        __m256i d0 = _mm256_packs_epi32(BlendAVX2(_mm256_unpacklo_epi16(f0, z), _mm256_unpacklo_epi16(b0, z)),
+                                        BlendAVX2(_mm256_unpackhi_epi16(f0, z), _mm256_unpackhi_epi16(b0, z)));
+        __m256i d1 = _mm256_packs_epi32(BlendAVX2(_mm256_unpacklo_epi16(f1, z), _mm256_unpacklo_epi16(b1, z)),
+                                        BlendAVX2(_mm256_unpackhi_epi16(f1, z), _mm256_unpackhi_epi16(b1, z)));
+        __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+        __m256i opaque = _mm256_cmpeq_epi32(_mm256_and_si256(f, alphaMask), alphaMask);
+        __m256i alpha = SelectAVX2(opaque, alphaMask, _mm256_and_si256(b, alphaMask));
+        return _mm256_or_si256(_mm256_andnot_si256(alphaMask, _mm256_packus_epi16(d0, d1)), alpha);
+    }
+#endif
+};
+
+struct AdditiveMix
+{
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int)
+    {
+        bg.Set(std::min(fg.red + bg.red, 255), std::min(fg.green + bg.green, 255), std::min(fg.blue + bg.blue, 255));
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i) { return OpaqueSSE2(_mm_adds_epu8(f, b)); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i) { return OpaqueAVX2(_mm256_adds_epu8(f, b)); }
+#endif
+};
+
+struct SubtractiveMix
+{
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int)
+    {
+        bg.Set(std::max(bg.red - fg.red, 0), std::max(bg.green - fg.green, 0), std::max(bg.blue - fg.blue, 0));
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i) { return OpaqueSSE2(_mm_subs_epu8(b, f)); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i) { return OpaqueAVX2(_mm256_subs_epu8(b, f)); }
+#endif
+};
+
+struct MinMix
+{
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int)
+    {
+        bg.Set(std::min(fg.red, bg.red), std::min(fg.green, bg.green), std::min(fg.blue, bg.blue));
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i) { return OpaqueSSE2(_mm_min_epu8(f, b)); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i) { return OpaqueAVX2(_mm256_min_epu8(f, b)); }
+#endif
+};
+
+struct MaxMix
+{
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int)
+    {
+        bg.Set(std::max(fg.red, bg.red), std::max(fg.green, bg.green), std::max(fg.blue, bg.blue));
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i) { return OpaqueSSE2(_mm_max_epu8(f, b)); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i) { return OpaqueAVX2(_mm256_max_epu8(f, b)); }
+#endif
+};
+
+struct AverageMix
+{
+    // only average when both colors are non-black
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int)
+    {
+        if (bg == xlBLACK) {
+            bg = fg;
+        } else if (fg != xlBLACK) {
+            bg.Set((fg.Red() + bg.Red()) / 2, (fg.Green() + bg.Green()) / 2, (fg.Blue() + bg.Blue()) / 2);
+        }
+    }
+    // avg_epu8 rounds up so take off the carry where the sum is odd to match the scalar truncation
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i)
+    {
+        __m128i odd = _mm_and_si128(_mm_xor_si128(f, b), _mm_set1_epi8(1));
+        __m128i avg = OpaqueSSE2(_mm_sub_epi8(_mm_avg_epu8(f, b), odd));
+        return SelectSSE2(BlackSSE2(b), f, SelectSSE2(BlackSSE2(f), b, avg));
+    }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i)
+    {
+        __m256i odd = _mm256_and_si256(_mm256_xor_si256(f, b), _mm256_set1_epi8(1));
+        __m256i avg = OpaqueAVX2(_mm256_sub_epi8(_mm256_avg_epu8(f, b), odd));
+        return SelectAVX2(BlackAVX2(b), f, SelectAVX2(BlackAVX2(f), b, avg));
+    }
+#endif
+};
+
+struct Mask1Mix
+{
+    // first masks second
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int threshold)
+    {
+        if (MaxRGB(fg) >= threshold) {
+            bg.Set(0, 0, 0);
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i t) { return SelectSSE2(AboveSSE2(f, t), _mm_set1_epi32((int)0xFF000000), b); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i t) { return SelectAVX2(AboveAVX2(f, t), _mm256_set1_epi32((int)0xFF000000), b); }
+#endif
+};
+
+struct Mask2Mix
+{
+    // second masks first
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int threshold)
+    {
+        if (MaxRGB(bg) < threshold) {
+            bg = fg;
+        } else {
+            bg.Set(0, 0, 0);
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i t) { return SelectSSE2(AboveSSE2(b, t), _mm_set1_epi32((int)0xFF000000), f); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i t) { return SelectAVX2(AboveAVX2(b, t), _mm256_set1_epi32((int)0xFF000000), f); }
+#endif
+};
+
+struct LayeredMix
+{
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int threshold)
+    {
+        if (MaxRGB(bg) < threshold) {
+            bg = fg;
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i t) { return SelectSSE2(AboveSSE2(b, t), b, f); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i t) { return SelectAVX2(AboveAVX2(b, t), b, f); }
+#endif
+};
+
+struct Reveals1Mix
+{
+    // effect 1 shows where it is non black
+    static inline void Scalar(const xlColor &fg, xlColor &bg, int threshold)
+    {
+        if (MaxRGB(fg) >= threshold) {
+            bg = fg;
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i f, __m128i b, __m128i t) { return SelectSSE2(AboveSSE2(f, t), f, b); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i f, __m256i b, __m256i t) { return SelectAVX2(AboveAVX2(f, t), f, b); }
+#endif
+};
+
+#ifdef CPU_AVX2
+template <class OP>
+CPU_AVX2_TARGET static int MixSpanAVX2(const xlColor *fg, xlColor *bg, int n, int threshold)
+{
+    __m256i t = _mm256_set1_epi32(threshold - 1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i f = _mm256_loadu_si256((const __m256i*)(fg + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(bg + i));
+        _mm256_storeu_si256((__m256i*)(bg + i), OP::AVX2(f, b, t));
+    }
+    return i;
+}
+#endif
+
+#ifdef CPU_SSE2
+template <class OP>
+static int MixSpanSSE2(const xlColor *fg, xlColor *bg, int n, int threshold, int i)
+{
+    __m128i t = _mm_set1_epi32(threshold - 1);
+    for (; i + 4 <= n; i += 4) {
+        __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+        _mm_storeu_si128((__m128i*)(bg + i), OP::SSE2(f, b, t));
+    }
+    return i;
+}
+#endif
+
+template <class OP>
+static void MixSpan(const xlColor *fg, xlColor *bg, int n, int threshold)
+{
+    int i = 0;
+#ifdef CPU_AVX2
+    if (CPUFeatures::UseAVX2()) {
+        i = MixSpanAVX2<OP>(fg, bg, n, threshold);
+    }
+#endif
+#ifdef CPU_SSE2
+    if (CPUFeatures::UseSSE2()) {
+        i = MixSpanSSE2<OP>(fg, bg, n, threshold, i);
+    }
+#endif
+    for (; i < n; ++i) {
+        OP::Scalar(fg[i], bg[i], threshold);
+    }
+}
+
+// nullptr for the mix types which have no span kernel
+static MIXSPANFUNCTION GetMixSpanFunction(MixTypes mixType)
+{
+    switch (mixType) {
+    case Mix_Normal: return MixSpan<NormalMix>;
+    case Mix_Additive: return MixSpan<AdditiveMix>;
+    case Mix_Subtractive: return MixSpan<SubtractiveMix>;
+    case Mix_Min: return MixSpan<MinMix>;
+    case Mix_Max: return MixSpan<MaxMix>;
+    case Mix_Average: return MixSpan<AverageMix>;
+    case Mix_Mask1: return MixSpan<Mask1Mix>;
+    case Mix_Mask2: return MixSpan<Mask2Mix>;
+    case Mix_Layered: return MixSpan<LayeredMix>;
+    case Mix_1_reveals_2: return MixSpan<Reveals1Mix>;
+    case Mix_2_reveals_1: return MixSpan<LayeredMix>; // effect 2 shows where it is non black, the same as layered
+    default: return nullptr;
+    }
+}
+#pragma endregion
+
+void PixelBufferClass::GetEffectMixFactors(int layer, double &emt, double &emtNot) const
 {
     static const int n = 0;  //increase to change the curve of the crossfade
 
+    float effectMixThreshold = layers[layer]->outputEffectMixThreshold;
+    if (!layers[layer]->effectMixVaries) {
+        emt = effectMixThreshold;
+        if ((emt > 0.000001) && (emt < 0.99999)) {
+            emtNot = 1 - effectMixThreshold;
+            //make cross-fade linear
+            emt = cos((M_PI/4)*(pow(2*emt-1,2*n+1)+1));
+            emtNot = cos((M_PI/4)*(pow(2*emtNot-1,2*n+1)+1));
+        } else {
+            emtNot = effectMixThreshold;
+            emt = 1 - effectMixThreshold;
+        }
+    } else {
+        emt = effectMixThreshold;
+        emtNot = 1 - effectMixThreshold;
+    }
+}
+
+void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer)
+{
     if (!layers[layer]->buffer.allowAlpha && layers[layer]->fadeFactor != 1.0) {
         //need to fade the first here as we're not mixing anything
         HSVValue hsv0 = fg.asHSV();
@@ -942,21 +1355,7 @@ void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg
     case Mix_Effect2:
     {
         double emt, emtNot;
-        if (!layers[layer]->effectMixVaries) {
-            emt = effectMixThreshold;
-            if ((emt > 0.000001) && (emt < 0.99999)) {
-                emtNot = 1 - effectMixThreshold;
-                //make cross-fade linear
-                emt = cos((M_PI/4)*(pow(2*emt-1,2*n+1)+1));
-                emtNot = cos((M_PI/4)*(pow(2*emtNot-1,2*n+1)+1));
-            } else {
-                emtNot = effectMixThreshold;
-                emt = 1 - effectMixThreshold;
-            }
-        } else {
-            emt = effectMixThreshold;
-            emtNot = 1 - effectMixThreshold;
-        }
+        GetEffectMixFactors(layer, emt, emtNot);
 
         if (layers[layer]->mixType == Mix_Effect2) {
             fg.Set(fg.Red()*(emtNot),fg.Green()*(emtNot), fg.Blue()*(emtNot));
@@ -1144,40 +1543,142 @@ void PixelBufferClass::mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg
     }
 }
 
-void PixelBufferClass::GetMixedColor(int node, const std::vector<bool> & validLayers, int EffectPeriod, int saveLayer)
+// Mixes a span of one layer's colours onto the layers below. The mix type is checked once for the span and the
+// types which only compare or combine colour bytes go through the SIMD kernels. Chroma key and the mix types
+// which work on the hue still go a node at a time through mixColors.
+void PixelBufferClass::MixLayerSpan(int layer, const int *nodeX, const int *nodeY, xlColor *fg, xlColor *bg, int n)
 {
-    unsigned short &sparkle = layers[0]->buffer.Nodes[node]->sparkle;
-    int cnt = 0;
-    xlColor c(xlBLACK);
-    xlColor color;
+    LayerInfo *thelayer = layers[layer];
+    MixTypes mixType = thelayer->mixType;
+    MIXSPANFUNCTION kernel = GetMixSpanFunction(mixType);
+    bool spanMix = kernel != nullptr || mixType == Mix_Effect1 || mixType == Mix_Effect2 ||
+                   mixType == Mix_BottomTop || mixType == Mix_LeftRight;
+    if (!spanMix || thelayer->isChromaKey) {
+        for (int i = 0; i < n; ++i) {
+            mixColors(nodeX[i], nodeY[i], fg[i], bg[i], layer);
+        }
+        return;
+    }
 
-    for (int layer = numLayers - 1; layer >= 0; layer--) {
-        if (validLayers[layer]) {
-            auto thelayer = layers[layer];
-            if (node >= thelayer->buffer.Nodes.size()) {
-                //logger_base.crit("PixelBufferClass::GetMixedColor thelayer->buffer.Nodes does not contain node %d as it is only %d in size ... this was going to crash.", node, thelayer->buffer.Nodes.size());
-            } else {
-                auto &coord = thelayer->buffer.Nodes[node]->Coords[0];
-                int x = coord.bufX;
-                int y = coord.bufY;
+    if (!thelayer->buffer.allowAlpha && thelayer->fadeFactor != 1.0) {
+        //need to fade the first here as we're not mixing anything
+        for (int i = 0; i < n; ++i) {
+            HSVValue hsv0 = fg[i].asHSV();
+            hsv0.value *= thelayer->fadeFactor;
+            fg[i] = hsv0;
+        }
+    }
 
-                if (thelayer->isMasked(x, y)
-                    || x < 0
-                    || y < 0
-                    || x >= thelayer->BufferWi
-                    || y >= thelayer->BufferHt
-                    ) {
-                    color.Set(0, 0, 0, 0);
+    float effectMixThreshold = thelayer->outputEffectMixThreshold;
+    switch (mixType) {
+    case Mix_Normal:
+    {
+        double fadeFactor = thelayer->fadeFactor;
+        double visible = 1.0 - effectMixThreshold;
+        for (int i = 0; i < n; ++i) {
+            fg[i].alpha = fg[i].alpha * fadeFactor * visible;
+        }
+        kernel(fg, bg, n, 0);
+        break;
+    }
+    case Mix_Effect1:
+    case Mix_Effect2:
+    {
+        double emt, emtNot;
+        GetEffectMixFactors(layer, emt, emtNot);
+        if (mixType == Mix_Effect2) {
+            std::swap(emt, emtNot);
+        }
+        for (int i = 0; i < n; ++i) {
+            xlColor &f = fg[i];
+            xlColor &b = bg[i];
+            f.Set(f.Red()*(emt), f.Green()*(emt), f.Blue()*(emt));
+            b.Set(b.Red()*(emtNot), b.Green()*(emtNot), b.Blue()*(emtNot));
+            b.Set(f.Red()+b.Red(), f.Green()+b.Green(), f.Blue()+b.Blue());
+        }
+        break;
+    }
+    case Mix_BottomTop:
+    {
+        int half = thelayer->BufferHt/2;
+        for (int i = 0; i < n; ++i) {
+            if (nodeY[i] < half) {
+                bg[i] = fg[i];
+            }
+        }
+        break;
+    }
+    case Mix_LeftRight:
+    {
+        int half = thelayer->BufferWi/2;
+        for (int i = 0; i < n; ++i) {
+            if (nodeX[i] < half) {
+                bg[i] = fg[i];
+            }
+        }
+        break;
+    }
+    default:
+        kernel(fg, bg, n, MixValueThreshold(effectMixThreshold));
+        break;
+    }
+}
+
+// Mixes the layers for nodes begin to end into out. The work is done a layer at a time over short spans of
+// nodes so each layer's settings are checked once per span and the inner loops stay simple enough for the
+// compiler to vectorise. Nodes not mapped in saveX are left black.
+void PixelBufferClass::GetMixedColors(int begin, int end, const std::vector<bool> & validLayers, const std::vector<int> &saveX, xlColor *out)
+{
+    static const int SPAN = 256;
+    xlColor color[SPAN];
+    bool mixed[SPAN];
+
+    for (int spanStart = begin; spanStart < end; spanStart += SPAN) {
+        int count = std::min(SPAN, end - spanStart);
+        xlColor *c = out + (spanStart - begin);
+        uint16_t *sparkle = &nodeOutput.sparkle[spanStart];
+        for (int i = 0; i < count; ++i) {
+            c[i] = xlBLACK;
+            mixed[i] = false;
+        }
+
+        for (int layer = numLayers - 1; layer >= 0; layer--) {
+            if (!validLayers[layer]) {
+                continue;
+            }
+            LayerInfo *thelayer = layers[layer];
+            const RenderBuffer &buffer = thelayer->buffer;
+            // nodes past the end of this layer's nodes are not in it
+            int n = std::min((int)buffer.NodeBufX.size() - spanStart, count);
+            if (n <= 0) {
+                continue;
+            }
+            const int *nodeX = &buffer.NodeBufX[spanStart];
+            const int *nodeY = &buffer.NodeBufY[spanStart];
+
+            int wi = thelayer->BufferWi;
+            int ht = thelayer->BufferHt;
+            bool masked = !thelayer->mask.empty();
+            for (int i = 0; i < n; ++i) {
+                int x = nodeX[i];
+                int y = nodeY[i];
+                if (x < 0 || y < 0 || x >= wi || y >= ht || (masked && thelayer->isMasked(x, y))) {
+                    color[i].Set(0, 0, 0, 0);
                 } else {
-                    thelayer->buffer.GetPixel(x, y, color);
+                    buffer.GetPixel(x, y, color[i]);
                 }
+            }
 
-                // adjust for HSV adjustments
-                if (thelayer->needsHSVAdjust) {
-                    HSVValue hsv = color.asHSV();
+            // adjust for HSV adjustments
+            if (thelayer->needsHSVAdjust) {
+                float hueAdjust = thelayer->outputHueAdjust;
+                float saturationAdjust = thelayer->outputSaturationAdjust;
+                float valueAdjust = thelayer->outputValueAdjust;
+                for (int i = 0; i < n; ++i) {
+                    HSVValue hsv = color[i].asHSV();
 
-                    if (thelayer->outputHueAdjust != 0) {
-                        hsv.hue += thelayer->outputHueAdjust;
+                    if (hueAdjust != 0) {
+                        hsv.hue += hueAdjust;
                         if (hsv.hue < 0) {
                             hsv.hue += 1.0;
                         } else if (hsv.hue > 1) {
@@ -1185,8 +1686,8 @@ void PixelBufferClass::GetMixedColor(int node, const std::vector<bool> & validLa
                         }
                     }
 
-                    if (thelayer->outputSaturationAdjust != 0) {
-                        hsv.saturation += thelayer->outputSaturationAdjust;
+                    if (saturationAdjust != 0) {
+                        hsv.saturation += saturationAdjust;
                         if (hsv.saturation < 0) {
                             hsv.saturation = 0.0;
                         } else if (hsv.saturation > 1) {
@@ -1194,8 +1695,8 @@ void PixelBufferClass::GetMixedColor(int node, const std::vector<bool> & validLa
                         }
                     }
 
-                    if (thelayer->outputValueAdjust != 0) {
-                        hsv.value += thelayer->outputValueAdjust;
+                    if (valueAdjust != 0) {
+                        hsv.value += valueAdjust;
                         if (hsv.value < 0) {
                             hsv.value = 0.0;
                         } else if (hsv.value > 1) {
@@ -1203,19 +1704,23 @@ void PixelBufferClass::GetMixedColor(int node, const std::vector<bool> & validLa
                         }
                     }
 
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
+                    unsigned char alpha = color[i].Alpha();
+                    color[i] = hsv;
+                    color[i].alpha = alpha;
                 }
+            }
 
-                // add sparkles
-                if (color != xlBLACK &&
-                    (thelayer->use_music_sparkle_count ||
-                        thelayer->sparkle_count > 0 ||
-                        thelayer->outputSparkleCount > 0)) {
+            // add sparkles
+            if (thelayer->use_music_sparkle_count ||
+                thelayer->sparkle_count > 0 ||
+                thelayer->outputSparkleCount > 0) {
 
-                    int sc = thelayer->outputSparkleCount;
-                    switch (sparkle % (208 - sc))
+                int sc = thelayer->outputSparkleCount;
+                for (int i = 0; i < n; ++i) {
+                    if (color[i] == xlBLACK || saveX[spanStart + i] == RenderBuffer::NODE_NOT_MAPPED) {
+                        continue;
+                    }
+                    switch (sparkle[i] % (208 - sc))
                     {
                     case 1:
                     case 7:
@@ -1224,72 +1729,87 @@ void PixelBufferClass::GetMixedColor(int node, const std::vector<bool> & validLa
                         break;
                     case 2:
                     case 6:
-                        color = thelayer->sparklesColour.ApplyBrightness(0.53f);
+                        color[i] = thelayer->sparklesColour.ApplyBrightness(0.53f);
                         break;
                     case 3:
                     case 5:
-                        color = thelayer->sparklesColour.ApplyBrightness(0.75f);
+                        color[i] = thelayer->sparklesColour.ApplyBrightness(0.75f);
                         break;
                     case 4:
-                        color = thelayer->sparklesColour;
+                        color[i] = thelayer->sparklesColour;
                         break;
                     default:
                         break;
                     }
-                    sparkle++;
+                    sparkle[i]++;
                 }
-                int b = thelayer->outputBrightnessAdjust;
-                if (thelayer->contrast != 0) {
-                    //contrast is not 0, can handle brightness change at same time
-                    HSVValue hsv = color.asHSV();
+            }
+
+            int b = thelayer->outputBrightnessAdjust;
+            if (thelayer->contrast != 0) {
+                //contrast is not 0, can handle brightness change at same time
+                double contrast = (double)thelayer->contrast / 100.0;
+                for (int i = 0; i < n; ++i) {
+                    HSVValue hsv = color[i].asHSV();
                     hsv.value = hsv.value * ((double)b / 100.0);
 
                     // Apply Contrast
                     if (hsv.value < 0.5) {
                         // reduce brightness when below 0.5 in the V value or increase if > 0.5
-                        hsv.value = hsv.value - (hsv.value* ((double)thelayer->contrast / 100.0));
+                        hsv.value = hsv.value - (hsv.value * contrast);
                     } else {
-                        hsv.value = hsv.value + (hsv.value* ((double)thelayer->contrast / 100.0));
+                        hsv.value = hsv.value + (hsv.value * contrast);
                     }
 
                     if (hsv.value < 0.0) hsv.value = 0.0;
                     if (hsv.value > 1.0) hsv.value = 1.0;
-                    unsigned char alpha = color.Alpha();
-                    color = hsv;
-                    color.alpha = alpha;
-                } else if (b != 100) {
-                    //just brightness
-                    float ba = b;
-                    ba /= 100.0f;
-                    float f = color.red * ba;
-                    color.red = std::min((int)f, 255);
-                    f = color.green * ba;
-                    color.green = std::min((int)f, 255);
-                    f = color.blue * ba;
-                    color.blue = std::min((int)f, 255);
+                    unsigned char alpha = color[i].Alpha();
+                    color[i] = hsv;
+                    color[i].alpha = alpha;
                 }
+            } else if (b != 100) {
+                //just brightness
+                float ba = b;
+                ba /= 100.0f;
+                for (int i = 0; i < n; ++i) {
+                    color[i].red = std::min((int)(color[i].red * ba), 255);
+                    color[i].green = std::min((int)(color[i].green * ba), 255);
+                    color[i].blue = std::min((int)(color[i].blue * ba), 255);
+                }
+            }
 
-                if (cnt > 0) {
-                    mixColors(x, y, color, c, layer);
+            if (std::all_of(mixed, mixed + n, [](bool m) { return m; })) {
+                // every node already has a colour from the layers above
+                MixLayerSpan(layer, nodeX, nodeY, color, c, n);
+                continue;
+            }
+            for (int i = 0; i < n; ++i) {
+                if (mixed[i]) {
+                    mixColors(nodeX[i], nodeY[i], color[i], c[i], layer);
                 } else if (thelayer->fadeFactor != 1.0) {
                     //need to fade the first here as we're not mixing anything
-                    HSVValue hsv = color.asHSV();
+                    HSVValue hsv = color[i].asHSV();
                     hsv.value *= thelayer->fadeFactor;
-                    if (color.alpha != 255) {
-                        hsv.value *= color.alpha;
+                    if (color[i].alpha != 255) {
+                        hsv.value *= color[i].alpha;
                         hsv.value /= 255.0f;
                     }
-                    c = hsv;
+                    c[i] = hsv;
+                    mixed[i] = true;
                 } else {
-                    c.AlphaBlendForgroundOnto(color);
+                    c[i].AlphaBlendForgroundOnto(color[i]);
+                    mixed[i] = true;
                 }
+            }
+        }
 
-                cnt++;
+        for (int i = 0; i < count; ++i) {
+            if (saveX[spanStart + i] == RenderBuffer::NODE_NOT_MAPPED) {
+                // unmapped pixel - set to black
+                c[i] = xlBLACK;
             }
         }
     }
-    // set color for physical output
-    layers[saveLayer]->buffer.Nodes[node]->SetColor(c);
 }
 
 void PixelBufferClass::GetMixedColor(int x, int y, xlColor& c, const std::vector<bool> & validLayers, int EffectPeriod)
@@ -1534,179 +2054,211 @@ static void boxesForGauss(int d, int n, std::vector<float> &boxes)  // standard
     }
 }
 
-#define RED(a, b) a[(b)*4]
-#define GREEN(a, b) a[(b)*4 + 1]
-#define BLUE(a, b) a[(b)*4 + 2]
-#define ALPHA(a, b) a[(b)*4 + 3]
-static inline void SET(std::vector<float>& ar, int idx, float r, float g, float b, float a) {
-    idx *= 4;
-    ar[idx++] = r;
-    ar[idx++] = g;
-    ar[idx++] = b;
-    ar[idx] = a;
-}
-
-static void boxBlurH_4 (const std::vector<float>& scl, std::vector<float>& tcl, int w, int h, float r) {
-    float iarr = 1.0f / (r+r+1.0f);
-    for(int i=0; i<h; i++) {
-        int ti = i*w;
-        int li = ti;
-        int ri = ti+r;
-        int maxri = ti + w - 1;
-        int fvIdx = ti;
-        int lvIdx = ti+w-1;
-
-        float valr = (r+1.0) * RED(scl,fvIdx);
-        float valg = (r+1.0) * GREEN(scl,fvIdx);
-        float valb = (r+1.0) * BLUE(scl,fvIdx);
-        float vala = (r+1.0) * ALPHA(scl,fvIdx);
-
-        float fvRed = RED(scl, fvIdx);
-        float fvGreen = GREEN(scl, fvIdx);
-        float fvBlue = BLUE(scl, fvIdx);
-        float fvAlpha = ALPHA(scl, fvIdx);
-        float lvRed = RED(scl, lvIdx);
-        float lvGreen = GREEN(scl, lvIdx);
-        float lvBlue = BLUE(scl, lvIdx);
-        float lvAlpha = ALPHA(scl, lvIdx);
-
-        for (int j=0; j<r; j++) {
-            int idx = j < w ? ti+j : lvIdx;
-            valr += RED(scl, idx);
-            valg += GREEN(scl, idx);
-            valb += BLUE(scl, idx);
-            vala += ALPHA(scl, idx);
-        }
-        for (int j=0  ; j<=r ; j++) {
-            int idx = ri <= maxri ? ri++ : lvIdx;
-            valr += RED(scl, idx) - fvRed;
-            valg += GREEN(scl, idx) - fvGreen;
-            valb += BLUE(scl, idx) - fvBlue;
-            vala += ALPHA(scl, idx) - fvAlpha;
-
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-                ti++;
+// The layer blur works on 16 bit channel values holding the 8 bit colour with BLUR_FRACTION_BITS of
+// fraction so the three box passes dont lose precision between them. Edges are clamped.
+#define BLUR_FRACTION_BITS 4
+
+static inline uint32_t BoxBlurScale(int r) {
+    return ((1 << 16) + r) / (2 * r + 1);
+}
+
+// The box passes keep 32 bit running sums and output (sum * scale + 0.5) >> 16 for each channel. The SIMD
+// versions below do exactly the same integer sums, the row pass across the four channels of a pixel and the
+// column pass across neighbouring columns.
+#ifdef CPU_SSE2
+// SSE2 has no 32 bit multiply keeping the low half so do the even and odd lanes separately
+static inline __m128i BlurScaleSSE2(__m128i sum, __m128i scale) {
+    __m128i even = _mm_mul_epu32(sum, scale);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(sum, 32), scale);
+    __m128i lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    return _mm_srli_epi32(_mm_add_epi32(lo, _mm_set1_epi32(1 << 15)), 16);
+}
+static inline __m128i LoadBlur4SSE2(const uint16_t *p) {
+    return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128());
+}
+#endif
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static inline __m256i BlurScaleAVX2(__m256i sum, __m256i scale) {
+    return _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(sum, scale), _mm256_set1_epi32(1 << 15)), 16);
+}
+#endif
+
+// blur rows y0 to y1 of in horizontally into out
+static void BoxBlurRowsScalar(const uint16_t *in, uint16_t *out, int w, int y0, int y1, int r) {
+    const uint32_t scale = BoxBlurScale(r);
+    const int last = w - 1;
+    for (int y = y0; y < y1; y++) {
+        const uint16_t *src = in + y * w * 4;
+        uint16_t *dst = out + y * w * 4;
+        uint32_t sum[4];
+        for (int c = 0; c < 4; c++) {
+            sum[c] = (r + 1) * src[c];
+        }
+        for (int k = 1; k <= r; k++) {
+            const uint16_t *p = src + std::min(k, last) * 4;
+            for (int c = 0; c < 4; c++) {
+                sum[c] += p[c];
             }
         }
-        for (int j=r+1; j<w-r; j++) {
-            int c = ri <= maxri ? ri++ : lvIdx;
-            int c2 = li <= maxri ? li++ : lvIdx;
-            valr += RED(scl, c) - RED(scl, c2);
-            valg += GREEN(scl, c) - GREEN(scl, c2);
-            valb += BLUE(scl, c) - BLUE(scl, c2);
-            vala += ALPHA(scl, c) - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-                ti++;
+        for (int x = 0; x < w; x++) {
+            const uint16_t *add = src + std::min(x + r + 1, last) * 4;
+            const uint16_t *sub = src + std::max(x - r, 0) * 4;
+            for (int c = 0; c < 4; c++) {
+                dst[x * 4 + c] = (sum[c] * scale + (1 << 15)) >> 16;
+                sum[c] += add[c] - sub[c];
             }
         }
+    }
+}
 
-        for (int j=w-r; j<w  ; j++) {
-            int c2 = li <= maxri ? li++: lvIdx;
-            valr += lvRed - RED(scl, c2);
-            valg += lvGreen - GREEN(scl, c2);
-            valb += lvBlue - BLUE(scl, c2);
-            vala += lvAlpha - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-                ti++;
-            }
+#ifdef CPU_SSE2
+static void BoxBlurRowsSSE2(const uint16_t *in, uint16_t *out, int w, int y0, int y1, int r) {
+    const __m128i scale = _mm_set1_epi32(BoxBlurScale(r));
+    const int last = w - 1;
+    for (int y = y0; y < y1; y++) {
+        const uint16_t *src = in + y * w * 4;
+        uint16_t *dst = out + y * w * 4;
+        __m128i first = LoadBlur4SSE2(src);
+        __m128i sum = _mm_setzero_si128();
+        for (int k = 0; k <= r; k++) {
+            sum = _mm_add_epi32(sum, first);
+        }
+        for (int k = 1; k <= r; k++) {
+            sum = _mm_add_epi32(sum, LoadBlur4SSE2(src + std::min(k, last) * 4));
+        }
+        for (int x = 0; x < w; x++) {
+            __m128i d = BlurScaleSSE2(sum, scale);
+            _mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packs_epi32(d, d));
+            __m128i add = LoadBlur4SSE2(src + std::min(x + r + 1, last) * 4);
+            __m128i sub = LoadBlur4SSE2(src + std::max(x - r, 0) * 4);
+            sum = _mm_add_epi32(sum, _mm_sub_epi32(add, sub));
         }
     }
 }
+#endif
 
-static void boxBlurT_4 (const std::vector<float>& scl, std::vector<float>& tcl, int w, int h, float r) {
-    float iarr = 1.0f / (r+r+1.0f);
-    for(int i=0; i<w; i++) {
-        int ti = i;
-        int li = ti;
-        int ri = ti+r*w;
-
-        int maxri = ti+w*(h-1);
-
-        int fvIdx = ti;
-        int lvIdx = ti+w*(h-1);
-
-        float fvRed = RED(scl, fvIdx);
-        float fvGreen = GREEN(scl, fvIdx);
-        float fvBlue = BLUE(scl, fvIdx);
-        float fvAlpha = ALPHA(scl, fvIdx);
-        float lvRed = RED(scl, lvIdx);
-        float lvGreen = GREEN(scl, lvIdx);
-        float lvBlue = BLUE(scl, lvIdx);
-        float lvAlpha = ALPHA(scl, lvIdx);
-
-        float valr = (r+1)*fvRed;
-        float valg = (r+1)*fvGreen;
-        float valb = (r+1)*fvBlue;
-        float vala = (r+1)*fvAlpha;
-
-        for(int j=0; j<r; j++) {
-            int idx = j < w ? ti+j*w : lvIdx;
-            valr += RED(scl, idx);
-            valg += GREEN(scl, idx);
-            valb += BLUE(scl, idx);
-            vala += ALPHA(scl, idx);
-        }
-        for(int j=0  ; j<=r ; j++) {
-            int idx = ri <= maxri ? ri : lvIdx;
-            valr += RED(scl, idx) - fvRed;
-            valg += GREEN(scl, idx) - fvGreen;
-            valb += BLUE(scl, idx) - fvBlue;
-            vala += ALPHA(scl, idx) - fvAlpha;
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-            }
-            ri+=w;
-            ti+=w;
-        }
-        for(int j=r+1; j<h-r; j++) {
-            int c = ri <= maxri ? ri : lvIdx;
-            int c2 = li <= maxri ? li : lvIdx;
-            valr += RED(scl, c) - RED(scl, c2);
-            valg += GREEN(scl, c) - GREEN(scl, c2);
-            valb += BLUE(scl, c) - BLUE(scl, c2);
-            vala += ALPHA(scl, c) - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
-            }
-            li+=w; ri+=w; ti+=w;
-        }
-        for(int j=h-r; j<h  ; j++) {
-            int c2 = li <= maxri ? li : lvIdx;
-            valr += lvRed - RED(scl, c2);
-            valg += lvGreen - GREEN(scl, c2);
-            valb += lvBlue - BLUE(scl, c2);
-            vala += lvAlpha - ALPHA(scl, c2);
-            if (ti <= maxri) {
-                SET(tcl, ti, valr*iarr, valg*iarr, valb*iarr, vala*iarr);
+static void BoxBlurRows(const uint16_t *in, uint16_t *out, int w, int y0, int y1, int r) {
+#ifdef CPU_SSE2
+    if (CPUFeatures::UseSSE2()) {
+        BoxBlurRowsSSE2(in, out, w, y0, y1, r);
+        return;
+    }
+#endif
+    BoxBlurRowsScalar(in, out, w, y0, y1, r);
+}
+
+// one output row of the column pass for lanes l to lanes, returns the lane it stopped at
+typedef int (*BLURSTEPFUNCTION)(uint32_t *sum, const uint16_t *add, const uint16_t *sub, uint16_t *d, int l, int lanes, uint32_t scale);
+
+static int BoxBlurStepScalar(uint32_t *sum, const uint16_t *add, const uint16_t *sub, uint16_t *d, int l, int lanes, uint32_t scale) {
+    for (; l < lanes; l++) {
+        d[l] = (sum[l] * scale + (1 << 15)) >> 16;
+        sum[l] += add[l] - sub[l];
+    }
+    return l;
+}
+
+#ifdef CPU_SSE2
+static int BoxBlurStepSSE2(uint32_t *sum, const uint16_t *add, const uint16_t *sub, uint16_t *d, int l, int lanes, uint32_t scale) {
+    const __m128i sc = _mm_set1_epi32(scale);
+    const __m128i z = _mm_setzero_si128();
+    for (; l + 8 <= lanes; l += 8) {
+        __m128i s0 = _mm_loadu_si128((const __m128i*)(sum + l));
+        __m128i s1 = _mm_loadu_si128((const __m128i*)(sum + l + 4));
+        _mm_storeu_si128((__m128i*)(d + l), _mm_packs_epi32(BlurScaleSSE2(s0, sc), BlurScaleSSE2(s1, sc)));
+        __m128i a = _mm_loadu_si128((const __m128i*)(add + l));
+        __m128i b = _mm_loadu_si128((const __m128i*)(sub + l));
+        s0 = _mm_add_epi32(s0, _mm_sub_epi32(_mm_unpacklo_epi16(a, z), _mm_unpacklo_epi16(b, z)));
+        s1 = _mm_add_epi32(s1, _mm_sub_epi32(_mm_unpackhi_epi16(a, z), _mm_unpackhi_epi16(b, z)));
+        _mm_storeu_si128((__m128i*)(sum + l), s0);
+        _mm_storeu_si128((__m128i*)(sum + l + 4), s1);
+    }
+    return l;
+}
+#endif
+
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static int BoxBlurStepAVX2(uint32_t *sum, const uint16_t *add, const uint16_t *sub, uint16_t *d, int l, int lanes, uint32_t scale) {
+    const __m256i sc = _mm256_set1_epi32(scale);
+    for (; l + 8 <= lanes; l += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(sum + l));
+        __m256i o = BlurScaleAVX2(s, sc);
+        _mm_storeu_si128((__m128i*)(d + l), _mm_packs_epi32(_mm256_castsi256_si128(o), _mm256_extracti128_si256(o, 1)));
+        __m256i a = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(add + l)));
+        __m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(sub + l)));
+        _mm256_storeu_si256((__m256i*)(sum + l), _mm256_add_epi32(s, _mm256_sub_epi32(a, b)));
+    }
+    return l;
+}
+#endif
+
+// blur pixel columns x0 to x1 of in vertically into out, a block of columns at a time so the running
+// sums for a whole block are updated together
+static void BoxBlurColumns(const uint16_t *in, uint16_t *out, int w, int h, int x0, int x1, int r, BLURSTEPFUNCTION step) {
+    static const int BLOCK = 64;
+    const uint32_t scale = BoxBlurScale(r);
+    const int last = h - 1;
+    const int stride = w * 4;
+    uint32_t sum[BLOCK * 4];
+    for (int bx = x0; bx < x1; bx += BLOCK) {
+        const int lanes = std::min(BLOCK, x1 - bx) * 4;
+        const uint16_t *col = in + bx * 4;
+        uint16_t *dst = out + bx * 4;
+        for (int l = 0; l < lanes; l++) {
+            sum[l] = (r + 1) * col[l];
+        }
+        for (int k = 1; k <= r; k++) {
+            const uint16_t *p = col + std::min(k, last) * stride;
+            for (int l = 0; l < lanes; l++) {
+                sum[l] += p[l];
             }
-            li += w;
-            ti += w;
+        }
+        for (int y = 0; y < h; y++) {
+            const uint16_t *add = col + std::min(y + r + 1, last) * stride;
+            const uint16_t *sub = col + std::max(y - r, 0) * stride;
+            uint16_t *d = dst + y * stride;
+            int l = step(sum, add, sub, d, 0, lanes, scale);
+            BoxBlurStepScalar(sum, add, sub, d, l, lanes, scale);
         }
     }
 }
 
-static void boxBlur_4(std::vector<float>& scl, std::vector<float>& tcl, int w, int h, float r, int size) {
-    tcl = scl;
-    //memcpy(tcl, scl, sizeof(float)*4*size);
-    boxBlurH_4(tcl, scl, w, h, r);
-    boxBlurT_4(scl, tcl, w, h, r);
+static BLURSTEPFUNCTION GetBoxBlurStep() {
+#ifdef CPU_AVX2
+    if (CPUFeatures::UseAVX2()) {
+        return BoxBlurStepAVX2;
+    }
+#endif
+#ifdef CPU_SSE2
+    if (CPUFeatures::UseSSE2()) {
+        return BoxBlurStepSSE2;
+    }
+#endif
+    return BoxBlurStepScalar;
 }
 
-static void gaussBlur_4(std::vector<float>& scl, std::vector<float>& tcl, int w, int h, int r, int size) {
+// three box blurs approximating a gaussian, the result ends up back in scl
+static void gaussBlur_4(std::vector<uint16_t> &scl, std::vector<uint16_t> &tcl, int w, int h, int r) {
     std::vector<float> bxs;
     boxesForGauss(r - 1, 3, bxs);
-    boxBlur_4 (scl, tcl, w, h, (bxs[0]-1)/2, size);
-    boxBlur_4 (tcl, scl, w, h, (bxs[1]-1)/2, size);
-    boxBlur_4 (scl, tcl, w, h, (bxs[2]-1)/2, size);
-}
 
-static inline int roundInt(float r) {
-    int tmp = static_cast<int> (r);
-    tmp += (r-tmp>=.5) - (r-tmp<=-.5);
-    return tmp;
+    // split large buffers across the pool by rows and by columns
+    const int pixelsPerJob = 4096;
+    for (float box : bxs) {
+        int br = (int)(box - 1) / 2;
+        if (br <= 0) {
+            continue;
+        }
+        uint16_t *s = scl.data();
+        uint16_t *t = tcl.data();
+        parallel_for_range(0, h, [s, t, w, br](int y0, int y1) {
+            BoxBlurRows(s, t, w, y0, y1, br);
+        }, std::max(1, pixelsPerJob / w));
+        BLURSTEPFUNCTION step = GetBoxBlurStep();
+        parallel_for_range(0, w, [s, t, w, h, br, step](int x0, int x1) {
+            BoxBlurColumns(t, s, w, h, x0, x1, br, step);
+        }, std::max(1, pixelsPerJob / h));
+    }
 }
 
 void PixelBufferClass::Blur(LayerInfo* layer, float offset)
@@ -1727,31 +2279,27 @@ void PixelBufferClass::Blur(LayerInfo* layer, float offset)
     if (b < 2) {
         return;
     } else if (b > 2 && layer->BufferWi > 6 && layer->BufferHt > 6) {
-        int os = std::max((int)layer->buffer.pixels.size(), layer->BufferWi * layer->BufferHt);
-        int pixCount = layer->buffer.pixels.size();
-        std::vector<float> input;
-        input.resize(os * 4);
-        std::vector<float> tmp;
-        tmp.resize(os * 4);
-        //float * input = new float[pixCount * 4];
-        //float * tmp = new float[pixCount * 4];
-        for (int x = 0; x < pixCount; x++) {
-            const xlColor &c = layer->buffer.pixels[x];
-            input[x * 4] = c.red;
-            input[x * 4 + 1] = c.green;
-            input[x * 4 + 2] = c.blue;
-            input[x * 4 + 3] = c.alpha;
-        }
-        gaussBlur_4(input, tmp, layer->BufferWi, layer->BufferHt, b, pixCount);
-
-        for (int x = 0; x < pixCount; x++) {
-            layer->buffer.pixels[x].Set(roundInt(tmp[x*4]),
-                                        roundInt(tmp[x*4 + 1]),
-                                        roundInt(tmp[x*4 + 2]),
-                                        roundInt(tmp[x*4 + 3]));
-        }
-        //delete [] input;
-        //delete [] tmp;
+        int w = layer->BufferWi;
+        int h = layer->BufferHt;
+        int pixCount = std::min((int)layer->buffer.pixels.size(), w * h);
+        // scratch space is kept per thread so large blurs dont allocate every frame
+        static thread_local std::vector<uint16_t> input;
+        static thread_local std::vector<uint16_t> tmp;
+        input.resize(w * h * 4);
+        tmp.resize(w * h * 4);
+
+        const uint8_t *pixels = (const uint8_t*)layer->buffer.pixels.data();
+        for (int x = 0; x < pixCount * 4; x++) {
+            input[x] = pixels[x] << BLUR_FRACTION_BITS;
+        }
+        std::fill(input.begin() + pixCount * 4, input.end(), 0);
+
+        gaussBlur_4(input, tmp, w, h, b);
+
+        uint8_t *out = (uint8_t*)layer->buffer.pixels.data();
+        for (int x = 0; x < pixCount * 4; x++) {
+            out[x] = std::min((input[x] + (1 << (BLUR_FRACTION_BITS - 1))) >> BLUR_FRACTION_BITS, 255);
+        }
     } else {
         int d;
         int u;
@@ -2123,6 +2671,17 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
     inf->persistent = settingsMap.GetBool(CHECKBOX_OverlayBkg);
     inf->mask.clear();
 
+    // random value curves pick new points every time they are loaded so frames rendered from
+    // different loads of the effect would not match
+    inf->randomValueCurve = false;
+    for (const auto& it : settingsMap) {
+        if (it.first.compare(0, 11, "VALUECURVE_") == 0 && it.second.find("Type=Random|") != std::string::npos &&
+            it.second.compare(0, 12, "Active=TRUE|") == 0) {
+            inf->randomValueCurve = true;
+            break;
+        }
+    }
+
     inf->fadeInSteps = (int)(settingsMap.GetDouble(TEXTCTRL_Fadein, 0.0)*1000)/frameTimeInMs;
     inf->fadeOutSteps = (int)(settingsMap.GetDouble(TEXTCTRL_Fadeout, 0.0)*1000)/frameTimeInMs;
 
@@ -2229,15 +2788,16 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
         if (StartsWith(type, "Per Model")) {
             tt = "Single Line";
         }
-        model->InitRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
+        model->GetRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
         if (origNodeCount != 0 && origNodeCount != inf->buffer.Nodes.size()) {
             inf->buffer.Nodes.clear();
-            model->InitRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
+            model->GetRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
         }
 
         int curBH = inf->BufferHt;
         int curBW = inf->BufferWi;
         ComputeSubBuffer(subBuffer, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt, 0, inf->buffer.GetStartTimeMS(), inf->buffer.GetEndTimeMS());
+        UpdateNodeTables(layer);
 
         curBH = std::max(curBH, inf->BufferHt);
         curBW = std::max(curBW, inf->BufferWi);
@@ -2290,7 +2850,7 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
                 std::string ntype = type.substr(10, type.length() - 10);
                 int bw, bh;
                 it->Nodes.clear();
-                gp->Models()[cnt]->InitRenderBufferNodes(ntype, camera, transform, it->Nodes, bw, bh);
+                gp->Models()[cnt]->GetRenderBufferNodes(ntype, camera, transform, it->Nodes, bw, bh);
                 if (bw == 0) bw = 1; // zero sized buffers are a problem
                 if (bh == 0) bh = 1;
                 it->InitBuffer(bh, bw, bh, bw, transform);
@@ -2307,6 +2867,14 @@ bool PixelBufferClass::IsPersistent(int layer) {
     return layers[layer]->persistent;
 }
 
+// false if the layer carries anything from one frame to the next
+bool PixelBufferClass::IsFrameIndependent(int layer) const
+{
+    const LayerInfo* l = layers[layer];
+    return !l->persistent && !l->randomValueCurve && l->freezeAfterFrame == 999999 &&
+        l->sparkle_count == 0 && !l->use_music_sparkle_count && !l->SparklesValueCurve.IsActive();
+}
+
 int PixelBufferClass::GetFreezeFrame(int layer)
 {
     return layers[layer]->freezeAfterFrame;
@@ -2410,63 +2978,79 @@ static inline bool IsInRange(const std::vector<bool> &restrictRange, size_t star
 
 void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &restrictRange) {
 
-    // KW ... I think this needs to be optimised
-
-    if (layers[0] != nullptr) { // I dont like this ... it should never be null
-        if (layers[0]->buffer.Nodes.size() < 1000) {
-            //smaller model, no sense in setting up the parallel_for
-            for (auto &n : layers[0]->buffer.Nodes) {
-                size_t start = n->ActChan;
-                if (IsInRange(restrictRange, start)) {
-                    if (n->model != nullptr) { // nor this
-                        DimmingCurve *curve = n->model->modelDimmingCurve;
-                        if (curve != nullptr) {
-                            if (n->GetChanCount() == 1) {
-                                uint8_t buf[3] = {0, 0, 0};
-                                n->GetForChannels(buf);
-                                xlColor color(buf[0], buf[0], buf[0]);
-                                curve->apply(color);
-
-                                n->SetColor(color);
-                            } else {
-                                xlColor color;
-                                n->GetColor(color);
-                                curve->apply(color);
-                                n->SetColor(color);
-                            }
-                        }
-                    }
-                    n->GetForChannels(&fdata[start]);
+    if (layers[0] == nullptr) { // I dont like this ... it should never be null
+        return;
+    }
+
+    const std::vector<NodeBaseClassPtr> &nodes = layers[0]->buffer.Nodes;
+    int count = std::min(nodes.size(), nodeOutput.colors.size());
+    //smaller models run in one block, no sense in setting up the parallel jobs
+    parallel_for_range(0, count, [this, &nodes, fdata, &restrictRange](int begin, int end) {
+        const auto &runs = nodeOutput.modelRuns;
+        auto run = std::upper_bound(runs.begin(), runs.end(), (uint32_t)begin,
+                                    [](uint32_t n, const std::pair<uint32_t, const Model*> &r) { return n < r.first; });
+        size_t nextRun = run - runs.begin();
+        DimmingCurve *curve = nullptr;
+        if (run != runs.begin()) {
+            const Model *m = (run - 1)->second;
+            curve = m == nullptr ? nullptr : m->modelDimmingCurve;
+        }
+        for (int i = begin; i < end; ++i) {
+            if (nextRun < runs.size() && runs[nextRun].first == (uint32_t)i) {
+                const Model *m = runs[nextRun++].second;
+                curve = m == nullptr ? nullptr : m->modelDimmingCurve;
+            }
+            size_t start = nodeOutput.startChannel[i];
+            if (!IsInRange(restrictRange, start)) {
+                continue;
+            }
+            xlColor color = nodeOutput.colors[i];
+            const uint8_t *offsets = &nodeOutput.offsets[i * 4];
+            switch (nodeOutput.type[i]) {
+            case NodeOutputType::RGB:
+                if (curve != nullptr) {
+                    curve->apply(color);
+                }
+                fdata[start + offsets[0]] = color.red;
+                fdata[start + offsets[1]] = color.green;
+                fdata[start + offsets[2]] = color.blue;
+                break;
+            case NodeOutputType::RGBW:
+                if (curve != nullptr) {
+                    curve->apply(color);
+                }
+                NodeClassRGBW::PackChannels(&color.red, offsets, (offsets[3] & RGBW_WHITE_LAST) != 0, (uint8_t)(offsets[3] & ~RGBW_WHITE_LAST), &fdata[start]);
+                break;
+            case NodeOutputType::SINGLE_COLOR: {
+                uint8_t v = (&color.red)[offsets[0]];
+                if (curve != nullptr) {
+                    xlColor c(v, v, v);
+                    curve->apply(c);
+                    v = (&c.red)[offsets[0]];
                 }
+                fdata[start] = v;
+                break;
             }
-        } else {
-            parallel_for(0,  layers[0]->buffer.Nodes.size(), [&](int i) {
-                auto &n = layers[0]->buffer.Nodes[i];
-                size_t start = n->ActChan;
-                if (IsInRange(restrictRange, start)) {
-                    if (n->model != nullptr) { // nor this
-                        DimmingCurve *curve = n->model->modelDimmingCurve;
-                        if (curve != nullptr) {
-                            if (n->GetChanCount() == 1) {
-                                uint8_t buf[3] = {0, 0, 0};
-                                n->GetForChannels(buf);
-                                xlColor color(buf[0], buf[0], buf[0]);
-                                curve->apply(color);
-
-                                n->SetColor(color);
-                            } else {
-                                xlColor color;
-                                n->GetColor(color);
-                                curve->apply(color);
-                                n->SetColor(color);
-                            }
-                        }
+            default: {
+                NodeBaseClass *n = nodes[i].get();
+                n->SetColor(color);
+                if (curve != nullptr) {
+                    if (n->GetChanCount() == 1) {
+                        uint8_t buf[3] = {0, 0, 0};
+                        n->GetForChannels(buf);
+                        color.Set(buf[0], buf[0], buf[0]);
+                    } else {
+                        n->GetColor(color);
                     }
-                    n->GetForChannels(&fdata[start]);
+                    curve->apply(color);
+                    n->SetColor(color);
                 }
-            }, 500);
+                n->GetForChannels(&fdata[start]);
+                break;
+            }
+            }
         }
-    }
+    }, 1000);
 }
 
 void PixelBufferClass::SetColors(int layer, const unsigned char *fdata)
@@ -2739,8 +3323,9 @@ void PixelBufferClass::PrepareVariableSubBuffer(int EffectPeriod, int layer)
     const std::string &camera = layers[layer]->camera;
     const std::string &transform = layers[layer]->transform;
     layers[layer]->buffer.Nodes.clear();
-    model->InitRenderBufferNodes(type, camera, transform, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt);
+    model->GetRenderBufferNodes(type, camera, transform, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt);
     ComputeSubBuffer(subBuffer, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt, offset, layers[layer]->buffer.GetStartTimeMS(), layers[layer]->buffer.GetEndTimeMS());
+    UpdateNodeTables(layer);
     layers[layer]->buffer.BufferWi = layers[layer]->BufferWi;
     layers[layer]->buffer.BufferHt = layers[layer]->BufferHt;
 
@@ -2775,9 +3360,9 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
         if (layers[ii]->use_music_sparkle_count &&
             layers[ii]->buffer.GetMedia() != nullptr) {
             float f = 0.0;
-            std::list<float> const * const pf = layers[ii]->buffer.GetMedia()->GetFrameData(layers[ii]->buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr) {
-                f = *pf->cbegin();
+            const FrameDataSpan pf = layers[ii]->buffer.GetMedia()->GetFrameData(layers[ii]->buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty()) {
+                f = pf.front();
             }
             layers[ii]->music_sparkle_count_factor = f;
         } else {
@@ -2869,16 +3454,27 @@ void PixelBufferClass::CalcOutput(int EffectPeriod, const std::vector<bool> & va
     }
     */
 
-    std::vector<NodeBaseClassPtr> &Nodes = layers[saveLayer]->buffer.Nodes;
-    parallel_for(0, NodeCount, [this, &Nodes, &validLayers, saveLayer, EffectPeriod] (int i) {
-        if (!Nodes[i]->IsVisible()) {
-            // unmapped pixel - set to black
-            Nodes[i]->SetColor(xlBLACK);
-        } else {
-            // get blend of two effects
-            GetMixedColor(i, validLayers, EffectPeriod, saveLayer);
-        }
-    }, blockSize);
+    if (NodeCount > nodeOutput.sparkle.size()) {
+        NodeCount = nodeOutput.sparkle.size();
+    }
+    const std::vector<int> &nodeX = layers[saveLayer]->buffer.NodeBufX;
+    NodeCount = std::min(NodeCount, nodeX.size());
+    if (saveLayer == 0) {
+        // the output layer keeps its colours in the flat table for GetColors
+        xlColor *colors = nodeOutput.colors.data();
+        parallel_for_range(0, NodeCount, [this, colors, &nodeX, &validLayers] (int begin, int end) {
+            GetMixedColors(begin, end, validLayers, nodeX, colors + begin);
+        }, blockSize);
+    } else {
+        std::vector<NodeBaseClassPtr> &Nodes = layers[saveLayer]->buffer.Nodes;
+        parallel_for_range(0, NodeCount, [this, &Nodes, &nodeX, &validLayers] (int begin, int end) {
+            std::vector<xlColor> colors(end - begin);
+            GetMixedColors(begin, end, validLayers, nodeX, colors.data());
+            for (int i = begin; i < end; ++i) {
+                Nodes[i]->SetColor(colors[i - begin]);
+            }
+        }, blockSize);
+    }
 }
 
 static int DecodeType(const std::string &type)
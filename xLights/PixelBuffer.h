@@ -79,6 +79,8 @@ class ModelGroup;
 
 class PixelBufferClass
 {
+    friend struct PixelBufferTests; // the self tests drive the layer mixing and blur directly
+
 private:
     class LayerInfo {
     public:
@@ -189,6 +191,7 @@ private:
         bool effectMixVaries;
         bool canvas = false;
         bool persistent = false;
+        bool randomValueCurve = false;
         int fadeInSteps;
         int fadeOutSteps;
         std::string inTransitionType;
@@ -248,13 +251,39 @@ private:
 
     //both fg and bg may be modified, bg will contain the new, mixed color to be the bg for the next mix
     void mixColors(const wxCoord &x, const wxCoord &y, xlColor &fg, xlColor &bg, int layer);
+    // mixColors for a span of nodes, fg and bg are arrays of n colours
+    void MixLayerSpan(int layer, const int *nodeX, const int *nodeY, xlColor *fg, xlColor *bg, int n);
+    void GetEffectMixFactors(int layer, double &emt, double &emtNot) const;
     void reset(int layers, int timing, bool isNode = false);
 	void Blur(LayerInfo* layer, float offset);
     void RotoZoom(LayerInfo* layer, float offset);
     void RotateX(LayerInfo* layer, float offset);
     void RotateY(LayerInfo* layer, float offset);
     void RotateZAndZoom(LayerInfo* layer, float offset);
-    void GetMixedColor(int node, const std::vector<bool> & validLayers, int EffectPeriod, int saveLayer);
+    void GetMixedColors(int begin, int end, const std::vector<bool> & validLayers, const std::vector<int> &saveX, xlColor *out);
+
+    // How a node's colour is written to its channels. RGB, RGBW and single colour nodes are packed directly,
+    // everything else goes through the node object.
+    enum class NodeOutputType : uint8_t { RGB, RGBW, SINGLE_COLOR, OTHER };
+    static const uint8_t RGBW_WHITE_LAST = 0x80;
+    // Flat copy of the output side of the model's nodes, one entry per node. The node objects are still built by
+    // the models and stay alive, so this is extra memory rather than a replacement: 15 bytes a node here plus 8 for
+    // the coordinates each RenderBuffer keeps, on top of more than 100 bytes a node for a node object with one
+    // coordinate. PixelBufferSelfTest logs the measured figures and packing times. The output colours live here
+    // rather than in the layer 0 nodes so anything reading the result of CalcOutput(..., 0) must go through
+    // nodeOutput.colors.
+    struct NodeOutputTable {
+        std::vector<uint32_t> startChannel;
+        std::vector<NodeOutputType> type;
+        // four per node, the red, green and blue channel offsets then for RGBW nodes the white handling with
+        // RGBW_WHITE_LAST set if white is the last channel. For single colour nodes the first is the component used.
+        std::vector<uint8_t> offsets;
+        std::vector<std::pair<uint32_t, const Model*>> modelRuns; // first node of each run of nodes from one model
+        std::vector<uint16_t> sparkle;
+        std::vector<xlColor> colors; // mixed colour from the last CalcOutput
+    };
+    NodeOutputTable nodeOutput;
+    void UpdateNodeTables(int layer);
 
     std::string modelName;
     std::string lastBufferType;
@@ -269,6 +298,7 @@ public:
     void GetNodeChannelValues(size_t nodenum, unsigned char *buf);
     void SetNodeChannelValues(size_t nodenum, const unsigned char *buf);
     xlColor GetNodeColor(size_t nodenum) const;
+    void CopyNodeColorsToPixels(int layer, std::vector<bool> &done);
     xlColor GetNodeMaskColor(size_t nodenum) const;
     int NodeStartChannel(size_t nodenum) const;
     int GetNodeCount() const;
@@ -301,6 +331,7 @@ public:
 
     void SetLayerSettings(int layer, const SettingsMap &settings);
     bool IsPersistent(int layer);
+    bool IsFrameIndependent(int layer) const;
     int GetFreezeFrame(int layer);
     int GetSuppressUntil(int layer);
 
@@ -225,7 +225,7 @@ public:
     RenderJob(ModelElement *row, SequenceData &data, xLightsFrame *xframe, bool zeroBased = false)
         : Job(), NextRenderer(), rowToRender(row), seqData(&data), xLights(xframe),
             gauge(nullptr), currentFrame(0), renderLog(log4cpp::Category::getInstance(std::string("log_render"))),
-            supportsModelBlending(false), abort(false), statusMap(nullptr)
+            supportsModelBlending(false), abort(false), statusMap(nullptr), zeroBased(zeroBased)
     {
         name = "";
         if (row != nullptr) {
@@ -233,28 +233,8 @@ public:
             mainBuffer = new PixelBufferClass(xframe);
             numLayers = rowToRender->GetEffectLayerCount();
 
-            if (xframe->InitPixelBuffer(name, *mainBuffer, numLayers, zeroBased)) {
+            if (InitModelBuffer(*mainBuffer)) {
                 const Model *model = mainBuffer->GetModel();
-                if ("ModelGroup" == model->GetDisplayAs()) {
-                    //for (int l = 0; l < numLayers; ++l) {
-                    for (int l = numLayers - 1; l >= 0; --l) {
-                        EffectLayer *layer = row->GetEffectLayer(l);
-                        bool perModelEffects = false;
-                        for (int e = 0; e < layer->GetEffectCount() && !perModelEffects; ++e) {
-                            static const std::string CHOICE_BufferStyle("B_CHOICE_BufferStyle");
-                            static const std::string DEFAULT("Default");
-                            static const std::string PER_MODEL("Per Model");
-                            const std::string &bt = layer->GetEffect(e)->GetSettings().Get(CHOICE_BufferStyle, DEFAULT);
-                            if (bt.compare(0, 9, PER_MODEL) == 0) {
-                                perModelEffects = true;
-                            }
-                        }
-                        if (perModelEffects) {
-                            const ModelGroup *grp = dynamic_cast<const ModelGroup*>(model);
-                            mainBuffer->InitPerModelBuffers(*grp, l, data.FrameTime());
-                        }
-                    }
-                }
                 for (int x = 0; x < row->GetSubModelAndStrandCount(); ++x) {
                     SubModelElement *se = row->GetSubModel(x);
                     if (se->HasEffects()) {
@@ -524,7 +504,36 @@ public:
         return frame - (ef->GetStartTimeMS() / frameTime);
     }
 
-    bool ProcessFrame(int frame, Element *el, EffectLayerInfo &info, PixelBufferClass *buffer, int strand = -1, bool blend = false) {
+    // sets up a buffer covering the whole model, this is the main buffer and the copies used to render frames in parallel
+    bool InitModelBuffer(PixelBufferClass &buffer) {
+        if (!xLights->InitPixelBuffer(name, buffer, numLayers, zeroBased)) {
+            return false;
+        }
+        const Model *model = buffer.GetModel();
+        if ("ModelGroup" == model->GetDisplayAs()) {
+            //for (int l = 0; l < numLayers; ++l) {
+            for (int l = numLayers - 1; l >= 0; --l) {
+                EffectLayer *layer = rowToRender->GetEffectLayer(l);
+                bool perModelEffects = false;
+                for (int e = 0; e < layer->GetEffectCount() && !perModelEffects; ++e) {
+                    static const std::string CHOICE_BufferStyle("B_CHOICE_BufferStyle");
+                    static const std::string DEFAULT("Default");
+                    static const std::string PER_MODEL("Per Model");
+                    const std::string &bt = layer->GetEffect(e)->GetSettings().Get(CHOICE_BufferStyle, DEFAULT);
+                    if (bt.compare(0, 9, PER_MODEL) == 0) {
+                        perModelEffects = true;
+                    }
+                }
+                if (perModelEffects) {
+                    const ModelGroup *grp = dynamic_cast<const ModelGroup*>(model);
+                    buffer.InitPerModelBuffers(*grp, l, seqData->FrameTime());
+                }
+            }
+        }
+        return true;
+    }
+
+    bool ProcessFrame(int frame, Element *el, EffectLayerInfo &info, PixelBufferClass *buffer, int strand = -1, bool blend = false, bool updateStatus = true) {
 
         wxStopWatch sw;
         bool effectsToUpdate = false;
@@ -542,7 +551,7 @@ public:
             Effect* ef = findEffectForFrame(elayer, frame, info.currentEffectIdxs[layer]);
             if (ef != info.currentEffects[layer]) {
                 info.currentEffects[layer] = ef;
-                SetInializingStatus(frame, layer, strand);
+                if (updateStatus) SetInializingStatus(frame, layer, strand);
                 initialize(layer, frame, ef, info.settingsMaps[layer], buffer);
                 info.effectStates[layer] = true;
             }
@@ -569,7 +578,7 @@ public:
                 suppress = buffer->GetSuppressUntil(layer) > GetEffectFrame(ef, frame, mainBuffer->GetFrameTimeInMS());
             }
 
-            SetRenderingStatus(frame, &info.settingsMaps[layer], layer, strand, -1, true);
+            if (updateStatus) SetRenderingStatus(frame, &info.settingsMaps[layer], layer, strand, -1, true);
             bool b = info.effectStates[layer];
 
             if (!freeze)
@@ -608,7 +617,7 @@ public:
                     // I have to calc the output here to apply blend, rotozoom and transitions
                     buffer->CalcOutput(frame, vl, layer);
                     std::vector<bool> done(rb.pixels.size());
-                    rb.CopyNodeColorsToPixels(done);
+                    buffer->CopyNodeColorsToPixels(layer, done);
                     // now fill in any spaces in the buffer that don't have nodes mapped to them
                     parallel_for(0, rb.BufferHt, [&rb, &buffer, &done, &vl, frame](int y) {
                         for (int x = 0; x < rb.BufferWi; x++) {
@@ -639,7 +648,7 @@ public:
         }
 
         if (effectsToUpdate) {
-            SetCalOutputStatus(frame, strand);
+            if (updateStatus) SetCalOutputStatus(frame, strand);
             if (blend) {
                 buffer->SetColors(numLayers, &((*seqData)[frame][0]));
                 info.validLayers[numLayers] = true;
@@ -657,6 +666,97 @@ public:
         return effectsToUpdate;
     }
 
+    // Returns the last frame after frame (up to limit) for which every layer is either empty or holds an effect
+    // that renders each frame independently. Returns frame if the following frames must be rendered in order.
+    // nextCheck is set to the first frame at which the answer could be different so the layers are not
+    // scanned again after every frame.
+    int GetFrameIndependentEnd(int frame, EffectLayerInfo &info, int limit, int &nextCheck) {
+        if (!subModelInfos.empty() || !nodeBuffers.empty() || zeroBased) {
+            nextCheck = END_OF_RENDER_FRAME;
+            return frame;
+        }
+
+        int frameTime = seqData->FrameTime();
+        int last = std::min((int)endFrame, limit);
+        for (int layer = 0; layer < numLayers && last > frame; ++layer) {
+            EffectLayer* elayer = rowToRender->GetEffectLayer(layer);
+            std::unique_lock<std::recursive_mutex> elayerLock(elayer->GetLock());
+            Effect* ef = info.currentEffects[layer];
+            if (ef == nullptr) {
+                // the layer stays empty until the next effect starts
+                for (int e = 0; e < elayer->GetEffectCount(); ++e) {
+                    int st = elayer->GetEffect(e)->GetStartTimeMS();
+                    if (st > frame * frameTime) {
+                        last = std::min(last, (st + frameTime - 1) / frameTime - 1);
+                        break;
+                    }
+                }
+            } else {
+                int effectEnd = (ef->GetEndTimeMS() + frameTime - 1) / frameTime - 1;
+                RenderableEffect* reff = ef->GetEffectIndex() == -1 ? nullptr : xLights->GetEffectManager().GetEffect(ef->GetEffectIndex());
+                // the render cache stores frames as differences from the one before and only saves once
+                // the last frame is added so effects it is caching are always rendered in order
+                if (reff == nullptr || !reff->CanRenderPartialTimeInterval() || !mainBuffer->IsFrameIndependent(layer) ||
+                    !reff->CanRenderOnBackgroundThread(ef, info.settingsMaps[layer], mainBuffer->BufferForLayer(layer, -1)) ||
+                    (reff->SupportsRenderCache(info.settingsMaps[layer]) && xLights->_renderCache.IsEffectOkForCaching(ef))) {
+                    nextCheck = std::max(frame + 1, effectEnd + 1);
+                    return frame;
+                }
+                last = std::min(last, effectEnd);
+            }
+        }
+        nextCheck = std::max(frame + 1, last);
+        return last;
+    }
+
+    // Renders frames first to last of the main model split across the parallel pool. Each thread gets its
+    // own copy of the model buffer and starts its effects from scratch at the first frame it renders.
+    bool RenderFramesInParallel(int first, int last) {
+        static const int MIN_FRAMES_PER_THREAD = 4;
+        int count = last - first + 1;
+        int steps = ParallelJobPool::POOL.calcSteps(MIN_FRAMES_PER_THREAD, count);
+        if (steps < 2) {
+            return false;
+        }
+        int grain = (count + steps - 1) / steps;
+        steps = (count + grain - 1) / grain;
+
+        // the buffers are set up on this thread and released once the span is done
+        std::vector<PixelBufferClassPtr> frameBuffers;
+        while ((int)frameBuffers.size() < steps) {
+            PixelBufferClassPtr buffer(new PixelBufferClass(xLights));
+            if (!InitModelBuffer(*buffer)) {
+                return false;
+            }
+            frameBuffers.push_back(std::move(buffer));
+        }
+
+        SetGenericStatus("%s: Rendering frames %d to " + std::to_string(last) + " in parallel", first, true);
+        parallel_for_range(first, last + 1, [this, first, grain, &frameBuffers](int begin, int end) {
+            PixelBufferClass *buffer = frameBuffers[(begin - first) / grain].get();
+            try {
+                EffectLayerInfo info(numLayers);
+                for (int layer = numLayers - 1; layer >= 0; --layer) {
+                    EffectLayer *elayer = rowToRender->GetEffectLayer(layer);
+                    std::unique_lock<std::recursive_mutex> elock(elayer->GetLock());
+                    info.currentEffects[layer] = findEffectForFrame(elayer, begin, info.currentEffectIdxs[layer]);
+                    initialize(layer, begin, info.currentEffects[layer], info.settingsMaps[layer], buffer);
+                    info.effectStates[layer] = true;
+                }
+                for (int frame = begin; frame < end && !abort; ++frame) {
+                    ProcessFrame(frame, rowToRender, info, buffer, -1, supportsModelBlending, false);
+                }
+            } catch (std::exception &ex) {
+                wxASSERT(false); // so when we debug we catch them
+                renderLog.error("Caught an exception rendering frames in parallel: " + std::string(ex.what()));
+            } catch (...) {
+                wxASSERT(false); // so when we debug we catch them
+                renderLog.error("Caught an unknown exception rendering frames in parallel.");
+            }
+        }, 1, grain);
+        return true;
+    }
+
     virtual void Process() override {
         static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         static log4cpp::Category& logger_jobpool = log4cpp::Category::getInstance(std::string("log_jobpool"));
@@ -799,6 +899,24 @@ public:
                     SetGenericStatus("%s: Notifying next renderer of frame %d done", frame);
                     FrameDone(frame);
                 }
+
+                // a stretch of frames that dont depend on each other is spread across the cores
+                int last = frame;
+                if (frame >= parallelCheckFrame) {
+                    last = GetFrameIndependentEnd(frame, mainModelInfo, maxFrameBeforeCheck, parallelCheckFrame);
+                }
+                if (last - frame >= MIN_PARALLEL_FRAMES && !abort && RenderFramesInParallel(frame + 1, last)) {
+                    if (abort) {
+                        break;
+                    }
+                    for (int f = frame + 1; f <= last; ++f) {
+                        if (HasNext()) {
+                            FrameDone(f);
+                        }
+                    }
+                    frame = last;
+                    currentFrame = frame;
+                }
             }
             SetGenericStatus("%s: All done - Completed frame %d ", endFrame, true, true);
         } catch ( std::exception &ex) {
@@ -862,15 +980,8 @@ private:
             return nullptr;
         }
         int time = frame * seqData->FrameTime();
-        for (int e = lastIdx; e < layer->GetEffectCount(); ++e) {
-            Effect *effect = layer->GetEffect(e);
-            int st = effect->GetStartTimeMS();
-            int et = effect->GetEndTimeMS();
-            if (et > time && st <= time) {
-                return effect;
-            }
-        }
-        return nullptr;
+        int e = layer->GetEffectIndexCoveringTime(time, lastIdx);
+        return e == -1 ? nullptr : layer->GetEffect(e);
     }
 
     Effect *findEffectForFrame(int layer, int frame, int &lastIdx) {
@@ -914,6 +1025,11 @@ private:
     std::vector<EffectLayerInfo *> subModelInfos;
 
     std::map<SNPair, PixelBufferClassPtr> nodeBuffers;
+
+    bool zeroBased;
+    // frames before this are rendered in order without looking for a parallel span
+    int parallelCheckFrame = 0;
+    static const int MIN_PARALLEL_FRAMES = 16;
 };
 
 
@@ -1385,6 +1501,8 @@ void xLightsFrame::Render(const std::list<Model*> models,
     unsigned int count = 0;
     if (clear) {
         for (int f = startFrame; f <= endFrame; f++) {
+            // frames never written are already zero, leave their pages for the render threads to commit
+            if (!SeqData.IsTouched(f)) continue;
             for (const auto& it : ranges) {
                 SeqData[f].Zero(it.start, it.end - it.start + 1);
             }
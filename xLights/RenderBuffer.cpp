@@ -203,7 +203,8 @@ Model* RenderBuffer::GetPermissiveModel() const
 
 std::string RenderBuffer::GetModelName() const
 {
-    Model* m = GetPermissiveModel();
+    // buffers made without a frame, as the self tests do, only have the name
+    Model* m = frame == nullptr ? nullptr : GetPermissiveModel();
 
     if (m != nullptr)
     {
@@ -984,10 +985,28 @@ void RenderBuffer::SetNodePixel(int nodeNum, const xlColor &color, bool dmx_igno
     }
 }
 
-void RenderBuffer::CopyNodeColorsToPixels(std::vector<bool> &done) {
+void RenderBuffer::UpdateNodeCoords() {
+    NodeBufX.resize(Nodes.size());
+    NodeBufY.resize(Nodes.size());
+    for (size_t n = 0; n < Nodes.size(); ++n) {
+        if (Nodes[n]->Coords.empty()) {
+            NodeBufX[n] = NODE_NOT_MAPPED;
+            NodeBufY[n] = NODE_NOT_MAPPED;
+        } else {
+            NodeBufX[n] = Nodes[n]->Coords[0].bufX;
+            NodeBufY[n] = Nodes[n]->Coords[0].bufY;
+        }
+    }
+}
+
+void RenderBuffer::CopyNodeColorsToPixels(std::vector<bool> &done, const xlColor *colors) {
     parallel_for(0, Nodes.size(), [&](int n) {
         xlColor c;
-        Nodes[n]->GetColor(c);
+        if (colors != nullptr) {
+            c = colors[n];
+        } else {
+            Nodes[n]->GetColor(c);
+        }
         for (auto &a : Nodes[n]->Coords) {
             int x = a.bufX;
             int y = a.bufY;
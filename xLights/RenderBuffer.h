@@ -422,7 +422,8 @@ public:
     void SetPixel(int x, int y, const xlColor &color, bool wrap = false, bool useAlpha = false, bool dmx_ignore = false);
     void SetPixel(int x, int y, const HSVValue& hsv, bool wrap = false);
     void SetNodePixel(int nodeNum, const xlColor &color, bool dmx_ignore = false);
-    void CopyNodeColorsToPixels(std::vector<bool> &done);
+    // colors, if given, is used in place of the node colours
+    void CopyNodeColorsToPixels(std::vector<bool> &done, const xlColor *colors = nullptr);
     
     void CopyPixel(int srcx, int srcy, int destx, int desty);
     void ProcessPixel(int x, int y, const xlColor &color, bool wrap_x = false, bool wrap_y = false);
@@ -513,7 +514,13 @@ public:
 
 private:
     friend class PixelBufferClass;
+    friend struct PixelBufferTests;
     std::vector<NodeBaseClassPtr> Nodes;
+    // first buffer coordinate of each node in Nodes held flat so mixing doesnt have to go through the node objects
+    std::vector<int> NodeBufX;
+    std::vector<int> NodeBufY;
+    static const int NODE_NOT_MAPPED = -0x7FFFFFFF;
+    void UpdateNodeCoords();
     PathDrawingContext *_pathDrawingContext = nullptr;
     TextDrawingContext *_textDrawingContext = nullptr;
 
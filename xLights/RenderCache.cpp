@@ -22,6 +22,43 @@
 #include "UtilFunctions.h"
 #include "TraceLog.h"
 
+#ifndef NO_ZSTD
+#include <zstd.h>
+#endif
+
+#if defined(__WXOSX__) || defined(LINUX) || defined(__linux__)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define USE_MMAP_CACHE
+#endif
+
+// Cache files start with the effect properties and a list of models. The original format then holds every
+// frame raw, one model after the other. The compressed format ends the header with RC_HEADEREND_V2 and then
+// has an index entry per frame (offset, size and flags) followed by the frame data. A frame may be stored
+// as the xor with the frame before it and may be zstd compressed.
+static const char* HEADER_END = "RC_HEADEREND";
+static const char* HEADER_END_V2 = "RC_HEADEREND_V2";
+static const int INDEX_ENTRY_SIZE = 13;
+
+// a frame is stored whole at least this often so getting any one frame doesnt need too many decoded
+static const int KEYFRAME_INTERVAL = 32;
+
+#ifndef NO_ZSTD
+// each thread keeps its compression contexts rather than creating them for every frame
+struct ZstdContexts
+{
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    ~ZstdContexts()
+    {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+};
+static thread_local ZstdContexts zstdContexts;
+#endif
+
 #pragma region RenderCache
 
 class RenderCacheLoadThread : public wxThread
@@ -404,15 +441,146 @@ RenderCacheItem::~RenderCacheItem()
 void RenderCacheItem::PurgeFrames()
 {
     _purged = true;
-    for (auto& it : _frames)
-    {
-        for (int x = it.second.size() - 1; x >= 0; --x) {
-            if (it.second[x]) {
-                free(it.second[x]);
-                it.second[x] = nullptr;
+    _frames.clear();
+    UnmapFile();
+}
+
+bool RenderCacheItem::MapFile()
+{
+    if (_fileData != nullptr) return true;
+
+    static log4cpp::Category& logger_rcache = log4cpp::Category::getInstance(std::string("log_rendercache"));
+#ifdef USE_MMAP_CACHE
+    int fd = open(_cacheFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        logger_rcache.warn("RenderCache unable to open " + _cacheFile);
+        return false;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    void* data = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED) {
+        logger_rcache.warn("RenderCache unable to map " + _cacheFile);
+        return false;
+    }
+    _fileData = (const unsigned char*)data;
+    _fileSize = size;
+#else
+    wxFile file;
+    if (!file.Open(_cacheFile)) {
+        logger_rcache.warn("RenderCache unable to open " + _cacheFile);
+        return false;
+    }
+    _fileBuffer.resize(file.Length());
+    if (_fileBuffer.empty() || file.Read(&_fileBuffer[0], _fileBuffer.size()) != (ssize_t)_fileBuffer.size()) {
+        logger_rcache.warn("RenderCache unable to read " + _cacheFile);
+        _fileBuffer.clear();
+        return false;
+    }
+    _fileData = &_fileBuffer[0];
+    _fileSize = _fileBuffer.size();
+#endif
+    return true;
+}
+
+void RenderCacheItem::UnmapFile()
+{
+#ifdef USE_MMAP_CACHE
+    if (_fileData != nullptr) {
+        munmap((void*)_fileData, _fileSize);
+    }
+#endif
+    std::vector<unsigned char>().swap(_fileBuffer);
+    _fileData = nullptr;
+    _fileSize = 0;
+}
+
+const unsigned char* RenderCacheItem::GetFrameData(const CachedFrame& frame)
+{
+    if (!frame.data.empty()) {
+        return &frame.data[0];
+    }
+    if (!MapFile() || frame.offset + frame.size > (long long)_fileSize) {
+        return nullptr;
+    }
+    return _fileData + frame.offset;
+}
+
+// copies every frame still in the file into memory so the file can be rewritten
+bool RenderCacheItem::LoadFrames()
+{
+    for (auto& itm : _frames) {
+        for (auto& it : itm.second.frames) {
+            if ((it.flags & FRAME_PRESENT) && it.data.empty()) {
+                const unsigned char* data = GetFrameData(it);
+                if (data == nullptr) {
+                    return false;
+                }
+                it.data.assign(data, data + it.size);
             }
         }
     }
+    UnmapFile();
+    return true;
+}
+
+// leaves the decoded frame in modelFrames.lastFrame
+bool RenderCacheItem::DecodeFrame(ModelFrames& modelFrames, int frame, long frameSize)
+{
+    auto& frames = modelFrames.frames;
+
+    // walk back to the frame the deltas start from or to the one we last decoded
+    int first = frame;
+    while (first != modelFrames.lastFrameIndex && (frames[first].flags & FRAME_DELTA)) {
+        --first;
+        if (first < 0 || !(frames[first].flags & FRAME_PRESENT)) {
+            return false;
+        }
+    }
+    if (first == modelFrames.lastFrameIndex && first != frame) {
+        ++first;
+    } else if (first == modelFrames.lastFrameIndex) {
+        return true;
+    }
+
+    std::vector<unsigned char> decoded(frameSize);
+    modelFrames.lastFrame.resize(frameSize);
+    for (int f = first; f <= frame; ++f) {
+        const CachedFrame& cf = frames[f];
+        const unsigned char* data = GetFrameData(cf);
+        if (data == nullptr) {
+            modelFrames.lastFrameIndex = -1;
+            return false;
+        }
+        if (cf.flags & FRAME_ZSTD) {
+#ifndef NO_ZSTD
+            size_t sz = ZSTD_decompressDCtx(zstdContexts.dctx, &decoded[0], frameSize, data, cf.size);
+            if (ZSTD_isError(sz) || sz != (size_t)frameSize) {
+                modelFrames.lastFrameIndex = -1;
+                return false;
+            }
+#else
+            modelFrames.lastFrameIndex = -1;
+            return false;
+#endif
+        } else if (cf.size == (uint32_t)frameSize) {
+            memcpy(&decoded[0], data, frameSize);
+        } else {
+            modelFrames.lastFrameIndex = -1;
+            return false;
+        }
+
+        unsigned char* last = &modelFrames.lastFrame[0];
+        if (cf.flags & FRAME_DELTA) {
+            for (long i = 0; i < frameSize; ++i) {
+                last[i] ^= decoded[i];
+            }
+        } else {
+            memcpy(last, &decoded[0], frameSize);
+        }
+        modelFrames.lastFrameIndex = f;
+    }
+    return true;
 }
 
 std::string RenderCacheItem::GetModelName(RenderBuffer* buffer)
@@ -605,41 +773,67 @@ void RenderCacheItem::AddFrame(RenderBuffer* buffer)
         }
     }
 
-    if (_frames.find(mname) == _frames.end())
-    {
-        std::vector<unsigned char *> n;
-        _frames[mname] = n;
+    if (_fileData != nullptr && !LoadFrames()) {
+        logger_base.warn("RenderCacheItem::AddFrame unable to read the existing cache file.");
+        PurgeFrames();
+        return;
     }
 
-    if (frame >= _frames.at(mname).size()) {
+    ModelFrames& modelFrames = _frames[mname];
+    auto& frames = modelFrames.frames;
+    if (frame >= frames.size()) {
         int maxframe = std::max(frame+1,buffer->curEffEndPer - buffer->curEffStartPer + 1);
-        _frames.at(mname).resize(maxframe);
+        frames.resize(maxframe);
     }
 
-    unsigned char* frameBuffer = (unsigned char *)malloc(_frameSize.at(mname));
-    if (frameBuffer == nullptr)
-    {
-        logger_base.warn("RenderCacheItem::AddFrame failed to allocate frameBuffer.");
-        PurgeFrames();
-        wxASSERT(false);
-        return;
+    long frameSize = _frameSize.at(mname);
+    const unsigned char* pixels = (const unsigned char*)&buffer->pixels[0];
+
+    // frames that follow on from the last one are stored as the difference from it which is mostly zeros
+    bool delta = frame % KEYFRAME_INTERVAL != 0 && modelFrames.lastFrameIndex == frame - 1 && (frames[frame - 1].flags & FRAME_PRESENT);
+    std::vector<unsigned char> raw(frameSize);
+    if (delta) {
+        const unsigned char* last = &modelFrames.lastFrame[0];
+        for (long i = 0; i < frameSize; ++i) {
+            raw[i] = pixels[i] ^ last[i];
+        }
+    } else {
+        memcpy(&raw[0], pixels, frameSize);
     }
-    memcpy(frameBuffer, &buffer->pixels[0], _frameSize.at(mname));
 
-    if (_frames.at(mname)[frame] != nullptr) {
-        free(_frames.at(mname)[frame]);
-        _frames.at(mname)[frame] = nullptr;
+    CachedFrame& cf = frames[frame];
+    cf.flags = FRAME_PRESENT | (delta ? FRAME_DELTA : 0);
+    cf.offset = 0;
+#ifndef NO_ZSTD
+    cf.data.resize(ZSTD_compressBound(frameSize));
+    size_t sz = ZSTD_compressCCtx(zstdContexts.cctx, &cf.data[0], cf.data.size(), &raw[0], frameSize, 1);
+    if (!ZSTD_isError(sz) && sz < (size_t)frameSize) {
+        cf.data.resize(sz);
+        cf.data.shrink_to_fit();
+        cf.flags |= FRAME_ZSTD;
+    } else {
+        cf.data.swap(raw);
+    }
+#else
+    cf.data.swap(raw);
+#endif
+    cf.size = cf.data.size();
+
+    // anything stored as a difference from the old content of this frame is no longer valid
+    for (int f = frame + 1; f < frames.size() && (frames[f].flags & FRAME_DELTA); ++f) {
+        frames[f] = CachedFrame();
     }
 
-    _frames.at(mname)[frame] = frameBuffer;
+    modelFrames.lastFrame.assign(pixels, pixels + frameSize);
+    modelFrames.lastFrameIndex = frame;
     _dirty = true;
 
     if (buffer->curPeriod == buffer->curEffEndPer)
     {
-        // if multi models in this cache then only call save when none of them have null pointers at the end
+        // if multi models in this cache then only call save when none of them have missing frames at the end
         for (const auto& itm : _frames)
         {
-            if (itm.second.back() == nullptr)
+            if (itm.second.frames.empty() || !(itm.second.frames.back().flags & FRAME_PRESENT))
             {
                 //logger_base.warn("RenderCacheItem::AddFrame save abandoned due to null frame.");
                 return;
@@ -660,7 +854,7 @@ bool RenderCacheItem::GetFrame(RenderBuffer* buffer)
         return false;
     }
 
-    auto modelFrames = _frames[mname];
+    ModelFrames& modelFrames = _frames[mname];
     if (_frameSize.at(mname) != (sizeof(xlColor) * buffer->pixels.size()))
     {
         logger_rcache.info("RenderCache::GetFrame on model " + mname + " failed due to frame size difference.");
@@ -669,17 +863,43 @@ bool RenderCacheItem::GetFrame(RenderBuffer* buffer)
 
     int frame = buffer->curPeriod - buffer->curEffStartPer;
 
-    if (frame < modelFrames.size() && modelFrames[frame]) {
-        // its in memory ... read it from there
-        unsigned char* pc = modelFrames[frame];
-        memcpy(&buffer->pixels[0], pc, _frameSize.at(mname));
-        return true;
+    if (frame >= 0 && frame < modelFrames.frames.size() && (modelFrames.frames[frame].flags & FRAME_PRESENT)) {
+        if (DecodeFrame(modelFrames, frame, _frameSize.at(mname))) {
+            memcpy(&buffer->pixels[0], &modelFrames.lastFrame[0], _frameSize.at(mname));
+            return true;
+        }
+        logger_rcache.info("RenderCache::GetFrame %d on model %s failed to decode the frame.", frame, (const char*)mname.c_str());
+        return false;
     }
 
     logger_rcache.info("RenderCache::GetFrame %d on model %s failed due to fall through.", frame, (const char*)mname.c_str());
     return false;
 }
 
+static void WriteIndexEntry(unsigned char* p, long long offset, uint32_t size, uint8_t flags)
+{
+    for (int i = 0; i < 8; ++i) {
+        p[i] = (offset >> (i * 8)) & 0xFF;
+    }
+    for (int i = 0; i < 4; ++i) {
+        p[8 + i] = (size >> (i * 8)) & 0xFF;
+    }
+    p[12] = flags;
+}
+
+static void ReadIndexEntry(const unsigned char* p, long long& offset, uint32_t& size, uint8_t& flags)
+{
+    offset = 0;
+    for (int i = 7; i >= 0; --i) {
+        offset = (offset << 8) | p[i];
+    }
+    size = 0;
+    for (int i = 3; i >= 0; --i) {
+        size = (size << 8) | p[8 + i];
+    }
+    flags = p[12];
+}
+
 void RenderCacheItem::Save()
 {
     if (_purged) return;
@@ -688,57 +908,82 @@ void RenderCacheItem::Save()
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     //logger_base.debug("Saving render cache file %s.", (const char *)_cacheFile.c_str());
 
-    char zero = 0x00;
-
     // check all the data is there
     for (const auto& itm : _frames)
     {
-        for (const auto& it : itm.second)
+        for (const auto& it : itm.second.frames)
         {
             // we are missing data
             //wxASSERT(false);
-            if (it == nullptr) return;
+            if (!(it.flags & FRAME_PRESENT)) return;
         }
     }
 
-    wxFile file;
+    // the frames still in the old file need to be read before it is replaced
+    if (_fileData != nullptr && !LoadFrames()) {
+        logger_base.warn("    Failed to read the existing cache file.");
+        return;
+    }
 
-    if (file.Create(_cacheFile, true))
+    std::string header;
+    _properties["Models"] = wxString::Format("%d", (int)_frames.size());
+    // write the header fields
+    for (const auto& it : _properties)
+    {
+        header += it.first;
+        header.push_back(0);
+        header += it.second;
+        header.push_back(0);
+    }
+    header += HEADER_END_V2;
+    header.push_back(0);
+
+    size_t frameCount = 0;
+    for (const auto& it : _frames)
+    {
+        header += it.first;
+        header.push_back(0);
+        header += wxString::Format("%d", (int)it.second.frames.size()).ToStdString();
+        header.push_back(0);
+        header += wxString::Format("%ld", _frameSize.at(it.first)).ToStdString();
+        header.push_back(0);
+        frameCount += it.second.frames.size();
+    }
+
+    // the index of where each frame is
+    std::vector<unsigned char> index(frameCount * INDEX_ENTRY_SIZE);
+    long long offset = header.size() + index.size();
+    unsigned char* entry = index.empty() ? nullptr : &index[0];
+    for (const auto& itm : _frames)
     {
-        _properties["Models"] = wxString::Format("%d", (int)_frames.size());
-        // write the header fields
-        for (const auto& it : _properties)
+        for (const auto& it : itm.second.frames)
         {
-            file.Write(it.first);
-            file.Write(&zero, 1);
-            file.Write(it.second);
-            file.Write(&zero, 1);
+            WriteIndexEntry(entry, offset, it.size, it.flags);
+            entry += INDEX_ENTRY_SIZE;
+            offset += it.size;
         }
+    }
 
-        file.Write("RC_HEADEREND");
-        file.Write(&zero, 1);
+    wxFile file;
 
-        for (const auto& it : _frames)
-        {
-            file.Write(it.first);
-            file.Write(&zero, 1);
-            file.Write(wxString::Format("%d", (int)it.second.size()));
-            file.Write(&zero, 1);
-            file.Write(wxString::Format("%ld", _frameSize.at(it.first)));
-            file.Write(&zero, 1);
+    if (file.Create(_cacheFile, true))
+    {
+        file.Write(header.c_str(), header.size());
+        if (!index.empty()) {
+            file.Write(&index[0], index.size());
         }
 
         // write the frames
         for (const auto& itm : _frames)
         {
-            for (const auto& it : itm.second)
+            for (const auto& it : itm.second.frames)
             {
-                wxASSERT(it != nullptr);
-                file.Write(it, _frameSize.at(itm.first));
+                file.Write(&it.data[0], it.size);
             }
         }
 
         file.Close();
+        _dirty = false;
     }
     else
     {
@@ -750,10 +995,11 @@ bool RenderCacheItem::IsDone(RenderBuffer* buffer) const
 {
     int frame = buffer->curPeriod - buffer->curEffStartPer;
     std::string mname = GetModelName(buffer);
-    auto modelFrames = _frames.at(mname);
-    return modelFrames[frame];
+    const auto& modelFrames = _frames.at(mname).frames;
+    return frame >= 0 && frame < modelFrames.size() && (modelFrames[frame].flags & FRAME_PRESENT);
 }
 
+// only the header and frame index are read here, the frames are read when they are first needed
 RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& filename) : _renderCache(renderCache)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -768,17 +1014,17 @@ RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& fi
     if (file.Open(_cacheFile)) {
         char headerBuffer[8192];
         memset(headerBuffer, 0x00, sizeof(headerBuffer));
-        file.Read(headerBuffer, sizeof(headerBuffer));
+        file.Read(headerBuffer, sizeof(headerBuffer) - 1);
 
         char* ps = headerBuffer;
 
-        while (strcmp(ps, "RC_HEADEREND") != 0) {
+        while (strcmp(ps, HEADER_END) != 0 && strcmp(ps, HEADER_END_V2) != 0) {
             std::string key(ps);
             ps += strlen(ps) + 1;
             std::string value(ps);
             ps += strlen(ps) + 1;
 
-            if (key == "")
+            if (key == "" || ps >= headerBuffer + sizeof(headerBuffer))
             {
                 // file looks corrupt
                 logger_base.debug("Cache file %s appears corrupt.", (const char*)filename.c_str());
@@ -790,10 +1036,12 @@ RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& fi
                 _properties[key] = value;
             }
         }
+        bool compressed = strcmp(ps, HEADER_END_V2) == 0;
         ps += strlen(ps) + 1;
 
         int models = wxAtoi(_properties["Models"]);
 
+        std::vector<std::string> modelOrder;
         for (int i = 0; i < models; i++)
         {
             std::string model(ps);
@@ -805,31 +1053,53 @@ RenderCacheItem::RenderCacheItem(RenderCache* renderCache, const std::string& fi
             ps += strlen(ps) + 1;
             long fsz = wxAtol(frameSize);
 
-            std::vector<unsigned char *> n;
-            _frames[model] = n;
-            _frames.at(model).resize(fs);
+            _frames[model].frames.resize(fs);
             _frameSize[model] = fsz;
+            modelOrder.push_back(model);
         }
 
-        long firstFrameOffset = ps - headerBuffer;
+        long long offset = ps - headerBuffer;
+        long long fileSize = file.Length();
 
-        file.Seek(firstFrameOffset);
-
-        for (auto& itm : _frames)
-        {
-            for (int i = 0; i < itm.second.size(); i++) {
-                unsigned char* frameBuffer = (unsigned char *)malloc(_frameSize.at(itm.first));
-
-                if (frameBuffer == nullptr)
-                {
-                    file.Close();
-                    PurgeFrames();
-                    logger_base.debug("Render Cache Item file %s fails due to memory allocation issue.", (const char*)filename.c_str());
-                    return;
+        if (compressed) {
+            size_t frameCount = 0;
+            for (const auto& it : _frames) {
+                frameCount += it.second.frames.size();
+            }
+            std::vector<unsigned char> index(frameCount * INDEX_ENTRY_SIZE);
+            file.Seek(offset);
+            if (!index.empty() && file.Read(&index[0], index.size()) != (ssize_t)index.size()) {
+                logger_base.debug("Cache file %s appears corrupt.", (const char*)filename.c_str());
+                PurgeFrames();
+                return;
+            }
+            const unsigned char* entry = index.empty() ? nullptr : &index[0];
+            for (auto& itm : _frames) {
+                for (auto& it : itm.second.frames) {
+                    ReadIndexEntry(entry, it.offset, it.size, it.flags);
+                    entry += INDEX_ENTRY_SIZE;
+                    if (it.offset + it.size > fileSize) {
+                        logger_base.debug("Cache file %s appears corrupt.", (const char*)filename.c_str());
+                        PurgeFrames();
+                        return;
+                    }
                 }
-
-                file.Read(frameBuffer, _frameSize.at(itm.first));
-                itm.second[i] = frameBuffer;
+            }
+        } else {
+            // the original format has the raw frames one after the other in the order the models were listed
+            for (const auto& model : modelOrder) {
+                long fsz = _frameSize.at(model);
+                for (auto& it : _frames.at(model).frames) {
+                    it.offset = offset;
+                    it.size = fsz;
+                    it.flags = FRAME_PRESENT;
+                    offset += fsz;
+                }
+            }
+            if (offset > fileSize) {
+                logger_base.debug("Cache file %s appears truncated.", (const char*)filename.c_str());
+                PurgeFrames();
+                return;
             }
         }
 
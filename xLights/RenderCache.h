@@ -15,6 +15,7 @@
 #include <map>
 #include <vector>
 #include <mutex>
+#include <stdint.h>
 
 class Effect;
 class RenderCache;
@@ -24,14 +25,45 @@ class RenderCacheLoadThread;
 
 class RenderCacheItem
 {
+    friend struct RenderCacheTests; // the self test checks how frames were stored and damages cache files
+
+    static const uint8_t FRAME_PRESENT = 0x01;
+    static const uint8_t FRAME_DELTA = 0x02; // xor with the frame before
+    static const uint8_t FRAME_ZSTD = 0x04;
+
+    // A cached frame is held compressed, either in memory when it was rendered this session or as an
+    // offset into the cache file which is only mapped in when a frame is first asked for.
+    struct CachedFrame
+    {
+        std::vector<unsigned char> data;
+        long long offset = 0;
+        uint32_t size = 0;
+        uint8_t flags = 0;
+    };
+    struct ModelFrames
+    {
+        std::vector<CachedFrame> frames;
+        // the last frame added or decoded, deltas are taken against it
+        std::vector<unsigned char> lastFrame;
+        int lastFrameIndex = -1;
+    };
+
     RenderCache* _renderCache;
     std::string _cacheFile;
     std::map<std::string, std::string> _properties;
-    std::map<std::string, std::vector<unsigned char *>> _frames;
+    std::map<std::string, ModelFrames> _frames;
     std::map<std::string, long> _frameSize;
     bool _purged;
     bool _dirty;
+    const unsigned char* _fileData = nullptr;
+    size_t _fileSize = 0;
+    std::vector<unsigned char> _fileBuffer; // holds the file where it cant be mapped
     static std::string GetModelName(RenderBuffer* buffer);
+    bool MapFile();
+    void UnmapFile();
+    bool LoadFrames();
+    const unsigned char* GetFrameData(const CachedFrame& frame);
+    bool DecodeFrame(ModelFrames& modelFrames, int frame, long frameSize);
 
 public:
     RenderCacheItem(RenderCache* renderCache, const std::string& file);
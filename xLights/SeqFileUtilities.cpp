@@ -699,7 +699,8 @@ void xLightsFrame::ClearSequenceData()
 {
     wxASSERT(SeqData.IsValidData());
     for (size_t i = 0; i < SeqData.NumFrames(); ++i)
-        SeqData[i].Zero();
+        if (SeqData.IsTouched(i))
+            SeqData[i].Zero();
 }
 
 void xLightsFrame::RenderIseqData(bool bottom_layers, ConvertLogDialog* plog)
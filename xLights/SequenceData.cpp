@@ -17,7 +17,7 @@
 #include <sys/mman.h>
 #include <mach/vm_statistics.h>
 #define USE_MMAP_BLOCKS
-#elif defined(LINUX)
+#elif defined(LINUX) || defined(__linux__)
 #include <sys/mman.h>
 #define USE_MMAP_BLOCKS
 #else
@@ -38,12 +38,20 @@ static const size_t MAX_BLOCK_SIZE = 1024 * 1024 * 1024;
 #ifdef USE_MMAP_BLOCKS
 std::list<std::unique_ptr<SequenceData::DataBlock>> SequenceData::HUGE_BLOCK_CACHE;
 #include <thread>
+#include <unistd.h>
+#include <wx/filename.h>
 // OSX/Linux allows 2MB huge pages (or Superpages as they call them on OSX)
 static const size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
 static bool firstSeq = true;
 static std::mutex HUGE_BLOCK_LOCK;
 static size_t _hugePageAllocSize = MAX_BLOCK_SIZE;
 static bool _hugePagesFailed;
+#ifdef MAP_NORESERVE
+// pages are committed when first written so dont reserve swap for the whole block up front
+static const int ANON_FLAGS = MAP_NORESERVE;
+#else
+static const int ANON_FLAGS = 0;
+#endif
 #endif
 
 SequenceData::SequenceData() : _invalidFrame()
@@ -113,6 +121,7 @@ SequenceData::DataBlock::~DataBlock()
 void SequenceData::Cleanup()
 {
     _frames.clear();
+    _touchedFrames.clear();
 #ifdef USE_MMAP_BLOCKS
     for (auto& p : _dataBlocks) {
         if (p.get() && p.get()->type == BlockType::HUGE_PAGE) {
@@ -130,12 +139,18 @@ void SequenceData::Cleanup()
     _invalidFrame._data = nullptr;
 }
 
-unsigned char* SequenceData::AllocBlock(size_t requested, size_t& szAllocated, BlockType &blockType)
+unsigned char* SequenceData::AllocBlock(size_t requested, size_t& szAllocated, BlockType &blockType, bool spillToFile)
 {
     unsigned char* data = nullptr;
     size_t sz = requested;
     blockType = BlockType::NORMAL;
 #ifdef USE_MMAP_BLOCKS
+    if (spillToFile) {
+        data = AllocFileBlock(requested, szAllocated, blockType);
+        if (data != nullptr) {
+            return data;
+        }
+    }
     if (sz > MAX_BLOCK_SIZE) {
         sz = MAX_BLOCK_SIZE;
     } else {
@@ -198,7 +213,7 @@ unsigned char* SequenceData::AllocBlock(size_t requested, size_t& szAllocated, B
         //could not get a superpage, we'll use the regular 4K pages
         data = (unsigned char*)mmap(nullptr, sz,
             PROT_READ | PROT_WRITE,
-            MAP_ANON | MAP_PRIVATE,
+            MAP_ANON | MAP_PRIVATE | ANON_FLAGS,
             -1, 0);
         if (data == nullptr || data == MAP_FAILED) {
             //could not allocate the block, we'll try a 128MB block
@@ -206,7 +221,7 @@ unsigned char* SequenceData::AllocBlock(size_t requested, size_t& szAllocated, B
                 sz = 1024 * 1024 * 128;
                 data = (unsigned char*)mmap(nullptr, sz,
                     PROT_READ | PROT_WRITE,
-                    MAP_ANON | MAP_PRIVATE,
+                    MAP_ANON | MAP_PRIVATE | ANON_FLAGS,
                     -1, 0);
             }
         }
@@ -242,10 +257,73 @@ unsigned char* SequenceData::AllocBlock(size_t requested, size_t& szAllocated, B
     }
 #endif
 
+#ifdef USE_MMAP_BLOCKS
+    if (data == nullptr && !spillToFile) {
+        // out of address space or swap, a file backed block can still be paged out to disk
+        return AllocFileBlock(requested, szAllocated, blockType);
+    }
+#endif
+
     szAllocated = sz;
     return data;
 }
 
+// Maps a block onto an unlinked temporary file so a sequence larger than RAM can be paged out to
+// disk rather than swap. The file is sparse so untouched frames take no space.
+unsigned char* SequenceData::AllocFileBlock(size_t requested, size_t& szAllocated, BlockType& blockType)
+{
+#ifdef USE_MMAP_BLOCKS
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    size_t sz = std::min(requested, MAX_BLOCK_SIZE);
+    std::string fn = (wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "xLightsSeqDataXXXXXX").ToStdString();
+    std::vector<char> name(fn.begin(), fn.end());
+    name.push_back(0);
+    int fd = mkstemp(name.data());
+    if (fd < 0) {
+        logger_base.warn("Unable to create sequence data spill file %s.", fn.c_str());
+        return nullptr;
+    }
+    unlink(name.data());
+
+    unsigned char* data = nullptr;
+    if (ftruncate(fd, sz) == 0) {
+        data = (unsigned char*)mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            data = nullptr;
+        }
+    }
+    close(fd);
+
+    if (data == nullptr) {
+        logger_base.warn("Unable to map sequence data spill file of %ld bytes.", (long)sz);
+        return nullptr;
+    }
+    logger_base.debug("Sequence data spilling %ld bytes to a temporary file.", (long)sz);
+    blockType = BlockType::FILE_BACKED;
+    szAllocated = sz;
+    return data;
+#else
+    return nullptr;
+#endif
+}
+
+// Sequences much larger than physical memory are better off spilling to a file than pushing everything else into swap
+bool SequenceData::ShouldSpillToFile(size_t total)
+{
+#ifdef USE_MMAP_BLOCKS
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) {
+        return false;
+    }
+    size_t physical = (size_t)pages * (size_t)pageSize;
+    return total > physical / 4 * 3;
+#else
+    return false;
+#endif
+}
+
 unsigned char *SequenceData::checkBlockPtr(unsigned char *block, size_t sizeRemaining) {
     static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     wxASSERT(block != nullptr); // if this fails then we have a memory allocation error
@@ -273,19 +351,25 @@ void SequenceData::init(unsigned int numChannels, unsigned int numFrames, unsign
     _numFrames = numFrames;
     _frameTime = frameTime;
     _bytesPerFrame = roundTo4(numChannels);
+    _touchedFrames = std::vector<std::atomic_bool>(numFrames);
 
     if (numFrames > 0 && numChannels > 0) {
         _frames.reserve(numFrames);
         size_t sizeRemaining = (size_t)_bytesPerFrame * (size_t)_numFrames;
         size_t blockSize = 0;
-        
+        bool spill = ShouldSpillToFile(sizeRemaining);
+        if (spill) {
+            logger_base.info("Sequence data of %ld bytes is larger than memory, it will be backed by a temporary file.", (long)sizeRemaining);
+        }
+
+        // the blocks are not touched here, pages are committed by whichever thread writes them first
         BlockType type = BlockType::NORMAL;
-        unsigned char* block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type), sizeRemaining);
+        unsigned char* block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type, spill), sizeRemaining);
         _dataBlocks.push_back(std::make_unique<DataBlock>(blockSize, block, type));
         
         for (unsigned int frame = 0; frame < numFrames; ++frame) {
             if (blockSize < _bytesPerFrame) {
-                block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type), sizeRemaining);
+                block = checkBlockPtr(AllocBlock(sizeRemaining, blockSize, type, spill), sizeRemaining);
                 _dataBlocks.push_back(std::make_unique<DataBlock>(blockSize, block, type));
             }
             _frames.push_back(FrameData(_numChannels, block));
@@ -11,8 +11,10 @@
  **************************************************************/
 
 #include <wx/wx.h>
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 class FrameData {
     FrameData(const FrameData&) = delete;
@@ -54,7 +56,8 @@ public:
 class SequenceData {
     enum class BlockType {
         NORMAL,
-        HUGE_PAGE
+        HUGE_PAGE,
+        FILE_BACKED
     };
     class DataBlock {
         DataBlock(const DataBlock&d) = delete;
@@ -74,6 +77,10 @@ class SequenceData {
     FrameData _invalidFrame;
     std::vector<FrameData> _frames;
     std::list<std::unique_ptr<DataBlock>> _dataBlocks;
+    // blocks start zeroed and their pages are only committed when first written. Frames that have never been
+    // handed out for writing dont need clearing and leaving them alone lets the render thread that writes a
+    // frame first decide which NUMA node its pages land on
+    std::vector<std::atomic_bool> _touchedFrames;
     
     unsigned int _bytesPerFrame;
     unsigned int _numChannels;
@@ -85,7 +92,9 @@ class SequenceData {
 
     void Cleanup();
     unsigned char *checkBlockPtr(unsigned char *block, size_t sizeRemaining);
-    static unsigned char *AllocBlock(size_t requested, size_t &szAllocated, BlockType &bt);
+    static unsigned char *AllocBlock(size_t requested, size_t &szAllocated, BlockType &bt, bool spillToFile = false);
+    static unsigned char *AllocFileBlock(size_t requested, size_t &szAllocated, BlockType &bt);
+    static bool ShouldSpillToFile(size_t total);
 public:
     SequenceData();
     virtual ~SequenceData();
@@ -98,6 +107,9 @@ public:
         if (frame >= _numFrames) {
             return _invalidFrame;
         }
+        if (!_touchedFrames[frame].load(std::memory_order_relaxed)) {
+            _touchedFrames[frame].store(true, std::memory_order_relaxed);
+        }
         return _frames[frame];
     }
     const FrameData &operator[](unsigned int frame) const {
@@ -110,6 +122,8 @@ public:
     unsigned int NumChannels() const { return _numChannels;}
     unsigned int NumFrames() const { return _numFrames;}
     unsigned int FrameTime() const { return _frameTime;}
+    // false if the frame has never been written so it is still all zero
+    bool IsTouched(unsigned int frame) const { return frame < _numFrames && _touchedFrames[frame].load(std::memory_order_relaxed); }
     bool IsValidData() const { return !_dataBlocks.empty(); }
 
     // encodes contents of SeqData in channel order
@@ -1063,7 +1063,7 @@ void xLightsFrame::OpenRenderAndSaveSequences(const wxArrayString &origFilenames
     ProgressBar->SetValue(10);
     RenderGridToSeqData([this, sw, fileNames, exitOnDone] {
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-        logger_base.info("   Effects done.");
+        logger_base.info("   Effects done in %ldms.", sw.Time());
         ProgressBar->SetValue(90);
         RenderIseqData(false, nullptr);  // render ISEQ layers above the Nutcracker layer
         logger_base.info("   iseq above effects done. Render complete.");
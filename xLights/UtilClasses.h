@@ -11,6 +11,7 @@
  **************************************************************/
 
 #include <map>
+#include <memory>
 #include <string>
 #include <algorithm>
 
@@ -192,17 +193,68 @@ private:
     static const std::string EMPTY_STRING;
 };
 
+class EffectParameterBlock;
+
 class SettingsMap: public MapStringString {
 public:
     SettingsMap(): MapStringString() {
     }
+    SettingsMap(const SettingsMap &m): MapStringString(m) {
+    }
     virtual ~SettingsMap() {}
 
+    SettingsMap &operator=(const SettingsMap &m) {
+        MapStringString::operator=(m);
+        _parameters.reset();
+        return *this;
+    }
+
     virtual void RemapKey(std::string &n, std::string &value) {
         RemapChangedSettingKey(n, value);
     }
+
+    // the compiled form of the settings used while rendering ... see RenderableEffect::GetValueCurveInt.
+    // It is thrown away when the settings are reloaded or a setting it may have been compiled from could
+    // change, so writing a value through a reference returned by operator[] is seen
+    std::shared_ptr<EffectParameterBlock> &GetParameterBlock() {
+        return _parameters;
+    }
+    using MapStringString::operator[];
+    std::string &operator[](const std::string &key) {
+        SettingChanged(key);
+        return MapStringString::operator[](key);
+    }
+    std::string &operator[](const char *key) {
+        return operator[](std::string(key));
+    }
+    using MapStringString::erase;
+    size_type erase(const std::string &key) {
+        SettingChanged(key);
+        return MapStringString::erase(key);
+    }
+    size_type erase(const char *key) {
+        return erase(std::string(key));
+    }
+    void clear() {
+        MapStringString::clear();
+        _parameters.reset();
+    }
+    void Parse(const std::string &str) {
+        MapStringString::Parse(str);
+        _parameters.reset();
+    }
 private:
     static void RemapChangedSettingKey(std::string &n,  std::string &value);
+
+    // only the value curves, sliders and text controls are compiled
+    void SettingChanged(const std::string &key) {
+        if (_parameters != nullptr &&
+            (key.compare(0, 11, "VALUECURVE_") == 0 || key.compare(0, 7, "SLIDER_") == 0 || key.compare(0, 9, "TEXTCTRL_") == 0)) {
+            _parameters.reset();
+        }
+    }
+
+    std::shared_ptr<EffectParameterBlock> _parameters;
 };
 
 class RangeAccumulator
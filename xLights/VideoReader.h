@@ -39,6 +39,7 @@ public:
 	int GetHeight() const { return _height; };
 	bool AtEnd() const { return _atEnd; };
     int GetPos();
+    int GetFrameMS() const { return _frameMS; }
     std::string GetFilename() const { return _filename; }
     int GetPixelChannels() const { return _wantAlpha ? 4 : 3; }
     static void SetHardwareAcceleratedVideo(bool accel);
@@ -871,7 +871,8 @@ void FPPConnectDialog::OnButton_UploadClick(wxCommandEvent& event)
                                 }
                             }
                         };
-                        parallel_for(instances, func);
+                        std::vector<FPP*> instanceList(instances.begin(), instances.end());
+                        parallel_for(instanceList, func);
                     }
                     row = 0;
                     for (const auto &inst : instances) {
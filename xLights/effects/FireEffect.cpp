@@ -211,10 +211,10 @@ void FireEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer &
         if (buffer.GetMedia() != nullptr)
         {
             float f = 0.0;
-            std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr)
+            const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty())
             {
-                f = *pf->cbegin();
+                f = pf.front();
             }
             HeightPct += 90 * f;
         }
@@ -27,6 +27,9 @@
 
 #include "../Parallel.h"
 
+#include <algorithm>
+#include <vector>
+
 MeteorsEffect::MeteorsEffect(int id) : RenderableEffect(id, "Meteors", meteors_16, meteors_24, meteors_32, meteors_48, meteors_64)
 {
     //ctor
@@ -112,8 +115,8 @@ public:
     HSVValue hsv;
 };
 
-typedef std::list<MeteorClass> MeteorList;
-typedef std::list<MeteorRadialClass> MeteorRadialList;
+typedef std::vector<MeteorClass> MeteorList;
+typedef std::vector<MeteorRadialClass> MeteorRadialList;
 
 class MeteorsRenderCache : public EffectRenderCache {
 public:
@@ -182,9 +185,9 @@ void MeteorsEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffe
     if (SettingsMap.GetBool("CHECKBOX_Meteors_UseMusic", false)) {
         float f = 0.0;
         if (buffer.GetMedia() != nullptr) {
-            std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-            if (pf != nullptr) {
-                f = *pf->cbegin();
+            const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+            if (!pf.empty()) {
+                f = pf.front();
             }
         }
         Count = (float)Count * f;
@@ -319,7 +322,7 @@ void MeteorsEffect::RenderMeteorsHorizontal(RenderBuffer &buffer, int ColorSchem
     parallel_for(cache->meteors, f, 500);
 
     // delete old meteors
-    cache->meteors.remove_if(MeteorHasExpiredX(TailLength));
+    cache->meteors.erase(std::remove_if(cache->meteors.begin(), cache->meteors.end(), MeteorHasExpiredX(TailLength)), cache->meteors.end());
 }
 
 /*
@@ -422,7 +425,7 @@ void MeteorsEffect::RenderMeteorsVertical(RenderBuffer &buffer, int ColorScheme,
 
 
     // delete old meteors
-    cache->meteors.remove_if(MeteorHasExpiredY(TailLength));
+    cache->meteors.erase(std::remove_if(cache->meteors.begin(), cache->meteors.end(), MeteorHasExpiredY(TailLength)), cache->meteors.end());
 }
 
 #define numents(thing)  (sizeof(thing) / sizeof(thing[0]))
@@ -506,7 +509,7 @@ void MeteorsEffect::RenderIcicleDrip(RenderBuffer &buffer, int ColorScheme, int
 
     // delete old meteors
     //    meteors.remove_if(MeteorHasExpiredY(TailLength));
-    cache->meteors.remove_if(IcicleHasExpired());
+    cache->meteors.erase(std::remove_if(cache->meteors.begin(), cache->meteors.end(), IcicleHasExpired()), cache->meteors.end());
 }
 
 /*
@@ -641,7 +644,7 @@ void MeteorsEffect::RenderMeteorsImplode(RenderBuffer &buffer, int ColorScheme,
     parallel_for(cache->meteorsRadial, f, 500);
 
     // delete old meteors
-    cache->meteorsRadial.remove_if(MeteorHasExpiredImplode(buffer.BufferWi/2+truexoffset,buffer.BufferHt/2+trueyoffset));
+    cache->meteorsRadial.erase(std::remove_if(cache->meteorsRadial.begin(), cache->meteorsRadial.end(), MeteorHasExpiredImplode(buffer.BufferWi/2+truexoffset,buffer.BufferHt/2+trueyoffset)), cache->meteorsRadial.end());
 }
 
 /*
@@ -774,6 +777,6 @@ void MeteorsEffect::RenderMeteorsExplode(RenderBuffer &buffer, int ColorScheme,
     parallel_for(cache->meteorsRadial, f, 500);
 
     // delete old meteors
-    cache->meteorsRadial.remove_if(MeteorHasExpiredExplode(buffer.BufferHt,buffer.BufferWi));
+    cache->meteorsRadial.erase(std::remove_if(cache->meteorsRadial.begin(), cache->meteorsRadial.end(), MeteorHasExpiredExplode(buffer.BufferHt,buffer.BufferWi)), cache->meteorsRadial.end());
 }
 
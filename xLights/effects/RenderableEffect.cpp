@@ -20,7 +20,9 @@
 #include <wx/notebook.h>
 #include <wx/spinctrl.h>
 
+#include <cmath>
 #include <sstream>
+#include <unordered_map>
 #include "../UtilFunctions.h"
 #include "../ValueCurveButton.h"
 #include "PixelBuffer.h"
@@ -903,87 +905,216 @@ void RenderableEffect::SetRadioValue(wxRadioButton *r) {
 
 static const std::string EMPTY_STRING("");
 
-double RenderableEffect::GetValueCurveDouble(const std::string &name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor)
+// GetValueCurveInt/GetValueCurveDouble are called for several settings on every frame. The first time a
+// parameter is asked for it is given a slot in a block kept with the SettingsMap and its value curve is parsed
+// into that slot. SettingsMap drops the block whenever a setting a parameter is compiled from may be written
+// or erased and when the settings are reloaded, so a lookup never has to look at the settings. Names passed
+// as string literals are matched to their slot by address so each frame a lookup is a pointer compare and an
+// array index. Random value curves pick new points every time they are parsed so they are never kept.
+class EffectParameterBlock
 {
-    double res = def;
-    const std::string vn = "VALUECURVE_" + name;
-    const std::string &vc = SettingsMap.Get(vn, EMPTY_STRING);
-    if (vc != EMPTY_STRING) {
-        ValueCurve valc(vc);
-        if (valc.IsActive()) {
-            bool needsUpgrade = (vc.find("RV=TRUE") == std::string::npos);
-            valc.SetLimits(min, max);
-            valc.SetDivisor(divisor);
-
-            // If we ask for a double we always want it pre-divided
-            //if (slider)
-            //{
-            //    res = valc.GetOutputValueAt(offset);
-            //}
-            //else
-            //{
-                res = valc.GetOutputValueAtDivided(offset, startMS, endMS);
-            //}
-
-            if (needsUpgrade) {
-                SettingsMap[vn] = valc.Serialise();
+public:
+    struct Parameter
+    {
+        // what the parameter was compiled for
+        bool compiled = false;
+        double min = 0;
+        double max = 0;
+        int divisor = 1;
+        long startMS = 0;
+        long endMS = 0;
+
+        bool hasCurve = false;
+        bool randomCurve = false;
+        ValueCurve curve;
+        bool hasValue = false;
+        int intValue = 0;
+        double doubleValue = 0;
+
+        bool Matches(double mn, double mx, int d, long s, long e) const {
+            return compiled && !randomCurve && min == mn && max == mx && divisor == d && startMS == s && endMS == e;
+        }
+
+        void Start(double mn, double mx, int d, long s, long e) {
+            *this = Parameter();
+            compiled = true;
+            min = mn;
+            max = mx;
+            divisor = d;
+            startMS = s;
+            endMS = e;
+        }
+    };
+
+    struct Slot
+    {
+        std::string name;
+        Parameter intParameter;
+        Parameter doubleParameter;
+    };
+
+    int GetSlot(const std::string& name) {
+        auto it = slotsByName.find(name);
+        if (it != slotsByName.end()) return it->second;
+        slots.emplace_back();
+        slots.back().name = name;
+        int slot = (int)slots.size() - 1;
+        slotsByName[name] = slot;
+        return slot;
+    }
+
+    // effects ask for the same literals in the same order every frame so the search starts after the last one found
+    int GetSlot(const char* name) {
+        size_t n = literalSlots.size();
+        for (size_t i = 0; i < n; i++) {
+            size_t j = nextLiteral + i;
+            if (j >= n) j -= n;
+            if (literalSlots[j].first == name) {
+                nextLiteral = j + 1 < n ? j + 1 : 0;
+                return literalSlots[j].second;
             }
-            return res;
         }
+        int slot = GetSlot(std::string(name));
+        literalSlots.emplace_back(name, slot);
+        nextLiteral = 0;
+        return slot;
     }
-    
-    const std::string sn = "SLIDER_" + name;
-    const std::string tn = "TEXTCTRL_" + name;
-    if (SettingsMap.Contains(sn)) {
-        res = SettingsMap.GetDouble(sn, def);
-    } else if (SettingsMap.Contains(tn)) {
-        res = SettingsMap.GetDouble(tn, def);
+
+    std::vector<Slot> slots;
+    std::unordered_map<std::string, int> slotsByName;
+    std::vector<std::pair<const char*, int>> literalSlots;
+    size_t nextLiteral = 0;
+};
+
+static EffectParameterBlock& GetParameterBlock(SettingsMap& settings)
+{
+    auto& block = settings.GetParameterBlock();
+    if (block == nullptr) {
+        block = std::make_shared<EffectParameterBlock>();
     }
-    return res;
+    return *block;
 }
 
-int RenderableEffect::GetValueCurveInt(const std::string &name, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor)
+static double GetSlotValueCurveDouble(EffectParameterBlock::Slot& slot, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor)
 {
-    int res = def;
-    const std::string vn = "VALUECURVE_" + name;
-    if (SettingsMap.Contains(vn)) {
+    EffectParameterBlock::Parameter& p = slot.doubleParameter;
+    // writing back an upgraded curve drops the block from the settings, keep it until we are done with the parameter
+    std::shared_ptr<EffectParameterBlock> block;
+    if (!p.Matches(min, max, divisor, startMS, endMS)) {
+        block = SettingsMap.GetParameterBlock();
+        p.Start(min, max, divisor, startMS, endMS);
+
+        const std::string vn = "VALUECURVE_" + slot.name;
         const std::string &vc = SettingsMap.Get(vn, EMPTY_STRING);
+        if (vc != EMPTY_STRING) {
+            p.curve.Deserialise(vc);
+            if (p.curve.IsActive()) {
+                bool needsUpgrade = (vc.find("RV=TRUE") == std::string::npos);
+                p.curve.SetLimits(min, max);
+                p.curve.SetDivisor(divisor);
+                p.hasCurve = true;
+                p.randomCurve = p.curve.GetType() == "Random";
 
-        ValueCurve valc;
-        valc.SetDivisor(divisor);
-        valc.SetLimits(min, max);
-        valc.Deserialise(vc);
-        if (valc.IsActive()) {
-            bool needsUpgrade = (vc.find("RV=TRUE") == std::string::npos);
-            // If we ask for an int then we seem to want it undivided
-            //if (!slider)
-            //{
-                res = valc.GetOutputValueAt(offset, startMS, endMS);
-            //}
-            //else
-            //{
-            //    res = valc.GetOutputValueAtDivided(offset);
-            //}
-
-            if (needsUpgrade) {
-                // this updates the settings map ... but not the actual settings on the effect ... 
-                // this is a problem as the error will keep occuring next time the sequence is loaded.
-                // To fix it the user needs to click on the offending effect and save and it will go away
-                SettingsMap[vn] = valc.Serialise();
+                if (needsUpgrade) {
+                    SettingsMap[vn] = p.curve.Serialise();
+                }
+            }
+        }
+
+        if (!p.hasCurve) {
+            const std::string sn = "SLIDER_" + slot.name;
+            const std::string tn = "TEXTCTRL_" + slot.name;
+            const std::string *key = SettingsMap.Contains(sn) ? &sn : SettingsMap.Contains(tn) ? &tn : nullptr;
+            if (key != nullptr) {
+                // GetDouble returns the default when the value is missing or invalid
+                p.doubleValue = SettingsMap.GetDouble(*key, NAN);
+                p.hasValue = !std::isnan(p.doubleValue);
             }
-            return res;
         }
     }
-    const std::string sn = "SLIDER_" + name;
-    const std::string tn = "TEXTCTRL_" + name;
-    //bool slider = false;
-    if (SettingsMap.Contains(sn)) {
-        res = SettingsMap.GetInt(sn, def);
-        //slider = true;
-    } else if (SettingsMap.Contains(tn)) {
-        res = SettingsMap.GetInt(tn, def);
+
+    if (p.hasCurve) {
+        // If we ask for a double we always want it pre-divided
+        return p.curve.GetOutputValueAtDivided(offset, startMS, endMS);
     }
-    return res;
+    return p.hasValue ? p.doubleValue : def;
+}
+
+static int GetSlotValueCurveInt(EffectParameterBlock::Slot& slot, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor)
+{
+    EffectParameterBlock::Parameter& p = slot.intParameter;
+    // writing back an upgraded curve drops the block from the settings, keep it until we are done with the parameter
+    std::shared_ptr<EffectParameterBlock> block;
+    if (!p.Matches(min, max, divisor, startMS, endMS)) {
+        block = SettingsMap.GetParameterBlock();
+        p.Start(min, max, divisor, startMS, endMS);
+
+        const std::string vn = "VALUECURVE_" + slot.name;
+        if (SettingsMap.Contains(vn)) {
+            const std::string &vc = SettingsMap.Get(vn, EMPTY_STRING);
+
+            p.curve.SetDivisor(divisor);
+            p.curve.SetLimits(min, max);
+            p.curve.Deserialise(vc);
+            if (p.curve.IsActive()) {
+                bool needsUpgrade = (vc.find("RV=TRUE") == std::string::npos);
+                p.hasCurve = true;
+                p.randomCurve = p.curve.GetType() == "Random";
+
+                if (needsUpgrade) {
+                    // this updates the settings map ... but not the actual settings on the effect ...
+                    // this is a problem as the error will keep occuring next time the sequence is loaded.
+                    // To fix it the user needs to click on the offending effect and save and it will go away
+                    SettingsMap[vn] = p.curve.Serialise();
+                }
+            }
+        }
+
+        if (!p.hasCurve) {
+            const std::string sn = "SLIDER_" + slot.name;
+            const std::string tn = "TEXTCTRL_" + slot.name;
+            const std::string *key = SettingsMap.Contains(sn) ? &sn : SettingsMap.Contains(tn) ? &tn : nullptr;
+            if (key != nullptr) {
+                // GetInt returns the default when the value is missing or invalid so ask twice with different defaults to tell
+                p.intValue = SettingsMap.GetInt(*key, 0);
+                p.hasValue = p.intValue != 0 || SettingsMap.GetInt(*key, 1) == 0;
+            }
+        }
+    }
+
+    if (p.hasCurve) {
+        // If we ask for an int then we seem to want it undivided
+        return p.curve.GetOutputValueAt(offset, startMS, endMS);
+    }
+    return p.hasValue ? p.intValue : def;
+}
+
+double RenderableEffect::GetValueCurveDouble(const std::string &name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor)
+{
+    EffectParameterBlock& block = GetParameterBlock(SettingsMap);
+    int slot = block.GetSlot(name);
+    return GetSlotValueCurveDouble(block.slots[slot], def, SettingsMap, offset, min, max, startMS, endMS, divisor);
+}
+
+double RenderableEffect::GetValueCurveDouble(const char *name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor)
+{
+    EffectParameterBlock& block = GetParameterBlock(SettingsMap);
+    int slot = block.GetSlot(name);
+    return GetSlotValueCurveDouble(block.slots[slot], def, SettingsMap, offset, min, max, startMS, endMS, divisor);
+}
+
+int RenderableEffect::GetValueCurveInt(const std::string &name, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor)
+{
+    EffectParameterBlock& block = GetParameterBlock(SettingsMap);
+    int slot = block.GetSlot(name);
+    return GetSlotValueCurveInt(block.slots[slot], def, SettingsMap, offset, min, max, startMS, endMS, divisor);
+}
+
+int RenderableEffect::GetValueCurveInt(const char *name, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor)
+{
+    EffectParameterBlock& block = GetParameterBlock(SettingsMap);
+    int slot = block.GetSlot(name);
+    return GetSlotValueCurveInt(block.slots[slot], def, SettingsMap, offset, min, max, startMS, endMS, divisor);
 }
 
 EffectLayer* RenderableEffect::GetTiming(const std::string& timingtrack) const
@@ -53,6 +53,8 @@ class RenderableEffect
         virtual std::list<std::string> GetFacesUsed(const SettingsMap &SettingsMap) const { return std::list<std::string>(); }
         virtual bool CleanupFileLocations(xLightsFrame* frame, SettingsMap &SettingsMap) { return false; }
         virtual bool AppropriateOnNodes() const { return true; }
+        // true if each frame is rendered without reference to the frames before it, such effects can have
+        // their frames rendered out of order and spread across threads
         virtual bool CanRenderPartialTimeInterval() const { return false; }
         virtual bool PressButton(const std::string& id, SettingsMap& paletteMap, SettingsMap& settings) { return false; }
 
@@ -92,8 +94,11 @@ class RenderableEffect
         static void SetTextValue(wxTextCtrl* choice, std::string value);
         static void SetCheckBoxValue(wxCheckBox *w, bool b);
 
-        double GetValueCurveDouble(const std::string & name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor = 1);
-        int GetValueCurveInt(const std::string &name, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor = 1);
+        static double GetValueCurveDouble(const std::string & name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor = 1);
+        static int GetValueCurveInt(const std::string &name, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor = 1);
+        // name must be a string literal, it is matched to its compiled parameter by address
+        static double GetValueCurveDouble(const char *name, double def, SettingsMap &SettingsMap, float offset, double min, double max, long startMS, long endMS, int divisor = 1);
+        static int GetValueCurveInt(const char *name, int def, SettingsMap &SettingsMap, float offset, int min, int max, long startMS, long endMS, int divisor = 1);
         EffectLayer* GetTiming(const std::string& timingtrack) const;
         Effect* GetCurrentTiming(const RenderBuffer& buffer, const std::string& timingtrack) const;
         std::string GetTimingTracks(const int maxLayers = 0, const int absoluteLayers = 0) const;
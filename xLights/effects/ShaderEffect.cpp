@@ -790,8 +790,8 @@ void ShaderEffect::Render(Effect* eff, SettingsMap& SettingsMap, RenderBuffer& b
         {
             auto fftData = audioManager->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-            std::vector<float> fft128(fftData->cbegin(), fftData->cend());
-            fft128.push_back( 0.f );
+            std::vector<float> fft128(fftData.cbegin(), fftData.cend());
+            fft128.resize(128, 0.f);
 
             LOG_GL_ERRORV(glActiveTexture(GL_TEXTURE0));
             LOG_GL_ERRORV(glBindTexture(GL_TEXTURE_2D, s_audioTex));
@@ -877,14 +877,14 @@ void ShaderEffect::Render(Effect* eff, SettingsMap& SettingsMap, RenderBuffer& b
             {
             case ShaderParmType::SHADER_PARM_FLOAT:
             {
-                double f = GetValueCurveDouble(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE), it._default * 100.0, SettingsMap, oset, it._min * 100.0, it._max * 100.0, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
+                double f = GetValueCurveDouble(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE).ToStdString(), it._default * 100.0, SettingsMap, oset, it._min * 100.0, it._max * 100.0, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
                 glUniform1f(loc, f);
                 break;
             }
             case ShaderParmType::SHADER_PARM_POINT2D:
             {
-                double x = GetValueCurveDouble(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE) + "X", it._defaultPt.x * 100, SettingsMap, oset, it._minPt.x * 100, it._maxPt.x * 100, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
-                double y = GetValueCurveDouble(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE) + "Y", it._defaultPt.y * 100, SettingsMap, oset, it._minPt.y * 100, it._maxPt.y * 100, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
+                double x = GetValueCurveDouble(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE).ToStdString() + "X", it._defaultPt.x * 100, SettingsMap, oset, it._minPt.x * 100, it._maxPt.x * 100, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
+                double y = GetValueCurveDouble(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE).ToStdString() + "Y", it._defaultPt.y * 100, SettingsMap, oset, it._minPt.y * 100, it._maxPt.y * 100, buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1) / 100.0;
                 glUniform2f(loc, x, y);
                 break;
             }
@@ -925,7 +925,7 @@ void ShaderEffect::Render(Effect* eff, SettingsMap& SettingsMap, RenderBuffer& b
             }
             case ShaderParmType::SHADER_PARM_LONG:
             {
-                long l = GetValueCurveInt(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE), it._default, SettingsMap, oset, it._min, it._max,
+                long l = GetValueCurveInt(it.GetUndecoratedId(ShaderCtrlType::SHADER_CTRL_VALUECURVE).ToStdString(), it._default, SettingsMap, oset, it._min, it._max,
                     buffer.GetStartTimeMS(), buffer.GetEndTimeMS(), 1);
                 glUniform1i(loc, l);
                 break;
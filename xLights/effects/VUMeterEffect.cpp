@@ -280,9 +280,9 @@ public:
     virtual ~VUMeterRenderCache() {};
 	std::list<int> _timingmarks; // collection of recent timing marks ... used for sweep
 	int _lasttimingmark; // last time we saw a timing mark ... used for pulse
-	std::list<float> _lastvalues;
-	std::list<float> _lastpeaks;
-    std::list<int> _pausepeakfall;
+	std::vector<float> _lastvalues;
+	std::vector<float> _lastpeaks;
+    std::vector<int> _pausepeakfall;
     std::list<std::vector<wxPoint>> _lineHistory;
 	float _lastsize;
     int _colourindex;
@@ -553,9 +553,9 @@ void VUMeterEffect::Render(RenderBuffer &buffer, SequenceElements *elements, int
 	}
 	std::list<int>& _timingmarks = cache->_timingmarks;
 	int &_lasttimingmark = cache->_lasttimingmark;
-	std::list<float>& _lastvalues = cache->_lastvalues;
-	std::list<float>& _lastpeaks = cache->_lastpeaks;
-	std::list<int>& _pausepeakfall = cache->_pausepeakfall;
+	std::vector<float>& _lastvalues = cache->_lastvalues;
+	std::vector<float>& _lastpeaks = cache->_lastpeaks;
+	std::vector<int>& _pausepeakfall = cache->_pausepeakfall;
     int& _nCount = cache->_nCount;
 	float& _lastsize = cache->_lastsize;
     int & _colourindex = cache->_colourindex;
@@ -717,36 +717,33 @@ void VUMeterEffect::Render(RenderBuffer &buffer, SequenceElements *elements, int
 	}
 }
 
-void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, std::list<float>& lastvalues, std::list<float>& lastpeaks, std::list<int>& pauseuntilpeakfall, bool slowdownfalls, int startNote, int endNote, int xoffset, int yoffset, bool peak, int peakhold, bool line, bool logarithmicX, bool circle, int gain, int sensitivity, std::list<std::vector<wxPoint>>& lineHistory) const
+void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, std::vector<float>& lastvalues, std::vector<float>& lastpeaks, std::vector<int>& pauseuntilpeakfall, bool slowdownfalls, int startNote, int endNote, int xoffset, int yoffset, bool peak, int peakhold, bool line, bool logarithmicX, bool circle, int gain, int sensitivity, std::list<std::vector<wxPoint>>& lineHistory) const
 {
     if (buffer.GetMedia() == nullptr) return;
 
     int truexoffset = xoffset * buffer.BufferWi / 100;
     int trueyoffset = yoffset * buffer.BufferHt / 100;
-	std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+	const FrameDataSpan pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
     while (lineHistory.size() > sensitivity / 10)
     {
         lineHistory.pop_front();
     }
 
-	if (pdata != nullptr && pdata->size() != 0)
+	if (!pdata.empty())
 	{
         if (peak)
         {
             if (lastvalues.size() == 0)
             {
-                lastvalues = *pdata;
-                lastpeaks = *pdata;
-                for (auto it = lastvalues.begin(); it != lastvalues.end(); ++it)
-                {
-                    pauseuntilpeakfall.push_back(0);
-                }
+                lastvalues.assign(pdata.begin(), pdata.end());
+                lastpeaks.assign(pdata.begin(), pdata.end());
+                pauseuntilpeakfall.resize(pauseuntilpeakfall.size() + lastvalues.size(), 0);
             }
             else
             {
-                std::list<float>::const_iterator newdata = pdata->cbegin();
-                std::list<float>::iterator olddata = lastpeaks.begin();
+                auto newdata = pdata.cbegin();
+                auto olddata = lastpeaks.begin();
                 auto pause = pauseuntilpeakfall.begin();
 
                 while (olddata != lastpeaks.end())
@@ -780,12 +777,12 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		{
 			if (lastvalues.size() == 0)
 			{
-				lastvalues = *pdata;
+				lastvalues.assign(pdata.begin(), pdata.end());
 			}
 			else
 			{
-				std::list<float>::const_iterator newdata = pdata->cbegin();
-				std::list<float>::iterator olddata = lastvalues.begin();
+				auto newdata = pdata.cbegin();
+				auto olddata = lastvalues.begin();
 
 				while (olddata != lastvalues.end())
 				{
@@ -809,10 +806,10 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
 		}
 		else
 		{
-			lastvalues = *pdata;
+			lastvalues.assign(pdata.begin(), pdata.end());
 		}
 
-        int datapoints = std::min((int)pdata->size(), endNote - startNote + 1);
+        int datapoints = std::min((int)pdata.size(), endNote - startNote + 1);
 
 		if (usebars > datapoints)
 		{
@@ -829,8 +826,8 @@ void VUMeterEffect::RenderSpectrogramFrame(RenderBuffer &buffer, int usebars, st
         {
             cols = 1;
         }
-		std::list<float>::iterator it = lastvalues.begin();
-		std::list<float>::iterator itpeak = lastpeaks.begin();
+		auto it = lastvalues.begin();
+		auto itpeak = lastpeaks.begin();
         int midiNote = 0;
         // skip to our start note
         for (int i = 0; i < startNote; i++)
@@ -1028,10 +1025,10 @@ void VUMeterEffect::RenderVolumeBarsFrame(RenderBuffer &buffer, int usebars, int
 		if (start + i >= 0)
 		{
 			float f = 0.0;
-			std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (!pf.empty())
 			{
-				f = ApplyGain(*pf->cbegin(), gain);
+				f = ApplyGain(pf.front(), gain);
 			}
 			for (int j = 0; j < cols; j++)
 			{
@@ -1112,16 +1109,16 @@ void VUMeterEffect::RenderWaveformFrame(RenderBuffer &buffer, int usebars, int y
             if (start + i >= 0)
             {
                 float fh = 0.0;
-                std::list<float> const * pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-                if (pf != nullptr)
+                FrameDataSpan pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+                if (!pf.empty())
                 {
-                    fh = ApplyGain(*pf->cbegin(), gain);
+                    fh = ApplyGain(pf.front(), gain);
                 }
                 float fl = 0.0;
                 pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_LOW, "");
-                if (pf != nullptr)
+                if (!pf.empty())
                 {
-                    fl = ApplyGain(*pf->cbegin(), gain);
+                    fl = ApplyGain(pf.front(), gain);
                 }
                 int s = (1.0 - fl) * buffer.BufferHt / 2;
                 int e = (1.0 + fh) * buffer.BufferHt / 2;
@@ -1313,10 +1310,10 @@ void VUMeterEffect::RenderOnFrame(RenderBuffer& buffer, int gain)
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-	std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (!pf.empty())
 	{
-		f = ApplyGain(*pf->cbegin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 	xlColor color1;
 	buffer.palette.GetColor(0, color1);
@@ -1337,14 +1334,14 @@ void VUMeterEffect::RenderDominantFrequencyColour(RenderBuffer& buffer, int sens
 
     float sns = (float)sensitivity / 100.0;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    const FrameDataSpan pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int note = -1;
         float max = -1000;
-        auto it = pdata->cbegin();
-        for (int i = 0; i < std::min((int)pdata->size(), endnote+1); i++)
+        auto it = pdata.cbegin();
+        for (int i = 0; i < std::min((int)pdata.size(), endnote+1); i++)
         {
             if (i >= startnote)
             {
@@ -1387,10 +1384,10 @@ void VUMeterEffect::RenderOnColourFrame(RenderBuffer& buffer, int gain)
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (!pf.empty())
     {
-        f = ApplyGain(*pf->cbegin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     xlColor color1;
@@ -1466,10 +1463,10 @@ void VUMeterEffect::RenderIntensityWaveFrame(RenderBuffer &buffer, int usebars,
 		if (start + i >= 0)
 		{
 			float f = 0.0;
-			std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
-			if (pf != nullptr)
+			const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(start + i, FRAMEDATA_HIGH, "");
+			if (!pf.empty())
 			{
-				f = ApplyGain(*pf->begin(), gain);
+				f = ApplyGain(pf.front(), gain);
 			}
 			xlColor color1;
 			if (buffer.palette.Size() < 2)
@@ -1502,10 +1499,10 @@ void VUMeterEffect::RenderLevelPulseFrame(RenderBuffer &buffer, int fadeframes,
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-	std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (!pf.empty())
 	{
-		f = ApplyGain(*pf->cbegin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 
 	if (f > (float)sensitivity / 100.0)
@@ -1543,10 +1540,10 @@ void VUMeterEffect::RenderLevelJumpFrame(RenderBuffer& buffer, int fadeframes, i
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (!pf.empty())
     {
-        f = ApplyGain(*pf->cbegin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -1591,10 +1588,10 @@ void VUMeterEffect::RenderLevelPulseColourFrame(RenderBuffer &buffer, int fadefr
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (!pf.empty())
     {
-        f = ApplyGain(*pf->begin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -1641,10 +1638,10 @@ void VUMeterEffect::RenderLevelColourFrame(RenderBuffer &buffer, int& colourinde
     if (buffer.GetMedia() == nullptr) return;
 
     float f = 0.0;
-    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-    if (pf != nullptr)
+    const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    if (!pf.empty())
     {
-        f = ApplyGain(*pf->begin(), gain);
+        f = ApplyGain(pf.front(), gain);
     }
 
     if (f > (float)sensitivity / 100.0)
@@ -2091,10 +2088,10 @@ void VUMeterEffect::RenderLevelShapeFrame(RenderBuffer& buffer, const std::strin
     float scaling = (float)scale / 100.0 * 7.0;
 
 	float f = 0.0;
-	std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-	if (pf != nullptr)
+	const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+	if (!pf.empty())
 	{
-		f = ApplyGain(*pf->begin(), gain);
+		f = ApplyGain(pf.front(), gain);
 	}
 
 	int centerx = (buffer.BufferWi / 2.0) + truexoffset;
@@ -2384,10 +2381,10 @@ void VUMeterEffect::RenderTimingEventJumpFrame(RenderBuffer &buffer, int fallfra
                 if (useAudioLevel)
                 {
                     float f = 0.0;
-                    std::list<float> const * const pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
-                    if (pf != nullptr)
+                    const FrameDataSpan pf = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+                    if (!pf.empty())
                     {
-                        f = ApplyGain(*pf->cbegin(), gain);
+                        f = ApplyGain(pf.front(), gain);
                     }
                     lastsize = f;
                 }
@@ -2594,13 +2591,13 @@ void VUMeterEffect::RenderNoteOnFrame(RenderBuffer& buffer, int startNote, int e
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    const FrameDataSpan pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata)
+        for (const auto& it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2629,13 +2626,13 @@ void VUMeterEffect::RenderNoteLevelPulseFrame(RenderBuffer& buffer, int fadefram
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float>const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    const FrameDataSpan pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata)
+        for (const auto& it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2681,13 +2678,13 @@ void VUMeterEffect::RenderNoteLevelJumpFrame(RenderBuffer& buffer, int fadeframe
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    const FrameDataSpan pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata)
+        for (const auto& it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
@@ -2739,11 +2736,11 @@ void VUMeterEffect::RenderLevelBarFrame(RenderBuffer &buffer, int bars, int sens
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
+    const FrameDataSpan pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_HIGH, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
-        float level = ApplyGain(pdata->front(), gain);
+        float level = ApplyGain(pdata.front(), gain);
 
         xlColor color1;
         if (level > (float)sensitivity / 100.0)
@@ -2873,13 +2870,13 @@ void VUMeterEffect::RenderNoteLevelBarFrame(RenderBuffer &buffer, int bars, int
 {
     if (buffer.GetMedia() == nullptr) return;
 
-    std::list<float> const * const pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
+    const FrameDataSpan pdata = buffer.GetMedia()->GetFrameData(buffer.curPeriod, FRAMEDATA_VU, "");
 
-    if (pdata != nullptr && pdata->size() != 0)
+    if (!pdata.empty())
     {
         int i = 0;
         float level = 0.0;
-        for (const auto& it : *pdata)
+        for (const auto& it : pdata)
         {
             if (i > startNote && i <= endNote)
             {
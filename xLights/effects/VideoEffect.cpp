@@ -27,6 +27,12 @@
 
 #include <log4cpp/Category.hh>
 
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
 VideoEffect::VideoEffect(int id) : RenderableEffect(id, "Video", video_16, video_24, video_32, video_48, video_64)
 {
 }
@@ -225,25 +231,305 @@ void VideoEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer
 		);
 }
 
+// A video file opened once for the whole process and decoded at its native resolution. Effects showing the same
+// part of a clip on different models share the decoded frames so it is only decoded once. Effects playing the clip
+// from different points each get their own decoder, up to MAX_READERS, so they do not keep making each other seek.
+// Recently decoded frames are kept in a small LRU and each is scaled once for the last few sizes asked for.
+// Decoding holds only the decoder's lock and scaling holds no lock at all.
+class SharedVideo
+{
+public:
+    static std::shared_ptr<SharedVideo> Get(const std::string& filename);
+
+    SharedVideo(const std::string& filename) : _filename(filename)
+    {
+        auto reader = std::make_shared<Reader>();
+        reader->reader = new VideoReader(filename, 100, 100, false, true, true);
+        _valid = reader->reader->IsValid() && reader->reader->GetWidth() > 0 && reader->reader->GetHeight() > 0;
+        _lengthMS = reader->reader->GetLengthMS();
+        _width = reader->reader->GetWidth();
+        _height = reader->reader->GetHeight();
+        _frameMS = std::max(reader->reader->GetFrameMS(), 1);
+        _readers.push_back(reader);
+    }
+    ~SharedVideo()
+    {
+        for (auto& it : _scalers) {
+            sws_freeContext(it.second);
+        }
+    }
+
+    bool IsValid() const { return _valid; }
+    int GetLengthMS() const { return _lengthMS; }
+    int GetWidth() const { return _width; }
+    int GetHeight() const { return _height; }
+
+    // Returns the frame showing at timestampMS as width x height RGBA rows, or nullptr if there is none
+    // The returned data is not touched again by the cache so it can be read without holding any lock
+    std::shared_ptr<const std::vector<uint8_t>> GetFrame(int timestampMS, int width, int height, bool& atEnd);
+
+private:
+    // 16 1080p frames are about 130MB
+    static const size_t MAX_CACHED_FRAMES = 16;
+    static const size_t MAX_SCALED_SIZES = 4;
+    static const size_t MAX_READERS = 4;
+    // a decoder is only asked for frames up to this far past where it is, further than that another decoder is used
+    static const int READER_WINDOW_MS = 2000;
+    // swscale may use SIMD stores that run slightly past the end of the last row
+    static const size_t SCALE_PADDING = 64;
+
+    struct Frame
+    {
+        int startMS = 0;
+        int endMS = 0;
+        std::shared_ptr<std::vector<uint8_t>> data;
+        std::mutex scaledLock;
+        std::list<std::pair<std::pair<int, int>, std::shared_ptr<std::vector<uint8_t>>>> scaled; // most recently used first
+    };
+
+    struct Reader
+    {
+        ~Reader() { delete reader; }
+
+        std::mutex lock; // held while the reader is opened or decoding
+        VideoReader* reader = nullptr; // opened by the first effect to use it
+        int posMS = 0; // where the reader last decoded, guarded by the SharedVideo lock
+    };
+
+    std::shared_ptr<Frame> FindFrame(int timestampMS);
+    std::shared_ptr<Reader> ChooseReader(int timestampMS);
+    std::shared_ptr<const std::vector<uint8_t>> Scale(Frame& frame, int width, int height);
+
+    // guards _readers and their positions, _frames and _scalers
+    std::mutex _lock;
+    std::string _filename;
+    bool _valid = false;
+    int _lengthMS = 0;
+    int _width = 0;
+    int _height = 0;
+    int _frameMS = 1;
+    std::list<std::shared_ptr<Reader>> _readers; // most recently used first
+    std::list<std::shared_ptr<Frame>> _frames; // most recently used first
+    std::multimap<std::pair<int, int>, SwsContext*> _scalers; // scalers not being used by anyone
+
+    static std::mutex __poolLock;
+    static std::map<std::string, std::weak_ptr<SharedVideo>> __pool;
+};
+
+std::mutex SharedVideo::__poolLock;
+std::map<std::string, std::weak_ptr<SharedVideo>> SharedVideo::__pool;
+
+std::shared_ptr<SharedVideo> SharedVideo::Get(const std::string& filename)
+{
+    std::unique_lock<std::mutex> lock(__poolLock);
+
+    auto it = __pool.find(filename);
+    if (it != __pool.end()) {
+        auto video = it->second.lock();
+        if (video != nullptr) {
+            return video;
+        }
+    }
+
+    // drop entries for videos no longer used by any effect
+    for (auto pit = __pool.begin(); pit != __pool.end(); ) {
+        if (pit->second.expired()) {
+            pit = __pool.erase(pit);
+        }
+        else {
+            ++pit;
+        }
+    }
+
+    auto video = std::make_shared<SharedVideo>(filename);
+    if (!video->IsValid()) {
+        return nullptr;
+    }
+    __pool[filename] = video;
+    return video;
+}
+
+// caller holds _lock
+std::shared_ptr<SharedVideo::Frame> SharedVideo::FindFrame(int timestampMS)
+{
+    for (auto it = _frames.begin(); it != _frames.end(); ++it) {
+        if (timestampMS >= (*it)->startMS && timestampMS < (*it)->endMS) {
+            _frames.splice(_frames.begin(), _frames, it);
+            return _frames.front();
+        }
+    }
+    return nullptr;
+}
+
+// The reader furthest along that can decode forward to the time without seeking, a new one if there is none and
+// we have room or otherwise the least recently used which will have to seek. Caller holds _lock.
+std::shared_ptr<SharedVideo::Reader> SharedVideo::ChooseReader(int timestampMS)
+{
+    auto best = _readers.end();
+    for (auto it = _readers.begin(); it != _readers.end(); ++it) {
+        int ahead = timestampMS - (*it)->posMS;
+        if (ahead >= -_frameMS && ahead <= READER_WINDOW_MS && (best == _readers.end() || (*it)->posMS > (*best)->posMS)) {
+            best = it;
+        }
+    }
+    if (best == _readers.end()) {
+        if (_readers.size() < MAX_READERS) {
+            _readers.push_front(std::make_shared<Reader>());
+            return _readers.front();
+        }
+        best = std::prev(_readers.end());
+    }
+    _readers.splice(_readers.begin(), _readers, best);
+    return _readers.front();
+}
+
+std::shared_ptr<const std::vector<uint8_t>> SharedVideo::GetFrame(int timestampMS, int width, int height, bool& atEnd)
+{
+    atEnd = false;
+    if (width <= 0 || height <= 0) return nullptr;
+    if (timestampMS > _lengthMS) {
+        atEnd = true;
+        return nullptr;
+    }
+
+    std::shared_ptr<Frame> frame;
+    std::shared_ptr<Reader> reader;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        frame = FindFrame(timestampMS);
+        if (frame == nullptr) {
+            reader = ChooseReader(timestampMS);
+        }
+    }
+
+    if (frame == nullptr) {
+        std::unique_lock<std::mutex> readerLock(reader->lock);
+
+        // another effect may have decoded it while we waited for the reader
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            frame = FindFrame(timestampMS);
+        }
+
+        if (frame == nullptr) {
+            if (reader->reader == nullptr) {
+                reader->reader = new VideoReader(_filename, 100, 100, false, true, true);
+            }
+            if (!reader->reader->IsValid()) return nullptr;
+
+            AVFrame* image = reader->reader->GetNextFrame(timestampMS);
+            if (image == nullptr) {
+                atEnd = reader->reader->AtEnd();
+                return nullptr;
+            }
+
+            // the reader hands back either the frame at its current position or the one before it
+            frame = std::make_shared<Frame>();
+            int pos = reader->reader->GetPos();
+            frame->startMS = timestampMS >= pos ? pos : pos - _frameMS;
+            frame->endMS = std::max(frame->startMS + _frameMS, timestampMS + 1);
+            size_t size = (size_t)_width * _height * 4;
+            frame->data = std::make_shared<std::vector<uint8_t>>(image->data[0], image->data[0] + size);
+
+            std::unique_lock<std::mutex> lock(_lock);
+            reader->posMS = pos;
+            _frames.push_front(frame);
+            while (_frames.size() > MAX_CACHED_FRAMES) {
+                _frames.pop_back();
+            }
+        }
+    }
+
+    return Scale(*frame, width, height);
+}
+
+std::shared_ptr<const std::vector<uint8_t>> SharedVideo::Scale(Frame& frame, int width, int height)
+{
+    if (width == _width && height == _height) {
+        return frame.data;
+    }
+
+    auto key = std::make_pair(width, height);
+    {
+        std::unique_lock<std::mutex> lock(frame.scaledLock);
+        for (auto it = frame.scaled.begin(); it != frame.scaled.end(); ++it) {
+            if (it->first == key) {
+                frame.scaled.splice(frame.scaled.begin(), frame.scaled, it);
+                return frame.scaled.front().second;
+            }
+        }
+    }
+
+    // a scaler can only be used by one thread at a time so it is taken out of the pool while we use it
+    SwsContext* ctx = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _scalers.find(key);
+        if (it != _scalers.end()) {
+            ctx = it->second;
+            _scalers.erase(it);
+        }
+    }
+    ctx = sws_getCachedContext(ctx, _width, _height, AV_PIX_FMT_RGBA,
+        width, height, AV_PIX_FMT_RGBA, SWS_BICUBIC, nullptr, nullptr, nullptr);
+    if (ctx == nullptr) {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        logger_base.error("SharedVideo: Unable to create scaler %dx%d -> %dx%d.", _width, _height, width, height);
+        return nullptr;
+    }
+
+    auto scaled = std::make_shared<std::vector<uint8_t>>((size_t)width * height * 4 + SCALE_PADDING);
+    const uint8_t* srcData[1] = { frame.data->data() };
+    int srcLines[1] = { _width * 4 };
+    uint8_t* dstData[1] = { scaled->data() };
+    int dstLines[1] = { width * 4 };
+    sws_scale(ctx, srcData, srcLines, 0, _height, dstData, dstLines);
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _scalers.emplace(key, ctx);
+    }
+
+    std::unique_lock<std::mutex> lock(frame.scaledLock);
+    for (const auto& it : frame.scaled) {
+        // someone else scaled it while we were
+        if (it.first == key) return it.second;
+    }
+    frame.scaled.emplace_front(key, scaled);
+    while (frame.scaled.size() > MAX_SCALED_SIZES) {
+        frame.scaled.pop_back();
+    }
+    return scaled;
+}
+
+// Works out the size the video is scaled to so the cropped part of it fills the buffer
+static void GetScaledSize(int videoWidth, int videoHeight, int maxWidth, int maxHeight, bool keepAspectRatio, int& width, int& height)
+{
+    if (keepAspectRatio) {
+        // matches the sizing VideoReader applies when asked to keep the aspect ratio
+        float shrink = std::min((float)maxWidth / (float)videoWidth, (float)maxHeight / (float)videoHeight);
+        height = (int)((float)videoHeight * shrink);
+        width = (int)((float)videoWidth * shrink);
+    }
+    else {
+        width = maxWidth;
+        height = maxHeight;
+    }
+}
+
 class VideoRenderCache : public EffectRenderCache {
 public:
     VideoRenderCache()
 	{
 		_videoframerate = -1;
-		_videoreader = nullptr;
         _loops = 0;
         _frameMS = 50;
         _nextManualMS = 0;
 	};
     virtual ~VideoRenderCache() {
-		if (_videoreader != nullptr)
-		{
-			delete _videoreader;
-			_videoreader = nullptr;
-		}
 	};
 
-    VideoReader* _videoreader;
+    std::shared_ptr<SharedVideo> _video;
 	int _videoframerate;
 	int _loops;
     int _frameMS;
@@ -295,7 +581,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
     }
 
     int &_loops = cache->_loops;
-    VideoReader* &_videoreader = cache->_videoreader;
+    std::shared_ptr<SharedVideo>& _video = cache->_video;
     int& _frameMS = cache->_frameMS;
     int& _nextManualMS = cache->_nextManualMS;
 
@@ -318,11 +604,7 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         _loops = 0;
         _nextManualMS = 0;
         _frameMS = buffer.frameTimeInMs;
-        if (_videoreader != nullptr)
-        {
-            delete _videoreader;
-            _videoreader = nullptr;
-        }
+        _video = nullptr;
 
         if (buffer.BufferHt == 1)
         {
@@ -330,19 +612,17 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         }
         else if (wxFileExists(filename))
         {
-            // have to open the file
-            int width = buffer.BufferWi * 100 / (cropRight - cropLeft);
-            int height = buffer.BufferHt * 100 / (cropTop - cropBottom);
-            _videoreader = new VideoReader(filename, width, height, aspectratio, false, true);
+            // shared with any other effects showing the same file
+            _video = SharedVideo::Get(filename);
 
-            if (_videoreader == nullptr)
+            if (_video == nullptr)
             {
                 logger_base.warn("VideoEffect: Failed to load video file %s.", (const char *)filename.c_str());
             }
             else
             {
                 // extract the video length
-                int videolen = _videoreader->GetLengthMS();
+                int videolen = _video->GetLengthMS();
 
                 if (videolen == 0)
                 {
@@ -359,12 +639,6 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
                     //fp->addVideoTime(filename, videolen);
                 }
 
-                if (starttime != 0)
-                {
-                    logger_base.debug("Video effect initialising ... seeking to start location for the video %f.", (float)starttime);
-                    _videoreader->Seek(starttime * 1000);
-                }
-
                 if (durationTreatment == "Slow/Accelerate")
                 {
                     int effectFrames = buffer.curEffEndPer - buffer.curEffStartPer + 1;
@@ -386,25 +660,14 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
         }
     }
 
-    if (_videoreader != nullptr) {
-        int width = buffer.BufferWi * 100 / (cropRight - cropLeft);
-        int height = buffer.BufferHt * 100 / (cropTop - cropBottom);
-        bool vwidthEq = width == _videoreader->GetWidth();
-        bool vheightEq = height == _videoreader->GetHeight();
-        if (aspectratio) {
-            // if aspect ratio scaling, then only one or the other will be equal
-            vwidthEq = vheightEq | vwidthEq;
-            vheightEq = vwidthEq;
-        }
-        if (!vwidthEq || !vheightEq) {
-            // need to close and reopen video reader to the new size ... this is inefficient ... but lots of work to do to change video reader size dynamically
-            delete _videoreader;
-            _videoreader = new VideoReader(filename, width, height, aspectratio, false, true);
-        }
-    }
-
-    if (_videoreader != nullptr && _videoreader->GetLengthMS() > 0)
+    if (_video != nullptr && _video->GetLengthMS() > 0)
     {
+        int videoWidth = 0;
+        int videoHeight = 0;
+        GetScaledSize(_video->GetWidth(), _video->GetHeight(),
+            buffer.BufferWi * 100 / (cropRight - cropLeft), buffer.BufferHt * 100 / (cropTop - cropBottom),
+            aspectratio, videoWidth, videoHeight);
+
         long frame = 0;
         
         if (durationTreatment == "Manual")
@@ -418,61 +681,61 @@ void VideoEffect::Render(RenderBuffer &buffer, std::string filename,
 
             while (frame < 0)
             {
-                frame += _videoreader->GetLengthMS();
+                frame += _video->GetLengthMS();
             }
 
-            while (frame > _videoreader->GetLengthMS())
+            while (frame > _video->GetLengthMS())
             {
-                frame -= _videoreader->GetLengthMS();
+                frame -= _video->GetLengthMS();
             }
 
             _nextManualMS += speed * _frameMS;
         }
         else
         {
-            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_videoreader->GetLengthMS() + _frameMS);
+            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_video->GetLengthMS() + _frameMS);
         }
 
         // get the image for the current frame
-        AVFrame* image = _videoreader->GetNextFrame(frame);
+        bool atEnd = false;
+        auto image = _video->GetFrame(frame, videoWidth, videoHeight, atEnd);
 
         // if we have reached the end and we are to loop
-        if (_videoreader->AtEnd() && durationTreatment == "Loop")
+        if (atEnd && durationTreatment == "Loop")
         {
             // jump back to start and try to read frame again
             _loops++;
-            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_videoreader->GetLengthMS() + _frameMS);
+            frame = starttime * 1000 + (buffer.curPeriod - buffer.curEffStartPer) * _frameMS - _loops * (_video->GetLengthMS() + _frameMS);
             if (frame < 0)
             {
                 frame = 0;
             }
             logger_base.debug("Video effect loop #%d at frame %d to video frame %d.", _loops, buffer.curPeriod - buffer.curEffStartPer, frame);
 
-            _videoreader->Seek(0);
-            image = _videoreader->GetNextFrame(frame);
+            image = _video->GetFrame(frame, videoWidth, videoHeight, atEnd);
         }
 
-        int xoffset = cropLeft * _videoreader->GetWidth() / 100;
-        int yoffset = cropBottom * _videoreader->GetHeight() / 100;
-        int xtail = (100 - cropRight) * _videoreader->GetWidth() / 100;
-        int ytail = (100 - cropTop) * _videoreader->GetHeight() / 100;
-        int startx = (buffer.BufferWi - _videoreader->GetWidth() * (cropRight - cropLeft) / 100) / 2;
-        int starty = (buffer.BufferHt - _videoreader->GetHeight() * (cropTop - cropBottom) / 100) / 2;
+        int xoffset = cropLeft * videoWidth / 100;
+        int yoffset = cropBottom * videoHeight / 100;
+        int xtail = (100 - cropRight) * videoWidth / 100;
+        int ytail = (100 - cropTop) * videoHeight / 100;
+        int startx = (buffer.BufferWi - videoWidth * (cropRight - cropLeft) / 100) / 2;
+        int starty = (buffer.BufferHt - videoHeight * (cropTop - cropBottom) / 100) / 2;
 
-        //wxASSERT(xoffset + xtail + buffer.BufferWi == _videoreader->GetWidth());
-        //wxASSERT(yoffset + ytail + buffer.BufferHt == _videoreader->GetHeight());
+        //wxASSERT(xoffset + xtail + buffer.BufferWi == videoWidth);
+        //wxASSERT(yoffset + ytail + buffer.BufferHt == videoHeight);
 
         // check it looks valid
         if (image != nullptr && frame >= 0)
         {
-            int ch = _videoreader->GetPixelChannels();
+            const int ch = 4;
             // draw the image
             xlColor c;
-            for (int y = 0; y < _videoreader->GetHeight() - yoffset - ytail; y++)
+            for (int y = 0; y < videoHeight - yoffset - ytail; y++)
             {
-                uint8_t* ptr = image->data[0] + (_videoreader->GetHeight() - 1 - y - yoffset) * _videoreader->GetWidth() * ch + xoffset * ch;
+                const uint8_t* ptr = image->data() + (videoHeight - 1 - y - yoffset) * videoWidth * ch + xoffset * ch;
 
-                for (int x = 0; x < _videoreader->GetWidth() - xoffset - xtail; x++)
+                for (int x = 0; x < videoWidth - xoffset - xtail; x++)
                 {
                     try
                     {
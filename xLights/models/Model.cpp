@@ -3183,8 +3183,15 @@ void Model::GetBufferSize(const std::string &type, const std::string &camera, co
     } else {
         //if (type == PER_PREVIEW) {
         //default is to go ahead and build the full node buffer
-        std::vector<NodeBaseClassPtr> newNodes;
-        InitRenderBufferNodes(type, camera, "None", newNodes, bufferWi, bufferHi);
+        auto mapping = GetRenderBufferNodeMapping(type, camera, "None");
+        if (mapping != nullptr) {
+            bufferWi = mapping->bufferWi;
+            bufferHi = mapping->bufferHi;
+        }
+        else {
+            std::vector<NodeBaseClassPtr> newNodes;
+            InitRenderBufferNodes(type, camera, "None", newNodes, bufferWi, bufferHi);
+        }
     }
     AdjustForTransform(transform, bufferWi, bufferHi);
 }
@@ -3637,6 +3644,66 @@ void Model::InitRenderBufferNodes(const std::string &type, const std::string &ca
     ApplyTransform(transform, newNodes, bufferWi, bufferHt);
 }
 
+void Model::GetRenderBufferNodes(const std::string &type, const std::string &camera, const std::string &transform,
+    std::vector<NodeBaseClassPtr> &newNodes, int &bufferWi, int &bufferHt) const {
+
+    auto mapping = GetRenderBufferNodeMapping(type, camera, transform);
+    if (mapping == nullptr) {
+        InitRenderBufferNodes(type, camera, transform, newNodes, bufferWi, bufferHt);
+        return;
+    }
+
+    // the buffer changes the colours and coordinates of its nodes so it gets its own copies
+    newNodes.reserve(newNodes.size() + mapping->nodes.size());
+    for (const auto& it : mapping->nodes) {
+        newNodes.push_back(NodeBaseClassPtr(it->clone()));
+    }
+    bufferWi = mapping->bufferWi;
+    bufferHt = mapping->bufferHi;
+}
+
+std::shared_ptr<const Model::RenderBufferNodeMapping> Model::GetRenderBufferNodeMapping(const std::string &type, const std::string &camera, const std::string &transform) const {
+
+    // 3D preview styles also depend on the camera settings which are not tracked by the change count
+    if (camera != "2D" && (type == PER_PREVIEW || type == PER_PREVIEW_NO_OFFSET)) {
+        return nullptr;
+    }
+
+    std::string key = type + "|" + camera + "|" + transform;
+    unsigned long changes = GetRenderBufferChangeCount();
+    unsigned long generation = 0;
+    {
+        std::unique_lock<std::mutex> lock(_renderBufferNodeLock);
+        if (changes != _renderBufferNodeChangeCount) {
+            _renderBufferNodeCache.clear();
+            _renderBufferNodeChangeCount = changes;
+            _renderBufferNodeGeneration++;
+        }
+        auto it = _renderBufferNodeCache.find(key);
+        if (it != _renderBufferNodeCache.end()) {
+            return it->second;
+        }
+        generation = _renderBufferNodeGeneration;
+    }
+
+    // built without the lock held as groups recurse into their models
+    auto mapping = std::make_shared<RenderBufferNodeMapping>();
+    InitRenderBufferNodes(type, camera, transform, mapping->nodes, mapping->bufferWi, mapping->bufferHi);
+
+    std::unique_lock<std::mutex> lock(_renderBufferNodeLock);
+    // dont keep it if the model changed while it was being built
+    if (generation == _renderBufferNodeGeneration) {
+        _renderBufferNodeCache[key] = mapping;
+    }
+    return mapping;
+}
+
+void Model::ClearRenderBufferNodeCache() const {
+    std::unique_lock<std::mutex> lock(_renderBufferNodeLock);
+    _renderBufferNodeCache.clear();
+    _renderBufferNodeGeneration++;
+}
+
 std::string Model::GetNextName() {
     if (nodeNames.size() > Nodes.size()) {
         return nodeNames[Nodes.size()];
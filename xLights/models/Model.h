@@ -14,6 +14,8 @@
 #include <map>
 #include <vector>
 #include <list>
+#include <memory>
+#include <mutex>
 
 #include "ModelScreenLocation.h"
 #include "../Color.h"
@@ -131,6 +133,10 @@ public:
     virtual void GetBufferSize(const std::string& type, const std::string& camera, const std::string& transform, int& BufferWi, int& BufferHi) const;
     virtual void InitRenderBufferNodes(const std::string& type, const std::string& camera, const std::string& transform,
         std::vector<NodeBaseClassPtr>& Nodes, int& BufferWi, int& BufferHi) const;
+    // Same as InitRenderBufferNodes but reuses the node mapping built for an earlier call with the same buffer style,
+    // camera and transform for as long as the model has not changed
+    void GetRenderBufferNodes(const std::string& type, const std::string& camera, const std::string& transform,
+        std::vector<NodeBaseClassPtr>& Nodes, int& BufferWi, int& BufferHi) const;
     const ModelManager& GetModelManager() const { return modelManager; }
     virtual bool SupportsXlightsModel() { return false; }
     static Model* GetXlightsModel(Model* model, std::string& last_model, xLightsFrame* xlights, bool& cancelled, bool download, wxProgressDialog* prog, int low, int high);
@@ -192,6 +198,9 @@ protected:
         int& bufferWi, int& bufferHi) const;
     void ApplyTransparency(xlColor& color, int transparency, int blackTransparency) const;
     void DumpBuffer(std::vector<NodeBaseClassPtr>& newNodes, int bufferWi, int bufferHi) const;
+    // cached render buffer node mappings are thrown away whenever this changes
+    virtual unsigned long GetRenderBufferChangeCount() const { return GetChangeCount(); }
+    void ClearRenderBufferNodeCache() const;
 
     // size of the default buffer
     int BufferHt = 0;
@@ -240,6 +249,21 @@ protected:
 
     std::vector<std::string> modelState;
 
+private:
+    // a render buffer node layout built by InitRenderBufferNodes, never modified once it is in the cache
+    struct RenderBufferNodeMapping
+    {
+        std::vector<NodeBaseClassPtr> nodes;
+        int bufferWi = 0;
+        int bufferHi = 0;
+    };
+    std::shared_ptr<const RenderBufferNodeMapping> GetRenderBufferNodeMapping(const std::string& type, const std::string& camera, const std::string& transform) const;
+
+    mutable std::mutex _renderBufferNodeLock;
+    mutable unsigned long _renderBufferNodeChangeCount = 0;
+    mutable unsigned long _renderBufferNodeGeneration = 0;
+    mutable std::map<std::string, std::shared_ptr<const RenderBufferNodeMapping>> _renderBufferNodeCache;
+
 public:
     bool IsControllerConnectionValid() const;
     wxXmlNode* GetControllerConnection() const;
@@ -360,12 +360,12 @@ void LoadRenderBufferNodes(Model *m, const std::string &type, const std::string
             }
         }
         else {
-            m->InitRenderBufferNodes(type, camera, "None", newNodes, bufferWi, bufferHi);
+            m->GetRenderBufferNodes(type, camera, "None", newNodes, bufferWi, bufferHi);
         }
     }
     else
     {
-        m->InitRenderBufferNodes(type, camera, "None", newNodes, bufferWi, bufferHi);
+        m->GetRenderBufferNodes(type, camera, "None", newNodes, bufferWi, bufferHi);
     }
 }
 
@@ -398,6 +398,7 @@ bool ModelGroup::Reset(bool zeroBased) {
     int offsetY = wxAtoi(ModelXml->GetAttribute("YCentreOffset", "0"));
     std::string layout = ModelXml->GetAttribute("layout", "minimalGrid").ToStdString();
     defaultBufferStyle = layout;
+    ClearRenderBufferNodeCache();
     if (layout.compare(0, 9, "Per Model") == 0) {
         layout = "Default";
     }
@@ -904,7 +905,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             if (m != nullptr) {
                 int start = Nodes.size();
                 int x, y;
-                m->InitRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
+                m->GetRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
                 y = 0;
                 while (start < Nodes.size()) {
                     for (auto& it2 : Nodes[start]->Coords) {
@@ -928,7 +929,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             if (m != nullptr) {
                 int start = Nodes.size();
                 int x, y;
-                m->InitRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
+                m->GetRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
                 while (start < Nodes.size()) {
                     for (auto& it2 : Nodes[start]->Coords) {
                         it2.bufX = it2.bufX + modelX;
@@ -950,7 +951,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             if (m != nullptr) {
                 int start = Nodes.size();
                 int x, y;
-                m->InitRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
+                m->GetRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
                 while (start < Nodes.size()) {
                     for (auto& it2 : Nodes[start]->Coords) {
                         it2.bufY = it2.bufY + modelY;
@@ -981,7 +982,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
                 if (m != nullptr) {
                     int start = Nodes.size();
                     int x, y;
-                    m->InitRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
+                    m->GetRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
                     while (start < Nodes.size()) {
                         for (auto& it2 : Nodes[start]->Coords) {
                             it2.bufX = (double)it2.bufX * ((double)modBufferWi / (double)x) + (double)modelX;
@@ -1011,7 +1012,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
                 if (m != nullptr) {
                     int start = Nodes.size();
                     int x, y;
-                    m->InitRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
+                    m->GetRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
                     while (start < Nodes.size()) {
                         for (auto& it2 : Nodes[start]->Coords) {
                             it2.bufX = (double)it2.bufX * ((double)BufferWi / (double)x);
@@ -1030,7 +1031,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             if (m != nullptr) {
                 int start = Nodes.size();
                 int x, y;
-                m->InitRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
+                m->GetRenderBufferNodes("Default", "2D", "None", Nodes, x, y);
                 y = 0;
                 while (start < Nodes.size()) {
                     for (auto& it2 : Nodes[start]->Coords) {
@@ -1056,7 +1057,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
                 int start = Nodes.size();
                 int x = 0;
                 int y = 0;
-                m->InitRenderBufferNodes("As Pixel", "2D", "None", Nodes, x, y);
+                m->GetRenderBufferNodes("As Pixel", "2D", "None", Nodes, x, y);
                 while (start < Nodes.size()) {
                     for (auto& it2 : Nodes[start]->Coords) {
                         it2.bufY = 0;
@@ -1111,7 +1112,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             if (grp != nullptr) {
                 int bw, bh;
                 bw = bh = 0;
-                grp->InitRenderBufferNodes(type, "2D", "None", Nodes, bw, bh);
+                grp->GetRenderBufferNodes(type, "2D", "None", Nodes, bw, bh);
                 for (int x = startBM; x < Nodes.size(); x++) {
                     for (auto& it2 : Nodes[x]->Coords) {
                         if (horiz) {
@@ -1129,7 +1130,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             } else if (m != nullptr) {
                 int bw, bh;
                 bw = bh = 0;
-                m->InitRenderBufferNodes(horiz ? "Horizontal Per Strand" : "Vertical Per Strand", "2D", "None", Nodes, bw, bh);
+                m->GetRenderBufferNodes(horiz ? "Horizontal Per Strand" : "Vertical Per Strand", "2D", "None", Nodes, bw, bh);
                 for (int x = startBM; x < Nodes.size(); x++) {
                     for (auto& it2 : Nodes[x]->Coords) {
                         if (horiz) {
@@ -1164,7 +1165,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             if (m != nullptr) {
                 int start = Nodes.size();
                 int x, y;
-                m->InitRenderBufferNodes("Single Line", "2D", "None", Nodes, x, y);
+                m->GetRenderBufferNodes("Single Line", "2D", "None", Nodes, x, y);
                 while (start < Nodes.size()) {
                     for (auto& it2 : Nodes[start]->Coords) {
                         it2.bufX = BufferWi;
@@ -1188,7 +1189,7 @@ void ModelGroup::InitRenderBufferNodes(const std::string &tp,
             if (m != nullptr) {
                 int start = Nodes.size();
                 int bw, bh;
-                m->InitRenderBufferNodes("Default", "2D", "None", Nodes, bw, bh);
+                m->GetRenderBufferNodes("Default", "2D", "None", Nodes, bw, bh);
                 if (bw != BufferWi || bh != BufferHt) {
                     //need to either scale or center
                     int offx = (BufferWi - bw)/2;
@@ -66,6 +66,7 @@ class ModelGroup : public ModelWithScreenLocation<BoxedScreenLocation>
         void ResetModels();
     protected:
         static std::vector<std::string> GROUP_BUFFER_STYLES;
+        virtual unsigned long GetRenderBufferChangeCount() const override { CheckForChanges(); return changeCount; }
 
     private:
         bool CheckForChanges() const;
@@ -227,7 +227,7 @@ void ModelManager::LoadModels(wxXmlNode* modelNode, int previewW, int previewH)
     previewHeight = previewH;
     this->modelNode = modelNode;
     wxStopWatch timer;
-    std::list<wxXmlNode*> modelsToLoad;
+    std::vector<wxXmlNode*> modelsToLoad;
     for (wxXmlNode* e = modelNode->GetChildren(); e != nullptr; e = e->GetNext()) {
         if (e->GetName() == "model") {
             std::string name = e->GetAttribute("name").Trim(true).Trim(false).ToStdString();
@@ -132,6 +132,13 @@ void NodeClassRGBW::SetFromChannels(const unsigned char* buf)
 
 void NodeClassRGBW::GetForChannels(unsigned char* buf) const
 {
+    PackChannels(c, offsets, wIndex != 0, rgbwHandling, buf);
+}
+
+void NodeClassRGBW::PackChannels(const uint8_t* c, const uint8_t* offsets, bool whiteLast, uint8_t rgbwHandling, unsigned char* buf)
+{
+    uint8_t wOffset = whiteLast ? 0 : 1;
+    uint8_t wIndex = whiteLast ? 3 : 0;
     switch (rgbwHandling) {
     case RGB_HANDLING_RGB:
         for (int x = 0; x < 3; x++) {
@@ -134,6 +134,10 @@ public:
     uint32_t GetChanCount() const {
         return chanCnt;
     }
+    // channel offset of the red, green or blue component, 255 if it isnt output
+    uint8_t GetChannelOffset(int x) const {
+        return offsets[x];
+    }
     bool IsVisible() const {
         return !Coords.empty();
     }
@@ -414,6 +418,15 @@ public:
     virtual NodeBaseClass *clone() const override {
         return new NodeClassRGBW(*this);
     }
+
+    bool IsWhiteLast() const {
+        return wIndex != 0;
+    }
+    uint8_t GetRGBWHandling() const {
+        return rgbwHandling;
+    }
+    // what GetForChannels writes for a colour without needing the node, used by the render output tables
+    static void PackChannels(const uint8_t *c, const uint8_t *offsets, bool whiteLast, uint8_t rgbwHandling, unsigned char *buf);
 private:
     uint8_t wOffset;
     uint8_t wIndex;
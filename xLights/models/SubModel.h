@@ -36,6 +36,9 @@ public:
     bool IsNodesAllValid() const { return _nodesAllValid; }
 
     Model* GetParent() const { return parent; }
+protected:
+    // the nodes and screen location come from the parent so its changes count too
+    virtual unsigned long GetRenderBufferChangeCount() const override { return changeCount + parent->GetChangeCount(); }
 private:
     Model *parent = nullptr;
     bool _nodesAllValid = false;
@@ -15,6 +15,7 @@
 #include <wx/xml/xml.h>
 #include <wx/regex.h>
 #include <wx/protocol/http.h>
+#include <wx/stopwatch.h>
 
 // This must be below the wx includes
 #ifdef __WXMSW__
@@ -24,6 +25,21 @@
 #include <icmpapi.h>
 #endif
 
+#ifdef __LINUX__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
 #include "../UtilFunctions.h"
 #include "../xSchedule/xSMSDaemon/Curl.h"
 
@@ -31,6 +47,202 @@
 
 std::string IPOutput::__localIP = "";
 
+#pragma region Batched Transmission
+#ifdef __LINUX__
+struct IPOutputBatch::SendBuffers
+{
+    std::vector<mmsghdr> msgs;
+    std::vector<iovec> iovs;
+    std::vector<sockaddr_in> addrs;
+};
+
+// when the socket buffer is full wait for it to drain this many times before giving up on the batch
+#define BATCH_SEND_RETRIES 3
+#define BATCH_SEND_RETRY_WAIT_MS 2
+#else
+struct IPOutputBatch::SendBuffers
+{
+};
+#endif
+
+IPOutputBatch::IPOutputBatch() : _open(false), _sendBuffers(std::make_unique<SendBuffers>()),
+    _lastSendTimeUS(0), _lastPacketsSent(0), _lastPacketsSentSingly(0), _lastPacketsDropped(0), _totalPacketsDropped(0) {
+}
+
+IPOutputBatch::~IPOutputBatch() {
+}
+
+bool IPOutputBatch::IsSupported() {
+#ifdef __LINUX__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void IPOutputBatch::Begin() {
+#ifdef __LINUX__
+    std::unique_lock<std::mutex> lock(_lock);
+    _data.clear();
+    for (size_t i = 0; i < _queuesUsed; i++) {
+        _queues[i].packets.clear();
+        _queues[i].lastRemoteAddr = nullptr;
+    }
+    _queuesUsed = 0;
+    _open = true;
+#endif
+}
+
+bool IPOutputBatch::Add(wxDatagramSocket* datagram, const wxIPV4address& remoteAddr, const void* data, size_t len) {
+#ifdef __LINUX__
+    if (!_open || !datagram->IsOk()) return false;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_open) return false;
+
+    Queue* queue = nullptr;
+    for (size_t i = 0; i < _queuesUsed; i++) {
+        if (_queues[i].datagram == datagram) {
+            queue = &_queues[i];
+            break;
+        }
+    }
+    if (queue == nullptr) {
+        if (_queuesUsed == _queues.size()) {
+            _queues.emplace_back();
+        }
+        queue = &_queues[_queuesUsed++];
+        queue->datagram = datagram;
+        queue->lastRemoteAddr = nullptr;
+    }
+
+    // outputs always send to the same address so only convert it when it changes
+    if (queue->lastRemoteAddr != &remoteAddr) {
+        in_addr addr;
+        if (inet_pton(AF_INET, remoteAddr.IPAddress().c_str(), &addr) != 1) {
+            queue->lastRemoteAddr = nullptr;
+            return false;
+        }
+        queue->lastIp = addr.s_addr;
+        queue->lastPort = htons(remoteAddr.Service());
+        queue->lastRemoteAddr = &remoteAddr;
+    }
+
+    Packet p;
+    p.offset = _data.size();
+    p.len = len;
+    p.remoteAddr = &remoteAddr;
+    p.ip = queue->lastIp;
+    p.port = queue->lastPort;
+    _data.insert(_data.end(), (const uint8_t*)data, (const uint8_t*)data + len);
+    queue->packets.push_back(p);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void IPOutputBatch::SendQueue(Queue& queue, uint32_t& sent, uint32_t& singly, uint32_t& dropped) {
+#ifdef __LINUX__
+    size_t count = queue.packets.size();
+    if (count == 0) return;
+
+    auto& b = *_sendBuffers;
+    if (b.msgs.size() < count) {
+        b.msgs.resize(count);
+        b.iovs.resize(count);
+        b.addrs.resize(count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        auto& p = queue.packets[i];
+        memset(&b.addrs[i], 0x00, sizeof(sockaddr_in));
+        b.addrs[i].sin_family = AF_INET;
+        b.addrs[i].sin_port = p.port;
+        b.addrs[i].sin_addr.s_addr = p.ip;
+        b.iovs[i].iov_base = &_data[p.offset];
+        b.iovs[i].iov_len = p.len;
+        memset(&b.msgs[i], 0x00, sizeof(mmsghdr));
+        b.msgs[i].msg_hdr.msg_name = &b.addrs[i];
+        b.msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        b.msgs[i].msg_hdr.msg_iov = &b.iovs[i];
+        b.msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int socket = (int)queue.datagram->GetSocket();
+    int retries = 0;
+    size_t done = 0;
+    while (done < count) {
+        unsigned int chunk = (unsigned int)std::min(count - done, (size_t)UIO_MAXIOV);
+        int res = sendmmsg(socket, &b.msgs[done], chunk, 0);
+        if (res > 0) {
+            done += res;
+        }
+        else if (res < 0 && errno == EINTR) {
+        }
+        else if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && retries < BATCH_SEND_RETRIES) {
+            // the non blocking socket is full ... give it a moment to drain and try again
+            pollfd pfd = { socket, POLLOUT, 0 };
+            poll(&pfd, 1, BATCH_SEND_RETRY_WAIT_MS);
+            retries++;
+        }
+        else {
+            break;
+        }
+    }
+    sent += done;
+
+    // whatever the batch could not send goes out one packet at a time as it would have without batching
+    for (size_t i = done; i < count; i++) {
+        auto& p = queue.packets[i];
+        queue.datagram->SendTo(*p.remoteAddr, &_data[p.offset], p.len);
+        if (queue.datagram->Error()) {
+            dropped++;
+        }
+        else {
+            singly++;
+        }
+    }
+#endif
+}
+
+void IPOutputBatch::Flush() {
+#ifdef __LINUX__
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_open) return;
+    _open = false;
+
+    wxStopWatch sw;
+    uint32_t sent = 0;
+    uint32_t singly = 0;
+    uint32_t dropped = 0;
+    for (size_t q = 0; q < _queuesUsed; q++) {
+        SendQueue(_queues[q], sent, singly, dropped);
+    }
+
+    _lastSendTimeUS = sw.TimeInMicro().GetValue();
+    _lastPacketsSent = sent;
+    _lastPacketsSentSingly = singly;
+    _lastPacketsDropped = dropped;
+    if (singly > 0 || dropped > 0) {
+        _totalPacketsDropped += dropped;
+        logger_base.debug("Batched send sent %u of %u packets one at a time and dropped %u. Total dropped %llu.",
+            singly, sent + singly + dropped, dropped, (unsigned long long)_totalPacketsDropped);
+    }
+#endif
+}
+
+std::string IPOutputBatch::GetStatusJSON() const {
+    return "{\"supported\":\"" + std::string(IsSupported() ? "true" : "false") +
+        "\",\"lastsendus\":\"" + std::to_string(GetLastSendTimeUS()) +
+        "\",\"lastsent\":\"" + std::to_string(GetLastPacketsSent()) +
+        "\",\"lastsentsingly\":\"" + std::to_string(GetLastPacketsSentSingly()) +
+        "\",\"lastdropped\":\"" + std::to_string(GetLastPacketsDropped()) +
+        "\",\"totaldropped\":\"" + std::to_string(GetTotalPacketsDropped()) + "\"}";
+}
+#pragma endregion
+
 #pragma region Private Functions
 void IPOutput::Save(wxXmlNode* node) {
 
@@ -41,6 +253,12 @@ void IPOutput::Save(wxXmlNode* node) {
 
     Output::Save(node);
 }
+
+void IPOutput::SendDatagram(wxDatagramSocket* datagram, const wxIPV4address& remoteAddr, const void* data, size_t len) {
+
+    if (_batch != nullptr && _batch->Add(datagram, remoteAddr, data, len)) return;
+    datagram->SendTo(remoteAddr, data, len);
+}
 #pragma endregion
 
 #pragma region Constructors and Destructors
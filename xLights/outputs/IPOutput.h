@@ -10,16 +10,92 @@
  * License: https://github.com/smeighan/xLights/blob/master/License.txt
  **************************************************************/
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "Output.h"
 
+class wxDatagramSocket;
+class wxIPV4address;
+
+// Packets from the IP outputs collected over a frame. On linux they are sent with one sendmmsg call
+// per socket when the batch is flushed, elsewhere nothing is ever queued and outputs send as they go.
+// Each OutputManager owns one and opens it around the outputs EndFrame calls.
+class IPOutputBatch
+{
+    struct Packet
+    {
+        size_t offset = 0; // into _data
+        size_t len = 0;
+        const wxIPV4address* remoteAddr = nullptr; // the outputs address ... used if the packet has to be sent on its own
+        uint32_t ip = 0; // network order
+        uint16_t port = 0; // network order
+    };
+
+    struct Queue
+    {
+        wxDatagramSocket* datagram = nullptr;
+        const wxIPV4address* lastRemoteAddr = nullptr;
+        uint32_t lastIp = 0;
+        uint16_t lastPort = 0;
+        std::vector<Packet> packets;
+    };
+
+    // the message headers handed to the kernel, defined with the platform specific code
+    struct SendBuffers;
+
+    std::mutex _lock;
+    std::atomic_bool _open;
+    // packet bytes for the whole frame ... outputs reuse their packet buffers so we have to copy
+    std::vector<uint8_t> _data;
+    // queues are kept in the order their sockets first sent this frame
+    std::vector<Queue> _queues;
+    size_t _queuesUsed = 0;
+    std::unique_ptr<SendBuffers> _sendBuffers;
+
+    std::atomic<uint64_t> _lastSendTimeUS;
+    std::atomic<uint32_t> _lastPacketsSent;
+    std::atomic<uint32_t> _lastPacketsSentSingly;
+    std::atomic<uint32_t> _lastPacketsDropped;
+    std::atomic<uint64_t> _totalPacketsDropped;
+
+    void SendQueue(Queue& queue, uint32_t& sent, uint32_t& singly, uint32_t& dropped);
+
+public:
+
+    IPOutputBatch();
+    ~IPOutputBatch();
+
+    static bool IsSupported();
+
+    void Begin();
+    // queues a copy of the packet if the batch is open, returns false if the caller must send it itself
+    bool Add(wxDatagramSocket* datagram, const wxIPV4address& remoteAddr, const void* data, size_t len);
+    void Flush();
+
+    uint64_t GetLastSendTimeUS() const { return _lastSendTimeUS; }
+    uint32_t GetLastPacketsSent() const { return _lastPacketsSent; }
+    // packets the socket would not take as a batch which then went out one at a time
+    uint32_t GetLastPacketsSentSingly() const { return _lastPacketsSentSingly; }
+    uint32_t GetLastPacketsDropped() const { return _lastPacketsDropped; }
+    uint64_t GetTotalPacketsDropped() const { return _totalPacketsDropped; }
+    std::string GetStatusJSON() const;
+};
+
 class IPOutput : public Output
 {
 protected:
 
+    IPOutputBatch* _batch = nullptr;
+
     #pragma region Private Functions
     virtual void Save(wxXmlNode* node) override;
+
+    // Sends a packet or, while our batch is open, queues a copy of it to go out with the rest of the frame
+    void SendDatagram(wxDatagramSocket* datagram, const wxIPV4address& remoteAddr, const void* data, size_t len);
     #pragma endregion
 
 public:
@@ -44,6 +120,7 @@ public:
 
     #pragma region Getters and Setters
     virtual void SetIP(const std::string& ip) override;
+    void SetBatch(IPOutputBatch* batch) { _batch = batch; }
 
     virtual bool IsIpOutput() const override { return true; }
     virtual bool IsSerialOutput() const override { return false; }
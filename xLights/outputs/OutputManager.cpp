@@ -14,6 +14,8 @@
 #include <wx/config.h>
 #include <wx/filename.h>
 
+#include <algorithm>
+
 #include "OutputManager.h"
 #include "ControllerEthernet.h"
 #include "ControllerNull.h"
@@ -129,12 +131,88 @@ void OutputManager::AsyncPingAll() {
 
     std::for_each(begin(_controllers), end(_controllers), [](Controller* c) { c->AsyncPing(); });
 }
+
+void OutputManager::BuildOutputIndex() const {
+
+    // take the generation before looking at the controllers so a change made while we build forces another build
+    uint32_t generation = _outputIndexGeneration;
+    if (generation == _outputIndexBuiltGeneration) return;
+
+    _allOutputs.clear();
+    _outputIndex.clear();
+    _outputIndexStart.clear();
+    _outputIndexPages.clear();
+
+    for (const auto& it : _controllers) {
+        for (const auto& it2 : it->GetOutputs()) {
+            _allOutputs.push_back(it2);
+            // while EndFrame has our batch open the IP outputs queue their packets in it
+            if (it2->IsIpOutput()) {
+                static_cast<IPOutput*>(it2)->SetBatch(_batch.get());
+            }
+            // outputs with no channels can never be the target of a channel so leave them out
+            if (it2->GetChannels() > 0) {
+                _outputIndex.push_back(it2);
+            }
+        }
+    }
+
+    // start channels are allocated in controller order so this should already be sorted ... but make sure
+    std::stable_sort(begin(_outputIndex), end(_outputIndex), [](Output* a, Output* b) { return a->GetStartChannel() < b->GetStartChannel(); });
+
+    _outputIndexStart.reserve(_outputIndex.size());
+    for (const auto& it : _outputIndex) {
+        _outputIndexStart.push_back(it->GetStartChannel());
+    }
+
+    // for each page record the first output which ends in or after that page
+    if (!_outputIndex.empty()) {
+        int32_t lastChannel = 0;
+        for (const auto& it : _outputIndex) {
+            lastChannel = std::max(lastChannel, it->GetEndChannel());
+        }
+        size_t pages = ((lastChannel - 1) >> OUTPUT_INDEX_PAGE_SHIFT) + 1;
+        _outputIndexPages.reserve(pages + 1);
+        size_t o = 0;
+        for (size_t p = 0; p < pages; p++) {
+            int32_t pageStart = (int32_t)(p << OUTPUT_INDEX_PAGE_SHIFT) + 1;
+            while (o < _outputIndex.size() && _outputIndex[o]->GetEndChannel() < pageStart) {
+                o++;
+            }
+            _outputIndexPages.push_back((int32_t)o);
+        }
+        _outputIndexPages.push_back((int32_t)_outputIndex.size());
+    }
+
+    _outputIndexBuiltGeneration = generation;
+}
+
+int OutputManager::GetOutputIndex(int32_t absoluteChannel) const {
+
+    BuildOutputIndex();
+
+    if (absoluteChannel < 1 || _outputIndexPages.empty()) return -1;
+
+    size_t page = (absoluteChannel - 1) >> OUTPUT_INDEX_PAGE_SHIFT;
+    if (page + 1 >= _outputIndexPages.size()) return -1;
+
+    // the output holding the channel lies between the first output overlapping this page and the first overlapping the next page
+    auto lo = begin(_outputIndexStart) + _outputIndexPages[page];
+    auto hi = begin(_outputIndexStart) + std::min((size_t)_outputIndexPages[page + 1] + 1, _outputIndexStart.size());
+    auto it = std::upper_bound(lo, hi, absoluteChannel);
+    if (it == lo) return -1;
+
+    int index = (int)(it - begin(_outputIndexStart)) - 1;
+    if (absoluteChannel > _outputIndex[index]->GetEndChannel()) return -1;
+    return index;
+}
 #pragma endregion
 
 #pragma region Constructors and Destructors
-OutputManager::OutputManager() {
+OutputManager::OutputManager() : _batch(std::make_unique<IPOutputBatch>()) {
 
     _dirty = false;
+    _outputIndexGeneration = 1;
 }
 
 OutputManager::~OutputManager()
@@ -462,6 +540,7 @@ void OutputManager::AddController(Controller* controller, int pos)
         std::advance(it, pos);
         _controllers.insert(it, controller);
     }
+    InvalidateOutputIndex();
     UpdateUnmanaged();
 }
 
@@ -474,11 +553,14 @@ void OutputManager::DeleteController(const std::string& controllerName) {
             break;
         }
     }
+    InvalidateOutputIndex();
     UpdateUnmanaged();
 }
 
 void OutputManager::DeleteAllControllers() {
 
+    InvalidateOutputIndex();
+
     while (_controllers.size() > 0) {
         delete _controllers.front();
         _controllers.pop_front();
@@ -650,14 +732,12 @@ Output* OutputManager::GetOutput_CONVERT(int outputNumber) const {
 // get an output based on an absolute channel number
 Output* OutputManager::GetOutput(int32_t absoluteChannel, int32_t& startChannel) const {
 
-    auto outputs = GetAllOutputs();
-    for (const auto& it : outputs) {
-        if (absoluteChannel >= it->GetStartChannel() && absoluteChannel <= it->GetEndChannel()) {
-            startChannel = absoluteChannel - it->GetStartChannel() + 1;
-            return it;
-        }
-    }
-    return nullptr;
+    std::unique_lock<std::mutex> lock(_outputIndexLock);
+    int index = GetOutputIndex(absoluteChannel);
+    if (index < 0) return nullptr;
+
+    startChannel = absoluteChannel - _outputIndexStart[index] + 1;
+    return _outputIndex[index];
 }
 
 // get an output based on a universe/id number
@@ -922,6 +1002,7 @@ void OutputManager::SomethingChanged() const {
     for (auto& it : _controllers) {
         it->SetTransientData(start, nullcnt);
     }
+    InvalidateOutputIndex();
 }
 
 bool OutputManager::IsDirty() const {
@@ -994,6 +1075,9 @@ bool OutputManager::StartOutput() {
 
     logger_base.debug("Starting light output.");
 
+    // frames use the cached output list so make sure it reflects the current controllers
+    InvalidateOutputIndex();
+
     int started = 0;
     bool ok = true;
     bool err = false;
@@ -1078,8 +1162,9 @@ void OutputManager::StartFrame(long msec) {
 
     if (!_outputting) return;
     if (!_outputCriticalSection.TryEnter()) return;
+    std::unique_lock<std::mutex> lock(_outputIndexLock);
     
-    for (const auto& it : GetAllOutputs()) {
+    for (const auto& it : GetAllOutputsSnapshot()) {
         it->StartFrame(msec);
     }
     _outputCriticalSection.Leave();
@@ -1089,8 +1174,9 @@ void OutputManager::ResetFrame() {
 
     if (!_outputting) return;
     if (!_outputCriticalSection.TryEnter()) return;
+    std::unique_lock<std::mutex> lock(_outputIndexLock);
 
-    for (const auto& it : GetAllOutputs()) {
+    for (const auto& it : GetAllOutputsSnapshot()) {
         it->ResetFrame();
     }
     _outputCriticalSection.Leave();
@@ -1100,9 +1186,13 @@ void OutputManager::EndFrame() {
 
     if (!_outputting) return;
     if (!_outputCriticalSection.TryEnter()) return;
+    std::unique_lock<std::mutex> lock(_outputIndexLock);
 
-    auto outputs = GetAllOutputs();
-    if (_parallelTransmission) {
+    auto& outputs = GetAllOutputsSnapshot();
+
+    // where supported the IP outputs queue their packets and they all go out together in FlushBatch
+    _batch->Begin();
+    if (_parallelTransmission && !IPOutputBatch::IsSupported()) {
         std::function<void(Output*&, int)> f = [this](Output*&o, int n) {
             o->EndFrame(_suppressFrames);
         };
@@ -1113,6 +1203,7 @@ void OutputManager::EndFrame() {
             it->EndFrame(_suppressFrames);
         }
     }
+    _batch->Flush();
 
     if (IsSyncEnabled()) {
         if (_syncUniverse != 0) {
@@ -1162,36 +1253,35 @@ void OutputManager::SetManyChannels(int32_t channel, unsigned char* data, size_t
 
     if (size == 0) return;
 
-    int32_t stch;
-    Output* o = GetOutput(channel + 1, stch);
+    std::unique_lock<std::mutex> lock(_outputIndexLock);
+    int index = GetOutputIndex(channel + 1);
 
     // if this doesnt map to an output then skip it
-    if (o == nullptr) return;
+    if (index < 0) return;
 
-    // get an iterator to the output which contains our first channel
-    auto outputs = GetAllOutputs();
-    auto it = outputs.begin();
-    while (*it != o && it != outputs.end()) ++it;
+    // zero based offset into the first output
+    int32_t stch = channel + 1 - _outputIndexStart[index];
 
+    // walk forward through the outputs which follow the first one until we run out of data
     size_t left = size;
-    while (left > 0 && o != nullptr) {
+    const size_t count = _outputIndex.size();
+    for (size_t i = index; i < count && left > 0; i++) {
+        Output* o = _outputIndex[i];
         wxASSERT(!o->IsOutputCollection_CONVERT());
-        size_t mx = o->GetChannels() - stch + 1;
+        size_t mx = o->GetChannels() - stch;
         size_t send = std::min(left, mx);
         if (o->IsEnabled()) {
-            o->SetManyChannels(stch - 1, &data[size - left], send);
+            o->SetManyChannels(stch, &data[size - left], send);
         }
-        stch = 1;
+        stch = 0;
         left -= send;
+    }
+}
 
-        // Move to the next output
-        ++it;
-        if (it == outputs.end()) {
-            o = nullptr;
-        }
-        else {
-            o = *it;
-        }
+void OutputManager::SetManyChannels(unsigned char* data, const std::vector<std::pair<int32_t, size_t>>& ranges) {
+
+    for (const auto& it : ranges) {
+        SetManyChannels(it.first, data + it.first, it.second);
     }
 }
 
@@ -15,11 +15,16 @@
 #include <list>
 #include <string>
 #include <map>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 class wxWindow;
 class wxXmlNode;
 
 class Output;
+class IPOutputBatch;
 class Controller;
 class TestPreset;
 class Controller;
@@ -43,6 +48,19 @@ class OutputManager
     bool _didConvert = false;
     std::string _globalFPPProxy;
     wxCriticalSection _outputCriticalSection; // used to protect areas that must be single threaded
+    std::unique_ptr<IPOutputBatch> _batch; // the IP outputs packets for the frame being sent
+
+    // flat index of all outputs in start channel order used to map absolute channels to outputs without walking the controllers
+    // this is rebuilt lazily the first time it is needed after the controller layout changes. Anything reading
+    // the index must hold _outputIndexLock while it uses it. Invalidating just bumps the generation so a change
+    // which arrives while the index is being built is not lost ... the next reader sees it out of date and rebuilds.
+    mutable std::vector<Output*> _allOutputs; // every output in controller order
+    mutable std::vector<Output*> _outputIndex;
+    mutable std::vector<int32_t> _outputIndexStart; // 1 based start channel of each output in _outputIndex
+    mutable std::vector<int32_t> _outputIndexPages; // for each page of channels the first entry in _outputIndex which overlaps it
+    mutable std::atomic<uint32_t> _outputIndexGeneration;
+    mutable uint32_t _outputIndexBuiltGeneration = 0; // the generation the index was built from
+    mutable std::mutex _outputIndexLock;
     #pragma endregion 
 
     #pragma region Static Variables
@@ -53,12 +71,18 @@ class OutputManager
     static int _currentSecondCount;
     static bool _isRetryOpen;
     static bool _isInteractive;
+    static const int OUTPUT_INDEX_PAGE_SHIFT = 9; // 512 channel pages
     #pragma endregion 
 
     #pragma region Private Functions
     bool SetGlobalOutputtingFlag(bool state, bool force = false);
     bool ConvertStartChannel(const std::string sc, std::string& newsc) const;
     void AsyncPingAll();
+    void InvalidateOutputIndex() const { ++_outputIndexGeneration; }
+    // these all require _outputIndexLock to be held
+    void BuildOutputIndex() const;
+    int GetOutputIndex(int32_t absoluteChannel) const; // returns the position in _outputIndex of the output holding the channel or -1
+    std::vector<Output*>& GetAllOutputsSnapshot() const { BuildOutputIndex(); return _allOutputs; }
     #pragma endregion 
 
 public:
@@ -176,6 +200,7 @@ public:
     void EndFrame();
     void ResetFrame();
     void SendHeartbeat();
+    const IPOutputBatch& GetBatch() const { return *_batch; }
     #pragma endregion 
 
     #pragma region Packet Sync
@@ -194,6 +219,9 @@ public:
     #pragma region Data Setting
     void SetOneChannel(int32_t channel, unsigned char data);
     void SetManyChannels(int32_t channel, unsigned char* data, size_t size);
+    // data is the whole frame and ranges the zero based (start, count) spans which may have changed.
+    // Outputs outside them are not touched so they only send their keepalive frames
+    void SetManyChannels(unsigned char* data, const std::vector<std::pair<int32_t, size_t>>& ranges);
     void AllOff(bool send = true);
     #pragma endregion 
 
@@ -23,6 +23,7 @@
 #include "../xLightsApp.h"
 #include "../effects/RenderableEffect.h"
 
+#include <algorithm>
 #include <unordered_map>
 
 #include <log4cpp/Category.hh>
@@ -338,32 +339,19 @@ void Effect::SetStartTimeMS(int startTimeMS)
 {
     wxASSERT(!IsLocked());
 
-    if (startTimeMS > mStartTime)
-    {
-        IncrementChangeCount();
-        mStartTime = startTimeMS;
-    }
-    else
-    {
-        mStartTime = startTimeMS;
-        IncrementChangeCount();
-    }
+    // the time the effect leaves is changed as well as the time it now covers
+    int changedStart = std::min(startTimeMS, mStartTime);
+    mStartTime = startTimeMS;
+    IncrementChangeCount(changedStart, mEndTime);
 }
 
 void Effect::SetEndTimeMS(int endTimeMS)
 {
     wxASSERT(!IsLocked());
 
-    if (endTimeMS < mEndTime)
-    {
-        IncrementChangeCount();
-        mEndTime = endTimeMS;
-    }
-    else
-    {
-        mEndTime = endTimeMS;
-        IncrementChangeCount();
-    }
+    int changedEnd = std::max(endTimeMS, mEndTime);
+    mEndTime = endTimeMS;
+    IncrementChangeCount(mStartTime, changedEnd);
 }
 
 bool Effect::OverlapsWith(int startTimeMS, int EndTimeMS) const
@@ -443,7 +431,12 @@ void Effect::SetLocked(bool lock)
 
 void Effect::IncrementChangeCount()
 {
-    mParentLayer->IncrementChangeCount(GetStartTimeMS(), GetEndTimeMS());
+    IncrementChangeCount(GetStartTimeMS(), GetEndTimeMS());
+}
+
+void Effect::IncrementChangeCount(int startMS, int endMS)
+{
+    mParentLayer->IncrementChangeCount(startMS, endMS);
     std::unique_lock<std::recursive_mutex> lock(settingsLock);
     if (mCache) {
         mCache->Delete();
@@ -110,6 +110,7 @@ public:
     void SetParentEffectLayer(EffectLayer* parent) { mParentLayer = parent; }
 
     void IncrementChangeCount();
+    void IncrementChangeCount(int startMS, int endMS);
 
     std::string GetSettingsAsString() const;
     void SetSettings(const std::string &settings, bool keepxsettings);
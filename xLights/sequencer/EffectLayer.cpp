@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "EffectLayer.h"
@@ -27,7 +28,7 @@
 std::atomic_int EffectLayer::exclusive_index(0);
 const std::string NamedLayer::NO_NAME("");
 
-EffectLayer::EffectLayer(Element* parent)
+EffectLayer::EffectLayer(Element* parent) : mEffectIndexValid(false)
 {
     mParentElement = parent;
     mIndex = exclusive_index++;
@@ -80,27 +81,100 @@ Effect* EffectLayer::GetEffect(int index) const
 }
 Effect* EffectLayer::GetEffectByTime(int timeMS) {
     std::unique_lock<std::recursive_mutex> locker(lock);
-    for(std::vector<Effect*>::iterator i = mEffects.begin(); i != mEffects.end(); i++) {
-        if (timeMS >= (*i)->GetStartTimeMS() &&
-            timeMS <= (*i)->GetEndTimeMS()) {
-            return (*i);
+    int index = FindEffectIndexAtTime(timeMS, true);
+    return index == -1 ? nullptr : mEffects[index];
+}
+
+bool EffectLayer::UpdateEffectIndex() const
+{
+    // caller holds mEffectIndexLock
+    if (mEffectIndexValid) {
+        return mEffectIndexSorted;
+    }
+    // marked valid before it is read so a change made while building it is not lost
+    mEffectIndexValid = true;
+
+    mEffectStarts.resize(mEffects.size());
+    mEffectMaxEnds.resize(mEffects.size());
+    mEffectSet.clear();
+    mEffectSet.reserve(mEffects.size());
+    mEffectsByID.clear();
+    mEffectsByID.reserve(mEffects.size());
+    mEffectIndexSorted = true;
+    int maxEnd = std::numeric_limits<int>::min();
+    for (size_t i = 0; i < mEffects.size(); i++) {
+        int start = mEffects[i]->GetStartTimeMS();
+        int end = mEffects[i]->GetEndTimeMS();
+        // effects being moved can be briefly out of order in which case we fall back to scanning
+        if ((i > 0 && start < mEffectStarts[i - 1]) || end < start) {
+            mEffectIndexSorted = false;
+        }
+        mEffectStarts[i] = start;
+        maxEnd = std::max(maxEnd, end);
+        mEffectMaxEnds[i] = maxEnd;
+        mEffectSet.insert(mEffects[i]);
+        // the first effect with an id wins as it did when they were searched for
+        mEffectsByID.emplace(mEffects[i]->GetID(), mEffects[i]);
+    }
+    return mEffectIndexSorted;
+}
+
+int EffectLayer::FindEffectIndexAtTime(int ms, bool includeEnd) const
+{
+    std::unique_lock<std::mutex> locker(mEffectIndexLock);
+    if (!UpdateEffectIndex()) {
+        for (int i = 0; i < mEffects.size(); i++) {
+            if (ms >= mEffects[i]->GetStartTimeMS() &&
+                (includeEnd ? ms <= mEffects[i]->GetEndTimeMS() : ms < mEffects[i]->GetEndTimeMS())) {
+                return i;
+            }
         }
+        return -1;
     }
-    return nullptr;
+
+    // every effect before the first one whose end reaches ms ends too early and every one after it starts later
+    auto it = includeEnd ? std::lower_bound(mEffectMaxEnds.begin(), mEffectMaxEnds.end(), ms)
+                         : std::upper_bound(mEffectMaxEnds.begin(), mEffectMaxEnds.end(), ms);
+    if (it == mEffectMaxEnds.end()) {
+        return -1;
+    }
+    int index = it - mEffectMaxEnds.begin();
+    return mEffectStarts[index] <= ms ? index : -1;
 }
 
+void EffectLayer::GetEffectIndexRange(int startTimeMS, int endTimeMS, int &first, int &last) const
+{
+    // [first, last) holds every effect that ends at or after startTimeMS and starts at or before endTimeMS
+    std::unique_lock<std::mutex> locker(mEffectIndexLock);
+    if (!UpdateEffectIndex() || startTimeMS > endTimeMS) {
+        first = 0;
+        last = mEffects.size();
+        return;
+    }
+    first = std::lower_bound(mEffectMaxEnds.begin(), mEffectMaxEnds.end(), startTimeMS) - mEffectMaxEnds.begin();
+    last = std::upper_bound(mEffectStarts.begin(), mEffectStarts.end(), endTimeMS) - mEffectStarts.begin();
+}
 
-Effect* EffectLayer::GetEffectFromID(int id)
+int EffectLayer::GetEffectIndexCoveringTime(int ms, int startIndex) const
 {
-    Effect* eff = nullptr;
-    for (int x = 0; x < mEffects.size(); x++) {
-        if( mEffects[x]->GetID() == id )
-        {
-            eff = mEffects[x];
-            break;
+    int index = FindEffectIndexAtTime(ms, false);
+    if (index == -1 || index >= startIndex) {
+        return index;
+    }
+    for (int i = startIndex; i < mEffects.size(); i++) {
+        if (ms >= mEffects[i]->GetStartTimeMS() && ms < mEffects[i]->GetEndTimeMS()) {
+            return i;
         }
     }
-    return eff;
+    return -1;
+}
+
+Effect* EffectLayer::GetEffectFromID(int id)
+{
+    std::unique_lock<std::mutex> locker(mEffectIndexLock);
+    UpdateEffectIndex();
+    auto it = mEffectsByID.find(id);
+    return it == mEffectsByID.end() ? nullptr : it->second;
 }
 
 int EffectLayer::GetFirstSelectedEffectStartMS() const
@@ -134,6 +208,7 @@ void EffectLayer::RemoveEffect(int index)
         if (!e->IsLocked())
         {
             mEffects.erase(mEffects.begin() + index);
+            InvalidateEffectIndex();
             IncrementChangeCount(e->GetStartTimeMS(), e->GetEndTimeMS());
             e->SetTimeToDelete();
             mEffectsToDelete.push_back(e);
@@ -153,6 +228,7 @@ void EffectLayer::DeleteEffect(int id)
             mEffects[i]->SetTimeToDelete();
             mEffectsToDelete.push_back(mEffects[i]);
             mEffects.erase(mEffects.begin() + i);
+            InvalidateEffectIndex();
             NumberEffects();
             return;
         }
@@ -175,6 +251,7 @@ void EffectLayer::RemoveAllEffects(UndoManager *undo_mgr)
         mEffectsToDelete.push_back(mEffects[x]);
     }
     mEffects.clear();
+    InvalidateEffectIndex();
 }
 
 Effect* EffectLayer::AddEffect(int id, const std::string &n, const std::string &settings, const std::string &palette,
@@ -215,6 +292,7 @@ Effect* EffectLayer::AddEffect(int id, const std::string &n, const std::string &
     Effect *e = new Effect(this, id, name, settings, palette, startTimeMS, endTimeMS, Selected, Protected);
     wxASSERT(e != nullptr);
     mEffects.push_back(e);
+    InvalidateEffectIndex();
     if (!suppress_sort)
     {
         SortEffects();
@@ -228,11 +306,13 @@ void EffectLayer::NumberEffects()
     for (int x = 0; x < mEffects.size(); x++) {
         mEffects[x]->SetID(x);
     }
+    InvalidateEffectIndex();
 }
 
 void EffectLayer::SortEffects()
 {
     std::sort(mEffects.begin(), mEffects.end(), SortEffectByStartTime);
+    InvalidateEffectIndex();
     NumberEffects();
 }
 
@@ -311,14 +391,11 @@ bool EffectLayer::IsFixedTimingLayer()
 
 bool EffectLayer::HitTestEffectByTime(int timeMS, int& index) const
 {
-    for (int i = 0; i < mEffects.size(); i++)
+    int i = FindEffectIndexAtTime(timeMS, true);
+    if (i != -1)
     {
-        if (timeMS >= mEffects[i]->GetStartTimeMS() &&
-            timeMS <= mEffects[i]->GetEndTimeMS())
-        {
-            index = i;
-            return true;
-        }
+        index = i;
+        return true;
     }
     return false;
 }
@@ -340,11 +417,21 @@ bool EffectLayer::HitTestEffectBetweenTime(int t1MS, int t2MS) const
 Effect* EffectLayer::GetEffectBeforeTime(int ms) const
 {
     int i;
-    for (i = 0; i < mEffects.size(); i++)
     {
-        if (mEffects[i]->GetStartTimeMS() >= ms)
+        std::unique_lock<std::mutex> locker(mEffectIndexLock);
+        if (UpdateEffectIndex())
         {
-            break;
+            i = std::lower_bound(mEffectStarts.begin(), mEffectStarts.end(), ms) - mEffectStarts.begin();
+        }
+        else
+        {
+            for (i = 0; i < mEffects.size(); i++)
+            {
+                if (mEffects[i]->GetStartTimeMS() >= ms)
+                {
+                    break;
+                }
+            }
         }
     }
     if (i == 0)
@@ -360,11 +447,21 @@ Effect* EffectLayer::GetEffectBeforeTime(int ms) const
 Effect* EffectLayer::GetEffectAfterTime(int ms) const
 {
     int i;
-    for (i = 0; i < mEffects.size(); i++)
     {
-        if (mEffects[i]->GetStartTimeMS() > ms)
+        std::unique_lock<std::mutex> locker(mEffectIndexLock);
+        if (UpdateEffectIndex())
         {
-            break;
+            i = std::upper_bound(mEffectStarts.begin(), mEffectStarts.end(), ms) - mEffectStarts.begin();
+        }
+        else
+        {
+            for (i = 0; i < mEffects.size(); i++)
+            {
+                if (mEffects[i]->GetStartTimeMS() > ms)
+                {
+                    break;
+                }
+            }
         }
     }
     if (i >= mEffects.size())
@@ -379,17 +476,20 @@ Effect* EffectLayer::GetEffectAfterTime(int ms) const
 
 Effect* EffectLayer::GetEffectAtTime(int timeMS) const
 {
-    for (int i = 0; i < mEffects.size(); i++) {
-        if (timeMS >= mEffects[i]->GetStartTimeMS() &&
-            timeMS <= mEffects[i]->GetEndTimeMS()) {
-            return mEffects[i];
-        }
-    }
-    return nullptr;
+    int index = FindEffectIndexAtTime(timeMS, true);
+    return index == -1 ? nullptr : mEffects[index];
 }
 
 Effect* EffectLayer::GetEffectStartingAtTime(int timeMS) const
 {
+    std::unique_lock<std::mutex> locker(mEffectIndexLock);
+    if (UpdateEffectIndex()) {
+        auto it = std::lower_bound(mEffectStarts.begin(), mEffectStarts.end(), timeMS);
+        if (it != mEffectStarts.end() && *it == timeMS) {
+            return mEffects[it - mEffectStarts.begin()];
+        }
+        return nullptr;
+    }
     for (int i = 0; i < mEffects.size(); i++) {
         if (timeMS == mEffects[i]->GetStartTimeMS()) {
             return mEffects[i];
@@ -420,22 +520,7 @@ Effect* EffectLayer::GetEffectBeforeEmptyTime(int ms) const
 
 Effect* EffectLayer::GetEffectAfterEmptyTime(int ms) const
 {
-    int i;
-    for (i = 0; i < mEffects.size(); i++)
-    {
-        if (mEffects[i]->GetStartTimeMS() > ms)
-        {
-            break;
-        }
-    }
-    if (i == mEffects.size())
-    {
-        return nullptr;
-    }
-    else
-    {
-        return mEffects[i];
-    }
+    return GetEffectAfterTime(ms);
 }
 
 std::list<Effect*> EffectLayer::GetAllEffects() const
@@ -452,7 +537,9 @@ std::list<Effect*> EffectLayer::GetAllEffects() const
 
 bool EffectLayer::GetRangeIsClearMS(int startTimeMS, int endTimeMS, bool ignore_selected)
 {
-    for (int i = 0; i < mEffects.size(); i++)
+    int first, last;
+    GetEffectIndexRange(startTimeMS, endTimeMS, first, last);
+    for (int i = first; i < last; i++)
     {
         if (ignore_selected)
         {
@@ -481,7 +568,9 @@ bool EffectLayer::GetRangeIsClearMS(int startTimeMS, int endTimeMS, bool ignore_
 }
 
 bool EffectLayer::HasEffectsInTimeRange(int startTimeMS, int endTimeMS) {
-    for (int i = 0; i < mEffects.size(); i++)
+    int first, last;
+    GetEffectIndexRange(startTimeMS, endTimeMS, first, last);
+    for (int i = first; i < last; i++)
     {
         if (mEffects[i]->OverlapsWith(startTimeMS, endTimeMS)) return true;
     }
@@ -508,7 +597,9 @@ bool EffectLayer::HasEffectsByType(const std::string& type) const
 int EffectLayer::SelectEffectsInTimeRange(int startTimeMS, int endTimeMS)
 {
     int num_selected = 0;
-    for (int i = 0; i < mEffects.size(); i++)
+    int first, last;
+    GetEffectIndexRange(startTimeMS, endTimeMS, first, last);
+    for (int i = first; i < last; i++)
     {
         int midpoint = mEffects[i]->GetStartTimeMS() + ((mEffects[i]->GetEndTimeMS() - mEffects[i]->GetStartTimeMS()) / 2);
         if (mEffects[i]->GetStartTimeMS() >= startTimeMS && mEffects[i]->GetStartTimeMS() < endTimeMS)
@@ -547,7 +638,9 @@ int EffectLayer::SelectEffectsInTimeRange(int startTimeMS, int endTimeMS)
 std::vector<Effect*> EffectLayer::GetEffectsByTypeAndTime(const std::string &type, int startTimeMS, int endTimeMS)
 {
     std::vector<Effect*> effs = std::vector<Effect*>();
-    for (int i = 0; i < mEffects.size(); i++)
+    int first, last;
+    GetEffectIndexRange(startTimeMS, endTimeMS, first, last);
+    for (int i = first; i < last; i++)
     {
         if (mEffects[i]->GetEffectName() == type)
         {
@@ -571,7 +664,9 @@ std::vector<Effect*> EffectLayer::GetEffectsByTypeAndTime(const std::string &typ
 std::vector<Effect*> EffectLayer::GetAllEffectsByTime(int startTimeMS, int endTimeMS)
 {
     std::vector<Effect*> effs = std::vector<Effect*>();
-    for (int i = 0; i < mEffects.size(); i++)
+    int first, last;
+    GetEffectIndexRange(startTimeMS, endTimeMS, first, last);
+    for (int i = first; i < last; i++)
     {
         if (mEffects[i]->GetStartTimeMS() >= startTimeMS && mEffects[i]->GetStartTimeMS() < endTimeMS)
         {
@@ -618,27 +713,19 @@ Effect* EffectLayer::SelectEffectUsingDescription(std::string description)
 
 bool EffectLayer::IsEffectValid(Effect* e) const
 {
-    for (int i = 0; i < mEffects.size(); i++)
-    {
-        if ((void*)mEffects[i] == (void*)e)
-        {
-            return true;
-        }
-    }
-
-    return false;
+    std::unique_lock<std::mutex> locker(mEffectIndexLock);
+    UpdateEffectIndex();
+    return mEffectSet.find(e) != mEffectSet.end();
 }
 
 Effect* EffectLayer::SelectEffectUsingTime(int time)
 {
-    for (int i = 0; i < mEffects.size(); i++)
+    int i = FindEffectIndexAtTime(time, false);
+    if (i != -1)
     {
-        if (time >= mEffects[i]->GetStartTimeMS() && time < mEffects[i]->GetEndTimeMS())
-        {
-            mEffects[i]->SetSelected(EFFECT_SELECTED);
-            PlayEffect(mEffects[i]);
-            return mEffects[i];
-        }
+        mEffects[i]->SetSelected(EFFECT_SELECTED);
+        PlayEffect(mEffects[i]);
+        return mEffects[i];
     }
 
     return nullptr;
@@ -1264,6 +1351,7 @@ void EffectLayer::DeleteSelectedEffects(UndoManager& undo_mgr)
         }
     }
     mEffects.erase(std::remove_if(mEffects.begin(), mEffects.end(), ShouldDeleteSelected),mEffects.end());
+    InvalidateEffectIndex();
 }
 
 void EffectLayer::DeleteAllEffects()
@@ -1278,6 +1366,7 @@ void EffectLayer::DeleteAllEffects()
         }
     }
     mEffects.erase(std::remove_if(mEffects.begin(), mEffects.end(), ShouldDeleteNotLocked), mEffects.end());
+    InvalidateEffectIndex();
 }
 
 void EffectLayer::DeleteEffectByIndex(int idx) {
@@ -1288,6 +1377,7 @@ void EffectLayer::DeleteEffectByIndex(int idx) {
         mEffects[idx]->SetTimeToDelete();
         mEffectsToDelete.push_back(mEffects[idx]);
         mEffects.erase(mEffects.begin() + idx);
+        InvalidateEffectIndex();
     }
 }
 
@@ -1308,6 +1398,8 @@ bool EffectLayer::SortEffectByStartTime(Effect *e1,Effect *e2)
 
 void EffectLayer::IncrementChangeCount(int startMS, int endMS)
 {
+    // effect times may have changed
+    InvalidateEffectIndex();
     if (mParentElement) {
         mParentElement->IncrementChangeCount(startMS, endMS);
     }
@@ -15,6 +15,8 @@
 #include <string>
 #include <list>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include "Effect.h"
 #include "UndoManager.h"
 #include "../effects/EffectManager.h"
@@ -71,6 +73,8 @@ class EffectLayer
         bool HitTestEffectBetweenTime(int t1MS, int t2MS) const;
 
         Effect* GetEffectAtTime(int ms) const;
+        // index of the first effect at or after startIndex with start <= ms < end, -1 if there isnt one
+        int GetEffectIndexCoveringTime(int ms, int startIndex = 0) const;
         Effect* GetEffectStartingAtTime(int ms) const;
         Effect* GetEffectBeforeTime(int ms) const;
         Effect* GetEffectAfterTime(int ms) const;
@@ -121,9 +125,9 @@ class EffectLayer
 
         void CleanupAfterRender();
         void NumberEffects();
+        void SortEffects();
     protected:
     private:
-        void SortEffects();
         void PlayEffect(Effect* effect);
 
         static std::atomic_int exclusive_index;
@@ -133,6 +137,21 @@ class EffectLayer
         void GetMaximumRangeOfMovementForEffect(int index, int &toLeft, int &toRight);
         void GetMaximumRangeWithLeftMovement(int index, int &toLeft, int &toRight);
         void GetMaximumRangeWithRightMovement(int index, int &toLeft, int &toRight);
+
+        // Lookup index over mEffects rebuilt on first use after the layer changes. Start times are kept in order with
+        // the running maximum of the end times so the first effect covering a time is a binary search away.
+        void InvalidateEffectIndex() { mEffectIndexValid = false; }
+        bool UpdateEffectIndex() const;
+        int FindEffectIndexAtTime(int ms, bool includeEnd) const;
+        void GetEffectIndexRange(int startTimeMS, int endTimeMS, int &first, int &last) const;
+        mutable std::mutex mEffectIndexLock;
+        mutable std::atomic_bool mEffectIndexValid;
+        mutable bool mEffectIndexSorted = false;
+        mutable std::vector<int> mEffectStarts;
+        mutable std::vector<int> mEffectMaxEnds;
+        mutable std::unordered_set<const Effect*> mEffectSet;
+        mutable std::unordered_map<int, Effect*> mEffectsByID;
+
         std::vector<Effect*> mEffects;
         std::list<Effect*> mEffectsToDelete;
         int mIndex;
@@ -27,6 +27,7 @@
 #include "../SequenceViewManager.h"
 #include "../JukeboxPanel.h"
 #include "../TraceLog.h"
+#include "../Parallel.h"
 
 #include <log4cpp/Category.hh>
 
@@ -43,15 +44,6 @@ static const std::string STR_INDEX("index");
 static const std::string STR_TYPE("type");
 static const std::string STR_TIMING("timing");
 
-static const std::string STR_STARTTIME("startTime");
-static const std::string STR_ENDTIME("endTime");
-static const std::string STR_PROTECTED("protected");
-static const std::string STR_ID("id");
-static const std::string STR_REF("ref");
-static const std::string STR_PALETTE("palette");
-static const std::string STR_LABEL("label");
-static const std::string STR_ZERO("0");
-
 SequenceElements::SequenceElements(xLightsFrame *f)
     : mEffectsNode(nullptr), undo_mgr(this), xframe(f), mFrequency(20), mSequenceEndMS(0)
 {
@@ -641,92 +633,64 @@ void SequenceElements::MoveElement(int index,int destinationIndex)
 
 int SequenceElements::LoadEffects(EffectLayer *effectLayer,
     const std::string &type,
-    wxXmlNode *effectLayerNode,
+    const SequenceFileLayer &fileLayer,
     const std::vector<std::string> & effectStrings,
     const std::vector<std::string> & colorPalettes) {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    int loaded = 0;
-    for (wxXmlNode* effect = effectLayerNode->GetChildren(); effect != nullptr; effect = effect->GetNext())
-    {
-        if (effect->GetName() == STR_EFFECT)
-        {
-            std::string effectName;
-            std::string settings;
-            int id = 0;
-            long palette = -1;
-
-            // Start time
-            double startTime;
-            effect->GetAttribute(STR_STARTTIME).ToDouble(&startTime);
-            startTime = TimeLine::RoundToMultipleOfPeriod(startTime, mFrequency);
-            // End time
-            double endTime;
-            effect->GetAttribute(STR_ENDTIME).ToDouble(&endTime);
-            endTime = TimeLine::RoundToMultipleOfPeriod(endTime, mFrequency);
-            // Protected
-            bool bProtected = effect->GetAttribute(STR_PROTECTED) == '1' ? true : false;
-            if (type != STR_TIMING)
-            {
-                // Name
-                effectName = effect->GetAttribute(STR_NAME);
-                // ID
-                id = wxAtoi(effect->GetAttribute(STR_ID, STR_ZERO));
-                if (effect->GetAttribute(STR_REF) != STR_EMPTY) {
-                    int ref = wxAtoi(effect->GetAttribute(STR_REF));
-                    if (ref >= effectStrings.size())
-                    {
-                        logger_base.warn("Effect string not found for effect %s between %d and %d. Settings ignored.", (const char *)effectName.c_str(), (int)startTime, (int)endTime);
-                        settings = "";
-                    }
-                    else
-                    {
-                        settings = effectStrings[ref];
-                    }
-                }
-                else {
-                    settings = effect->GetNodeContent();
-                }
+    bool timing = type == STR_TIMING;
+    for (const auto& effect : fileLayer.effects)
+    {
+        double startTime = TimeLine::RoundToMultipleOfPeriod(effect.startTime, mFrequency);
+        double endTime = TimeLine::RoundToMultipleOfPeriod(effect.endTime, mFrequency);
 
-                if (settings.find("E_FILEPICKER_Pictures_Filename") != std::string::npos)
+        std::string settings;
+        if (!timing)
+        {
+            if (effect.ref != -1) {
+                if (effect.ref < 0 || effect.ref >= effectStrings.size())
                 {
-                    settings = FixEffectFileParameter("E_FILEPICKER_Pictures_Filename", settings, "");
+                    logger_base.warn("Effect string not found for effect %s between %d and %d. Settings ignored.", (const char *)effect.name.c_str(), (int)startTime, (int)endTime);
                 }
-                else if (settings.find("E_FILEPICKER_Glediator_Filename") != std::string::npos)
+                else
                 {
-                    settings = FixEffectFileParameter("E_FILEPICKER_Glediator_Filename", settings, "");
-                }
-
-                wxString tmp;
-                if (effect->GetAttribute(STR_PALETTE, &tmp)) {
-                    tmp.ToLong(&palette);
+                    settings = effectStrings[effect.ref];
                 }
             }
-            else
-            {
-                // store timing labels in name attribute
-                effectName = UnXmlSafe(effect->GetAttribute(STR_LABEL));
+            else {
+                settings = effect.settings;
             }
-            std::string pal = STR_EMPTY;
-            if (palette != -1)
+
+            if (settings.find("E_FILEPICKER_Pictures_Filename") != std::string::npos)
             {
-                pal = colorPalettes[palette];
+                settings = FixEffectFileParameter("E_FILEPICKER_Pictures_Filename", settings, "");
             }
-            effectLayer->AddEffect(id, effectName, settings, pal,
-                startTime, endTime, EFFECT_NOT_SELECTED, bProtected);
-        }
-        else if (effect->GetName() == STR_NODE && effectLayerNode->GetName() == STR_STRAND) {
-            StrandElement *se = (StrandElement*)effectLayer->GetParentElement();
-            EffectLayer* neffectLayer = se->GetNodeLayer(wxAtoi(effect->GetAttribute(STR_INDEX)), true);
-            if (effect->GetAttribute(STR_NAME, STR_EMPTY) != STR_EMPTY) {
-                ((NodeLayer*)neffectLayer)->SetName(effect->GetAttribute(STR_NAME).ToStdString());
+            else if (settings.find("E_FILEPICKER_Glediator_Filename") != std::string::npos)
+            {
+                settings = FixEffectFileParameter("E_FILEPICKER_Glediator_Filename", settings, "");
             }
-
-            LoadEffects(neffectLayer, type, effect, effectStrings, colorPalettes);
         }
-        loaded++;
+        std::string pal = STR_EMPTY;
+        if (effect.palette != -1)
+        {
+            pal = colorPalettes[effect.palette];
+        }
+        // sorted once the whole layer is loaded rather than after every effect
+        effectLayer->AddEffect(effect.id, effect.name, settings, pal,
+            startTime, endTime, EFFECT_NOT_SELECTED, effect.isProtected, true);
     }
-    return loaded;
+    for (const auto& node : fileLayer.nodes)
+    {
+        StrandElement *se = (StrandElement*)effectLayer->GetParentElement();
+        EffectLayer* neffectLayer = se->GetNodeLayer(node.index, true);
+        if (node.name != STR_EMPTY) {
+            ((NodeLayer*)neffectLayer)->SetName(node.name);
+        }
+
+        LoadEffects(neffectLayer, type, node, effectStrings, colorPalettes);
+    }
+    effectLayer->SortEffects();
+    return fileLayer.effects.size() + fileLayer.nodes.size();
 }
 
 bool SequenceElements::LoadSequencerFile(xLightsXmlFile& xml_file, const wxString &ShowDir)
@@ -811,36 +775,65 @@ bool SequenceElements::LoadSequencerFile(xLightsXmlFile& xml_file, const wxStrin
                 }
             }
         }
+        else if (e->GetName() == "EffectDB" && xml_file.HasStreamedEffectDB())
+        {
+            // streamed entries are used as read, as the document ones are since fixing a node below
+            // doesnt change the text it is read from
+            xml_file.TakeStreamedEffectDB(effectStrings);
+        }
         else if (e->GetName() == "EffectDB")
         {
-            effectStrings.clear();
+            std::vector<wxXmlNode*> nodes;
             for (wxXmlNode* elementNode = e->GetChildren(); elementNode != nullptr; elementNode = elementNode->GetNext())
             {
                 if (elementNode->GetName() == STR_EFFECT)
                 {
-                    if (elementNode->GetNodeContent().Find("E_FILEPICKER_Pictures_Filename") >= 0)
-                    {
-                        elementNode->SetContent(FixEffectFileParameter("E_FILEPICKER_Pictures_Filename", elementNode->GetNodeContent(), ShowDir));
-                    }
-                    else if (elementNode->GetNodeContent().Find("E_TEXTCTRL_Glediator_Filename") >= 0)
-                    {
-                        elementNode->SetContent(FixEffectFileParameter("E_TEXTCTRL_Glediator_Filename", elementNode->GetNodeContent(), ShowDir));
-                    }
+                    nodes.push_back(elementNode);
+                }
+            }
+
+            // the settings strings are independent so decode them across the pool
+            effectStrings.clear();
+            effectStrings.resize(nodes.size());
+            parallel_for(0, nodes.size(), [&nodes, &effectStrings](int i) {
+                effectStrings[i] = nodes[i]->GetNodeContent().ToStdString();
+            }, 500);
 
-                    effectStrings.push_back(elementNode->GetNodeContent().ToStdString());
+            // file fixing shares a cache of known files so do the few that need it one at a time
+            for (size_t i = 0; i < nodes.size(); i++)
+            {
+                std::string param;
+                if (effectStrings[i].find("E_FILEPICKER_Pictures_Filename") != std::string::npos)
+                {
+                    param = "E_FILEPICKER_Pictures_Filename";
+                }
+                else if (effectStrings[i].find("E_TEXTCTRL_Glediator_Filename") != std::string::npos)
+                {
+                    param = "E_TEXTCTRL_Glediator_Filename";
+                }
+                if (param != "")
+                {
+                    nodes[i]->SetContent(FixEffectFileParameter(param, nodes[i]->GetNodeContent(), ShowDir));
+                    effectStrings[i] = nodes[i]->GetNodeContent().ToStdString();
                 }
             }
         }
         else if (e->GetName() == "ColorPalettes")
         {
-            colorPalettes.clear();
+            std::vector<wxXmlNode*> nodes;
             for (wxXmlNode* elementNode = e->GetChildren(); elementNode != nullptr; elementNode = elementNode->GetNext())
             {
                 if (elementNode->GetName() == STR_COLORPALETTE)
                 {
-                    colorPalettes.push_back(elementNode->GetNodeContent().ToStdString());
+                    nodes.push_back(elementNode);
                 }
             }
+
+            colorPalettes.clear();
+            colorPalettes.resize(nodes.size());
+            parallel_for(0, nodes.size(), [&nodes, &colorPalettes](int i) {
+                colorPalettes[i] = nodes[i]->GetNodeContent().ToStdString();
+            }, 500);
         }
         else if (e->GetName() == "Jukebox")
         {
@@ -848,118 +841,113 @@ bool SequenceElements::LoadSequencerFile(xLightsXmlFile& xml_file, const wxStrin
         }
         else if (e->GetName() == "ElementEffects")
         {
+            // take the layers of every element first so progress can be shown against the total
+            std::vector<std::pair<wxXmlNode*, std::vector<SequenceFileLayer>>> elementLayers;
             int count = 0;
             for (wxXmlNode* elementNode = e->GetChildren(); elementNode != NULL; elementNode = elementNode->GetNext())
             {
                 if (elementNode->GetName() == STR_ELEMENT)
                 {
-                    for (wxXmlNode* effectLayerNode = elementNode->GetChildren(); effectLayerNode != nullptr; effectLayerNode = effectLayerNode->GetNext())
+                    elementLayers.emplace_back(elementNode, std::vector<SequenceFileLayer>());
+                    xml_file.TakeElementLayers(elementNode, elementLayers.back().second);
+                    for (const auto& l : elementLayers.back().second)
                     {
-                        for (wxXmlNode* effect = effectLayerNode->GetChildren(); effect != nullptr; effect = effect->GetNext())
-                        {
-                            count++;
-                        }
+                        count += l.effects.size() + l.nodes.size();
                     }
                 }
             }
 
             int loaded = 0;
-            for (wxXmlNode* elementNode = e->GetChildren(); elementNode != NULL; elementNode = elementNode->GetNext())
+            for (auto& it : elementLayers)
             {
-                if (elementNode->GetName() == STR_ELEMENT)
+                wxXmlNode* elementNode = it.first;
+                auto nm = elementNode->GetAttribute(STR_NAME).Trim(true).Trim(false);
+                if (elementNode->GetAttribute(STR_NAME) != nm)                     {
+                    elementNode->DeleteAttribute(STR_NAME);
+                    elementNode->AddAttribute(STR_NAME, nm);
+                }
+                Element* element = GetElement(elementNode->GetAttribute(STR_NAME));
+                if (element != nullptr)
                 {
-                    auto nm = elementNode->GetAttribute(STR_NAME).Trim(true).Trim(false);
-                    if (elementNode->GetAttribute(STR_NAME) != nm)                         {
-                        elementNode->DeleteAttribute(STR_NAME);
-                        elementNode->AddAttribute(STR_NAME, nm);
+                    // check for fixed timing interval
+                    int interval = 0;
+                    if (elementNode->GetAttribute(STR_TYPE) == STR_TIMING)
+                    {
+                        interval = wxAtoi(elementNode->GetAttribute("fixed"));
                     }
-                    Element* element = GetElement(elementNode->GetAttribute(STR_NAME));
-                    if (element != nullptr)
+                    if (interval > 0)
                     {
-                        // check for fixed timing interval
-                        int interval = 0;
-                        if (elementNode->GetAttribute(STR_TYPE) == STR_TIMING)
+                        if (interval != TimeLine::RoundToMultipleOfPeriod(interval, mFrequency))
                         {
-                            interval = wxAtoi(elementNode->GetAttribute("fixed"));
+                            int newinterval = TimeLine::RoundToMultipleOfPeriod(interval, mFrequency);
+                            if (newinterval == 0) newinterval = 1000/mFrequency;
+                            logger_base.warn("Timing interval of %dms not a multiple of frame time so changed to %dms.", interval, newinterval);
+                            interval = newinterval;
                         }
-                        if (interval > 0)
+                        dynamic_cast<TimingElement*>(element)->SetFixedTiming(interval);
+                        EffectLayer* effectLayer = element->AddEffectLayer();
+                        int time = 0;
+                        int end_time = TimeLine::RoundToMultipleOfPeriod(xml_file.GetSequenceDurationMS(), mFrequency);
+                        while (time < end_time)
                         {
-                            if (interval != TimeLine::RoundToMultipleOfPeriod(interval, mFrequency))
-                            {
-                                int newinterval = TimeLine::RoundToMultipleOfPeriod(interval, mFrequency);
-                                if (newinterval == 0) newinterval = 1000/mFrequency;
-                                logger_base.warn("Timing interval of %dms not a multiple of frame time so changed to %dms.", interval, newinterval);
-                                interval = newinterval;
-                            }
-                            dynamic_cast<TimingElement*>(element)->SetFixedTiming(interval);
-                            EffectLayer* effectLayer = element->AddEffectLayer();
-                            int time = 0;
-                            int end_time = TimeLine::RoundToMultipleOfPeriod(xml_file.GetSequenceDurationMS(), mFrequency);
-                            while (time < end_time)
-                            {
-                                int startTime = time;
-                                int endTime = time + interval;
-                                effectLayer->AddEffect(0, "", "", "", startTime, endTime, EFFECT_NOT_SELECTED, false, true); // we can suppress sort because we know we are adding them in time order
-                                time += interval;
-                            }
-                            effectLayer->NumberEffects();
+                            int startTime = time;
+                            int endTime = time + interval;
+                            effectLayer->AddEffect(0, "", "", "", startTime, endTime, EFFECT_NOT_SELECTED, false, true); // we can suppress sort because we know we are adding them in time order
+                            time += interval;
                         }
-                        else
+                        effectLayer->NumberEffects();
+                    }
+                    else
+                    {
+                        std::string type = elementNode->GetAttribute(STR_TYPE).ToStdString();
+                        for (const auto& fileLayer : it.second)
                         {
-                            for (wxXmlNode* effectLayerNode = elementNode->GetChildren(); effectLayerNode != nullptr; effectLayerNode = effectLayerNode->GetNext())
-                            {
-                                EffectLayer* effectLayer = nullptr;
-                                if (effectLayerNode->GetName() == STR_EFFECTLAYER) {
-                                    effectLayer = element->AddEffectLayer();
+                            EffectLayer* effectLayer = nullptr;
+                            if (fileLayer.type == STR_EFFECTLAYER) {
+                                effectLayer = element->AddEffectLayer();
+                            }
+                            else if (fileLayer.type == STR_SUBMODEL_EFFECTLAYER) {
+                                SubModelElement *se = dynamic_cast<ModelElement*>(element)->GetSubModel(fileLayer.name, true);
+                                wxASSERT(se != nullptr);
+                                while (fileLayer.layer >= se->GetEffectLayerCount()) {
+                                    se->AddEffectLayer();
                                 }
-                                else if (effectLayerNode->GetName() == STR_SUBMODEL_EFFECTLAYER) {
-                                    wxString name = effectLayerNode->GetAttribute("name").Trim(true).Trim(false);
-                                    if (name != effectLayerNode->GetAttribute("name")) {
-                                        effectLayerNode->DeleteAttribute("name");
-                                        effectLayerNode->AddAttribute("name", name);
-                                    }
-                                    int layer = wxAtoi(effectLayerNode->GetAttribute("layer", "0"));
-                                    SubModelElement *se = dynamic_cast<ModelElement*>(element)->GetSubModel(name.ToStdString(), true);
-                                    wxASSERT(se != nullptr);
-                                    while (layer >= se->GetEffectLayerCount()) {
+                                effectLayer = se->GetEffectLayer(fileLayer.layer);
+                            }
+                            else {
+                                if (dynamic_cast<ModelElement*>(element) != nullptr) {
+                                    StrandElement* se = dynamic_cast<ModelElement*>(element)->GetStrand(fileLayer.index, true);
+                                    while (fileLayer.layer >= se->GetEffectLayerCount()) {
                                         se->AddEffectLayer();
                                     }
-                                    effectLayer = se->GetEffectLayer(layer);
-                                }
-                                else {
-                                    if (dynamic_cast<ModelElement*>(element) != nullptr) {
-                                        StrandElement* se = dynamic_cast<ModelElement*>(element)->GetStrand(wxAtoi(effectLayerNode->GetAttribute(STR_INDEX)), true);
-                                        int layer = wxAtoi(effectLayerNode->GetAttribute("layer", "0"));
-                                        while (layer >= se->GetEffectLayerCount()) {
-                                            se->AddEffectLayer();
-                                        }
-                                        effectLayer = se->GetEffectLayer(layer);
-                                        if (effectLayerNode->GetAttribute(STR_NAME, STR_EMPTY) != STR_EMPTY) {
-                                            se->SetName(effectLayerNode->GetAttribute(STR_NAME).Trim(true).Trim(false).ToStdString());
-                                        }
-                                    }
-                                    else                                         {
-                                        logger_base.error("Element %s was not a model element: %s. This typically happens when a timing track is created with the same name as a model.", (const char *)element->GetName().c_str());
+                                    effectLayer = se->GetEffectLayer(fileLayer.layer);
+                                    if (fileLayer.name != STR_EMPTY) {
+                                        se->SetName(fileLayer.name);
                                     }
                                 }
-                                if (effectLayer != nullptr) {
-                                    loaded += LoadEffects(effectLayer, elementNode->GetAttribute(STR_TYPE).ToStdString(), effectLayerNode, effectStrings, colorPalettes);
-                                    if (count) {
-                                        GetXLightsFrame()->SetStatusText(wxString::Format("Effects Loaded: %i%%.", loaded * 100 / count));
-                                    }
+                                else                                     {
+                                    logger_base.error("Element %s was not a model element: %s. This typically happens when a timing track is created with the same name as a model.", (const char *)element->GetName().c_str());
                                 }
-                                else
-                                {
-                                    wxASSERT(false);
+                            }
+                            if (effectLayer != nullptr) {
+                                loaded += LoadEffects(effectLayer, type, fileLayer, effectStrings, colorPalettes);
+                                if (count) {
+                                    GetXLightsFrame()->SetStatusText(wxString::Format("Effects Loaded: %i%%.", loaded * 100 / count));
                                 }
                             }
+                            else
+                            {
+                                wxASSERT(false);
+                            }
                         }
                     }
-                    else
-                    {
-                        wxASSERT(false);
-                    }
                 }
+                else
+                {
+                    wxASSERT(false);
+                }
+                // the effects now live in the layers
+                std::vector<SequenceFileLayer>().swap(it.second);
             }
         }
         TraceLog::PopTraceContext();
@@ -22,6 +22,7 @@
 #include "UndoManager.h"
 
 class xLightsXmlFile;  // forward declaration needed due to circular dependency
+struct SequenceFileLayer;
 class SequenceViewManager;
 class TimeLine;
 
@@ -203,7 +204,7 @@ protected:
 private:
     int LoadEffects(EffectLayer *layer,
         const std::string &type,
-        wxXmlNode *effectLayerNode,
+        const SequenceFileLayer &fileLayer,
         const std::vector<std::string> & effectStrings,
         const std::vector<std::string> & colorPalettes);
     static bool SortElementsByIndex(const Element *element1, const Element *element2)
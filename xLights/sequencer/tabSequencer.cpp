@@ -3100,10 +3100,10 @@ std::map<int, std::list<float>> xLightsFrame::LoadPolyphonicTranscription(AudioM
 
         for (size_t i = 0; i < frames; i++)
         {
-            std::list<float> const * const pdata = audio->GetFrameData(i, FRAMEDATA_NOTES, "");
-            if (pdata != nullptr)
+            const FrameDataSpan pdata = audio->GetFrameData(i, FRAMEDATA_NOTES, "");
+            if (!pdata.empty())
             {
-                res[i*intervalMS] = *pdata;
+                res[i*intervalMS] = std::list<float>(pdata.begin(), pdata.end());
             }
         }
 
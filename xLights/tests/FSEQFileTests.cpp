@@ -0,0 +1,96 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "SelfTests.h"
+#include "../FSEQFile.h"
+
+#include <wx/filename.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <log4cpp/Category.hh>
+
+// frames that compress about as well as a real sequence, runs of the same value with some noise
+static void FillFSEQTestFrame(std::mt19937 &rng, uint32_t frame, std::vector<uint8_t> &data)
+{
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(((i / 300) * 37 + frame * 3) & 0xFF);
+    }
+    for (int i = 0; i < 200; i++) {
+        data[rng() % data.size()] = (uint8_t)rng();
+    }
+}
+
+// Writes the same sequence as a zstd V2 fseq using 1, 2, 4 and all the cores, checks every file reads
+// back to the frames that were written and logs how long each save took.
+bool FSEQFileSelfTest()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    const uint32_t channels = 30000;
+    const uint32_t frames = 1200;
+
+    std::vector<std::vector<uint8_t>> data(frames, std::vector<uint8_t>(channels));
+    std::mt19937 rng(0x5eed);
+    for (uint32_t f = 0; f < frames; f++) {
+        FillFSEQTestFrame(rng, f, data[f]);
+    }
+
+    std::vector<int> threadCounts = { 1, 2, 4 };
+    int cores = (int)std::thread::hardware_concurrency();
+    if (cores > 4) {
+        threadCounts.push_back(cores);
+    }
+
+    wxFileName fn(wxFileName::GetTempDir(), "xLightsFSEQSelfTest.fseq");
+    std::string filename = fn.GetFullPath().ToStdString();
+    bool ok = true;
+    for (int threads : threadCounts) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<FSEQFile> out(FSEQFile::createFSEQFile(filename, 2, FSEQFile::CompressionType::zstd));
+        out->setChannelCount(channels);
+        out->setStepTime(25);
+        out->setNumFrames(frames);
+        out->setCompressionThreads(threads);
+        out->writeHeader();
+        for (uint32_t f = 0; f < frames; f++) {
+            out->addFrame(f, data[f].data());
+        }
+        out->finalize();
+        out.reset();
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        logger_base.info("FSEQ benchmark: %u frames of %u channels saved in %lldms using %d thread(s).", frames, channels, ms, threads);
+
+        std::unique_ptr<FSEQFile> in(FSEQFile::openFSEQFile(filename));
+        if (in == nullptr || in->getNumFrames() != frames || in->getChannelCount() != channels) {
+            logger_base.error("FSEQ self test: the file saved with %d thread(s) could not be opened.", threads);
+            ok = false;
+            continue;
+        }
+        std::vector<std::pair<uint32_t, uint32_t>> ranges = { { 0, channels } };
+        in->prepareRead(ranges);
+        std::vector<uint8_t> frame(channels);
+        for (uint32_t f = 0; f < frames; f++) {
+            if (!in->readFrame(f, frame.data(), channels) || memcmp(frame.data(), data[f].data(), channels) != 0) {
+                logger_base.error("FSEQ self test: frame %u of the file saved with %d thread(s) does not match what was written.", f, threads);
+                ok = false;
+                break;
+            }
+        }
+    }
+    wxRemoveFile(fn.GetFullPath());
+
+    logger_base.info("FSEQ self test %s.", ok ? "passed" : "FAILED");
+    return ok;
+}
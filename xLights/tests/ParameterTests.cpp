@@ -0,0 +1,261 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "SelfTests.h"
+#include "../effects/RenderableEffect.h"
+#include "../effects/BarsEffect.h"
+#include "../effects/ButterflyEffect.h"
+#include "../RenderBuffer.h"
+#include "../UtilClasses.h"
+#include "../UtilFunctions.h"
+#include "../ValueCurve.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <log4cpp/Category.hh>
+
+// the parameter lookups effects use are protected
+struct ParameterTests : public RenderableEffect
+{
+    using RenderableEffect::GetValueCurveDouble;
+    using RenderableEffect::GetValueCurveInt;
+};
+
+static const std::string EMPTY_STRING("");
+
+// The lookups as they were before parameters were compiled ... every call finds the settings and parses the curve
+static double ReferenceValueCurveDouble(const std::string& name, double def, SettingsMap& settings, float offset, double min, double max, long startMS, long endMS, int divisor)
+{
+    const std::string& vc = settings.Get("VALUECURVE_" + name, EMPTY_STRING);
+    if (vc != EMPTY_STRING) {
+        ValueCurve valc(vc);
+        if (valc.IsActive()) {
+            valc.SetLimits(min, max);
+            valc.SetDivisor(divisor);
+            return valc.GetOutputValueAtDivided(offset, startMS, endMS);
+        }
+    }
+    const std::string sn = "SLIDER_" + name;
+    const std::string tn = "TEXTCTRL_" + name;
+    if (settings.Contains(sn)) return settings.GetDouble(sn, def);
+    if (settings.Contains(tn)) return settings.GetDouble(tn, def);
+    return def;
+}
+
+static int ReferenceValueCurveInt(const std::string& name, int def, SettingsMap& settings, float offset, int min, int max, long startMS, long endMS, int divisor)
+{
+    const std::string vn = "VALUECURVE_" + name;
+    if (settings.Contains(vn)) {
+        ValueCurve valc;
+        valc.SetDivisor(divisor);
+        valc.SetLimits(min, max);
+        valc.Deserialise(settings.Get(vn, EMPTY_STRING));
+        if (valc.IsActive()) {
+            return valc.GetOutputValueAt(offset, startMS, endMS);
+        }
+    }
+    const std::string sn = "SLIDER_" + name;
+    const std::string tn = "TEXTCTRL_" + name;
+    if (settings.Contains(sn)) return settings.GetInt(sn, def);
+    if (settings.Contains(tn)) return settings.GetInt(tn, def);
+    return def;
+}
+
+// Renders an effect whose value curves change every frame with its parameters kept and with them compiled again
+// every frame, as they were parsed every frame before, checks both give the same pixels and logs the time per frame
+static bool TimeEffectRender(RenderableEffect& effect, SettingsMap& settings)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    const int frames = 1000;
+
+    RenderBuffer buffer(nullptr);
+    buffer.InitBuffer(50, 150, 50, 150, "None");
+    buffer.SetEffectDuration(0, frames * buffer.frameTimeInMs);
+    xlColorVector colors = { xlRED, xlGREEN, xlBLUE, xlWHITE };
+    xlColorCurveVector cc(colors.size());
+    buffer.SetPalette(colors, cc);
+
+    std::vector<xlColorVector> rendered[2];
+    long long us[2] = { 0, 0 };
+    for (int pass = 0; pass < 2; pass++) {
+        settings.GetParameterBlock().reset();
+        buffer.needToInit = true;
+        for (int f = 0; f < frames; f++) {
+            if (pass == 1) {
+                settings.GetParameterBlock().reset();
+            }
+            buffer.curPeriod = f;
+            buffer.Clear();
+            auto start = std::chrono::steady_clock::now();
+            effect.Render(nullptr, settings, buffer);
+            us[pass] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            rendered[pass].push_back(buffer.pixels);
+        }
+    }
+
+    bool ok = true;
+    for (int f = 0; f < frames; f++) {
+        if (memcmp(rendered[0][f].data(), rendered[1][f].data(), rendered[0][f].size() * sizeof(xlColor)) != 0) {
+            logger_base.error("Parameter self test: %s frame %d differs when its parameters are kept.", (const char*)effect.Name().c_str(), f);
+            ok = false;
+            break;
+        }
+    }
+    logger_base.info("Render benchmark: %s 150x50 parameters kept %.1fus, compiled every frame %.1fus per frame.",
+        (const char*)effect.Name().c_str(), (double)us[0] / frames, (double)us[1] / frames);
+    return ok;
+}
+
+static std::string ActiveCurve(const std::string& name, float min, float max, const std::string& type, float p1, float p2, float divisor = 1.0)
+{
+    ValueCurve vc("ID_VALUECURVE_" + name, min, max, type, p1, p2, 0, 0, false, divisor);
+    vc.SetActive(true);
+    return vc.Serialise();
+}
+
+// checks compiled value curve parameters against parsing the settings every frame and logs how long both take
+bool ParameterSelfTest()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    // a typical effect ... a few curves, sliders and text values among other settings
+    SettingsMap settings;
+    const char* curves[] = { "Ramp", "Sine", "Saw Tooth", "Parabolic Up" };
+    for (int i = 0; i < 4; i++) {
+        ValueCurve vc("ID_VALUECURVE_Test_Curve" + std::to_string(i), 0, 100, curves[i], 10, 90, 5, 50);
+        vc.SetActive(true);
+        settings["VALUECURVE_Test_Curve" + std::to_string(i)] = vc.Serialise();
+        settings["SLIDER_Test_Curve" + std::to_string(i)] = "25";
+    }
+    for (int i = 0; i < 4; i++) {
+        settings["SLIDER_Test_Slider" + std::to_string(i)] = std::to_string(i * 7);
+        settings["TEXTCTRL_Test_Text" + std::to_string(i)] = std::to_string(i * 3) + ".5";
+        settings["CHOICE_Test_Choice" + std::to_string(i)] = "Normal";
+        settings["CHECKBOX_Test_Check" + std::to_string(i)] = "1";
+    }
+    std::vector<std::string> names;
+    for (int i = 0; i < 4; i++) {
+        names.push_back("Test_Curve" + std::to_string(i));
+        names.push_back("Test_Slider" + std::to_string(i));
+        names.push_back("Test_Text" + std::to_string(i));
+    }
+    names.push_back("Test_Missing");
+
+    const int frames = 2000;
+    bool ok = true;
+    for (int f = 0; f < frames && ok; f++) {
+        float offset = (float)f / frames;
+        for (const auto& n : names) {
+            int i1 = ParameterTests::GetValueCurveInt(n, -1, settings, offset, 0, 100, 0, 50000);
+            int i2 = ReferenceValueCurveInt(n, -1, settings, offset, 0, 100, 0, 50000);
+            double d1 = ParameterTests::GetValueCurveDouble(n, -1, settings, offset, 0, 100, 0, 50000, 10);
+            double d2 = ReferenceValueCurveDouble(n, -1, settings, offset, 0, 100, 0, 50000, 10);
+            if (i1 != i2 || d1 != d2) {
+                logger_base.error("Parameter self test: %s at %f gave %d/%f but should be %d/%f.", (const char*)n.c_str(), offset, i1, d1, i2, d2);
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    // names passed as literals are found by address rather than by name
+    for (int f = 0; f < frames && ok; f += 7) {
+        float offset = (float)f / frames;
+        int i1 = ParameterTests::GetValueCurveInt("Test_Curve2", -1, settings, offset, 0, 100, 0, 50000);
+        double d1 = ParameterTests::GetValueCurveDouble("Test_Text1", -1, settings, offset, 0, 100, 0, 50000, 10);
+        int i2 = ReferenceValueCurveInt("Test_Curve2", -1, settings, offset, 0, 100, 0, 50000);
+        double d2 = ReferenceValueCurveDouble("Test_Text1", -1, settings, offset, 0, 100, 0, 50000, 10);
+        if (i1 != i2 || d1 != d2) {
+            logger_base.error("Parameter self test: literal lookups at %f gave %d/%f but should be %d/%f.", offset, i1, d1, i2, d2);
+            ok = false;
+        }
+    }
+
+    // a value rewritten with the same length must be seen
+    settings["SLIDER_Test_Slider1"] = "8";
+    if (ParameterTests::GetValueCurveInt("Test_Slider1", -1, settings, 0, 0, 100, 0, 50000) != 8) {
+        logger_base.error("Parameter self test: a changed slider value was not picked up.");
+        ok = false;
+    }
+    settings["SLIDER_Test_Slider1"] = "7";
+
+    // as must an erased value and settings that are parsed again
+    settings.erase("SLIDER_Test_Slider2");
+    if (ParameterTests::GetValueCurveInt("Test_Slider2", -1, settings, 0, 0, 100, 0, 50000) != -1) {
+        logger_base.error("Parameter self test: an erased slider value was still used.");
+        ok = false;
+    }
+    settings["SLIDER_Test_Slider2"] = "14";
+    std::string saved = settings.AsString();
+    settings.Parse("SLIDER_Test_Slider3=40");
+    if (ParameterTests::GetValueCurveInt("Test_Slider3", -1, settings, 0, 0, 100, 0, 50000) != 40 ||
+        ParameterTests::GetValueCurveInt("Test_Curve0", -1, settings, 0.5, 0, 100, 0, 50000) != -1) {
+        logger_base.error("Parameter self test: parsed settings were not picked up.");
+        ok = false;
+    }
+    settings.Parse(saved);
+
+    // random curves pick new points each time they are parsed so they must not be kept
+    ValueCurve random("ID_VALUECURVE_Test_Random", 0, 100, "Random", 0, 100, 0, 50);
+    random.SetActive(true);
+    settings["VALUECURVE_Test_Random"] = random.Serialise();
+    bool varies = false;
+    int first = ParameterTests::GetValueCurveInt("Test_Random", -1, settings, 0.5, 0, 100, 0, 50000);
+    for (int i = 0; i < 50 && !varies; i++) {
+        varies = ParameterTests::GetValueCurveInt("Test_Random", -1, settings, 0.5, 0, 100, 0, 50000) != first;
+    }
+    if (!varies) {
+        logger_base.error("Parameter self test: a random value curve was not regenerated.");
+        ok = false;
+    }
+    settings.erase("VALUECURVE_Test_Random");
+
+    long long us[2] = { 0, 0 };
+    double sum[2] = { 0, 0 };
+    for (int pass = 0; pass < 2; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            float offset = (float)f / frames;
+            for (const auto& n : names) {
+                sum[pass] += pass == 0 ? ReferenceValueCurveInt(n, -1, settings, offset, 0, 100, 0, 50000) : ParameterTests::GetValueCurveInt(n, -1, settings, offset, 0, 100, 0, 50000);
+            }
+        }
+        us[pass] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    logger_base.info("Parameter benchmark: %d frames of %d parameters parsed every frame %lldus, compiled %lldus (%.0f/%.0f).",
+        frames, (int)names.size(), us[0], us[1], sum[0], sum[1]);
+
+    // the lookups as effects make them, a few curves read every frame among the rest of the render
+    SettingsMap bars;
+    bars["VALUECURVE_Bars_BarCount"] = ActiveCurve("Bars_BarCount", BARCOUNT_MIN, BARCOUNT_MAX, "Ramp", 1, 5);
+    bars["VALUECURVE_Bars_Cycles"] = ActiveCurve("Bars_Cycles", BARCYCLES_MIN, BARCYCLES_MAX, "Sine", 10, 50, 10);
+    bars["VALUECURVE_Bars_Center"] = ActiveCurve("Bars_Center", BARCENTER_MIN, BARCENTER_MAX, "Saw Tooth", -50, 50);
+    bars["CHOICE_Bars_Direction"] = "expand";
+    bars["CHECKBOX_Bars_Gradient"] = "1";
+    bars["CHECKBOX_Bars_Highlight"] = "1";
+    BarsEffect barsEffect(0);
+    ok = TimeEffectRender(barsEffect, bars) && ok;
+
+    SettingsMap butterfly;
+    butterfly["VALUECURVE_Butterfly_Chunks"] = ActiveCurve("Butterfly_Chunks", BUTTERFLY_CHUNKS_MIN, BUTTERFLY_CHUNKS_MAX, "Ramp", 1, 10);
+    butterfly["VALUECURVE_Butterfly_Speed"] = ActiveCurve("Butterfly_Speed", BUTTERFLY_SPEED_MIN, BUTTERFLY_SPEED_MAX, "Parabolic Up", 5, 60);
+    butterfly["SLIDER_Butterfly_Skip"] = "2";
+    butterfly["SLIDER_Butterfly_Style"] = "1";
+    butterfly["CHOICE_Butterfly_Colors"] = "Rainbow";
+    butterfly["CHOICE_Butterfly_Direction"] = "Normal";
+    ButterflyEffect butterflyEffect(1);
+    ok = TimeEffectRender(butterflyEffect, butterfly) && ok;
+
+    logger_base.info("Parameter self test %s.", ok ? "passed" : "FAILED");
+    return ok;
+}
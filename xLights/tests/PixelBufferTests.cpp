@@ -0,0 +1,367 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "SelfTests.h"
+#include "../PixelBuffer.h"
+#include "../CPUFeatures.h"
+#include "../Parallel.h"
+#include "../models/Node.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <typeinfo>
+#include <vector>
+
+#include <log4cpp/Category.hh>
+
+// random colours with plenty of black, transparent and opaque ones so every branch of the mixes is hit
+static void FillMixTestData(std::mt19937 &rng, std::vector<xlColor> &data)
+{
+    for (auto &c : data) {
+        int kind = rng() % 4;
+        if (kind == 0) {
+            c.Set(0, 0, 0, rng() % 2 == 0 ? 255 : (uint8_t)rng());
+        } else {
+            c.Set((uint8_t)rng(), (uint8_t)rng(), (uint8_t)rng(), kind == 1 ? 255 : (kind == 2 ? 0 : (uint8_t)rng()));
+        }
+    }
+}
+
+// Drives the layer mixing and blur of a one layer PixelBufferClass
+struct PixelBufferTests
+{
+    PixelBufferClass pb;
+    PixelBufferClass::LayerInfo *layer;
+
+    PixelBufferTests() : pb(nullptr) {
+        pb.layers.push_back(new PixelBufferClass::LayerInfo(nullptr));
+        pb.numLayers = 1;
+        layer = pb.layers[0];
+        layer->BufferWi = 20;
+        layer->BufferHt = 20;
+    }
+
+    // the span mixes against mixColors one node at a time
+    bool CheckMixes(const char *path) {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        static const float thresholds[] = { 0.0f, 0.1f, 0.5f, 0.75f, 1.0f };
+        static const double fades[] = { 1.0, 0.6 };
+        static const int counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 255, 256 };
+
+        layer->BufferWi = 20;
+        layer->BufferHt = 20;
+        std::mt19937 rng(0x5eed);
+        bool ok = true;
+        for (int mt = Mix_Normal; mt <= Mix_Min; ++mt) {
+            // only the first mismatch for each mix type is reported
+            bool mixOk = true;
+            for (float threshold : thresholds) {
+                for (double fade : fades) {
+                    for (int alpha = 0; alpha < 2 && mixOk; ++alpha) {
+                        for (int count : counts) {
+                            layer->mixType = (MixTypes)mt;
+                            layer->outputEffectMixThreshold = threshold;
+                            layer->fadeFactor = fade;
+                            layer->buffer.allowAlpha = alpha != 0;
+                            layer->effectMixVaries = rng() % 2 == 0;
+
+                            std::vector<xlColor> fg(count), bg(count);
+                            std::vector<int> nodeX(count), nodeY(count);
+                            FillMixTestData(rng, fg);
+                            FillMixTestData(rng, bg);
+                            for (int i = 0; i < count; ++i) {
+                                nodeX[i] = rng() % 20;
+                                nodeY[i] = rng() % 20;
+                            }
+                            std::vector<xlColor> expectedFg = fg, expected = bg;
+                            for (int i = 0; i < count; ++i) {
+                                pb.mixColors(nodeX[i], nodeY[i], expectedFg[i], expected[i], 0);
+                            }
+                            pb.MixLayerSpan(0, nodeX.data(), nodeY.data(), fg.data(), bg.data(), count);
+                            if (count > 0 && memcmp(bg.data(), expected.data(), count * sizeof(xlColor)) != 0) {
+                                logger_base.error("Mix self test: mix type %d (%s) does not match mixColors for %d nodes, threshold %f, fade %f, alpha %d.",
+                                    mt, path, count, threshold, fade, alpha);
+                                mixOk = false;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            ok = ok && mixOk;
+        }
+        return ok;
+    }
+
+    // blurs random buffers of awkward sizes with the scalar code and at the current level and compares them
+    bool CheckBlur(const char *path) {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        static const int sizes[] = { 7, 8, 31, 64, 65, 130 };
+        static const int blurs[] = { 3, 4, 5, 8, 15, 31 };
+
+        SIMDLEVEL simd = CPUFeatures::GetSIMD();
+        std::mt19937 rng(0x5eed);
+        for (int w : sizes) {
+            for (int h : sizes) {
+                for (int b : blurs) {
+                    std::vector<xlColor> in(w * h);
+                    FillMixTestData(rng, in);
+                    layer->BufferWi = w;
+                    layer->BufferHt = h;
+                    layer->blur = b;
+
+                    CPUFeatures::SetSIMD(SIMDLEVEL::SCALAR);
+                    layer->buffer.pixels = in;
+                    pb.Blur(layer, 0);
+                    xlColorVector expected = layer->buffer.pixels;
+
+                    CPUFeatures::SetSIMD(simd);
+                    layer->buffer.pixels = in;
+                    pb.Blur(layer, 0);
+                    if (memcmp(layer->buffer.pixels.data(), expected.data(), w * h * sizeof(xlColor)) != 0) {
+                        logger_base.error("Blur self test: %s does not match the scalar code for %dx%d blur %d.", path, w, h, b);
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // a model of every node type GetColors packs itself and one that still goes through the node object,
+    // one buffer coordinate per node and the channels laid out one node after another
+    void MakeNodes(int count) {
+        static const char *orders[] = { "RGB", "GRB", "BGR", "BRG" };
+        std::vector<NodeBaseClassPtr> &nodes = layer->buffer.Nodes;
+        nodes.clear();
+        uint32_t chan = 0;
+        for (int i = 0; i < count; ++i) {
+            NodeBaseClass *node;
+            int kind = i % 16;
+            if (kind < 7) {
+                node = new NodeBaseClass(0, 1, orders[kind % 4]);
+            } else if (kind < 12) {
+                node = new NodeClassRGBW(0, 1, orders[kind % 4], kind % 2 == 0, kind - 7);
+            } else if (kind == 12) {
+                node = new NodeClassRed(0, 1);
+            } else if (kind == 13) {
+                node = new NodeClassGreen(0, 1);
+            } else if (kind == 14) {
+                node = new NodeClassCustom(0, 1, xlColor(255, 128, 0));
+            } else {
+                node = new NodeClassRGBW(0, 1, "RGB", true, (i / 16) % 5);
+            }
+            node->ActChan = chan;
+            chan += node->GetChanCount();
+            node->Coords.push_back({ i % 20, (i / 20) % 20, 0, 0.0f, 0.0f, 0.0f });
+            nodes.push_back(NodeBaseClassPtr(node));
+        }
+        pb.UpdateNodeTables(0);
+    }
+
+    // colours with plenty of greys as the RGBW handling treats them differently
+    void FillNodeColors(std::mt19937 &rng) {
+        FillMixTestData(rng, pb.nodeOutput.colors);
+        for (size_t i = 0; i < pb.nodeOutput.colors.size(); i += 3) {
+            xlColor &c = pb.nodeOutput.colors[i];
+            c.green = c.blue = c.red;
+        }
+    }
+
+    size_t ChannelCount() const {
+        const auto &nodes = layer->buffer.Nodes;
+        return nodes.empty() ? 0 : nodes.back()->ActChan + nodes.back()->GetChanCount();
+    }
+
+    // what the node objects write for the colours in the output table
+    void GetColorsFromNodes(unsigned char *fdata) {
+        const auto &nodes = layer->buffer.Nodes;
+        parallel_for_range(0, (int)nodes.size(), [this, &nodes, fdata](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                nodes[i]->SetColor(pb.nodeOutput.colors[i]);
+                nodes[i]->GetForChannels(&fdata[nodes[i]->ActChan]);
+            }
+        }, 1000);
+    }
+
+    // GetColors packs every node type the same as the node objects
+    bool CheckNodeOutput() {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        static const int counts[] = { 1, 16, 17, 999, 1000, 5003 };
+
+        std::mt19937 rng(0x5eed);
+        for (int count : counts) {
+            MakeNodes(count);
+            for (int pass = 0; pass < 4; ++pass) {
+                FillNodeColors(rng);
+                size_t channels = ChannelCount();
+                std::vector<unsigned char> expected(channels), packed(channels);
+                GetColorsFromNodes(expected.data());
+                pb.GetColors(packed.data(), std::vector<bool>());
+                if (packed != expected) {
+                    size_t c = 0;
+                    while (packed[c] == expected[c]) {
+                        ++c;
+                    }
+                    logger_base.error("Node output self test: %d nodes, channel %d is %d but the node objects give %d.",
+                        count, (int)c, (int)packed[c], (int)expected[c]);
+                    layer->buffer.Nodes.clear();
+                    pb.UpdateNodeTables(0);
+                    return false;
+                }
+            }
+        }
+        layer->buffer.Nodes.clear();
+        pb.UpdateNodeTables(0);
+        return true;
+    }
+
+    // what the flat tables cost on top of the node objects and how long a 100k node model takes to pack each way
+    void TimeNodeOutput() {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        const int nodes = 100000;
+        const int frames = 100;
+
+        MakeNodes(nodes);
+        const auto &out = pb.nodeOutput;
+        size_t tableBytes = out.startChannel.capacity() * sizeof(uint32_t) + out.type.capacity() * sizeof(PixelBufferClass::NodeOutputType) +
+            out.offsets.capacity() + out.modelRuns.capacity() * sizeof(out.modelRuns[0]) + out.sparkle.capacity() * sizeof(uint16_t) +
+            out.colors.capacity() * sizeof(xlColor) + (layer->buffer.NodeBufX.capacity() + layer->buffer.NodeBufY.capacity()) * sizeof(int);
+        size_t nodeBytes = 0;
+        for (const auto &n : layer->buffer.Nodes) {
+            nodeBytes += sizeof(NodeBaseClassPtr) + (typeid(*n) == typeid(NodeClassRGBW) ? sizeof(NodeClassRGBW) :
+                (typeid(*n) == typeid(NodeClassCustom) ? sizeof(NodeClassCustom) : sizeof(NodeBaseClass))) +
+                n->Coords.capacity() * sizeof(NodeBaseClass::CoordStruct);
+        }
+
+        std::mt19937 rng(0x5eed);
+        FillNodeColors(rng);
+        std::vector<unsigned char> fdata(ChannelCount());
+        long long us[2] = { 0, 0 };
+        for (int k = 0; k < 2; ++k) {
+            auto start = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; ++f) {
+                if (k == 0) {
+                    GetColorsFromNodes(fdata.data());
+                } else {
+                    pb.GetColors(fdata.data(), std::vector<bool>());
+                }
+            }
+            us[k] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+        logger_base.info("Node output benchmark: %d nodes, tables %.1f bytes a node on top of %.1f for the node objects (not counting allocator overhead), node objects %.1fus tables %.1fus per frame.",
+            nodes, (double)tableBytes / nodes, (double)nodeBytes / nodes, (double)us[0] / frames, (double)us[1] / frames);
+        layer->buffer.Nodes.clear();
+        pb.UpdateNodeTables(0);
+    }
+
+    // a 100k node layer mixed a node at a time and a span at a time
+    void TimeMixes() {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        const int nodes = 100000;
+        const int frames = 100;
+        static const MixTypes timed[] = { Mix_Normal, Mix_Effect1, Mix_Average, Mix_Additive, Mix_Max, Mix_Mask1, Mix_Layered };
+
+        std::mt19937 rng(0x5eed);
+        std::vector<xlColor> fg(nodes), bg(nodes), workFg(nodes), workBg(nodes);
+        std::vector<int> nodeX(nodes), nodeY(nodes);
+        FillMixTestData(rng, fg);
+        FillMixTestData(rng, bg);
+        for (int i = 0; i < nodes; ++i) {
+            nodeX[i] = rng() % 20;
+            nodeY[i] = rng() % 20;
+        }
+        layer->BufferWi = 20;
+        layer->BufferHt = 20;
+        layer->outputEffectMixThreshold = 0.25f;
+        layer->fadeFactor = 1.0;
+        layer->buffer.allowAlpha = false;
+        for (MixTypes mt : timed) {
+            layer->mixType = mt;
+            long long us[2] = { 0, 0 };
+            for (int k = 0; k < 2; ++k) {
+                auto start = std::chrono::steady_clock::now();
+                for (int f = 0; f < frames; ++f) {
+                    workFg = fg;
+                    workBg = bg;
+                    if (k == 0) {
+                        for (int i = 0; i < nodes; ++i) {
+                            pb.mixColors(nodeX[i], nodeY[i], workFg[i], workBg[i], 0);
+                        }
+                    } else {
+                        pb.MixLayerSpan(0, nodeX.data(), nodeY.data(), workFg.data(), workBg.data(), nodes);
+                    }
+                }
+                us[k] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+            logger_base.info("Mix benchmark: mix type %d %d nodes per node %.1fus span %.1fus per frame.",
+                (int)mt, nodes, (double)us[0] / frames, (double)us[1] / frames);
+        }
+    }
+
+    // a blur of 8 over a 1000x500 layer at each level
+    void TimeBlur() {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        const int w = 1000;
+        const int h = 500;
+        const int passes = 20;
+
+        std::mt19937 rng(0x5eed);
+        std::vector<xlColor> in(w * h);
+        FillMixTestData(rng, in);
+        layer->BufferWi = w;
+        layer->BufferHt = h;
+        layer->blur = 8;
+
+        SIMDLEVEL simd = CPUFeatures::GetSIMD();
+        for (int level = (int)CPUFeatures::GetSupportedSIMD(); level >= (int)SIMDLEVEL::SCALAR; --level) {
+            CPUFeatures::SetSIMD((SIMDLEVEL)level);
+            long long us = 0;
+            for (int i = 0; i < passes; ++i) {
+                layer->buffer.pixels = in;
+                auto start = std::chrono::steady_clock::now();
+                pb.Blur(layer, 0);
+                us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+            logger_base.info("Blur benchmark: %dx%d blur %d %s %.1fus per frame.",
+                w, h, layer->blur, CPUFeatures::GetSIMDName((SIMDLEVEL)level), (double)us / passes);
+        }
+        CPUFeatures::SetSIMD(simd);
+    }
+};
+
+bool PixelBufferSelfTest()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    PixelBufferTests t;
+
+    // every level this machine supports is checked, the mixes against mixColors and the blur against the scalar code
+    bool ok = true;
+    SIMDLEVEL simd = CPUFeatures::GetSIMD();
+    for (int level = (int)CPUFeatures::GetSupportedSIMD(); level >= (int)SIMDLEVEL::SCALAR; --level) {
+        CPUFeatures::SetSIMD((SIMDLEVEL)level);
+        const char *path = CPUFeatures::GetSIMDName((SIMDLEVEL)level);
+        ok = t.CheckMixes(path) && ok;
+        if (level > (int)SIMDLEVEL::SCALAR) {
+            ok = t.CheckBlur(path) && ok;
+        }
+    }
+    CPUFeatures::SetSIMD(simd);
+    ok = t.CheckNodeOutput() && ok;
+
+    t.TimeMixes();
+    t.TimeBlur();
+    t.TimeNodeOutput();
+
+    logger_base.info("Pixel buffer self test %s.", ok ? "passed" : "FAILED");
+    return ok;
+}
@@ -0,0 +1,250 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "SelfTests.h"
+#include "../RenderCache.h"
+#include "../RenderBuffer.h"
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <log4cpp/Category.hh>
+
+// Writes a cache file through AddFrame the way rendering does and reads it back through GetFrame
+struct RenderCacheTests
+{
+    static const int FRAMES = 100;
+    static const int WIDTH = 30;
+    static const int HEIGHT = 20;
+
+    RenderCache cache;
+    RenderBuffer buffer;
+    std::string filename;
+    std::string model;
+
+    RenderCacheTests() : buffer(nullptr) {
+        wxFileName fn(wxFileName::GetTempDir(), "xLightsRenderCacheSelfTest.cache");
+        filename = fn.GetFullPath().ToStdString();
+        model = "Self Test Model";
+        buffer.InitBuffer(HEIGHT, WIDTH, HEIGHT, WIDTH, "None");
+        buffer.cur_model = model;
+        buffer.curEffStartPer = 0;
+        buffer.curEffEndPer = FRAMES - 1;
+    }
+
+    // mostly the same from one frame to the next so the deltas have something to do, version changes every pixel
+    static void FillFrame(int frame, int version, xlColorVector& pixels) {
+        for (size_t i = 0; i < pixels.size(); i++) {
+            uint8_t moving = i == (size_t)frame % pixels.size() ? 200 : 0;
+            pixels[i].Set((uint8_t)(i * 7 + moving), (uint8_t)(i + frame / 10), (uint8_t)(version * 31), 255);
+        }
+    }
+
+    std::unique_ptr<RenderCacheItem> OpenItem() {
+        wxLogNull logNo; // a missing file is reported by wxFile
+        return std::unique_ptr<RenderCacheItem>(new RenderCacheItem(&cache, filename));
+    }
+
+    const std::vector<RenderCacheItem::CachedFrame>& Frames(RenderCacheItem& item) {
+        return item._frames[model].frames;
+    }
+
+    bool CheckFrame(RenderCacheItem& item, int frame, int version, const char* what) {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        xlColorVector expected(buffer.pixels.size());
+        FillFrame(frame, version, expected);
+        buffer.curPeriod = frame;
+        buffer.Clear();
+        if (!item.GetFrame(&buffer)) {
+            logger_base.error("Render cache self test: %s, frame %d could not be read.", what, frame);
+            return false;
+        }
+        if (memcmp(buffer.pixels.data(), expected.data(), expected.size() * sizeof(xlColor)) != 0) {
+            logger_base.error("Render cache self test: %s, frame %d does not match what was added.", what, frame);
+            return false;
+        }
+        return true;
+    }
+
+    // every frame in order, then backwards so each one decodes from its keyframe, then jumping about
+    bool CheckAllFrames(RenderCacheItem& item, const char* what) {
+        for (int f = 0; f < FRAMES; f++) {
+            if (!CheckFrame(item, f, 0, what)) return false;
+        }
+        for (int f = FRAMES - 1; f >= 0; f--) {
+            if (!CheckFrame(item, f, 0, what)) return false;
+        }
+        for (int f = 0; f < FRAMES; f++) {
+            if (!CheckFrame(item, (f * 37) % FRAMES, 0, what)) return false;
+        }
+        return true;
+    }
+
+    bool ReadFile(std::vector<unsigned char>& data) {
+        wxFile file;
+        if (!file.Open(filename)) return false;
+        data.resize(file.Length());
+        return !data.empty() && file.Read(data.data(), data.size()) == (ssize_t)data.size();
+    }
+
+    void WriteFile(const std::vector<unsigned char>& data, size_t size) {
+        wxFile file;
+        if (file.Create(filename, true)) {
+            file.Write(data.data(), size);
+        }
+    }
+
+    // adding the last frame saves the file
+    bool CheckRoundTrip() {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        wxRemoveFile(filename);
+        auto item = OpenItem();
+        item->_properties["Effect"] = "Self Test";
+        for (int f = 0; f < FRAMES; f++) {
+            buffer.curPeriod = f;
+            FillFrame(f, 0, buffer.pixels);
+            item->AddFrame(&buffer);
+        }
+        if (item->_dirty || !wxFile::Exists(filename)) {
+            logger_base.error("Render cache self test: the cache file was not saved after the last frame.");
+            return false;
+        }
+        if (!CheckAllFrames(*item, "in memory")) return false;
+
+        auto loaded = OpenItem();
+        if (loaded->IsPurged() || loaded->_properties["Effect"] != "Self Test" || Frames(*loaded).size() != FRAMES) {
+            logger_base.error("Render cache self test: the saved cache file could not be loaded.");
+            return false;
+        }
+        if (loaded->_fileData != nullptr) {
+            logger_base.error("Render cache self test: the cache file was read before a frame was asked for.");
+            return false;
+        }
+        return CheckAllFrames(*loaded, "from the file");
+    }
+
+    // frames after a keyframe are stored as deltas and replacing one drops the deltas that were taken from it
+    bool CheckDeltaChain() {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        auto item = OpenItem();
+        const auto& frames = Frames(*item);
+        int keyframes = 0;
+        for (int f = 0; f < FRAMES; f++) {
+            if (!(frames[f].flags & RenderCacheItem::FRAME_DELTA)) {
+                keyframes++;
+            }
+        }
+        if ((frames[0].flags & RenderCacheItem::FRAME_DELTA) || !(frames[1].flags & RenderCacheItem::FRAME_DELTA) || keyframes < 2 || keyframes > FRAMES / 2) {
+            logger_base.error("Render cache self test: %d of %d frames were stored whole.", keyframes, FRAMES);
+            return false;
+        }
+
+        int replaced = 1;
+        while (replaced < FRAMES - 1 && !(frames[replaced + 1].flags & RenderCacheItem::FRAME_DELTA)) {
+            replaced++;
+        }
+        int nextKeyframe = replaced + 1;
+        while (nextKeyframe < FRAMES && (frames[nextKeyframe].flags & RenderCacheItem::FRAME_DELTA)) {
+            nextKeyframe++;
+        }
+
+        buffer.curPeriod = replaced;
+        FillFrame(replaced, 1, buffer.pixels);
+        item->AddFrame(&buffer);
+        for (int f = replaced + 1; f < nextKeyframe; f++) {
+            buffer.curPeriod = f;
+            if (item->IsDone(&buffer)) {
+                logger_base.error("Render cache self test: frame %d was kept after the frame it was a delta of was replaced.", f);
+                return false;
+            }
+        }
+        if (!CheckFrame(*item, replaced, 1, "replaced")) return false;
+        if (!CheckFrame(*item, replaced - 1, 0, "before the replaced frame")) return false;
+        if (nextKeyframe < FRAMES && !CheckFrame(*item, nextKeyframe, 0, "after the replaced frame")) return false;
+        return true;
+    }
+
+    // a damaged file must be dropped or fail to give the frame, not crash or give the wrong pixels
+    bool CheckDamagedFiles() {
+        static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        std::vector<unsigned char> data;
+        if (!ReadFile(data)) {
+            logger_base.error("Render cache self test: the cache file could not be read back.");
+            return false;
+        }
+
+        static const double cuts[] = { 0.25, 0.5, 0.9, 0.999 };
+        for (double cut : cuts) {
+            WriteFile(data, (size_t)(data.size() * cut));
+            auto item = OpenItem();
+            if (!item->IsPurged()) {
+                logger_base.error("Render cache self test: a cache file cut to %d of %d bytes was loaded.", (int)(data.size() * cut), (int)data.size());
+                return false;
+            }
+        }
+
+        std::vector<unsigned char> damaged(data);
+        memset(damaged.data(), 0, 16);
+        WriteFile(damaged, damaged.size());
+        if (!OpenItem()->IsPurged()) {
+            logger_base.error("Render cache self test: a cache file with a damaged header was loaded.");
+            return false;
+        }
+
+        // without zstd nothing in a frame says it is damaged so only compressed frames can be checked
+        WriteFile(data, data.size());
+        auto item = OpenItem();
+        const auto& first = Frames(*item)[0];
+        if (first.flags & RenderCacheItem::FRAME_ZSTD) {
+            damaged = data;
+            memset(&damaged[first.offset], 0xFF, std::min<size_t>(first.size, 8));
+            item.reset();
+            WriteFile(damaged, damaged.size());
+            item = OpenItem();
+            buffer.curPeriod = 0;
+            if (item->IsPurged() || item->GetFrame(&buffer)) {
+                logger_base.error("Render cache self test: a damaged frame was read without an error.");
+                return false;
+            }
+            // the frames from the next keyframe on dont depend on it
+            const auto& frames = Frames(*item);
+            int keyframe = 1;
+            while (keyframe < FRAMES && (frames[keyframe].flags & RenderCacheItem::FRAME_DELTA)) {
+                keyframe++;
+            }
+            if (keyframe < FRAMES && !CheckFrame(*item, keyframe, 0, "after a damaged frame")) return false;
+        }
+        return true;
+    }
+};
+
+// Saves a render cache file with the compressed delta format and checks every frame reads back, that replacing
+// a frame drops the frames stored against it and that truncated or damaged files are rejected
+bool RenderCacheSelfTest()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    bool ok;
+    {
+        RenderCacheTests t;
+        ok = t.CheckRoundTrip() && t.CheckDeltaChain() && t.CheckDamagedFiles();
+    }
+    wxFileName fn(wxFileName::GetTempDir(), "xLightsRenderCacheSelfTest.cache");
+    wxRemoveFile(fn.GetFullPath());
+
+    logger_base.info("Render cache self test %s.", ok ? "passed" : "FAILED");
+    return ok;
+}
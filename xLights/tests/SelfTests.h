@@ -0,0 +1,21 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+// The xLights self tests. Each checks optimised code against a simpler version of it, logs how long
+// both take and returns false if they differ. They are only built into the Linux_Test target which
+// runs them all and exits non zero if any fail.
+
+bool FSEQFileSelfTest();
+bool ParameterSelfTest();
+bool PixelBufferSelfTest();
+bool RenderCacheSelfTest();
+bool SequenceLoadSelfTest();
@@ -0,0 +1,377 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "SelfTests.h"
+#include "../xLightsXmlFile.h"
+
+#include <wx/file.h>
+#include <wx/textfile.h>
+#include <wx/stopwatch.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <log4cpp/Category.hh>
+
+// writes a sequence with the sections and layer types the loader handles, a few entities and non ascii
+// text, count models of layers x effects effects each
+static void WriteLoadTestSequence(const wxString& filename, int models, int layers, int effects)
+{
+    std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<xsequence BaseChannel=\"0\" ChanCtrlBasic=\"0\" ChanCtrlColor=\"0\" FixedPointTiming=\"1\" ModelBlending=\"true\">\n"
+        "  <head>\n    <version>2020.1</version>\n    <author>Load &amp; Test</author>\n    <song>Sch\xc3\xb6n</song>\n"
+        "    <sequenceTiming>25 ms</sequenceTiming>\n    <sequenceType>Animation</sequenceType>\n    <sequenceDuration>600.000</sequenceDuration>\n  </head>\n"
+        "  <nextid>1</nextid>\n";
+    const int palettes = 50;
+    const int settings = 20000;
+    xml += "  <ColorPalettes>\n";
+    for (int i = 0; i < palettes; i++) {
+        xml += wxString::Format("    <ColorPalette>C_BUTTON_Palette1=#%06X,C_BUTTON_Palette2=#00FF00,C_CHECKBOX_Palette1=1</ColorPalette>\n", i * 4099).ToStdString();
+    }
+    xml += "  </ColorPalettes>\n  <EffectDB>\n";
+    for (int i = 0; i < settings; i++) {
+        xml += wxString::Format("    <Effect>B_CHOICE_BufferStyle=Default,E_SLIDER_Speed=%d,E_TEXTCTRL_Text=a &lt;%d&gt; &amp; b,T_CHOICE_LayerMethod=Normal,T_SLIDER_EffectLayerMix=%d</Effect>\n", i, i, i % 100).ToStdString();
+    }
+    xml += "  </EffectDB>\n  <DataLayers/>\n  <DisplayElements>\n"
+        "    <Element collapsed=\"0\" type=\"timing\" name=\"Beats\" visible=\"1\" active=\"1\"/>\n"
+        "    <Element collapsed=\"0\" type=\"timing\" name=\"Fixed\" visible=\"1\" active=\"0\"/>\n";
+    for (int m = 0; m < models; m++) {
+        xml += wxString::Format("    <Element collapsed=\"0\" type=\"model\" name=\"Model %d\" visible=\"1\"/>\n", m).ToStdString();
+    }
+    xml += "  </DisplayElements>\n  <ElementEffects>\n"
+        "    <Element type=\"timing\" name=\"Beats\">\n      <EffectLayer>\n";
+    for (int i = 0; i < effects; i++) {
+        xml += wxString::Format("        <Effect label=\"beat %d &amp; \xc3\xbc\" startTime=\"%d\" endTime=\"%d\"/>\n", i, i * 500, i * 500 + 500).ToStdString();
+    }
+    xml += "      </EffectLayer>\n    </Element>\n    <Element type=\"timing\" name=\"Fixed\" fixed=\"50\"/>\n";
+    int id = 1;
+    auto addEffects = [&xml, &id, effects](int step, bool inlineSettings) {
+        for (int i = 0; i < effects; i += step) {
+            if (inlineSettings && i % 3 == 0) {
+                xml += wxString::Format("        <Effect name=\"Off\" id=\"%d\" startTime=\"%d\" endTime=\"%d\">E_TEXTCTRL_Text=\xc3\xa9 &amp; %d</Effect>\n", id, i * 100, i * 100 + 100, i).ToStdString();
+            }
+            else {
+                xml += wxString::Format("        <Effect ref=\"%d\" name=\"On\" id=\"%d\" startTime=\"%d\" endTime=\"%d\" palette=\"%d\" protected=\"%d\"/>\n",
+                    (id * 7919) % settings, id, i * 100, i * 100 + 100, id % palettes, i % 5 == 0 ? 1 : 0).ToStdString();
+            }
+            id++;
+        }
+    };
+    for (int m = 0; m < models; m++) {
+        xml += wxString::Format("    <Element type=\"model\" name=\"Model %d\">\n", m).ToStdString();
+        for (int l = 0; l < layers; l++) {
+            xml += "      <EffectLayer>\n";
+            addEffects(1, l == layers - 1);
+            xml += "      </EffectLayer>\n";
+        }
+        if (m % 10 == 0) {
+            xml += "      <SubModelEffectLayer name=\" Arm \" layer=\"1\">\n";
+            addEffects(10, false);
+            xml += "      </SubModelEffectLayer>\n      <Strand index=\"2\" name=\" Strand 2 \" layer=\"0\">\n";
+            addEffects(10, false);
+            xml += "        <Node index=\"3\" name=\" Node 3\">\n";
+            addEffects(20, true);
+            xml += "        </Node>\n      </Strand>\n";
+        }
+        xml += "    </Element>\n";
+    }
+    xml += "  </ElementEffects>\n  <lastView>0</lastView>\n  <TimingTags>\n    <Tag number=\"1\" position=\"100\"/>\n  </TimingTags>\n</xsequence>\n";
+
+    wxFile file(filename, wxFile::write);
+    file.Write(xml.c_str(), xml.size());
+}
+
+// compares two documents, except for the EffectDB entries and the layers of the ElementEffects Elements.
+// Where they differ is left in path.
+static bool SameLoadedNodes(wxXmlNode* a, wxXmlNode* b, int depth, bool effects, wxString& path)
+{
+    for (; a != nullptr && b != nullptr; a = a->GetNext(), b = b->GetNext()) {
+        if (a->GetType() != b->GetType() || a->GetContent() != b->GetContent() ||
+            (a->GetType() == wxXML_ELEMENT_NODE && a->GetName() != b->GetName())) {
+            path = "/" + a->GetName() + " (document has " + b->GetName() + " '" + b->GetContent() + "', streamed '" + a->GetContent() + "')";
+            return false;
+        }
+        wxXmlAttribute* aa = a->GetAttributes();
+        wxXmlAttribute* ba = b->GetAttributes();
+        for (; aa != nullptr && ba != nullptr; aa = aa->GetNext(), ba = ba->GetNext()) {
+            if (aa->GetName() != ba->GetName() || aa->GetValue() != ba->GetValue()) {
+                path = "/" + a->GetName() + " (document has " + ba->GetName() + "=\"" + ba->GetValue() + "\", streamed " + aa->GetName() + "=\"" + aa->GetValue() + "\")";
+                return false;
+            }
+        }
+        if (aa != nullptr || ba != nullptr) {
+            path = "/" + a->GetName() + " (different number of attributes)";
+            return false;
+        }
+        bool section = depth == 1 && (a->GetName() == "EffectDB" || a->GetName() == "ElementEffects");
+        wxString child;
+        if (!(effects && depth == 2) && !(section && a->GetName() == "EffectDB") &&
+            !SameLoadedNodes(a->GetChildren(), b->GetChildren(), depth + 1, effects || section, child)) {
+            path = "/" + a->GetName() + child;
+            return false;
+        }
+    }
+    if (a != nullptr || b != nullptr) {
+        path = "/" + (a != nullptr ? a : b)->GetName() + (a != nullptr ? " (only streamed)" : " (only in the document)");
+        return false;
+    }
+    return true;
+}
+
+// at most this many differences are logged for each kind of record, the rest are only counted
+static const int MAX_REPORTED_DIFFERENCES = 10;
+
+static void ReportDifference(int& reported, const wxString& message)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    if (reported++ < MAX_REPORTED_DIFFERENCES) {
+        logger_base.error("Load self test: %s", (const char*)message.c_str());
+    }
+}
+
+// compares the streamed strings one by one and logs the ones that differ, returns how many did
+static int CompareLoadedStrings(const wxArrayString& s, const wxArrayString& d, const char* what)
+{
+    int reported = 0;
+    int differences = 0;
+    if (s.size() != d.size()) {
+        ReportDifference(reported, wxString::Format("streamed %s has %d entries, the document load %d.", what, (int)s.size(), (int)d.size()));
+        differences++;
+    }
+    for (size_t i = 0; i < std::min(s.size(), d.size()); i++) {
+        if (s[i] != d[i]) {
+            ReportDifference(reported, wxString::Format("streamed %s %d is '%s', the document load '%s'.", what, (int)i, s[i], d[i]));
+            differences++;
+        }
+    }
+    return differences;
+}
+
+static wxString DescribeLoadedEffect(const SequenceFileEffect& e)
+{
+    return wxString::Format("'%s' id %d ref %d palette %ld %.3f-%.3f%s settings '%s'", e.name, e.id, e.ref, e.palette,
+        e.startTime, e.endTime, e.isProtected ? " protected" : "", e.settings);
+}
+
+static wxString DescribeLoadedLayer(const SequenceFileLayer& l, size_t i)
+{
+    return wxString::Format("%s %d '%s' index %d layer %d", l.type, (int)i, l.name, l.index, l.layer);
+}
+
+// compares the streamed layers and their effects one by one against the document load, logs the ones that
+// differ and returns how many did
+static int CompareLoadedLayers(const std::vector<SequenceFileLayer>& s, const std::vector<SequenceFileLayer>& d, const wxString& where, int& reported)
+{
+    int differences = 0;
+    if (s.size() != d.size()) {
+        ReportDifference(reported, wxString::Format("%s has %d layers streamed, %d from the document.", where, (int)s.size(), (int)d.size()));
+        differences++;
+    }
+    for (size_t l = 0; l < std::min(s.size(), d.size()); l++) {
+        const SequenceFileLayer& sl = s[l];
+        const SequenceFileLayer& dl = d[l];
+        wxString at = where + " " + DescribeLoadedLayer(dl, l);
+        if (sl.type != dl.type || sl.name != dl.name || sl.index != dl.index || sl.layer != dl.layer) {
+            ReportDifference(reported, at + " was streamed as " + DescribeLoadedLayer(sl, l) + ".");
+            differences++;
+        }
+        if (sl.effects.size() != dl.effects.size()) {
+            ReportDifference(reported, wxString::Format("%s has %d effects streamed, %d from the document.", at, (int)sl.effects.size(), (int)dl.effects.size()));
+            differences++;
+        }
+        for (size_t e = 0; e < std::min(sl.effects.size(), dl.effects.size()); e++) {
+            if (!(sl.effects[e] == dl.effects[e])) {
+                ReportDifference(reported, wxString::Format("%s effect %d streamed %s, document %s.", at, (int)e,
+                    DescribeLoadedEffect(sl.effects[e]), DescribeLoadedEffect(dl.effects[e])));
+                differences++;
+            }
+        }
+        differences += CompareLoadedLayers(sl.nodes, dl.nodes, at, reported);
+    }
+    return differences;
+}
+
+// resident and peak resident memory in KB, -1 where the platform cant say. On linux the peak is reset
+// first so each load is measured on its own.
+static void ResetPeakMemory()
+{
+#ifdef __LINUX__
+    wxFile f("/proc/self/clear_refs", wxFile::write);
+    if (f.IsOpened()) {
+        f.Write("5", 1);
+    }
+#endif
+}
+
+static void GetMemoryUsage(long& residentKB, long& peakKB)
+{
+    residentKB = -1;
+    peakKB = -1;
+#ifdef __LINUX__
+    wxTextFile status("/proc/self/status");
+    if (status.Open()) {
+        for (wxString line = status.GetFirstLine(); !status.Eof(); line = status.GetNextLine()) {
+            if (line.StartsWith("VmRSS:")) {
+                residentKB = wxAtol(line.Mid(6).Trim(false));
+            }
+            else if (line.StartsWith("VmHWM:")) {
+                peakKB = wxAtol(line.Mid(6).Trim(false));
+            }
+        }
+    }
+#endif
+}
+
+// Loads a sequence through the private streaming and document loaders of xLightsXmlFile
+struct SequenceLoadTests
+{
+    // Loads a synthetic sequence with the streaming reader and with the whole xml document, checks both
+    // give the same document and effects and logs the time and memory each takes.
+    static bool Run()
+    {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+        wxFileName fn(wxFileName::GetTempDir(), "xLightsLoadSelfTest.xsq");
+        WriteLoadTestSequence(fn.GetFullPath(), 400, 2, 250);
+        wxULongLong size = fn.GetSize();
+
+        struct LoadResult
+        {
+            std::unique_ptr<xLightsXmlFile> file;
+            std::vector<std::string> effectDB;
+            std::vector<std::vector<SequenceFileLayer>> layers;
+            std::vector<wxString> elements;
+            long ms = 0;
+            long growthKB = -1;
+            long peakKB = -1;
+        };
+        // streams first so any heap it leaves behind can only flatter the whole document load
+        LoadResult results[2];
+        for (int i = 0; i < 2; i++) {
+            LoadResult& r = results[i];
+            bool stream = i == 0;
+            long before = 0;
+            long peak = 0;
+            ResetPeakMemory();
+            GetMemoryUsage(before, peak);
+            wxStopWatch sw;
+
+            r.file = std::make_unique<xLightsXmlFile>(fn);
+            if (!r.file->LoadSequence(fn.GetPath(), true, stream)) {
+                logger_base.error("Load self test: %s load failed.", stream ? "streamed" : "document");
+                wxRemoveFile(fn.GetFullPath());
+                return false;
+            }
+            // what the sequencer load then takes from the file
+            if (r.file->HasStreamedEffectDB()) {
+                r.file->TakeStreamedEffectDB(r.effectDB);
+            }
+            for (wxXmlNode* e = r.file->seqDocument.GetRoot()->GetChildren(); e != nullptr; e = e->GetNext()) {
+                if (e->GetName() == "EffectDB" && !stream) {
+                    for (wxXmlNode* n = e->GetChildren(); n != nullptr; n = n->GetNext()) {
+                        r.effectDB.push_back(n->GetNodeContent().ToStdString());
+                    }
+                }
+                else if (e->GetName() == "ElementEffects") {
+                    for (wxXmlNode* n = e->GetChildren(); n != nullptr; n = n->GetNext()) {
+                        r.elements.push_back(n->GetAttribute("name"));
+                        r.layers.emplace_back();
+                        r.file->TakeElementLayers(n, r.layers.back());
+                    }
+                }
+            }
+
+            r.ms = sw.Time();
+            long after = 0;
+            GetMemoryUsage(after, peak);
+            if (before >= 0 && after >= 0) {
+                r.growthKB = after - before;
+                r.peakKB = peak - before;
+            }
+        }
+        wxRemoveFile(fn.GetFullPath());
+
+        LoadResult& s = results[0];
+        LoadResult& d = results[1];
+        bool ok = true;
+        int differences = CompareLoadedStrings(s.file->timing_list, d.file->timing_list, "timing element") +
+            CompareLoadedStrings(s.file->models, d.file->models, "model element") +
+            CompareLoadedStrings(s.file->header_info, d.file->header_info, "header field");
+        if (s.file->GetSequenceDurationMS() != d.file->GetSequenceDurationMS() || s.file->GetSequenceTiming() != d.file->GetSequenceTiming()) {
+            logger_base.error("Load self test: streamed duration %dms timing %s, the document load %dms timing %s.",
+                s.file->GetSequenceDurationMS(), (const char*)s.file->GetSequenceTiming().c_str(),
+                d.file->GetSequenceDurationMS(), (const char*)d.file->GetSequenceTiming().c_str());
+            differences++;
+        }
+        if (differences != 0) {
+            logger_base.error("Load self test: %d streamed header or element list entries differ from the document load.", differences);
+            ok = false;
+        }
+
+        wxString path;
+        if (!SameLoadedNodes(s.file->seqDocument.GetRoot(), d.file->seqDocument.GetRoot(), 0, false, path)) {
+            logger_base.error("Load self test: streamed xml document differs from the document load at %s.", (const char*)path.c_str());
+            ok = false;
+        }
+
+        int reported = 0;
+        differences = 0;
+        if (s.effectDB.size() != d.effectDB.size() || d.effectDB.size() != 20000) {
+            ReportDifference(reported, wxString::Format("streamed EffectDB has %d entries, the document load %d, the file 20000.",
+                (int)s.effectDB.size(), (int)d.effectDB.size()));
+            differences++;
+        }
+        for (size_t i = 0; i < std::min(s.effectDB.size(), d.effectDB.size()); i++) {
+            if (s.effectDB[i] != d.effectDB[i]) {
+                ReportDifference(reported, wxString::Format("streamed EffectDB entry %d is '%s', the document load '%s'.",
+                    (int)i, s.effectDB[i], d.effectDB[i]));
+                differences++;
+            }
+        }
+        if (differences != 0) {
+            logger_base.error("Load self test: %d streamed EffectDB entries differ from the document load.", differences);
+            ok = false;
+        }
+
+        size_t count = 0;
+        for (const auto& l : d.layers) {
+            for (const auto& layer : l) {
+                count += layer.effects.size();
+                for (const auto& node : layer.nodes) {
+                    count += node.effects.size();
+                }
+            }
+        }
+        reported = 0;
+        differences = 0;
+        if (s.layers.size() != d.layers.size() || count == 0) {
+            ReportDifference(reported, wxString::Format("%d elements with effects streamed, %d from the document with %d effects.",
+                (int)s.layers.size(), (int)d.layers.size(), (int)count));
+            differences++;
+        }
+        for (size_t i = 0; i < std::min(s.layers.size(), d.layers.size()); i++) {
+            differences += CompareLoadedLayers(s.layers[i], d.layers[i], "element '" + d.elements[i] + "'", reported);
+        }
+        if (differences != 0) {
+            logger_base.error("Load self test: %d streamed effect records differ from the document load.", differences);
+            ok = false;
+        }
+
+        logger_base.info("Load benchmark: %.1fMB sequence with %d effects, streamed %ldms resident +%ldKB peak +%ldKB, document %ldms resident +%ldKB peak +%ldKB.",
+            (double)size.ToDouble() / (1024 * 1024), (int)count, s.ms, s.growthKB, s.peakKB, d.ms, d.growthKB, d.peakKB);
+        logger_base.info("Load self test %s.", ok ? "passed" : "FAILED");
+        return ok;
+    }
+};
+
+bool SequenceLoadSelfTest()
+{
+    return SequenceLoadTests::Run();
+}
@@ -305,6 +305,7 @@ void DumpConfig()
     #include <X11/Xlib.h>
 #endif // LINUX
 //IMPLEMENT_APP(xLightsApp)
+#ifndef XL_SELF_TESTS // the self tests provide main
 int main(int argc, char **argv)
 {
     srand(time(nullptr));
@@ -330,6 +331,7 @@ int main(int argc, char **argv)
     logger_base.info("Main: wxWidgets exited with rc=" + wxString::Format("%d", rc));
     return rc;
 }
+#endif
 
 #ifdef _MSC_VER
 IMPLEMENT_APP(xLightsApp);
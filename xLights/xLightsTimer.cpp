@@ -11,12 +11,64 @@
 #include "xLightsTimer.h"
 #include <wx/thread.h>
 #include <log4cpp/Category.hh>
+#include <chrono>
 #include <mutex>
 
 #ifndef __WXOSX__
 #define USE_THREADED_TIMER
 #endif
 
+// when catching up never hand the owner more than this many missed ticks to run at once ... beyond that we skip
+#define MAX_CATCHUP_TICKS 10
+
+#pragma region xLightsTimerStats
+// upper bound of each jitter bucket in microseconds ... the last bucket has no upper bound
+static const long long __jitterBucketLimits[xLightsTimerStats::JITTER_BUCKETS - 1] = { 100, 500, 1000, 2000, 5000, 10000, 20000 };
+
+int xLightsTimerStats::GetJitterBucket(long long lateUS)
+{
+    for (int i = 0; i < JITTER_BUCKETS - 1; i++)
+    {
+        if (lateUS < __jitterBucketLimits[i]) return i;
+    }
+    return JITTER_BUCKETS - 1;
+}
+
+std::string xLightsTimerStats::GetJitterBucketName(int bucket)
+{
+    if (bucket < JITTER_BUCKETS - 1)
+    {
+        return wxString::Format("<%gms", (double)__jitterBucketLimits[bucket] / 1000.0).ToStdString();
+    }
+    return wxString::Format(">=%gms", (double)__jitterBucketLimits[JITTER_BUCKETS - 2] / 1000.0).ToStdString();
+}
+
+std::string xLightsTimerStats::GetJSON() const
+{
+    std::string res = "{\"fired\":\"" + std::to_string(fired) +
+        "\",\"late\":\"" + std::to_string(late) +
+        "\",\"skipped\":\"" + std::to_string(skipped) +
+        "\",\"caughtup\":\"" + std::to_string(caughtUp) +
+        "\",\"maxlateus\":\"" + std::to_string(maxLateUS) +
+        "\",\"jitter\":[";
+    for (int i = 0; i < JITTER_BUCKETS; i++)
+    {
+        if (i != 0) res += ",";
+        res += "{\"bucket\":\"" + GetJitterBucketName(i) + "\",\"count\":\"" + std::to_string(jitter[i]) + "\"}";
+    }
+    res += "],\"delivered\":\"" + std::to_string(delivered) +
+        "\",\"maxdeliveredlateus\":\"" + std::to_string(maxDeliveredLateUS) +
+        "\",\"deliveredjitter\":[";
+    for (int i = 0; i < JITTER_BUCKETS; i++)
+    {
+        if (i != 0) res += ",";
+        res += "{\"bucket\":\"" + GetJitterBucketName(i) + "\",\"count\":\"" + std::to_string(deliveredJitter[i]) + "\"}";
+    }
+    res += "]}";
+    return res;
+}
+#pragma endregion
+
 #ifdef USE_THREADED_TIMER
 
 class xlTimerThread : public wxThread
@@ -33,6 +85,11 @@ public:
     void SetName(const std::string& name) {
         _name = name;
     }
+    xLightsTimerStats GetStats() const;
+    void ResetStats();
+    void RecordDelivered(long long lateUS);
+    void RecordSkipped(long long skipped);
+    void RecordCaughtUp(long long caughtUp);
 private:
     std::atomic<bool> _stop;
     std::atomic<bool> _suspend;
@@ -54,7 +111,11 @@ private:
     // released. Once the timer thread gets it it immediately releases it.
     std::mutex _suspendLock;
 
-    void DoSleep(int millis);
+    mutable std::mutex _statsLock;
+    xLightsTimerStats _stats;
+
+    void DoSleepUntil(std::chrono::steady_clock::time_point deadline);
+    void RecordTick(long long lateUS, int interval);
     virtual ExitCode Entry() override;
 };
 
@@ -66,6 +127,10 @@ xLightsTimer::xLightsTimer()
     _timerCallback = nullptr;
     _t = nullptr;
     _pending = false;
+    _missed = 0;
+    _tickDeadline = 0;
+    _pendingDeadline = 0;
+    _catchUpPolicy = CATCHUP_POLICY::SKIP;
     _name = "";
 }
 
@@ -129,6 +194,10 @@ void xLightsTimer::DoSendTimer() {
     if (!_pending) {
         return;
     }
+    if (_t != nullptr) {
+        auto due = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(_pendingDeadline.load()));
+        _t->RecordDelivered(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - due).count());
+    }
     wxTimer::Notify();
     //reset pending to false AFTER sending the event so if sending takes to long, it results in a skipped frame instead of
     //infinite number of CallAfters consuming the CPU
@@ -143,16 +212,45 @@ void xLightsTimer::Notify() {
 
     if (_timerCallback != nullptr)
     {
+        if (_t != nullptr)
+        {
+            auto due = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(_tickDeadline.load()));
+            _t->RecordDelivered(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - due).count());
+        }
         wxTimerEvent event(*this);
         _timerCallback->TimerCallback(event);
     }
+    else if (_pending.exchange(true))
+    {
+        // the UI thread has not got to the last tick yet so this one is missed
+        if (_catchUpPolicy == CATCHUP_POLICY::CATCHUP)
+        {
+            _missed++;
+        }
+        else if (_t != nullptr)
+        {
+            _t->RecordSkipped(1);
+        }
+    }
     else
     {
-        _pending = true;
+        _pendingDeadline = _tickDeadline.load();
         CallAfter(&xLightsTimer::DoSendTimer);
     }
 }
 
+int xLightsTimer::TakeMissedTicks()
+{
+    int missed = _missed.exchange(0);
+    if (missed > MAX_CATCHUP_TICKS)
+    {
+        if (_t != nullptr) _t->RecordSkipped(missed - MAX_CATCHUP_TICKS);
+        missed = MAX_CATCHUP_TICKS;
+    }
+    if (missed > 0 && _t != nullptr) _t->RecordCaughtUp(missed);
+    return missed;
+}
+
 int xLightsTimer::GetInterval() const
 {
     if (_t != nullptr)
@@ -162,6 +260,23 @@ int xLightsTimer::GetInterval() const
     return -1;
 }
 
+xLightsTimerStats xLightsTimer::GetStats() const
+{
+    if (_t != nullptr)
+    {
+        return _t->GetStats();
+    }
+    return xLightsTimerStats();
+}
+
+void xLightsTimer::ResetStats()
+{
+    if (_t != nullptr)
+    {
+        _t->ResetStats();
+    }
+}
+
 xlTimerThread::xlTimerThread(const std::string& name, int interval, bool oneshot, xLightsTimer* timer, bool log) : wxThread(wxTHREAD_JOINABLE)
 {
     static log4cpp::Category &logger_timer = log4cpp::Category::getInstance(std::string("log_timer"));
@@ -304,20 +419,23 @@ void xlTimerThread::Stop()
     logger_timer.debug("    Stop took %ldms", sw.Time());
 }
 
-void xlTimerThread::DoSleep(int millis)
+void xlTimerThread::DoSleepUntil(std::chrono::steady_clock::time_point deadline)
 {
     static log4cpp::Category &logger_timer = log4cpp::Category::getInstance(std::string("log_timer"));
+
+    long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
     if (millis > 5000)
     {
-        logger_timer.debug("THREAD: DoSleep(%d)", millis);
+        logger_timer.debug("THREAD: DoSleepUntil(%lldms)", millis);
     }
 
-    // try to grab the lock but time out after the desired number of milliseconds
-    if (_waiter.try_lock_for(std::chrono::milliseconds(millis)))
+    // try to grab the lock but time out at the deadline. The deadline is absolute on the steady
+    // (monotonic) clock so time lost waking up or in the callback does not accumulate into drift.
+    if (_waiter.try_lock_until(deadline))
     {
         if (millis > 5000)
         {
-            logger_timer.debug("THREAD: DoSleep(%d) ... timer was aborted", millis);
+            logger_timer.debug("THREAD: DoSleepUntil(%lldms) ... timer was aborted", millis);
         }
         wxASSERT(_suspend == true || _stop == true);
 
@@ -328,11 +446,59 @@ void xlTimerThread::DoSleep(int millis)
     {
         if (millis > 5000)
         {
-            logger_timer.debug("THREAD: DoSleep(%d) ... %s timer timed out", millis, (const char*)_name.c_str());
+            logger_timer.debug("THREAD: DoSleepUntil(%lldms) ... %s timer timed out", millis, (const char*)_name.c_str());
         }
     }
 }
 
+void xlTimerThread::RecordTick(long long lateUS, int interval)
+{
+    if (lateUS < 0) lateUS = 0;
+
+    std::unique_lock<std::mutex> lock(_statsLock);
+    _stats.fired++;
+    _stats.jitter[xLightsTimerStats::GetJitterBucket(lateUS)]++;
+    if (lateUS > _stats.maxLateUS) _stats.maxLateUS = lateUS;
+    if (lateUS >= (std::max)(1000LL, (long long)interval * 250))
+    {
+        _stats.late++;
+    }
+}
+
+void xlTimerThread::RecordDelivered(long long lateUS)
+{
+    if (lateUS < 0) lateUS = 0;
+
+    std::unique_lock<std::mutex> lock(_statsLock);
+    _stats.delivered++;
+    _stats.deliveredJitter[xLightsTimerStats::GetJitterBucket(lateUS)]++;
+    if (lateUS > _stats.maxDeliveredLateUS) _stats.maxDeliveredLateUS = lateUS;
+}
+
+void xlTimerThread::RecordSkipped(long long skipped)
+{
+    std::unique_lock<std::mutex> lock(_statsLock);
+    _stats.skipped += skipped;
+}
+
+void xlTimerThread::RecordCaughtUp(long long caughtUp)
+{
+    std::unique_lock<std::mutex> lock(_statsLock);
+    _stats.caughtUp += caughtUp;
+}
+
+xLightsTimerStats xlTimerThread::GetStats() const
+{
+    std::unique_lock<std::mutex> lock(_statsLock);
+    return _stats;
+}
+
+void xlTimerThread::ResetStats()
+{
+    std::unique_lock<std::mutex> lock(_statsLock);
+    _stats = xLightsTimerStats();
+}
+
 wxThread::ExitCode xlTimerThread::Entry()
 {
     static log4cpp::Category &logger_timer = log4cpp::Category::getInstance(std::string("log_timer"));
@@ -341,7 +507,10 @@ wxThread::ExitCode xlTimerThread::Entry()
     bool oneshot = _oneshot;
     int interval = _interval;
     int fudgefactor = _fudgefactor;
-    long long last = wxGetLocalTimeMillis().GetValue();
+
+    // ticks are scheduled against absolute deadlines on the steady clock rather than relative to
+    // when we last woke up so the cadence does not drift over a long show
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds((std::max)(1, interval + fudgefactor));
 
     while (!_stop)
     {
@@ -375,7 +544,7 @@ wxThread::ExitCode xlTimerThread::Entry()
             }
 
             logger_timer.debug("THREAD: Timer %s thread unsuspended.", (const char *)_name.c_str());
-            last = wxGetLocalTimeMillis().GetValue();
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds((std::max)(1, (int)_interval + fudgefactor));
         }
 
         oneshot = _oneshot;
@@ -383,20 +552,16 @@ wxThread::ExitCode xlTimerThread::Entry()
 
         if (!_stop)
         {
-            long long now = wxGetLocalTimeMillis().GetValue();
-            long long toSleep = last + interval + fudgefactor - now;
-            //if (log)
-            //{
-            //    logger_base.debug("Timer sleeping for %ldms", (std::max)(1, (int)toSleep));
-            //}
-            DoSleep((std::max)(1, (int)toSleep));
-
-            last = wxGetLocalTimeMillis().GetValue();
+            DoSleepUntil(deadline);
+
+            auto now = std::chrono::steady_clock::now();
             bool suspend = _suspend;
             fudgefactor = _fudgefactor;
             if (!_stop && !suspend)
             {
+                RecordTick(std::chrono::duration_cast<std::chrono::microseconds>(now - deadline).count(), interval);
                 logger_timer.debug("THREAD: Timer %s fired.", (const char *)_name.c_str());
+                _timer->SetTickDeadline(deadline);
                 _timer->Notify();
             }
             if (oneshot)
@@ -406,6 +571,34 @@ wxThread::ExitCode xlTimerThread::Entry()
                 _interval = -99;
                 interval = -99;
             }
+            else
+            {
+                auto step = std::chrono::milliseconds((std::max)(1, interval + fudgefactor));
+                deadline += step;
+
+                // if we have fallen behind a tick whose deadline has only just passed fires straight away.
+                // Ticks whose whole interval has passed are either counted for the owner to run or skipped.
+                now = std::chrono::steady_clock::now();
+                if (deadline < now)
+                {
+                    long long missed = (now - deadline) / step;
+                    if (missed > 0)
+                    {
+                        deadline += step * missed;
+                        long long caughtUp = 0;
+                        if (_timer->GetCatchUpPolicy() == xLightsTimer::CATCHUP_POLICY::CATCHUP)
+                        {
+                            caughtUp = (std::min)(missed, (long long)MAX_CATCHUP_TICKS);
+                            _timer->AddMissedTicks((int)caughtUp);
+                        }
+                        if (missed > caughtUp) RecordSkipped(missed - caughtUp);
+                        if (log)
+                        {
+                            logger_timer.debug("THREAD: Timer %s missed %lld ticks, %lld to catch up.", (const char *)_name.c_str(), missed, caughtUp);
+                        }
+                    }
+                }
+            }
         }
     }
 
@@ -419,7 +612,7 @@ void xlTimerThread::SetFudgeFactor(int ff)
     _fudgefactor = ff;
 }
 #else
-xLightsTimer::xLightsTimer() {}
+xLightsTimer::xLightsTimer() { _missed = 0; _catchUpPolicy = CATCHUP_POLICY::SKIP; }
 xLightsTimer::~xLightsTimer() {}
 void xLightsTimer::Stop() {wxTimer::Stop();}
 bool xLightsTimer::Start(int time, bool oneShot, const std::string& name) {return wxTimer::Start(time, oneShot);};
@@ -427,5 +620,8 @@ void xLightsTimer::Notify() {wxTimer::Notify();}
 int xLightsTimer::GetInterval() const { return wxTimer::GetInterval(); }
 void xLightsTimer::DoSendTimer() {};
 void xLightsTimer::SetName(const std::string& name) {_name = name;}
+xLightsTimerStats xLightsTimer::GetStats() const { return xLightsTimerStats(); }
+void xLightsTimer::ResetStats() {}
+int xLightsTimer::TakeMissedTicks() { return 0; }
 
 #endif
@@ -13,9 +13,33 @@
 #include <wx/timer.h>
 
 #include <atomic>
+#include <chrono>
+#include <string>
 
 class xlTimerThread;
 
+// How closely a timer is keeping to its schedule. Lateness is measured from the deadline each
+// tick was due on the monotonic clock to when the timer thread woke up and again to when the
+// tick reached the code it runs, which for timers without a callback is after the UI thread got to it.
+struct xLightsTimerStats
+{
+    static const int JITTER_BUCKETS = 8;
+    static std::string GetJitterBucketName(int bucket);
+    static int GetJitterBucket(long long lateUS);
+
+    unsigned long long fired = 0;
+    unsigned long long late = 0; // fired a quarter of an interval or more after the deadline
+    unsigned long long skipped = 0; // ticks dropped because the timer fell too far behind
+    unsigned long long caughtUp = 0; // missed ticks handed to the owner to run
+    long long maxLateUS = 0;
+    unsigned long long jitter[JITTER_BUCKETS] = { 0 };
+    unsigned long long delivered = 0;
+    long long maxDeliveredLateUS = 0;
+    unsigned long long deliveredJitter[JITTER_BUCKETS] = { 0 };
+
+    std::string GetJSON() const;
+};
+
 // CLasses that want to have the timer call it from another thread need to derive from this class
 class xLightsTimerCallback
 {
@@ -28,11 +52,25 @@ public:
 class xLightsTimer :
     public wxTimer
 {
+public:
+    // What to do when ticks are missed because the callback or the system was too slow. Timers
+    // skip by default ... xSchedule can switch its frame timer to catch up in its options.
+    enum class CATCHUP_POLICY
+    {
+        SKIP,    // drop the missed ticks and carry on at the next deadline
+        CATCHUP  // count the missed ticks ... up to a point ... for the owner to run with the next one, see TakeMissedTicks
+    };
+
+private:
     xlTimerThread* _t;
     std::atomic<bool> _pending;
+    std::atomic<int> _missed;
+    std::atomic<std::chrono::steady_clock::rep> _tickDeadline; // when the tick being fired was due
+    std::atomic<std::chrono::steady_clock::rep> _pendingDeadline; // when the tick waiting for the UI thread was due
     xLightsTimerCallback* _timerCallback;
     std::atomic<bool> _suspend;
     std::atomic<bool> _log;
+    std::atomic<CATCHUP_POLICY> _catchUpPolicy;
     std::string _name;
 
 public:
@@ -46,6 +84,14 @@ public:
     virtual void DoSendTimer();
     int GetInterval() const;
     void SetLog(bool log) { _log = true; }
+    void SetCatchUpPolicy(CATCHUP_POLICY policy) { _catchUpPolicy = policy; }
+    CATCHUP_POLICY GetCatchUpPolicy() const { return _catchUpPolicy; }
+    xLightsTimerStats GetStats() const;
+    void ResetStats();
+    // Ticks missed since the last call when catching up. Each one is a frame the owner should run now.
+    int TakeMissedTicks();
+    void AddMissedTicks(int missed) { _missed += missed; }
+    void SetTickDeadline(std::chrono::steady_clock::time_point deadline) { _tickDeadline = deadline.time_since_epoch().count(); }
 
     // If you use this method to receive the timer notification then be sure that you dont do any UI
     // updates in the callback function as it will be called on another thread. Also if you are going
@@ -17,9 +17,11 @@
 #include <wx/textfile.h>
 #include <wx/mstream.h>
 #include <wx/base64.h>
+#include <wx/stopwatch.h>
 #include <zstd.h>
 
 #include "../include/spxml-0.5/spxmlparser.hpp"
+#include "../include/spxml-0.5/spxmlevent.hpp"
 
 #include "xLightsXmlFile.h"
 #include "xLightsMain.h"
@@ -836,6 +838,7 @@ void xLightsXmlFile::DeleteTimingSection(const std::string & section)
                         element->GetAttribute("name", &attr);
                         if (attr == section) {
                             e->RemoveChild(element);
+                            streamed_layers.erase(element);
                             delete element;
                             element = nullptr;
                             found = true;
@@ -849,6 +852,8 @@ void xLightsXmlFile::DeleteTimingSection(const std::string & section)
 
 void xLightsXmlFile::CreateNew()
 {
+    ClearStreamedEffects();
+
     // construct the new XML file
     wxXmlNode* root = new wxXmlNode(wxXML_ELEMENT_NODE,"xsequence");
     root->AddAttribute("BaseChannel","0");
@@ -1115,16 +1120,371 @@ void xLightsXmlFile::ConvertToFixedPointTiming()
     }
 }
 
-bool xLightsXmlFile::LoadSequence(const wxString& ShowDir, bool ignore_audio)
+#pragma region Streaming Load
+
+bool SequenceFileEffect::operator==(const SequenceFileEffect& other) const
+{
+    return name == other.name && settings == other.settings && ref == other.ref && palette == other.palette &&
+        id == other.id && startTime == other.startTime && endTime == other.endTime && isProtected == other.isProtected;
+}
+
+bool SequenceFileLayer::operator==(const SequenceFileLayer& other) const
+{
+    return type == other.type && name == other.name && index == other.index && layer == other.layer &&
+        effects == other.effects && nodes == other.nodes;
+}
+
+// text from the pull parser is utf-8, convert it the way a wxString from the xml document would be
+static std::string StreamText(const char* s)
+{
+    for (const char* p = s; *p != 0; p++) {
+        if ((unsigned char)*p >= 0x80) {
+            return wxString::FromUTF8(s).ToStdString();
+        }
+    }
+    return std::string(s);
+}
+
+static std::string StreamTrimmed(const char* s)
+{
+    return wxString::FromUTF8(s).Trim(true).Trim(false).ToStdString();
+}
+
+// layer attributes, only strand and submodel names are trimmed
+static void ReadLayerAttribute(SequenceFileLayer& layer, const char* name, const char* value)
+{
+    if (strcmp(name, "name") == 0) {
+        layer.name = layer.type == "Node" ? StreamText(value) : StreamTrimmed(value);
+    }
+    else if (strcmp(name, "index") == 0) {
+        layer.index = atoi(value);
+    }
+    else if (strcmp(name, "layer") == 0) {
+        layer.layer = atoi(value);
+    }
+}
+
+// effect attributes, timing marks keep their label as the name
+static void ReadEffectAttribute(SequenceFileEffect& effect, bool timing, const char* name, const char* value)
+{
+    if (strcmp(name, "startTime") == 0) {
+        effect.startTime = strtod(value, nullptr);
+    }
+    else if (strcmp(name, "endTime") == 0) {
+        effect.endTime = strtod(value, nullptr);
+    }
+    else if (strcmp(name, "protected") == 0) {
+        effect.isProtected = strcmp(value, "1") == 0;
+    }
+    else if (timing) {
+        if (strcmp(name, "label") == 0) {
+            effect.name = UnXmlSafe(wxString::FromUTF8(value));
+        }
+    }
+    else if (strcmp(name, "name") == 0) {
+        effect.name = StreamText(value);
+    }
+    else if (strcmp(name, "id") == 0) {
+        effect.id = atoi(value);
+    }
+    else if (strcmp(name, "ref") == 0) {
+        if (*value != 0) {
+            effect.ref = atoi(value);
+        }
+    }
+    else if (strcmp(name, "palette") == 0) {
+        effect.palette = strtol(value, nullptr, 10);
+    }
+}
+
+// the same records read from effect layers that are in the xml document
+static void ReadDocumentLayer(wxXmlNode* node, bool timing, SequenceFileLayer& layer)
+{
+    layer.type = node->GetName().ToStdString();
+    for (wxXmlAttribute* attr = node->GetAttributes(); attr != nullptr; attr = attr->GetNext()) {
+        ReadLayerAttribute(layer, attr->GetName().utf8_str(), attr->GetValue().utf8_str());
+    }
+    for (wxXmlNode* child = node->GetChildren(); child != nullptr; child = child->GetNext()) {
+        if (child->GetName() == "Effect") {
+            layer.effects.emplace_back();
+            SequenceFileEffect& effect = layer.effects.back();
+            for (wxXmlAttribute* attr = child->GetAttributes(); attr != nullptr; attr = attr->GetNext()) {
+                ReadEffectAttribute(effect, timing, attr->GetName().utf8_str(), attr->GetValue().utf8_str());
+            }
+            if (!timing && effect.ref == -1) {
+                effect.settings = child->GetNodeContent().ToStdString();
+            }
+        }
+        else if (child->GetName() == "Node" && layer.type == "Strand") {
+            layer.nodes.emplace_back();
+            ReadDocumentLayer(child, timing, layer.nodes.back());
+        }
+    }
+}
+
+static wxXmlNode* NewStreamNode(SP_XmlStartTagEvent* tag)
+{
+    wxXmlNode* node = new wxXmlNode(wxXML_ELEMENT_NODE, wxString::FromUTF8(tag->getName()));
+    for (int i = 0; i < tag->getAttrCount(); i++) {
+        const char* value = nullptr;
+        const char* name = tag->getAttr(i, &value);
+        node->AddAttribute(wxString::FromUTF8(name), wxString::FromUTF8(value));
+    }
+    return node;
+}
+
+// Reads the sequence with the pull parser. Everything except the EffectDB and the effect layers of the
+// ElementEffects Elements goes into the xml document as usual, those are decoded straight into strings
+// and effect records so a large sequence never holds an xml node and wxString copy of every effect.
+// Returns false, leaving the document alone, if the file needs the full xml document loader.
+bool xLightsXmlFile::StreamSequence()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    static const int STREAM_BLOCK_SIZE = 1024 * 1024;
+
+    wxFile file(GetFullPath());
+    if (!file.IsOpened()) {
+        return false;
+    }
+
+    struct OpenNode
+    {
+        wxXmlNode* node;
+        wxXmlNode* last;   // last child so appending doesnt walk the children
+    };
+    std::vector<OpenNode> open;
+    auto append = [&open](wxXmlNode* node) {
+        OpenNode& parent = open.back();
+        parent.node->InsertChildAfter(node, parent.last);
+        parent.last = node;
+    };
+
+    enum { SECTION_NONE, SECTION_EFFECTDB, SECTION_ELEMENTEFFECTS } section = SECTION_NONE;
+    wxXmlNode* root = nullptr;
+    std::vector<std::string> effectDB;
+    std::map<const wxXmlNode*, std::vector<SequenceFileLayer>> layers;
+    std::vector<SequenceFileLayer>* elementLayers = nullptr;
+    SequenceFileLayer* layer = nullptr;
+    SequenceFileLayer* node = nullptr;
+    std::string* text = nullptr;
+    bool timing = false;
+    int depth = 0;
+    bool done = false;
+    bool ok = true;
+
+    SP_XmlPullParser parser;
+    std::vector<char> bytes(STREAM_BLOCK_SIZE);
+    SP_XmlPullEvent* event = parser.getNext();
+    while (!done && ok) {
+        if (event == nullptr) {
+            if (parser.getError() != nullptr) {
+                logger_base.warn("LoadSequence: Streaming read failed: %s", parser.getError());
+                ok = false;
+                break;
+            }
+            ssize_t read = file.Read(bytes.data(), bytes.size());
+            if (read <= 0) {
+                break;
+            }
+            parser.append(bytes.data(), read);
+        }
+        else {
+            switch (event->getEventType()) {
+            case SP_XmlPullEvent::eDocDecl:
+            {
+                const char* encoding = ((SP_XmlDocDeclEvent*)event)->getEncoding();
+                if (*encoding != 0 && wxStricmp(encoding, "utf-8") != 0) {
+                    ok = false;
+                }
+                break;
+            }
+            case SP_XmlPullEvent::eStartTag:
+            {
+                SP_XmlStartTagEvent* tag = (SP_XmlStartTagEvent*)event;
+                const char* name = tag->getName();
+                depth++;
+                if (depth == 1) {
+                    root = NewStreamNode(tag);
+                    open.push_back({ root, nullptr });
+                }
+                else if (section == SECTION_EFFECTDB) {
+                    if (depth == 3 && strcmp(name, "Effect") == 0) {
+                        effectDB.emplace_back();
+                        text = &effectDB.back();
+                    }
+                }
+                else if (section == SECTION_ELEMENTEFFECTS) {
+                    if (depth == 3) {
+                        // the Elements stay in the document as other code finds and renames them there
+                        wxXmlNode* element = NewStreamNode(tag);
+                        append(element);
+                        elementLayers = &layers[element];
+                        const char* type = tag->getAttrValue("type");
+                        timing = type != nullptr && strcmp(type, "timing") == 0;
+                    }
+                    else if (depth == 4) {
+                        elementLayers->emplace_back();
+                        layer = &elementLayers->back();
+                        layer->type = name;
+                        for (int i = 0; i < tag->getAttrCount(); i++) {
+                            const char* value = nullptr;
+                            const char* attr = tag->getAttr(i, &value);
+                            ReadLayerAttribute(*layer, attr, value);
+                        }
+                    }
+                    else if ((depth == 5 || (depth == 6 && node != nullptr)) && strcmp(name, "Effect") == 0) {
+                        SequenceFileLayer* target = depth == 5 ? layer : node;
+                        target->effects.emplace_back();
+                        SequenceFileEffect& effect = target->effects.back();
+                        for (int i = 0; i < tag->getAttrCount(); i++) {
+                            const char* value = nullptr;
+                            const char* attr = tag->getAttr(i, &value);
+                            ReadEffectAttribute(effect, timing, attr, value);
+                        }
+                        if (!timing && effect.ref == -1) {
+                            text = &effect.settings;
+                        }
+                    }
+                    else if (depth == 5 && strcmp(name, "Node") == 0 && layer->type == "Strand") {
+                        layer->nodes.emplace_back();
+                        node = &layer->nodes.back();
+                        node->type = name;
+                        for (int i = 0; i < tag->getAttrCount(); i++) {
+                            const char* value = nullptr;
+                            const char* attr = tag->getAttr(i, &value);
+                            ReadLayerAttribute(*node, attr, value);
+                        }
+                    }
+                }
+                else if (depth == 2 && strcmp(name, "CompressedData") == 0) {
+                    ok = false;
+                }
+                else {
+                    wxXmlNode* n = NewStreamNode(tag);
+                    append(n);
+                    open.push_back({ n, nullptr });
+                    if (depth == 2 && strcmp(name, "EffectDB") == 0) {
+                        section = SECTION_EFFECTDB;
+                    }
+                    else if (depth == 2 && strcmp(name, "ElementEffects") == 0) {
+                        section = SECTION_ELEMENTEFFECTS;
+                    }
+                }
+                break;
+            }
+            case SP_XmlPullEvent::eEndTag:
+                text = nullptr;
+                if (section == SECTION_NONE) {
+                    open.pop_back();
+                }
+                else if (depth == 2) {
+                    open.pop_back();
+                    section = SECTION_NONE;
+                }
+                else if (depth == 3) {
+                    elementLayers = nullptr;
+                }
+                else if (depth == 4) {
+                    layer = nullptr;
+                }
+                else if (depth == 5) {
+                    node = nullptr;
+                }
+                depth--;
+                done = depth == 0;
+                break;
+            case SP_XmlPullEvent::eCData:
+            {
+                const char* t = ((SP_XmlCDataEvent*)event)->getText();
+                if (text != nullptr) {
+                    text->append(StreamText(t));
+                }
+                else if (section == SECTION_NONE && !open.empty()) {
+                    append(new wxXmlNode(wxXML_TEXT_NODE, "text", wxString::FromUTF8(t)));
+                }
+                break;
+            }
+            case SP_XmlPullEvent::eComment:
+                if (section == SECTION_NONE && !open.empty()) {
+                    append(new wxXmlNode(wxXML_COMMENT_NODE, "comment", wxString::FromUTF8(((SP_XmlCommentEvent*)event)->getText())));
+                }
+                break;
+            case SP_XmlPullEvent::eEndDocument:
+                done = true;
+                break;
+            default:
+                break;
+            }
+            delete event;
+        }
+        if (!done && ok) {
+            event = parser.getNext();
+        }
+    }
+    file.Close();
+
+    if (!ok || !done || root == nullptr) {
+        logger_base.debug("LoadSequence: Sequence not streamed, loading the whole xml document.");
+        delete root;
+        return false;
+    }
+
+    seqDocument.SetRoot(root);
+    streamed_effectdb = std::move(effectDB);
+    streamed_effectdb_loaded = true;
+    streamed_layers = std::move(layers);
+    return true;
+}
+
+void xLightsXmlFile::ClearStreamedEffects()
+{
+    streamed_effectdb.clear();
+    streamed_effectdb.shrink_to_fit();
+    streamed_effectdb_loaded = false;
+    streamed_layers.clear();
+}
+
+void xLightsXmlFile::TakeStreamedEffectDB(std::vector<std::string>& effectStrings)
+{
+    effectStrings = std::move(streamed_effectdb);
+    streamed_effectdb.clear();
+    streamed_effectdb_loaded = false;
+}
+
+void xLightsXmlFile::TakeElementLayers(wxXmlNode* element, std::vector<SequenceFileLayer>& layers)
+{
+    layers.clear();
+    auto it = streamed_layers.find(element);
+    if (it != streamed_layers.end()) {
+        layers = std::move(it->second);
+        streamed_layers.erase(it);
+        return;
+    }
+
+    bool timing = element->GetAttribute("type") == "timing";
+    for (wxXmlNode* layerNode = element->GetChildren(); layerNode != nullptr; layerNode = layerNode->GetNext()) {
+        layers.emplace_back();
+        ReadDocumentLayer(layerNode, timing, layers.back());
+    }
+}
+
+#pragma endregion
+
+bool xLightsXmlFile::LoadSequence(const wxString& ShowDir, bool ignore_audio, bool stream)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     logger_base.info("LoadSequence: Loading sequence " + GetFullPath());
 
-	if (!seqDocument.Load(GetFullPath()))
+    wxStopWatch sw;
+    ClearStreamedEffects();
+    // files that need their times converted are fixed up in the xml document so they are loaded whole
+    bool streamed = stream && !NeedsTimesCorrected() && StreamSequence();
+	if (!streamed && !seqDocument.Load(GetFullPath()))
 	{
 		logger_base.error("LoadSequence: XML file load failed.");
 		return false;
 	}
+    logger_base.info("LoadSequence: File read in %ldms%s.", sw.Time(), streamed ? " (streamed)" : "");
     is_open = true;
 
     wxXmlNode* root=seqDocument.GetRoot();
@@ -2760,6 +3120,7 @@ void xLightsXmlFile::Save( SequenceElements& seq_elements)
             e=e->GetNext();
         }
     }
+    ClearStreamedEffects();
 
     StringIntMap colorPalettes;
     wxXmlNode* colorPalette_node = AddChildXmlNode(root, "ColorPalettes");
@@ -3704,3 +4065,4 @@ void xLightsXmlFile::FixEffectPresets(wxXmlNode* effects_node)
         }
     }
 }
+
@@ -17,13 +17,47 @@
 #include "AudioManager.h"
 #include "Vixen3.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
 class SequenceElements;  // forward declaration needed due to circular dependency
 class xLightsFrame;
 
 WX_DECLARE_STRING_HASH_MAP( int, StringIntMap );
 
+// An Effect from the ElementEffects section of a sequence file
+struct SequenceFileEffect
+{
+    std::string name;      // the effect name, or the label of a timing mark
+    std::string settings;  // the settings when they are not a reference into the EffectDB
+    int ref = -1;          // index into the EffectDB
+    long palette = -1;     // index into the ColorPalettes
+    int id = 0;
+    double startTime = 0;
+    double endTime = 0;
+    bool isProtected = false;
+
+    bool operator==(const SequenceFileEffect& other) const;
+};
+
+// An EffectLayer, SubModelEffectLayer, Strand or Node of an ElementEffects Element
+struct SequenceFileLayer
+{
+    std::string type;                       // the xml tag
+    std::string name;                       // trimmed name attribute
+    int index = 0;                          // strand or node index
+    int layer = 0;                          // submodel or strand layer
+    std::vector<SequenceFileEffect> effects;
+    std::vector<SequenceFileLayer> nodes;   // Node layers of a Strand
+
+    bool operator==(const SequenceFileLayer& other) const;
+};
+
 class xLightsXmlFile : public wxFileName
 {
+    friend struct SequenceLoadTests; // the load self test drives the streaming and document loads directly
+
     public:
         //xLightsXmlFile();
         xLightsXmlFile(const wxFileName &filename);
@@ -141,6 +175,13 @@ class xLightsXmlFile : public wxFileName
 
         wxXmlNode* GetPalettesNode() const;
 
+        // The streaming load keeps the EffectDB and the effects of each ElementEffects Element out of the
+        // xml document. These hand them over, reading the document for anything that was not streamed.
+        // Streamed effects are given out once, SequenceElements takes them when it loads.
+        bool HasStreamedEffectDB() const { return streamed_effectdb_loaded; }
+        void TakeStreamedEffectDB(std::vector<std::string>& effectStrings);
+        void TakeElementLayers(wxXmlNode* element, std::vector<SequenceFileLayer>& layers);
+
         // static methods
         static void FixVersionDifferences(const wxString& filename);
         static void FixEffectPresets(wxXmlNode* effects_node);
@@ -163,9 +204,14 @@ class xLightsXmlFile : public wxFileName
         bool sequence_loaded = false;  // flag to indicate the sequencer has been loaded with this xml data
         DataLayerSet mDataLayers;
 		AudioManager* audio = nullptr;
+        std::vector<std::string> streamed_effectdb;
+        bool streamed_effectdb_loaded = false;
+        std::map<const wxXmlNode*, std::vector<SequenceFileLayer>> streamed_layers;
 
         void CreateNew();
-        bool LoadSequence(const wxString& ShowDir, bool ignore_audio=false);
+        bool LoadSequence(const wxString& ShowDir, bool ignore_audio=false, bool stream=true);
+        bool StreamSequence();
+        void ClearStreamedEffects();
         bool LoadV3Sequence();
         bool Save();
         bool SaveCopy() const;
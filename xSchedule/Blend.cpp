@@ -11,22 +11,354 @@
 
 #include "Blend.h"
 
-//#define SIMD
+#include <algorithm>
+#include <cstring>
 
-#ifdef SIMD
-#include "emmintrin.h"
-#define ALIGNMENT (128 / 8)
+#include "../xLights/CPUFeatures.h"
 
-int GetMisalignedBytes(uint8_t* b1, uint8_t* b2)
+#pragma region Byte Kernels
+// Each byte operation provides a scalar version and, where the platform supports it, SSE2 and AVX2 versions
+// that must produce exactly the same result as the scalar one
+
+struct OverwriteIfZeroOp
+{
+    static inline uint8_t Scalar(uint8_t b, uint8_t bb) { return b == 0x00 ? bb : b; }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb)
+    {
+        __m128i mask = _mm_cmpeq_epi8(b, _mm_setzero_si128()); // sets FF where b is zero
+        return _mm_or_si128(b, _mm_and_si128(mask, bb));
+    }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i b, __m256i bb)
+    {
+        __m256i mask = _mm256_cmpeq_epi8(b, _mm256_setzero_si256());
+        return _mm256_or_si256(b, _mm256_and_si256(mask, bb));
+    }
+#endif
+};
+
+struct MaskOp
+{
+    static inline uint8_t Scalar(uint8_t b, uint8_t bb) { return bb > 0 ? 0x00 : b; }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb)
+    {
+        __m128i mask = _mm_cmpeq_epi8(bb, _mm_setzero_si128()); // sets FF where bb is zero
+        return _mm_and_si128(mask, b);
+    }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i b, __m256i bb)
+    {
+        __m256i mask = _mm256_cmpeq_epi8(bb, _mm256_setzero_si256());
+        return _mm256_and_si256(mask, b);
+    }
+#endif
+};
+
+struct UnmaskOp
+{
+    static inline uint8_t Scalar(uint8_t b, uint8_t bb) { return bb == 0 ? 0x00 : b; }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb)
+    {
+        __m128i mask = _mm_cmpeq_epi8(bb, _mm_setzero_si128()); // sets FF where bb is zero
+        return _mm_andnot_si128(mask, b);
+    }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i b, __m256i bb)
+    {
+        __m256i mask = _mm256_cmpeq_epi8(bb, _mm256_setzero_si256());
+        return _mm256_andnot_si256(mask, b);
+    }
+#endif
+};
+
+struct AverageOp
+{
+    static inline uint8_t Scalar(uint8_t b, uint8_t bb) { return (uint8_t)(((int)b + (int)bb) / 2); }
+    // avg_epu8 rounds up so take off the carry where the sum is odd to match the scalar truncation
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb)
+    {
+        __m128i odd = _mm_and_si128(_mm_xor_si128(b, bb), _mm_set1_epi8(1));
+        return _mm_sub_epi8(_mm_avg_epu8(b, bb), odd);
+    }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i b, __m256i bb)
+    {
+        __m256i odd = _mm256_and_si256(_mm256_xor_si256(b, bb), _mm256_set1_epi8(1));
+        return _mm256_sub_epi8(_mm256_avg_epu8(b, bb), odd);
+    }
+#endif
+};
+
+struct MaximumOp
 {
-    int m1 = (size_t)b1 % ALIGNMENT;
-    int m2 = (size_t)b2 % ALIGNMENT;
+    static inline uint8_t Scalar(uint8_t b, uint8_t bb) { return std::max(b, bb); }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb) { return _mm_max_epu8(b, bb); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i b, __m256i bb) { return _mm256_max_epu8(b, bb); }
+#endif
+};
 
-    if (m1 == m2) return m1;
-    return -1;
+struct MinimumOp
+{
+    static inline uint8_t Scalar(uint8_t b, uint8_t bb) { return std::min(b, bb); }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb) { return _mm_min_epu8(b, bb); }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i b, __m256i bb) { return _mm256_min_epu8(b, bb); }
+#endif
+};
+
+struct BrightnessOp
+{
+    static inline uint8_t Scalar(uint8_t b, uint8_t bb) { return (uint8_t)(((int)b * (int)bb) / 255); }
+    // x / 255 == (x + 1 + (x >> 8)) >> 8 for every product of two bytes
+#ifdef CPU_SSE2
+    static inline __m128i Div255(__m128i x)
+    {
+        return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+    }
+    static inline __m128i SSE2(__m128i b, __m128i bb)
+    {
+        __m128i zero = _mm_setzero_si128();
+        __m128i lo = Div255(_mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(bb, zero)));
+        __m128i hi = Div255(_mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(bb, zero)));
+        return _mm_packus_epi16(lo, hi);
+    }
+#endif
+#ifdef CPU_AVX2
+    CPU_AVX2_TARGET static inline __m256i Div255(__m256i x)
+    {
+        return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, _mm256_set1_epi16(1)), _mm256_srli_epi16(x, 8)), 8);
+    }
+    // unpack and pack both work within 128 bit lanes so the byte order is preserved
+    CPU_AVX2_TARGET static inline __m256i AVX2(__m256i b, __m256i bb)
+    {
+        __m256i zero = _mm256_setzero_si256();
+        __m256i lo = Div255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi8(bb, zero)));
+        __m256i hi = Div255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi8(bb, zero)));
+        return _mm256_packus_epi16(lo, hi);
+    }
+#endif
+};
+
+#ifdef CPU_AVX2
+template <class OP>
+CPU_AVX2_TARGET static size_t BlendBytesAVX2(uint8_t* buffer, const uint8_t* blendBuffer, size_t channels)
+{
+    size_t i = 0;
+    for (; i + 32 <= channels; i += 32)
+    {
+        __m256i b = _mm256_loadu_si256((const __m256i*)(buffer + i));
+        __m256i bb = _mm256_loadu_si256((const __m256i*)(blendBuffer + i));
+        _mm256_storeu_si256((__m256i*)(buffer + i), OP::AVX2(b, bb));
+    }
+    return i;
+}
+#endif
+
+#ifdef CPU_SSE2
+template <class OP>
+static size_t BlendBytesSSE2(uint8_t* buffer, const uint8_t* blendBuffer, size_t channels, size_t i)
+{
+    for (; i + 16 <= channels; i += 16)
+    {
+        __m128i b = _mm_loadu_si128((const __m128i*)(buffer + i));
+        __m128i bb = _mm_loadu_si128((const __m128i*)(blendBuffer + i));
+        _mm_storeu_si128((__m128i*)(buffer + i), OP::SSE2(b, bb));
+    }
+    return i;
 }
 #endif
 
+template <class OP>
+static void BlendBytesScalar(uint8_t* buffer, const uint8_t* blendBuffer, size_t channels, size_t i)
+{
+    for (; i < channels; ++i)
+    {
+        *(buffer + i) = OP::Scalar(*(buffer + i), *(blendBuffer + i));
+    }
+}
+
+template <class OP>
+static void BlendBytes(uint8_t* buffer, const uint8_t* blendBuffer, size_t channels)
+{
+    size_t i = 0;
+#ifdef CPU_AVX2
+    if (CPUFeatures::UseAVX2()) i = BlendBytesAVX2<OP>(buffer, blendBuffer, channels);
+#endif
+#ifdef CPU_SSE2
+    if (CPUFeatures::UseSSE2()) i = BlendBytesSSE2<OP>(buffer, blendBuffer, channels, i);
+#endif
+    BlendBytesScalar<OP>(buffer, blendBuffer, channels, i);
+}
+#pragma endregion
+
+#pragma region Pixel Kernels
+// Pixel operations test whether all 3 channels of a pixel in one of the buffers are zero. The SIMD
+// version works on 16 pixels (48 bytes, 3 registers) at a time so pixels always start at the same
+// byte positions within the block.
+
+struct OverwriteIfBlackOp
+{
+    static const bool TestBlend = false;
+    static inline void Scalar(uint8_t* p, const uint8_t* pp, bool black)
+    {
+        if (black)
+        {
+            *p = *pp;
+            *(p + 1) = *(pp + 1);
+            *(p + 2) = *(pp + 2);
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb, __m128i black) { return _mm_or_si128(_mm_and_si128(black, bb), _mm_andnot_si128(black, b)); }
+#endif
+};
+
+struct OverwriteSkipBlackOp
+{
+    static const bool TestBlend = true;
+    static inline void Scalar(uint8_t* p, const uint8_t* pp, bool black)
+    {
+        if (!black)
+        {
+            *p = *pp;
+            *(p + 1) = *(pp + 1);
+            *(p + 2) = *(pp + 2);
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb, __m128i black) { return _mm_or_si128(_mm_and_si128(black, b), _mm_andnot_si128(black, bb)); }
+#endif
+};
+
+struct MaskPixelOp
+{
+    static const bool TestBlend = true;
+    static inline void Scalar(uint8_t* p, const uint8_t* pp, bool black)
+    {
+        if (!black)
+        {
+            *p = 0x00;
+            *(p + 1) = 0x00;
+            *(p + 2) = 0x00;
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb, __m128i black) { return _mm_and_si128(black, b); }
+#endif
+};
+
+struct UnmaskPixelOp
+{
+    static const bool TestBlend = true;
+    static inline void Scalar(uint8_t* p, const uint8_t* pp, bool black)
+    {
+        if (black)
+        {
+            *p = 0x00;
+            *(p + 1) = 0x00;
+            *(p + 2) = 0x00;
+        }
+    }
+#ifdef CPU_SSE2
+    static inline __m128i SSE2(__m128i b, __m128i bb, __m128i black) { return _mm_andnot_si128(black, b); }
+#endif
+};
+
+#ifdef CPU_SSE2
+// Given FF where a byte is zero across a 48 byte block work out FF for every byte of a pixel which is entirely zero
+static inline void BlackPixels(__m128i z0, __m128i z1, __m128i z2, __m128i& b0, __m128i& b1, __m128i& b2)
+{
+    // bytes which start a pixel within the block
+    const __m128i s0 = _mm_setr_epi8(-1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1);
+    const __m128i s1 = _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0);
+    const __m128i s2 = _mm_setr_epi8(0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0);
+
+    // and each byte with the two that follow it
+    __m128i a0 = _mm_and_si128(z0, _mm_and_si128(_mm_or_si128(_mm_srli_si128(z0, 1), _mm_slli_si128(z1, 15)), _mm_or_si128(_mm_srli_si128(z0, 2), _mm_slli_si128(z1, 14))));
+    __m128i a1 = _mm_and_si128(z1, _mm_and_si128(_mm_or_si128(_mm_srli_si128(z1, 1), _mm_slli_si128(z2, 15)), _mm_or_si128(_mm_srli_si128(z1, 2), _mm_slli_si128(z2, 14))));
+    __m128i a2 = _mm_and_si128(z2, _mm_and_si128(_mm_srli_si128(z2, 1), _mm_srli_si128(z2, 2)));
+
+    // keep only the result for the first byte of each pixel
+    a0 = _mm_and_si128(a0, s0);
+    a1 = _mm_and_si128(a1, s1);
+    a2 = _mm_and_si128(a2, s2);
+
+    // then spread it over the other two bytes of the pixel
+    b0 = _mm_or_si128(a0, _mm_or_si128(_mm_slli_si128(a0, 1), _mm_slli_si128(a0, 2)));
+    b1 = _mm_or_si128(a1, _mm_or_si128(_mm_or_si128(_mm_slli_si128(a1, 1), _mm_srli_si128(a0, 15)), _mm_or_si128(_mm_slli_si128(a1, 2), _mm_srli_si128(a0, 14))));
+    b2 = _mm_or_si128(a2, _mm_or_si128(_mm_or_si128(_mm_slli_si128(a2, 1), _mm_srli_si128(a1, 15)), _mm_or_si128(_mm_slli_si128(a2, 2), _mm_srli_si128(a1, 14))));
+}
+
+template <class OP>
+static size_t BlendPixelsSSE2(uint8_t* buffer, const uint8_t* blendBuffer, size_t pixels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        uint8_t* p = buffer + i * 3;
+        const uint8_t* pp = blendBuffer + i * 3;
+        __m128i b0 = _mm_loadu_si128((const __m128i*)p);
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(p + 16));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(p + 32));
+        __m128i bb0 = _mm_loadu_si128((const __m128i*)pp);
+        __m128i bb1 = _mm_loadu_si128((const __m128i*)(pp + 16));
+        __m128i bb2 = _mm_loadu_si128((const __m128i*)(pp + 32));
+
+        __m128i k0, k1, k2;
+        if (OP::TestBlend)
+        {
+            BlackPixels(_mm_cmpeq_epi8(bb0, zero), _mm_cmpeq_epi8(bb1, zero), _mm_cmpeq_epi8(bb2, zero), k0, k1, k2);
+        }
+        else
+        {
+            BlackPixels(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero), _mm_cmpeq_epi8(b2, zero), k0, k1, k2);
+        }
+
+        _mm_storeu_si128((__m128i*)p, OP::SSE2(b0, bb0, k0));
+        _mm_storeu_si128((__m128i*)(p + 16), OP::SSE2(b1, bb1, k1));
+        _mm_storeu_si128((__m128i*)(p + 32), OP::SSE2(b2, bb2, k2));
+    }
+    return i;
+}
+#endif
+
+template <class OP>
+static void BlendPixelsScalar(uint8_t* buffer, const uint8_t* blendBuffer, size_t pixels, size_t i)
+{
+    for (; i < pixels; ++i)
+    {
+        uint8_t* p = buffer + i * 3;
+        const uint8_t* pp = blendBuffer + i * 3;
+        const uint8_t* t = OP::TestBlend ? pp : p;
+        OP::Scalar(p, pp, (*t | *(t + 1) | *(t + 2)) == 0);
+    }
+}
+
+template <class OP>
+static void BlendPixels(uint8_t* buffer, const uint8_t* blendBuffer, size_t pixels)
+{
+    size_t i = 0;
+#ifdef CPU_SSE2
+    if (CPUFeatures::UseSSE2()) i = BlendPixelsSSE2<OP>(buffer, blendBuffer, pixels);
+#endif
+    BlendPixelsScalar<OP>(buffer, blendBuffer, pixels, i);
+}
+#pragma endregion
+
 void PopulateBlendModes(wxChoice* choice)
 {
     choice->AppendString("Overwrite");
@@ -153,6 +485,7 @@ void Blend(uint8_t* buffer, size_t bufferSize, uint8_t* blendBuffer, size_t blen
     }
 }
 
+
 void Overwrite(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 {
     memcpy(buffer, blendBuffer, channels);
@@ -160,362 +493,56 @@ void Overwrite(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 
 void OverwriteIfZero(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            if (*(buffer + i) == 0x00)
-            {
-                *(buffer + i) = *(blendBuffer + i);
-            }
-        }
-
-        __m128i zero = _mm_setr_epi32(0, 0, 0, 0);
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i mask = _mm_cmpeq_epi8(b, zero); // sets FF where B is zero
-            __m128i newv = _mm_and_si128(mask, bb); // grab bb where B has zero
-            __m128i r = _mm_or_si128(b, newv); // merge them
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = misaligned + i + simd * ALIGNMENT;
-            if (*(buffer + offset) == 0)
-            {
-                *(buffer + offset) = *(blendBuffer + offset);
-            }
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            if (*(buffer + i) == 0x00)
-            {
-                *(buffer + i) = *(blendBuffer + i);
-            }
-        }
-    }
+    BlendBytes<OverwriteIfZeroOp>(buffer, blendBuffer, channels);
 }
 
 void Mask(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            if (*(blendBuffer + i) > 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-
-        __m128i zero = _mm_setr_epi32(0, 0, 0, 0);
-        int simd = channels / ALIGNMENT;
-
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i mask = _mm_cmpeq_epi8(bb, zero); // sets FF where BB is zero
-            __m128i r = _mm_and_si128(mask, b); // and the mask
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = misaligned + i + simd * ALIGNMENT;
-            if (*(blendBuffer + offset) > 0)
-            {
-                *(buffer + offset) = 0x00;
-            }
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            if (*(blendBuffer + i) > 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-    }
+    BlendBytes<MaskOp>(buffer, blendBuffer, channels);
 }
 
 void MaskPixel(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels)
 {
-    for (size_t i = 0; i < pixels; ++i)
-    {
-        uint8_t* p = blendBuffer + i * 3;
-        auto sum = *p + *(p + 1) + *(p + 2);
-        if (sum > 0)
-        {
-            uint8_t* pp = buffer + i * 3;
-            *pp = 0x00;
-            *(pp + 1) = 0x00;
-            *(pp + 2) = 0x00;
-        }
-    }
+    BlendPixels<MaskPixelOp>(buffer, blendBuffer, pixels);
 }
 
 void Unmask(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            if (*(blendBuffer + i) == 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-
-        __m128i zero = _mm_setr_epi32(0, 0, 0, 0);
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i mask = _mm_cmpeq_epi8(bb, zero); // sets FF where BB is zero
-            __m128i r = _mm_andnot_si128(mask, b); // invert the mask and then and it
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = misaligned + i + simd * ALIGNMENT;
-            if (*(blendBuffer + offset) == 0)
-            {
-                *(buffer + offset) = 0x00;
-            }
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            if (*(blendBuffer + i) == 0)
-            {
-                *(buffer + i) = 0x00;
-            }
-        }
-    }
+    BlendBytes<UnmaskOp>(buffer, blendBuffer, channels);
 }
 
 void UnmaskPixel(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels)
 {
-    for (size_t i = 0; i < pixels; ++i)
-    {
-        uint8_t* p = blendBuffer + i * 3;
-        auto sum = *p + *(p + 1) + *(p + 2);
-        if (sum == 0)
-        {
-            uint8_t* pp = buffer + i * 3;
-            *pp = 0x00;
-            *(pp + 1) = 0x00;
-            *(pp + 2) = 0x00;
-        }
-    }
+    BlendPixels<UnmaskPixelOp>(buffer, blendBuffer, pixels);
 }
 
 void Average(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            *(buffer + i) = (uint8_t)(((int)*(buffer + i) + (int)*(blendBuffer + i)) / 2);
-        }
-
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i r = _mm_avg_epu8(b, bb);
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = i + misaligned + simd * ALIGNMENT;
-            *(buffer + offset) = (uint8_t)(((int)*(buffer + offset) + (int)*(blendBuffer + offset)) / 2);
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            *(buffer + i) = (uint8_t)(((int)*(buffer + i) + (int)*(blendBuffer + i)) / 2);
-        }
-    }
+    BlendBytes<AverageOp>(buffer, blendBuffer, channels);
 }
 
 void Maximum(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            *(buffer + i) = std::max(*(buffer + i), *(blendBuffer + i));
-        }
-
-        // do the aligned pieces using SIMD instructions ... up to 16 times faster
-        int simd = (channels - misaligned) / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i r = _mm_max_epu8(b, bb);
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-                                }
-
-        // do the residual part at the end where we dont have enough bytes to process
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = i + misaligned + simd * ALIGNMENT;
-            *(buffer + offset) = std::max(*(buffer + offset), *(blendBuffer + offset));
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            *(buffer + i) = std::max(*(buffer + i), *(blendBuffer + i));
-        }
-    }
+    BlendBytes<MaximumOp>(buffer, blendBuffer, channels);
 }
 
 void Minimum(uint8_t* buffer, uint8_t* blendBuffer, size_t channels)
 {
-#ifdef SIMD
-    int misaligned = GetMisalignedBytes(buffer, blendBuffer);
-
-    if (misaligned >= 0 && (channels - misaligned) >= ALIGNMENT) // we can only use SIMD if misalignment is the same for both buffers and we have the minimum number of bytes to do
-    {
-        // do the misaligned
-        for (size_t i = 0; i < misaligned; ++i)
-        {
-            *(buffer + i) = std::min(*(buffer + i), *(blendBuffer + i));
-        }
-
-        int simd = channels / ALIGNMENT;
-        for (size_t i = 0; i < simd; ++i)
-        {
-            size_t offset = misaligned + i * ALIGNMENT;
-            __m128i b = _mm_load_si128((__m128i*)(buffer + offset));
-            __m128i bb = _mm_load_si128((__m128i*)(blendBuffer + offset));
-
-            __m128i r = _mm_min_epu8(b, bb);
-
-            _mm_store_si128((__m128i*)(buffer + offset), r);
-        }
-
-        // do the residual
-        for (size_t i = 0; i < channels % ALIGNMENT; ++i)
-        {
-            size_t offset = i + misaligned + simd * ALIGNMENT;
-            *(buffer + offset) = std::min(*(buffer + offset), *(blendBuffer + offset));
-        }
-    }
-    else
-#endif
-    {
-        for (size_t i = 0; i < channels; ++i)
-        {
-            *(buffer + i) = std::min(*(buffer + i), *(blendBuffer + i));
-        }
-    }
+    BlendBytes<MinimumOp>(buffer, blendBuffer, channels);
 }
 
 void OverwriteIfBlack(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels)
 {
-    for (size_t i = 0; i < pixels; ++i)
-    {
-        uint8_t* p = buffer + i * 3;
-        auto sum = *p + *(p + 1) + *(p + 2);
-        if (sum == 0)
-        {
-            uint8_t* pp = blendBuffer + i * 3;
-            *p = *pp;
-            *(p + 1) = *(pp + 1);
-            *(p + 2) = *(pp + 2);
-        }
-    }
+    BlendPixels<OverwriteIfBlackOp>(buffer, blendBuffer, pixels);
 }
 
 void OverwriteSkipBlack(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels)
 {
-    for (size_t i = 0; i < pixels; ++i)
-    {
-        uint8_t* pp = blendBuffer + i * 3;
-        auto sum = *pp + *(pp + 1) + *(pp + 2);
-        if (sum > 0)
-        {
-            uint8_t* p = buffer + i * 3;
-            *p = *pp;
-            *(p + 1) = *(pp + 1);
-            *(p + 2) = *(pp + 2);
-        }
-    }
+    BlendPixels<OverwriteSkipBlackOp>(buffer, blendBuffer, pixels);
 }
 
 // apply the input data as if it was (inputvalue / 255) * currentvalue ... ie a brightness
 void Brightness(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels)
 {
-    uint8_t* p = buffer;
-    uint8_t* pp = blendBuffer;
-    for (size_t i = 0; i < pixels * 3; ++i)         {
-        if (*pp == 0)             {
-            *p = 0;
-        }
-        else if (*pp != 255)             {
-            *p = ((int)*p * (int)*pp) / 255;
-        }
-    }
-}
\ No newline at end of file
+    BlendBytes<BrightnessOp>(buffer, blendBuffer, pixels * 3);
+}
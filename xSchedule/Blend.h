@@ -41,7 +41,7 @@ void Unmask(uint8_t* buffer, uint8_t* blendBuffer, size_t channels);
 void Average(uint8_t* buffer, uint8_t* blendBuffer, size_t channels);
 void Maximum(uint8_t* buffer, uint8_t* blendBuffer, size_t channels);
 void Minimum(uint8_t* buffer, uint8_t* blendBuffer, size_t channels);
-void Brightness(uint8_t* buffer, uint8_t* blendBuffer, size_t channels);
+void Brightness(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels);
 void OverwriteIfBlack(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels);
 void MaskPixel(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels);
 void UnmaskPixel(uint8_t* buffer, uint8_t* blendBuffer, size_t pixels);
@@ -0,0 +1,82 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "ChannelRanges.h"
+
+#include <algorithm>
+
+// ranges closer than this are joined as one bigger copy is cheaper than two small ones
+#define MERGE_GAP_CHANNELS 64
+
+void ChannelRanges::Add(long start, long count)
+{
+    if (_all) return;
+
+    if (start < 0)
+    {
+        count += start;
+        start = 0;
+    }
+    if (count <= 0) return;
+
+    _ranges.push_back({ (int32_t)start, (size_t)count });
+}
+
+void ChannelRanges::Add(const ChannelRanges& ranges)
+{
+    if (_all) return;
+
+    if (ranges._all)
+    {
+        AddAll();
+        return;
+    }
+    _ranges.insert(_ranges.end(), ranges._ranges.begin(), ranges._ranges.end());
+}
+
+void ChannelRanges::Normalise(size_t size)
+{
+    if (_all)
+    {
+        _ranges.clear();
+        if (size > 0) _ranges.push_back({ 0, size });
+        return;
+    }
+
+    std::sort(_ranges.begin(), _ranges.end());
+
+    std::vector<std::pair<int32_t, size_t>> merged;
+    for (const auto& it : _ranges)
+    {
+        if ((size_t)it.first >= size) break;
+        size_t end = std::min((size_t)it.first + it.second, size);
+
+        if (merged.size() > 0 && (size_t)it.first <= merged.back().first + merged.back().second + MERGE_GAP_CHANNELS)
+        {
+            auto& last = merged.back();
+            last.second = std::max(last.first + last.second, end) - last.first;
+        }
+        else
+        {
+            merged.push_back({ it.first, end - it.first });
+        }
+    }
+    _ranges.swap(merged);
+}
+
+size_t ChannelRanges::GetChannels() const
+{
+    size_t channels = 0;
+    for (const auto& it : _ranges)
+    {
+        channels += it.second;
+    }
+    return channels;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// A set of zero based channel ranges in the frame buffer. Used to track the channels something may
+// have written during a frame so only those need to be handed to the outputs.
+class ChannelRanges
+{
+    std::vector<std::pair<int32_t, size_t>> _ranges; // start, count ... sorted and merged by Normalise
+    bool _all = false;
+
+public:
+
+    void Clear() { _ranges.clear(); _all = false; }
+    void AddAll() { _all = true; }
+    bool IsAll() const { return _all; }
+    void Add(long start, long count);
+    void Add(const ChannelRanges& ranges);
+
+    // sort, merge and clip the ranges to a buffer of size channels
+    void Normalise(size_t size);
+    const std::vector<std::pair<int32_t, size_t>>& GetRanges() const { return _ranges; }
+    size_t GetChannels() const;
+};
@@ -44,5 +44,6 @@ class ESEQFile
 		bool IsOk() const { return _ok; }
 		size_t GetChannels() const { return _channelsPerFrame; }
 		size_t GetOffset() const { return _offset; }
+		size_t GetModelSize() const { return _modelSize; }
         void Close();
 };
@@ -41,6 +41,8 @@ const long OptionsDialog::ID_CHECKBOX10 = wxNewId();
 const long OptionsDialog::ID_CHECKBOX11 = wxNewId();
 const long OptionsDialog::ID_CHECKBOX12 = wxNewId();
 const long OptionsDialog::ID_CHECKBOX14 = wxNewId();
+const long OptionsDialog::ID_CHECKBOX15 = wxNewId();
+const long OptionsDialog::ID_CHECKBOX16 = wxNewId();
 const long OptionsDialog::ID_STATICTEXT2 = wxNewId();
 const long OptionsDialog::ID_LISTVIEW1 = wxNewId();
 const long OptionsDialog::ID_BUTTON5 = wxNewId();
@@ -138,6 +140,12 @@ OptionsDialog::OptionsDialog(wxWindow* parent, CommandManager* commandManager, S
 	CheckBox_MinimiseUI = new wxCheckBox(this, ID_CHECKBOX14, _("Minimise runtime UI updates for performance"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX14"));
 	CheckBox_MinimiseUI->SetValue(false);
 	FlexGridSizer7->Add(CheckBox_MinimiseUI, 1, wxALL|wxEXPAND, 5);
+	CheckBox_PipelinedFrames = new wxCheckBox(this, ID_CHECKBOX15, _("Send frames while composing the next one"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX15"));
+	CheckBox_PipelinedFrames->SetValue(false);
+	FlexGridSizer7->Add(CheckBox_PipelinedFrames, 1, wxALL|wxEXPAND, 5);
+	CheckBox_CatchUpFrames = new wxCheckBox(this, ID_CHECKBOX16, _("Catch up missed frames rather than skipping them"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX16"));
+	CheckBox_CatchUpFrames->SetValue(false);
+	FlexGridSizer7->Add(CheckBox_CatchUpFrames, 1, wxALL|wxEXPAND, 5);
 	FlexGridSizer1->Add(FlexGridSizer7, 1, wxALL|wxEXPAND, 5);
 	FlexGridSizer5 = new wxFlexGridSizer(0, 3, 0, 0);
 	FlexGridSizer5->AddGrowableCol(1);
@@ -297,6 +305,8 @@ OptionsDialog::OptionsDialog(wxWindow* parent, CommandManager* commandManager, S
     CheckBox_RemoteAllOff->SetValue(options->IsRemoteAllOff());
     CheckBox_KeepScreenOn->SetValue(options->IsKeepScreenOn());
     CheckBox_MinimiseUI->SetValue(options->IsMinimiseUIUpdates());
+    CheckBox_PipelinedFrames->SetValue(options->IsPipelinedFrames());
+    CheckBox_CatchUpFrames->SetValue(options->IsCatchUpFrames());
     CheckBox_SuppressAudioOnRemotes->SetValue(options->IsSuppressAudioOnRemotes());
     CheckBox_HWAcceleratedVideo->SetValue(options->IsHardwareAcceleratedVideo());
     CheckBox_LastStartingSequenceUsesTime->SetValue(options->IsLateStartingScheduleUsesTime());
@@ -405,6 +415,8 @@ void OptionsDialog::OnButton_OkClick(wxCommandEvent& event)
     _options->SetRemoteAllOff(CheckBox_RemoteAllOff->GetValue());
     _options->SetKeepScreenOn(CheckBox_KeepScreenOn->GetValue());
     _options->SetMinimiseUIUpdates(CheckBox_MinimiseUI->GetValue());
+    _options->SetPipelinedFrames(CheckBox_PipelinedFrames->GetValue());
+    _options->SetCatchUpFrames(CheckBox_CatchUpFrames->GetValue());
     _options->SetSuppressAudioOnRemotes(CheckBox_SuppressAudioOnRemotes->GetValue());
     _options->SetLateStartingScheduleUsesTime(CheckBox_LastStartingSequenceUsesTime->GetValue());
 
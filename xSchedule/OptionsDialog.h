@@ -58,6 +58,8 @@ class OptionsDialog: public wxDialog
 		wxCheckBox* CheckBox_LastStartingSequenceUsesTime;
 		wxCheckBox* CheckBox_MinimiseUI;
 		wxCheckBox* CheckBox_MultithreadedTransmission;
+		wxCheckBox* CheckBox_PipelinedFrames;
+		wxCheckBox* CheckBox_CatchUpFrames;
 		wxCheckBox* CheckBox_RemoteAllOff;
 		wxCheckBox* CheckBox_RetryOpen;
 		wxCheckBox* CheckBox_RunBackground;
@@ -108,6 +110,8 @@ class OptionsDialog: public wxDialog
 		static const long ID_CHECKBOX11;
 		static const long ID_CHECKBOX12;
 		static const long ID_CHECKBOX14;
+		static const long ID_CHECKBOX15;
+		static const long ID_CHECKBOX16;
 		static const long ID_STATICTEXT2;
 		static const long ID_LISTVIEW1;
 		static const long ID_BUTTON5;
@@ -20,6 +20,7 @@
 #include "OutputProcessGamma.h"
 #include "OutputProcessColourOrder.h"
 #include "OutputProcessDeadChannel.h"
+#include "ChannelRanges.h"
 #include "../xLights/outputs/OutputManager.h"
 
 OutputProcess::OutputProcess(OutputManager* outputManager, wxXmlNode* node)
@@ -76,6 +77,11 @@ size_t OutputProcess::GetStartChannelAsNumber()
     return _sc;
 }
 
+void OutputProcess::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.AddAll();
+}
+
 void OutputProcess::Save(wxXmlNode* node)
 {
     node->AddAttribute("StartChannel", _startChannel);
@@ -15,6 +15,8 @@
 
 class wxXmlNode;
 class OutputManager;
+class OutputProcessPlanStage;
+class ChannelRanges;
 
 class OutputProcess
 {
@@ -53,6 +55,15 @@ class OutputProcess
             return _enabled;
         }
         void Enable(bool enable) { _enabled = enable; _changeCount++; }
+        int GetChangeCount() const { return _changeCount; }
 
         virtual void Frame(uint8_t* buffer, size_t size) = 0;
+
+        // Add what Frame would do to a fused plan stage. Return false if the process cant be
+        // expressed as lookup tables and channel moves and so must run on its own.
+        virtual bool AddToPlan(OutputProcessPlanStage& stage, size_t size) { return false; }
+
+        // Add the channels Frame may set to a non zero value or move a value into.
+        // By default that is assumed to be everything.
+        virtual void AddWrittenChannels(ChannelRanges& ranges);
 };
@@ -10,6 +10,8 @@
 
 #include "OutputProcessColourOrder.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
+#include "OutputProcessPlan.h"
 
 OutputProcessColourOrder::OutputProcessColourOrder(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -94,3 +96,38 @@ void OutputProcessColourOrder::Frame(uint8_t* buffer, size_t size)
 		}
     }
 }
+
+void OutputProcessColourOrder::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _nodes * 3);
+}
+
+bool OutputProcessColourOrder::AddToPlan(OutputProcessPlanStage& stage, size_t size)
+{
+    if (!_enabled) return true;
+    if (_colourOrder == 123) return true;
+
+    // where each output channel of a node takes its value from
+    int order[3];
+    switch (_colourOrder)
+    {
+    case 132: order[0] = 0; order[1] = 2; order[2] = 1; break;
+    case 213: order[0] = 1; order[1] = 0; order[2] = 2; break;
+    case 231: order[0] = 1; order[1] = 2; order[2] = 0; break;
+    case 312: order[0] = 2; order[1] = 0; order[2] = 1; break;
+    case 321: order[0] = 2; order[1] = 1; order[2] = 0; break;
+    default: return false;
+    }
+
+    size_t sc = GetStartChannelAsNumber();
+    if (sc < 1 || sc - 1 >= size) return false;
+
+    size_t nodes = std::min(_nodes, (size - (sc - 1)) / 3);
+    size_t base = sc - 1;
+
+    stage.ApplyGather(base, nodes * 3, [base, &order](size_t ch) {
+        size_t offset = ch - base;
+        return ch - offset % 3 + order[offset % 3];
+    });
+    return true;
+}
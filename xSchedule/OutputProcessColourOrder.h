@@ -26,6 +26,8 @@ class OutputProcessColourOrder : public OutputProcess
         virtual ~OutputProcessColourOrder() {}
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size) override;
+        virtual void AddWrittenChannels(ChannelRanges& ranges) override;
+        virtual bool AddToPlan(OutputProcessPlanStage& stage, size_t size) override;
         virtual size_t GetP1() const override { return _nodes; }
         virtual size_t GetP2() const override { return _colourOrder; }
         virtual std::string GetType() const override { return "Color Order"; }
@@ -25,6 +25,7 @@ class OutputProcessDeadChannel : public OutputProcess
         virtual ~OutputProcessDeadChannel() {}
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size) override;
+        virtual void AddWrittenChannels(ChannelRanges& ranges) override {} // only ever clears channels
         virtual size_t GetP1() const override { return _channel; }
         virtual size_t GetP2() const override { return 0; }
         virtual std::string GetType() const override { return "Dead Channel"; }
@@ -10,6 +10,7 @@
 
 #include "OutputProcessDim.h"
 #include <wx/xml/xml.h>
+#include "OutputProcessPlan.h"
 
 OutputProcessDim::OutputProcessDim(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -85,3 +86,25 @@ void OutputProcessDim::Frame(uint8_t* buffer, size_t size)
         *(buffer + i + sc - 1) = _dimTable[*(buffer + i + sc - 1)];
     }
 }
+
+bool OutputProcessDim::AddToPlan(OutputProcessPlanStage& stage, size_t size)
+{
+    if (!_enabled) return true;
+    if (_dim == 100) return true;
+
+    size_t sc = GetStartChannelAsNumber();
+    if (sc < 1 || sc - 1 >= size) return false;
+
+    size_t chs = std::min(_channels, size - (sc - 1));
+
+    if (_dim == 0)
+    {
+        uint8_t off[256];
+        memset(off, 0x00, sizeof(off));
+        stage.ApplyLUT(sc - 1, chs, off, off, off);
+        return true;
+    }
+
+    stage.ApplyLUT(sc - 1, chs, _dimTable, _dimTable, _dimTable);
+    return true;
+}
@@ -30,6 +30,8 @@ public:
     virtual ~OutputProcessDim() {}
     virtual wxXmlNode* Save() override;
     virtual void Frame(uint8_t* buffer, size_t size) override;
+    virtual void AddWrittenChannels(ChannelRanges& ranges) override {} // only ever scales values down
+    virtual bool AddToPlan(OutputProcessPlanStage& stage, size_t size) override;
     virtual size_t GetP1() const override { return _channels; }
     virtual size_t GetP2() const override { return _dim; }
     virtual std::string GetType() const override { return "Dim"; }
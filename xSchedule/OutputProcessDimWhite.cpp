@@ -10,6 +10,7 @@
 
 #include "OutputProcessDimWhite.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
 
 OutputProcessDimWhite::OutputProcessDimWhite(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -39,6 +40,7 @@ OutputProcessDimWhite::OutputProcessDimWhite(OutputManager* outputManager, std::
     _lastDim = -1;
     _nodes = p1;
     _dim = p2;
+    BuildDimTable();
 }
 
 wxXmlNode* OutputProcessDimWhite::Save()
@@ -85,3 +87,8 @@ void OutputProcessDimWhite::Frame(uint8_t* buffer, size_t size)
         }
     }
 }
+
+void OutputProcessDimWhite::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _nodes * 3);
+}
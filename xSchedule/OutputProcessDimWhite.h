@@ -30,6 +30,7 @@ class OutputProcessDimWhite : public OutputProcess
         virtual ~OutputProcessDimWhite() {}
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size) override;
+        virtual void AddWrittenChannels(ChannelRanges& ranges) override;
         virtual size_t GetP1() const override { return _nodes; }
         virtual size_t GetP2() const override { return _dim; }
         virtual std::string GetType() const override { return "Dim White"; }
@@ -10,6 +10,8 @@
 
 #include "OutputProcessGamma.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
+#include "OutputProcessPlan.h"
 
 OutputProcessGamma::OutputProcessGamma(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -117,3 +119,33 @@ void OutputProcessGamma::Frame(uint8_t* buffer, size_t size)
         }
     }
 }
+
+void OutputProcessGamma::AddWrittenChannels(ChannelRanges& ranges)
+{
+    // a gamma of zero takes black to full on
+    if (_gammaData[0] == 0 && _gammaDataR[0] == 0 && _gammaDataG[0] == 0 && _gammaDataB[0] == 0) return;
+
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _nodes * 3);
+}
+
+bool OutputProcessGamma::AddToPlan(OutputProcessPlanStage& stage, size_t size)
+{
+    if (!_enabled) return true;
+    if (_gamma == 1.0) return true;
+    if (_gamma == 0.00 && _gammaR == 1.0 && _gammaG == 1.0 && _gammaB == 1.0) return true;
+
+    size_t sc = GetStartChannelAsNumber();
+    if (sc < 1 || sc - 1 >= size) return false;
+
+    size_t nodes = std::min(_nodes, (size - (sc - 1)) / 3);
+
+    if (_gamma != 0.0)
+    {
+        stage.ApplyLUT(sc - 1, nodes * 3, _gammaData, _gammaData, _gammaData);
+    }
+    else
+    {
+        stage.ApplyLUT(sc - 1, nodes * 3, _gammaDataR, _gammaDataG, _gammaDataB);
+    }
+    return true;
+}
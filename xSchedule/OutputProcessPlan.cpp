@@ -0,0 +1,331 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "OutputProcessPlan.h"
+#include "OutputProcess.h"
+#include "../xLights/Parallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <log4cpp/Category.hh>
+
+// stages touching fewer channels than this are not worth spreading across threads
+#define PARALLEL_CHANNELS 262144
+// runs are split into chunks this size (a multiple of 3 so the table phase is kept) to share the work out
+#define RUN_CHUNK_CHANNELS 49152
+
+#pragma region OutputProcessPlanStage
+OutputProcessPlanStage::OutputProcessPlanStage(size_t size) : _size(size)
+{
+    _source.resize(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        _source[i] = (uint32_t)i;
+    }
+    _lut.resize(size, 0);
+
+    std::array<uint8_t, 256> identity;
+    for (int i = 0; i < 256; i++)
+    {
+        identity[i] = (uint8_t)i;
+    }
+    _luts.push_back(identity);
+    _lutIds[identity] = 0;
+}
+
+uint32_t OutputProcessPlanStage::GetLUTId(const uint8_t* lut)
+{
+    std::array<uint8_t, 256> table;
+    memcpy(table.data(), lut, 256);
+
+    auto it = _lutIds.find(table);
+    if (it != _lutIds.end()) return it->second;
+
+    uint32_t id = (uint32_t)_luts.size();
+    _luts.push_back(table);
+    _lutIds[table] = id;
+    return id;
+}
+
+// the table equivalent to applying inner and then outer
+uint32_t OutputProcessPlanStage::Compose(uint32_t outer, uint32_t inner)
+{
+    if (outer == 0) return inner;
+    if (inner == 0) return outer;
+
+    auto key = std::make_pair(outer, inner);
+    auto it = _composed.find(key);
+    if (it != _composed.end()) return it->second;
+
+    uint8_t table[256];
+    for (int i = 0; i < 256; i++)
+    {
+        table[i] = _luts[outer][_luts[inner][i]];
+    }
+    uint32_t id = GetLUTId(table);
+    _composed[key] = id;
+    return id;
+}
+
+void OutputProcessPlanStage::ApplyLUT(size_t start, size_t count, const uint8_t* lut0, const uint8_t* lut1, const uint8_t* lut2)
+{
+    if (start >= _size) return;
+    count = std::min(count, _size - start);
+    if (count == 0) return;
+
+    uint32_t ids[3] = { GetLUTId(lut0), GetLUTId(lut1), GetLUTId(lut2) };
+    if (ids[0] == 0 && ids[1] == 0 && ids[2] == 0) return;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t& lut = _lut[start + i];
+        lut = Compose(ids[i % 3], lut);
+    }
+    _touched = true;
+}
+
+void OutputProcessPlanStage::ApplyGather(size_t start, size_t count, const std::function<size_t(size_t)>& source)
+{
+    if (start >= _size) return;
+    count = std::min(count, _size - start);
+    if (count == 0) return;
+
+    // read everything before writing as the source and target ranges may overlap
+    std::vector<uint32_t> newSource(count);
+    std::vector<uint32_t> newLut(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t s = source(start + i);
+        wxASSERT(s < _size);
+        newSource[i] = _source[s];
+        newLut[i] = _lut[s];
+    }
+    memcpy(&_source[start], newSource.data(), count * sizeof(uint32_t));
+    memcpy(&_lut[start], newLut.data(), count * sizeof(uint32_t));
+    _touched = true;
+}
+
+void OutputProcessPlanStage::Compile()
+{
+    // the gather covers only the channels which no longer read from themselves. Like the tables
+    // the moves are collapsed into runs which repeat every 3 channels so colour orders stay cheap
+    size_t moved = 0;
+    size_t i = 0;
+    while (i < _size)
+    {
+        if (_source[i] == i)
+        {
+            i++;
+            continue;
+        }
+
+        GatherRun run;
+        run.target = i;
+        for (size_t j = 0; j < 3; j++)
+        {
+            run.offsets[j] = (i + j < _size) ? (ptrdiff_t)_source[i + j] - (ptrdiff_t)(i + j) : 0;
+        }
+
+        size_t end = i + 1;
+        while (end < _size && (ptrdiff_t)_source[end] - (ptrdiff_t)end == run.offsets[(end - i) % 3] && end - i < RUN_CHUNK_CHANNELS)
+        {
+            end++;
+        }
+        run.count = end - i;
+        moved += run.count;
+        _gather.push_back(run);
+        i = end;
+    }
+    _scratch.resize(moved);
+
+    // collapse the per channel tables into runs which repeat every 3 channels
+    size_t touched = moved;
+    i = 0;
+    while (i < _size)
+    {
+        if (_lut[i] == 0)
+        {
+            i++;
+            continue;
+        }
+
+        LUTRun run;
+        run.start = i;
+        for (size_t j = 0; j < 3; j++)
+        {
+            run.luts[j] = (i + j < _size) ? _lut[i + j] : 0;
+        }
+
+        size_t end = i + 1;
+        while (end < _size && _lut[end] == run.luts[(end - i) % 3] && end - i < RUN_CHUNK_CHANNELS)
+        {
+            end++;
+        }
+        run.count = end - i;
+        touched += run.count;
+        _runs.push_back(run);
+        i = end;
+    }
+
+    _parallel = touched >= PARALLEL_CHANNELS;
+
+    std::vector<uint32_t>().swap(_source);
+    std::vector<uint32_t>().swap(_lut);
+    _lutIds.clear();
+    _composed.clear();
+}
+
+void OutputProcessPlanStage::Frame(uint8_t* buffer)
+{
+    if (_gather.size() > 0)
+    {
+        // read every source before writing any target as they can overlap
+        uint8_t* scratch = _scratch.data();
+        for (const auto& it : _gather)
+        {
+            const uint8_t* p = buffer + it.target;
+            if (it.offsets[0] == it.offsets[1] && it.offsets[0] == it.offsets[2])
+            {
+                memcpy(scratch, p + it.offsets[0], it.count);
+            }
+            else
+            {
+                const uint8_t* s0 = p + it.offsets[0];
+                const uint8_t* s1 = p + 1 + it.offsets[1];
+                const uint8_t* s2 = p + 2 + it.offsets[2];
+                size_t i = 0;
+                for (; i + 3 <= it.count; i += 3)
+                {
+                    scratch[i] = s0[i];
+                    scratch[i + 1] = s1[i];
+                    scratch[i + 2] = s2[i];
+                }
+                if (i < it.count) scratch[i] = s0[i];
+                if (i + 1 < it.count) scratch[i + 1] = s1[i];
+            }
+            scratch += it.count;
+        }
+        scratch = _scratch.data();
+        for (const auto& it : _gather)
+        {
+            memcpy(buffer + it.target, scratch, it.count);
+            scratch += it.count;
+        }
+    }
+
+    auto applyRun = [this, buffer](const LUTRun& run) {
+        uint8_t* p = buffer + run.start;
+        const uint8_t* t0 = _luts[run.luts[0]].data();
+        const uint8_t* t1 = _luts[run.luts[1]].data();
+        const uint8_t* t2 = _luts[run.luts[2]].data();
+        size_t i = 0;
+        for (; i + 3 <= run.count; i += 3)
+        {
+            p[i] = t0[p[i]];
+            p[i + 1] = t1[p[i + 1]];
+            p[i + 2] = t2[p[i + 2]];
+        }
+        if (i < run.count) p[i] = t0[p[i]];
+        if (i + 1 < run.count) p[i + 1] = t1[p[i + 1]];
+    };
+
+    if (_parallel)
+    {
+        parallel_for(0, (int)_runs.size(), [this, &applyRun](int r) {
+            applyRun(_runs[r]);
+        });
+    }
+    else
+    {
+        for (const auto& it : _runs)
+        {
+            applyRun(it);
+        }
+    }
+}
+#pragma endregion
+
+#pragma region OutputProcessPlan
+bool OutputProcessPlan::IsCurrent(const std::list<OutputProcess*>& processes, size_t size) const
+{
+    if (!_valid || size != _size || processes.size() != _signature.size()) return false;
+
+    auto sig = _signature.begin();
+    for (const auto& it : processes)
+    {
+        if (!(*sig == Signature{ it, it->GetChangeCount(), it->IsEnabled() })) return false;
+        ++sig;
+    }
+    return true;
+}
+
+void OutputProcessPlan::Compile(const std::list<OutputProcess*>& processes, size_t size)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _steps.clear();
+    _signature.clear();
+    _size = size;
+
+    int fused = 0;
+    std::unique_ptr<OutputProcessPlanStage> stage;
+    for (const auto& it : processes)
+    {
+        _signature.push_back({ it, it->GetChangeCount(), it->IsEnabled() });
+
+        if (stage == nullptr) stage = std::make_unique<OutputProcessPlanStage>(size);
+        if (it->AddToPlan(*stage, size))
+        {
+            fused++;
+            continue;
+        }
+
+        // this one has to run on its own
+        if (!stage->IsEmpty())
+        {
+            stage->Compile();
+            _steps.push_back({ nullptr, std::move(stage) });
+        }
+        stage = nullptr;
+        _steps.push_back({ it, nullptr });
+    }
+    if (stage != nullptr && !stage->IsEmpty())
+    {
+        stage->Compile();
+        _steps.push_back({ nullptr, std::move(stage) });
+    }
+
+    _valid = true;
+    logger_base.debug("Output processing plan built: %d processes, %d fused into %d steps.", (int)processes.size(), fused, (int)_steps.size());
+}
+
+void OutputProcessPlan::Frame(const std::list<OutputProcess*>& processes, uint8_t* buffer, size_t size)
+{
+    if (processes.size() == 0) return;
+
+    if (!IsCurrent(processes, size))
+    {
+        Compile(processes, size);
+    }
+
+    for (const auto& it : _steps)
+    {
+        if (it.stage != nullptr)
+        {
+            it.stage->Frame(buffer);
+        }
+        else
+        {
+            it.process->Frame(buffer, size);
+        }
+    }
+}
+#pragma endregion
@@ -0,0 +1,109 @@
+#pragma once
+
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+class OutputProcess;
+
+// A run of output processes folded into one gather followed by one lookup table per channel.
+// Processes describe themselves using ApplyLUT and ApplyGather. Channels are zero based.
+class OutputProcessPlanStage
+{
+    struct LUTRun
+    {
+        size_t start;
+        size_t count;
+        uint32_t luts[3]; // channel start + n uses luts[n % 3]
+    };
+
+    struct GatherRun
+    {
+        size_t target;
+        size_t count;
+        ptrdiff_t offsets[3]; // channel target + n reads from target + n + offsets[n % 3]
+    };
+
+    size_t _size = 0;
+    bool _touched = false;
+
+    // build state ... released by Compile
+    std::vector<uint32_t> _source;
+    std::vector<uint32_t> _lut;
+    std::map<std::array<uint8_t, 256>, uint32_t> _lutIds;
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> _composed;
+
+    // compiled state
+    std::vector<std::array<uint8_t, 256>> _luts; // 0 is always the identity table
+    std::vector<LUTRun> _runs;
+    std::vector<GatherRun> _gather;
+    std::vector<uint8_t> _scratch; // gathered values are staged here as sources and targets can overlap
+    bool _parallel = false;
+
+    uint32_t GetLUTId(const uint8_t* lut);
+    uint32_t Compose(uint32_t outer, uint32_t inner);
+
+public:
+
+    OutputProcessPlanStage(size_t size);
+
+    bool IsEmpty() const { return !_touched; }
+
+    // channel start + n is passed through lut[n % 3]
+    void ApplyLUT(size_t start, size_t count, const uint8_t* lut0, const uint8_t* lut1, const uint8_t* lut2);
+    // channel n in [start, start + count) takes the value channel source(n) had before this call
+    void ApplyGather(size_t start, size_t count, const std::function<size_t(size_t)>& source);
+
+    void Compile();
+    void Frame(uint8_t* buffer);
+};
+
+// The output processing chain compiled into fused stages. Processes which cant be expressed as
+// a gather and lookup tables are run on their own between stages. The plan rebuilds itself when
+// the processes or the buffer size change.
+class OutputProcessPlan
+{
+    struct Step
+    {
+        OutputProcess* process = nullptr;
+        std::unique_ptr<OutputProcessPlanStage> stage;
+    };
+
+    struct Signature
+    {
+        OutputProcess* process;
+        int changeCount;
+        bool enabled;
+        bool operator==(const Signature& s) const { return process == s.process && changeCount == s.changeCount && enabled == s.enabled; }
+    };
+
+    std::atomic_bool _valid;
+    size_t _size = 0;
+    std::vector<Signature> _signature;
+    std::vector<Step> _steps;
+
+    bool IsCurrent(const std::list<OutputProcess*>& processes, size_t size) const;
+    void Compile(const std::list<OutputProcess*>& processes, size_t size);
+
+public:
+
+    OutputProcessPlan() : _valid(false) {}
+    void Invalidate() { _valid = false; }
+    void Frame(const std::list<OutputProcess*>& processes, uint8_t* buffer, size_t size);
+};
@@ -10,6 +10,8 @@
 
 #include "OutputProcessRemap.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
+#include "OutputProcessPlan.h"
 
 OutputProcessRemap::OutputProcessRemap(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -59,3 +61,27 @@ void OutputProcessRemap::Frame(uint8_t* buffer, size_t size)
 
     memcpy(buffer + _to - 1, buffer + sc - 1, chs);
 }
+
+void OutputProcessRemap::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)_to - 1, _channels);
+}
+
+bool OutputProcessRemap::AddToPlan(OutputProcessPlanStage& stage, size_t size)
+{
+    size_t sc = GetStartChannelAsNumber();
+
+    if (sc == _to) return true;
+    if (sc < 1 || sc - 1 >= size || _to < 1 || _to - 1 >= size) return false;
+
+    size_t chs1 = std::min(_channels, size - (sc - 1));
+    size_t chs2 = std::min(_channels, size - (_to - 1));
+    size_t chs = std::min(chs1, chs2);
+
+    size_t from = sc - 1;
+    size_t to = _to - 1;
+    stage.ApplyGather(to, chs, [from, to](size_t ch) {
+        return from + ch - to;
+    });
+    return true;
+}
@@ -10,6 +10,7 @@
 
 #include "OutputProcessReverse.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
 
 OutputProcessReverse::OutputProcessReverse(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -65,3 +66,8 @@ void OutputProcessReverse::Frame(uint8_t* buffer, size_t size)
 		to -= 3;
     }
 }
+
+void OutputProcessReverse::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _nodes * 3);
+}
@@ -25,6 +25,7 @@ class OutputProcessReverse : public OutputProcess
         virtual ~OutputProcessReverse() {}
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size) override;
+        virtual void AddWrittenChannels(ChannelRanges& ranges) override;
         virtual size_t GetP1() const override { return _nodes; }
         virtual size_t GetP2() const override { return 0; }
         virtual std::string GetType() const override { return "Reverse"; }
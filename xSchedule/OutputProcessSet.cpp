@@ -10,6 +10,8 @@
 
 #include "OutputProcessSet.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
+#include "OutputProcessPlan.h"
 
 OutputProcessSet::OutputProcessSet(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -54,3 +56,21 @@ void OutputProcessSet::Frame(uint8_t* buffer, size_t size)
 
     memset(buffer + sc - 1, (uint8_t)_value, chs);
 }
+
+void OutputProcessSet::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _channels);
+}
+
+bool OutputProcessSet::AddToPlan(OutputProcessPlanStage& stage, size_t size)
+{
+    size_t sc = GetStartChannelAsNumber();
+    if (sc < 1 || sc - 1 >= size) return false;
+
+    size_t chs = std::min(_channels, size - (sc - 1));
+
+    uint8_t value[256];
+    memset(value, (uint8_t)_value, sizeof(value));
+    stage.ApplyLUT(sc - 1, chs, value, value, value);
+    return true;
+}
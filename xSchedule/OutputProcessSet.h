@@ -26,6 +26,8 @@ class OutputProcessSet : public OutputProcess
         virtual ~OutputProcessSet() {}
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size) override;
+        virtual void AddWrittenChannels(ChannelRanges& ranges) override;
+        virtual bool AddToPlan(OutputProcessPlanStage& stage, size_t size) override;
         virtual size_t GetP1() const override { return _channels; }
         virtual size_t GetP2() const override { return _value; }
         virtual std::string GetType() const override { return "Set"; }
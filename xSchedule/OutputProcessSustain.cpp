@@ -10,6 +10,7 @@
 
 #include "OutputProcessSustain.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
 
 OutputProcessSustain::OutputProcessSustain(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -74,3 +75,8 @@ void OutputProcessSustain::Frame(uint8_t* buffer, size_t size)
     // back everything up for next time
     memcpy(_save, buffer + sc - 1, chs);
 }
+
+void OutputProcessSustain::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _channels);
+}
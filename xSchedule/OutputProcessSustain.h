@@ -26,6 +26,7 @@ class OutputProcessSustain : public OutputProcess
         virtual ~OutputProcessSustain();
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size) override;
+        virtual void AddWrittenChannels(ChannelRanges& ranges) override;
         virtual size_t GetP1() const override { return _channels; }
         virtual size_t GetP2() const override { return 0; }
         virtual std::string GetType() const override { return "Sustain"; }
@@ -10,6 +10,7 @@
 
 #include "OutputProcessThreeToFour.h"
 #include <wx/xml/xml.h>
+#include "ChannelRanges.h"
 
 OutputProcessThreeToFour::OutputProcessThreeToFour(OutputManager* outputManager, wxXmlNode* node) : OutputProcess(outputManager, node)
 {
@@ -99,3 +100,8 @@ void OutputProcessThreeToFour::Frame(uint8_t* buffer, size_t size)
 		target -= 4;
     }
 }
+
+void OutputProcessThreeToFour::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _nodes * 4);
+}
@@ -26,6 +26,7 @@ class OutputProcessThreeToFour : public OutputProcess
         virtual ~OutputProcessThreeToFour() {}
         virtual wxXmlNode* Save() override;
         virtual void Frame(uint8_t* buffer, size_t size) override;
+        virtual void AddWrittenChannels(ChannelRanges& ranges) override;
         virtual size_t GetP1() const override { return _nodes; }
         std::string GetColourOrder() const { return _colourOrder; }
         virtual size_t GetP2() const override { return 0; }
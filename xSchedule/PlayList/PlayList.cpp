@@ -625,6 +625,17 @@ bool PlayList::Frame(uint8_t* buffer, size_t size, bool outputframe)
     return false;
 }
 
+void PlayList::AddWrittenChannels(ChannelRanges& ranges) const
+{
+    if (_currentStep == nullptr || IsPaused() || IsSuspended()) return;
+
+    _currentStep->AddWrittenChannels(ranges);
+    for (const auto& it : _everySteps)
+    {
+        it->AddWrittenChannels(ranges);
+    }
+}
+
 bool PlayList::IsRunning() const
 {
     return _currentStep != nullptr;
@@ -22,6 +22,7 @@ class PlayListStep;
 class wxWindow;
 class Schedule;
 class PlayListItem;
+class ChannelRanges;
 
 class PlayList
 {
@@ -119,6 +120,7 @@ public:
     void SetLastOnce(bool foo) { if (_lastOnlyOnce != foo) { _lastOnlyOnce = foo; _changeCount++; } }
     void SetShuffle(bool foo) { if (_alwaysShuffle != foo) { _alwaysShuffle = foo; _changeCount++; } }
     bool Frame(uint8_t* buffer, size_t size, bool outputframe); // true if this was the last frame
+    void AddWrittenChannels(ChannelRanges& ranges) const; // the channels the next Frame may write
     int GetPlayListSize() const { return _steps.size(); }
     bool IsLooping() const { return _looping; }
     void StopAtEndOfThisLoop() { _lastLoop = true; }
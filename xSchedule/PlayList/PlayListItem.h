@@ -17,6 +17,7 @@
 
 class wxXmlNode;
 class AudioManager;
+class ChannelRanges;
 
 class PlayListItem
 {
@@ -83,6 +84,8 @@ protected:
     void SetPriority(size_t priority) { if (_priority != priority) { _priority = priority; _changeCount++; } }
     virtual bool Done() const { return false; }
     virtual void Frame(uint8_t* buffer, size_t size, size_t ms, size_t framems, bool outputframe) = 0;
+    // Adds the channels Frame may set to a non zero value. Items which dont write to the frame buffer or only scale what is already there dont need this
+    virtual void AddWrittenChannels(ChannelRanges& ranges) {}
     virtual std::string GetSyncItemFSEQ() const { return ""; }
     virtual std::string GetSyncItemMedia() { return ""; }
     virtual std::string GetTitle() const = 0;
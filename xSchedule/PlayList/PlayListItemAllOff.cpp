@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemAllOff.h"
+#include "../ChannelRanges.h"
 #include <wx/xml/xml.h>
 #include <wx/notebook.h>
 #include "PlayListItemAllOffPanel.h"
@@ -152,4 +153,16 @@ void PlayListItemAllOff::Frame(uint8_t* buffer, size_t size, size_t ms, size_t f
             }
         }
     }
+}
+
+void PlayListItemAllOff::AddWrittenChannels(ChannelRanges& ranges)
+{
+    if (_channels == 0)
+    {
+        ranges.AddAll();
+    }
+    else
+    {
+        ranges.Add((long)GetStartChannelAsNumber() - 1, _channels);
+    }
 }
\ No newline at end of file
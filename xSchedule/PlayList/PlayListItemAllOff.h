@@ -65,6 +65,7 @@ public:
 
 #pragma region Playing
     virtual void Frame(uint8_t* buffer, size_t size, size_t ms, size_t framems, bool outputframe) override;
+    virtual void AddWrittenChannels(ChannelRanges& ranges) override;
 #pragma endregion Playing
 
     #pragma region UI
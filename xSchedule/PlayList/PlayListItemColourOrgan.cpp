@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemColourOrgan.h"
+#include "../ChannelRanges.h"
 #include <wx/xml/xml.h>
 #include <wx/notebook.h>
 #include "PlayListItemColourOrganPanel.h"
@@ -194,6 +195,11 @@ void PlayListItemColourOrgan::Frame(uint8_t* buffer, size_t size, size_t ms, siz
     }
 }
 
+void PlayListItemColourOrgan::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _pixels * 3);
+}
+
 void PlayListItemColourOrgan::Start(long stepLengthMS)
 {
     PlayListItem::Start(stepLengthMS);
@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemESEQ.h"
+#include "../ChannelRanges.h"
 #include "wx/xml/xml.h"
 #include <wx/notebook.h>
 #include "PlayListItemESEQPanel.h"
@@ -114,6 +115,14 @@ void PlayListItemESEQ::Frame(uint8_t* buffer, size_t size, size_t ms, size_t fra
     }
 }
 
+void PlayListItemESEQ::AddWrittenChannels(ChannelRanges& ranges)
+{
+    if (_ESEQFile != nullptr && _ESEQFile->IsOk())
+    {
+        ranges.Add((long)_ESEQFile->GetOffset() - 1, _ESEQFile->GetModelSize());
+    }
+}
+
 void PlayListItemESEQ::Start(long stepLengthMS)
 {
     PlayListItem::Start(stepLengthMS);
@@ -13,6 +13,7 @@
 #include "PlayListItem.h"
 #include "../Blend.h"
 #include <string>
+#include <vector>
 
 class wxXmlNode;
 class wxWindow;
@@ -41,6 +42,7 @@ protected:
     size_t _channels;
     bool _fastStartAudio;
     std::string _cachedAudioFilename;
+    std::vector<uint8_t> _frameBuffer; // reused every frame to avoid allocating on the playback thread
     #pragma endregion Member Variables
 
     void LoadFiles();
@@ -94,6 +96,7 @@ public:
 
     #pragma region Playing
     virtual void Frame(uint8_t* buffer, size_t size, size_t ms, size_t framems, bool outputframe) override;
+    virtual void AddWrittenChannels(ChannelRanges& ranges) override;
     virtual void Start(long stepLengthMS) override;
     virtual void Stop() override;
     virtual void Restart() override;
@@ -13,6 +13,7 @@
 #include <wx/mediactrl.h>   //for wxMediaCtrl
 
 #include "PlayListItemFSEQVideo.h"
+#include "../ChannelRanges.h"
 #include "PlayListItemFSEQVideoPanel.h"
 #include "../../xLights/AudioManager.h"
 #include "../../xLights/VideoReader.h"
@@ -548,20 +549,19 @@ void PlayListItemFSEQVideo::Frame(uint8_t* buffer, size_t size, size_t ms, size_
 
             if (_fseqFile != nullptr) {
                 int frame =  adjustedMS / framems;
-                FSEQFile::FrameData *data = _fseqFile->getFrame(frame);
-                if (data != nullptr) {
-                    std::vector<uint8_t> buf(_fseqFile->getMaxChannel() + 1);
-                    data->readFrame(&buf[0], buf.size());
+                if (_frameBuffer.size() != (size_t)_fseqFile->getMaxChannel() + 1) {
+                    _frameBuffer.resize((size_t)_fseqFile->getMaxChannel() + 1);
+                }
+                if (_fseqFile->readFrame(frame, &_frameBuffer[0], _frameBuffer.size())) {
                     size_t channelsPerFrame = (size_t)_fseqFile->getMaxChannel() + 1;
                     if (_channels > 0) channelsPerFrame = std::min(_channels, (size_t)_fseqFile->getMaxChannel() + 1);
                     if (_channels > 0) {
                         long offset = GetStartChannelAsNumber() - 1;
-                        Blend(buffer, size, &buf[offset], channelsPerFrame, _applyMethod, offset);
+                        Blend(buffer, size, &_frameBuffer[offset], channelsPerFrame, _applyMethod, offset);
                     }
                     else {
-                        Blend(buffer, size, &buf[0], channelsPerFrame, _applyMethod, 0);
+                        Blend(buffer, size, &_frameBuffer[0], channelsPerFrame, _applyMethod, 0);
                     }
-                    delete data;
                 }
                 else {
                     wxASSERT(false);
@@ -646,6 +646,21 @@ void PlayListItemFSEQVideo::Frame(uint8_t* buffer, size_t size, size_t ms, size_
     }
 }
 
+void PlayListItemFSEQVideo::AddWrittenChannels(ChannelRanges& ranges)
+{
+    if (_fseqFile == nullptr) return;
+
+    size_t channels = (size_t)_fseqFile->getMaxChannel() + 1;
+    if (_channels > 0)
+    {
+        ranges.Add((long)GetStartChannelAsNumber() - 1, std::min(_channels, channels));
+    }
+    else
+    {
+        ranges.Add(0, channels);
+    }
+}
+
 void PlayListItemFSEQVideo::Restart()
 {
     if (ControlsTiming() && _audioManager != nullptr) {
@@ -673,7 +688,18 @@ void PlayListItemFSEQVideo::Start(long stepLengthMS)
     LoadFiles(true);
 
     if (_fseqFile != nullptr) {
-        _fseqFile->prepareRead({ { 0, _fseqFile->getMaxChannel() + 1} });
+        // only the channels we blend need to be decoded
+        uint32_t start = 0;
+        uint32_t channels = _fseqFile->getMaxChannel() + 1;
+        if (_channels > 0) {
+            start = GetStartChannelAsNumber() - 1;
+            channels = std::min((uint32_t)_channels, channels);
+        }
+        _frameBuffer.resize((size_t)_fseqFile->getMaxChannel() + 1);
+
+        // decompress the next couple of blocks in the background so we dont stall crossing block boundaries
+        _fseqFile->setReadAheadBlocks(2);
+        _fseqFile->prepareRead({ { start, channels } });
     }
 
     _currentFrame = 0;
@@ -781,9 +807,17 @@ void PlayListItemFSEQVideo::Stop()
 void PlayListItemFSEQVideo::CloseFiles()
 {
     if (_fseqFile != nullptr) {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        auto stats = _fseqFile->getReadAheadStats();
+        if (stats.blocks > 0) {
+            logger_base.debug("FSEQ read ahead '%s': blocks %u, ready %u, stalls %u (%ldms), cancelled %u.",
+                (const char*)_fseqFileName.c_str(), stats.blocks, stats.hits, stats.stalls, (long)(stats.stallTimeUS / 1000), stats.cancelled);
+        }
         delete _fseqFile;
         _fseqFile = nullptr;
     }
+    _frameBuffer.clear();
+    _frameBuffer.shrink_to_fit();
 
     if (_audioManager != nullptr) {
         if (!_fastStartAudio) {
@@ -50,6 +50,7 @@ protected:
     VideoReader* _videoReader = nullptr;
     CachedVideoReader* _cachedVideoReader = nullptr;
     std::string _cachedAudioFilename;
+    std::vector<uint8_t> _frameBuffer; // reused every frame to avoid allocating on the playback thread
     long _fadeInMS = 0;
     long _fadeOutMS = 0;
     bool _loopVideo= false;
@@ -131,6 +132,7 @@ public:
 
     #pragma region Playing
     virtual void Frame(uint8_t* buffer, size_t size, size_t ms, size_t framems, bool outputframe) override;
+    virtual void AddWrittenChannels(ChannelRanges& ranges) override;
     virtual void Start(long stepLengthMS) override;
     virtual void Stop() override;
     virtual void Restart() override;
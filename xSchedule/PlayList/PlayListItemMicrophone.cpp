@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemMicrophone.h"
+#include "../ChannelRanges.h"
 #include <wx/xml/xml.h>
 #include <wx/notebook.h>
 #include "PlayListItemMicrophonePanel.h"
@@ -145,6 +146,11 @@ void PlayListItemMicrophone::Frame(uint8_t* buffer, size_t size, size_t ms, size
     }
 }
 
+void PlayListItemMicrophone::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _pixels * 3);
+}
+
 void PlayListItemMicrophone::Start(long stepLengthMS)
 {
     PlayListItem::Start(stepLengthMS);
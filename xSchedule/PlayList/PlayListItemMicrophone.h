@@ -68,6 +68,7 @@ public:
     virtual void Start(long stepLengthMS) override;
     virtual void Stop() override;
     virtual void Frame(uint8_t* buffer, size_t size, size_t ms, size_t framems, bool outputframe) override;
+    virtual void AddWrittenChannels(ChannelRanges& ranges) override;
     #pragma endregion Playing
 
 #pragma region UI
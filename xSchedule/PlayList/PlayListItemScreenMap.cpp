@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemScreenMap.h"
+#include "../ChannelRanges.h"
 #include <wx/xml/xml.h>
 #include <wx/notebook.h>
 #include "PlayListItemScreenMapPanel.h"
@@ -230,6 +231,14 @@ void PlayListItemScreenMap::Frame(uint8_t* buffer, size_t size, size_t ms, size_
     }
 }
 
+void PlayListItemScreenMap::AddWrittenChannels(ChannelRanges& ranges)
+{
+    if (_matrixMapper != nullptr)
+    {
+        ranges.Add(_matrixMapper->GetStartChannelAsNumber() - 1, _matrixMapper->GetChannels());
+    }
+}
+
 void PlayListItemScreenMap::SetPixel(uint8_t* p, uint8_t r, uint8_t g, uint8_t b, APPLYMETHOD blendMode)
 {
     uint8_t rgb[3];
@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemSetColour.h"
+#include "../ChannelRanges.h"
 #include <wx/xml/xml.h>
 #include <wx/notebook.h>
 #include "PlayListItemSetColourPanel.h"
@@ -165,3 +166,15 @@ void PlayListItemSetColour::Frame(uint8_t* buffer, size_t size, size_t ms, size_
         }
     }
 }
+
+void PlayListItemSetColour::AddWrittenChannels(ChannelRanges& ranges)
+{
+    if (_nodes == 0)
+    {
+        ranges.AddAll();
+    }
+    else
+    {
+        ranges.Add((long)GetStartChannelAsNumber() - 1, _nodes * 3);
+    }
+}
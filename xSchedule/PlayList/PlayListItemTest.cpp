@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemTest.h"
+#include "../ChannelRanges.h"
 #include <wx/xml/xml.h>
 #include <wx/notebook.h>
 #include "PlayListItemTestPanel.h"
@@ -237,6 +238,11 @@ void PlayListItemTest::Frame(uint8_t* buffer, size_t size, size_t ms, size_t fra
     }
 }
 
+void PlayListItemTest::AddWrittenChannels(ChannelRanges& ranges)
+{
+    ranges.Add((long)GetStartChannelAsNumber() - 1, _channels);
+}
+
 void PlayListItemTest::Start(long stepLengthMS)
 {
     PlayListItem::Start(stepLengthMS);
@@ -9,6 +9,7 @@
  **************************************************************/
 
 #include "PlayListItemText.h"
+#include "../ChannelRanges.h"
 #include <wx/xml/xml.h>
 #include <wx/notebook.h>
 #include <wx/wfstream.h>
@@ -604,6 +605,14 @@ void PlayListItemText::Frame(uint8_t* buffer, size_t size, size_t ms, size_t fra
     }
 }
 
+void PlayListItemText::AddWrittenChannels(ChannelRanges& ranges)
+{
+    if (_matrixMapper != nullptr)
+    {
+        ranges.Add(_matrixMapper->GetStartChannelAsNumber() - 1, _matrixMapper->GetChannels());
+    }
+}
+
 void PlayListItemText::SetPixel(uint8_t* p, uint8_t r, uint8_t g, uint8_t b, APPLYMETHOD blendMode)
 {
     uint8_t rgb[3];
@@ -537,6 +537,14 @@ bool PlayListStep::Frame(uint8_t* buffer, size_t size, bool outputframe)
     }
 }
 
+void PlayListStep::AddWrittenChannels(ChannelRanges& ranges) const
+{
+    for (const auto& it : _items)
+    {
+        it->AddWrittenChannels(ranges);
+    }
+}
+
 size_t PlayListStep::GetFrameMS()
 {
     size_t ms = 0;
@@ -22,6 +22,7 @@ class PlayListItem;
 class wxWindow;
 class AudioManager;
 class PlayList;
+class ChannelRanges;
 
 class PlayListStep
 {
@@ -97,6 +98,7 @@ public:
     void AddItem(PlayListItem* item) { _items.push_back(item); _items.sort(); _changeCount++; }
     void RemoveItem(PlayListItem* item);
     bool Frame(uint8_t* buffer, size_t size, bool outputframe);
+    void AddWrittenChannels(ChannelRanges& ranges) const;
     size_t GetPosition();
     PlayListItem* GetItem(const std::string item);
     PlayListItem* GetItem(const wxUint32 id);
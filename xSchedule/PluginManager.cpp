@@ -176,11 +176,13 @@ bool PluginManager::HandleWeb(const std::string& plugin, const std::string& acti
     return false;
 }
 
-void PluginManager::ManipulateBuffer(uint8_t* buffer, size_t bufferSize)
+bool PluginManager::ManipulateBuffer(uint8_t* buffer, size_t bufferSize)
 {
+    bool manipulated = false;
     for (auto it : _plugins) {
-        DoManipulateBuffer(it.first, buffer, bufferSize);
+        manipulated |= DoManipulateBuffer(it.first, buffer, bufferSize);
     }
+    return manipulated;
 }
 
 void PluginManager::NotifyStatus(const std::string& statusJSON)
@@ -74,7 +74,7 @@ private:
         std::string GetVirtualWebFolder(const std::string& plugin) const;
         std::string GetMenuLabel(const std::string& plugin) const;
         bool HandleWeb(const std::string& plugin, const std::string& command, const std::wstring& parameters, const std::wstring& data, const std::wstring& reference, std::wstring& response);
-        void ManipulateBuffer(uint8_t* buffer, size_t bufferSize);
+        bool ManipulateBuffer(uint8_t* buffer, size_t bufferSize); // true if any plugin was given the buffer
         void NotifyStatus(const std::string& statusJSON);
         bool FirePluginEvent(const std::string& plugin, const std::string& eventType, const std::string& eventParam);
         bool FireEvent(const std::string& eventType, const std::string& eventParam);
@@ -47,6 +47,7 @@
 #include "../xLights/VideoReader.h"
 #include "../xLights/outputs/Controller.h"
 
+#include <chrono>
 #include <memory>
 
 #include <log4cpp/Category.hh>
@@ -65,6 +66,8 @@ ScheduleManager::ScheduleManager(xScheduleFrame* frame, const std::string& showD
     _listenerManager = nullptr;
     _pinger = nullptr;
     _webRequestToggle = false;
+    _sendAllChannels = true;
+    _sentChannels = 0;
     _backgroundPlayList = nullptr;
     _queuedSongs = new PlayList();
     _queuedSongs->SetName("Song Queue");
@@ -193,6 +196,7 @@ ScheduleManager::ScheduleManager(xScheduleFrame* frame, const std::string& showD
             }
             DisableRemoteOutputs();
             _outputManager->StartOutput();
+            _sendAllChannels = true; // freshly opened outputs hold nothing we sent
 #ifdef __WXMSW__
             ::SetPriorityClass(::GetCurrentProcess(), ABOVE_NORMAL_PRIORITY_CLASS);
 #endif
@@ -419,6 +423,7 @@ int ScheduleManager::DoSync(const std::string& filename, long ms)
 ScheduleManager::~ScheduleManager()
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    StopOutputThread();
     AllOff();
     _outputManager->StopOutput();
 #ifdef __WXMSW__
@@ -718,6 +723,8 @@ void ScheduleManager::AllOff()
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     logger_base.debug("Turning all the lights off.");
 
+    FinishOutputFrame();
+
     memset(_buffer, 0x00, _outputManager->GetTotalChannels()); // clear out any prior frame data
     _outputManager->StartFrame(0);
 
@@ -764,11 +771,51 @@ void ScheduleManager::AllOff()
         }
     }
 
+    ProcessFrameOutput(_buffer, _outputManager->GetTotalChannels());
+
+    _outputManager->SetManyChannels(0, _buffer, _outputManager->GetTotalChannels());
+    _outputManager->EndFrame();
+    _sendAllChannels = true;
+}
+
+#pragma region Frame Pipeline
+static long long ElapsedUS(const std::chrono::steady_clock::time_point& since)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+void FrameStageTiming::Record(long long us)
+{
+    count++;
+    lastUS = us;
+    totalUS += us;
+    long long mx = maxUS;
+    while (us > mx && !maxUS.compare_exchange_weak(mx, us)) {}
+}
+
+std::string FrameStageTiming::GetJSON() const
+{
+    unsigned long long c = count;
+    return "{\"count\":\"" + std::to_string(c) +
+        "\",\"lastus\":\"" + std::to_string(lastUS.load()) +
+        "\",\"averageus\":\"" + std::to_string(c == 0 ? 0 : totalUS.load() / (long long)c) +
+        "\",\"maxus\":\"" + std::to_string(maxUS.load()) + "\"}";
+}
+
+// Output processing, brightness and virtual matrices ... everything between composing a frame and sending it
+void ScheduleManager::ProcessFrameOutput(uint8_t* buffer, long totalChannels)
+{
+    ApplyOutputProcessing(buffer, totalChannels);
+    FrameVirtualMatrices(buffer, totalChannels);
+}
+
+// The part of processing a frame the output thread does. Everything it reads is only changed while the thread is suspended.
+void ScheduleManager::ApplyOutputProcessing(uint8_t* buffer, long totalChannels)
+{
+    auto start = std::chrono::steady_clock::now();
+
     // apply any output processing
-    for (const auto& it : _outputProcessing)
-    {
-        it->Frame(_buffer, _outputManager->GetTotalChannels());
-    }
+    _outputProcessPlan.Frame(_outputProcessing, buffer, totalChannels);
 
     if (_brightness < 100)
     {
@@ -778,23 +825,177 @@ void ScheduleManager::AllOff()
             CreateBrightnessArray();
         }
 
-        uint8_t* pb = _buffer;
-        for (int i = 0; i < _outputManager->GetTotalChannels(); ++i)
+        uint8_t* pb = buffer;
+        for (int i = 0; i < totalChannels; ++i)
         {
             *pb = _brightnessArray[*pb];
             pb++;
         }
     }
 
+    _frameStageTiming[(int)FRAMESTAGE::PROCESS].Record(ElapsedUS(start));
+}
+
+// virtual matrices draw into windows so they are only ever given frames on the UI thread
+void ScheduleManager::FrameVirtualMatrices(uint8_t* buffer, long totalChannels)
+{
     for (const auto& it : *GetOptions()->GetVirtualMatrices())
     {
-        it->Frame(_buffer, _outputManager->GetTotalChannels());
+        it->Frame(buffer, totalChannels);
     }
+}
 
-    _outputManager->SetManyChannels(0, _buffer, _outputManager->GetTotalChannels());
-    _outputManager->EndFrame();
+// Hands the frame composed in _buffer to the output thread and takes back the buffer it last sent.
+// Waits for the previous frame to go out first so we are never more than one frame behind.
+void ScheduleManager::QueueOutputFrame(long totalChannels, long msec, ChannelRanges& ranges)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    auto start = std::chrono::steady_clock::now();
+    bool listen = false;
+    {
+        std::unique_lock<std::mutex> lock(_outputLock);
+        if (!_outputThread.joinable())
+        {
+            _outputBuffer = (uint8_t*)malloc(totalChannels);
+            memset(_outputBuffer, 0x00, totalChannels);
+            _outputStop = false;
+            _outputThread = std::thread(&ScheduleManager::OutputThreadEntry, this);
+            logger_base.info("Frame output thread started with a %ld byte frame buffer.", totalChannels);
+        }
+        _outputSignal.wait(lock, [this] { return !_outputPending; });
+        listen = _outputListen;
+        _outputListen = false;
+    }
+    _frameStageTiming[(int)FRAMESTAGE::WAIT].Record(ElapsedUS(start));
+
+    // listeners and virtual matrices are given the frame the output thread sent here rather than on the output
+    // thread as events can act on the schedule and virtual matrices draw into windows
+    if (listen)
+    {
+        FrameVirtualMatrices(_outputBuffer, _outputChannels);
+        if (_listenerManager != nullptr)
+        {
+            _listenerManager->ProcessFrame(_outputBuffer, _outputChannels);
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_outputLock);
+        std::swap(_buffer, _outputBuffer);
+        _outputChannels = totalChannels;
+        _outputMsec = msec;
+        std::swap(_outputRanges, ranges);
+        _outputPending = true;
+        _outputListen = true;
+    }
+    _outputSignal.notify_all();
 }
 
+// Waits for any frame the output thread is sending so the caller can use the outputs directly
+void ScheduleManager::FinishOutputFrame()
+{
+    bool listen = false;
+    {
+        std::unique_lock<std::mutex> lock(_outputLock);
+        _outputSignal.wait(lock, [this] { return !_outputPending; });
+        listen = _outputListen;
+        _outputListen = false;
+    }
+
+    if (listen)
+    {
+        FrameVirtualMatrices(_outputBuffer, _outputChannels);
+        if (_listenerManager != nullptr)
+        {
+            _listenerManager->ProcessFrame(_outputBuffer, _outputChannels);
+        }
+    }
+}
+
+void ScheduleManager::StopOutputThread()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!_outputThread.joinable()) return;
+
+    {
+        std::unique_lock<std::mutex> lock(_outputLock);
+        _outputStop = true;
+    }
+    _outputSignal.notify_all();
+    _outputThread.join();
+    logger_base.info("Frame output thread stopped.");
+
+    _outputListen = false;
+    free(_outputBuffer);
+    _outputBuffer = nullptr;
+}
+
+// Frames are sent from the UI thread until the matching ResumeOutputThread so output processes, virtual
+// matrices, options and the outputs themselves can be changed. The output thread restarts with the next frame.
+void ScheduleManager::SuspendOutputThread()
+{
+    _outputSuspended++;
+    FinishOutputFrame();
+    StopOutputThread();
+}
+
+void ScheduleManager::ResumeOutputThread()
+{
+    wxASSERT(_outputSuspended > 0);
+    if (_outputSuspended > 0) _outputSuspended--;
+}
+
+void ScheduleManager::OutputThreadEntry()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_outputLock);
+            _outputSignal.wait(lock, [this] { return _outputPending || _outputStop; });
+            // a pending frame is always sent before we stop
+            if (!_outputPending) break;
+        }
+
+        _outputManager->StartFrame(_outputMsec);
+        ApplyOutputProcessing(_outputBuffer, _outputChannels);
+
+        auto start = std::chrono::steady_clock::now();
+        _outputManager->SetManyChannels(_outputBuffer, _outputRanges.GetRanges());
+        _outputManager->EndFrame();
+        _frameStageTiming[(int)FRAMESTAGE::SEND].Record(ElapsedUS(start));
+
+        {
+            std::unique_lock<std::mutex> lock(_outputLock);
+            _outputPending = false;
+        }
+        _outputSignal.notify_all();
+    }
+}
+// The channels to hand to the outputs for the frame just composed. Output processes can move data
+// so they add where they write. Anything written last frame is included as it has gone back to zero.
+ChannelRanges ScheduleManager::GetSendRanges(long totalChannels)
+{
+    for (const auto& it : _outputProcessing)
+    {
+        it->AddWrittenChannels(_frameRanges);
+    }
+
+    ChannelRanges send = _frameRanges;
+    send.Add(_lastFrameRanges);
+    if (_sendAllChannels.exchange(false))
+    {
+        send.AddAll();
+    }
+    send.Normalise(totalChannels);
+    _lastFrameRanges = _frameRanges;
+
+    _sentChannels = send.GetChannels();
+    return send;
+}
+#pragma endregion
+
 int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
 {
     static bool reentry = false;
@@ -822,6 +1023,8 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
 
     if (IsTest())
     {
+        FinishOutputFrame();
+
         long msec = wxGetUTCTimeMillis().GetLo() - _startTime;
 
         if (outputframe)
@@ -829,39 +1032,10 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
             memset(_buffer, 0x00, totalChannels); // clear out any prior frame data
             _outputManager->StartFrame(msec);
             TestFrame(_buffer, totalChannels, msec);
-        }
-
-        // apply any output processing
-        for (const auto& it : _outputProcessing)
-        {
-            it->Frame(_buffer, totalChannels);
-        }
-
-        if (outputframe && _brightness < 100)
-        {
-            if (_brightness != _lastBrightness)
-            {
-                _lastBrightness = _brightness;
-                CreateBrightnessArray();
-            }
-
-            uint8_t* pb = _buffer;
-            for (int i = 0; i < totalChannels; ++i)
-            {
-                *pb = _brightnessArray[*pb];
-                pb++;
-            }
-        }
-
-        for (const auto& it : *GetOptions()->GetVirtualMatrices())
-        {
-            it->Frame(_buffer, totalChannels);
-        }
-
-        if (outputframe)
-        {
+            ProcessFrameOutput(_buffer, totalChannels);
             _outputManager->SetManyChannels(0, _buffer, totalChannels);
             _outputManager->EndFrame();
+            _sendAllChannels = true;
         }
     }
     else
@@ -882,16 +1056,29 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
 
             long msec = wxGetUTCTimeMillis().GetLo() - _startTime;
 
+            // when pipelined the output thread starts the frame when it picks it up
+            bool pipelined = outputframe && _scheduleOptions->IsPipelinedFrames() && _outputSuspended == 0;
+            if (!pipelined)
+            {
+                FinishOutputFrame();
+            }
+            auto composeStart = std::chrono::steady_clock::now();
+
+            _frameRanges.Clear();
             if (outputframe)
             {
                 memset(_buffer, 0x00, totalChannels); // clear out any prior frame data
-                _outputManager->StartFrame(msec);
+                if (!pipelined)
+                {
+                    _outputManager->StartFrame(msec);
+                }
             }
 
             bool done = false;
             if (running != nullptr)
             {
                 logger_frame.debug("Frame: About to run step frame %ldms", sw.Time());
+                running->AddWrittenChannels(_frameRanges);
                 done = running->Frame(_buffer, totalChannels, outputframe);
                 logger_frame.debug("Frame: step frame done %ldms", sw.Time());
 
@@ -936,6 +1123,7 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
                     _backgroundPlayList->Start(true);
                     logger_base.debug("Background playlist restarted. %s.", (const char *)_backgroundPlayList->GetNameNoTime().c_str());
                 }
+                _backgroundPlayList->AddWrittenChannels(_frameRanges);
                 _backgroundPlayList->Frame(_buffer, totalChannels, outputframe);
             }
 
@@ -944,6 +1132,7 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
                 auto it = _eventPlayLists.begin();
                 while (it != _eventPlayLists.end())
                 {
+                    (*it)->AddWrittenChannels(_frameRanges);
                     if ((*it)->Frame(_buffer, _outputManager->GetTotalChannels(), outputframe))
                     {
                         auto temp = it;
@@ -961,6 +1150,7 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
 
             if (_xyzzy != nullptr)
             {
+                _frameRanges.AddAll();
                 _xyzzy->Frame(_buffer, totalChannels, outputframe);
             }
 
@@ -969,58 +1159,47 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
                 // apply any overlay data
                 for (auto it = _overlayData.begin(); it != _overlayData.end(); ++it)
                 {
+                    _frameRanges.Add((long)(*it)->GetStartChannel() - 1, (*it)->GetSize());
                     (*it)->Set(_buffer, totalChannels);
                 }
 
-                frame->ManipulateBuffer(_buffer, totalChannels);
-
-                logger_frame.debug("Frame: Overlay data done %ldms", sw.Time());
-
-                // apply any output processing
-                for (auto it = _outputProcessing.begin(); it != _outputProcessing.end(); ++it)
+                // we cant know what a plugin changed
+                if (frame->ManipulateBuffer(_buffer, totalChannels))
                 {
-                    (*it)->Frame(_buffer, totalChannels);
+                    _frameRanges.AddAll();
                 }
 
-                logger_frame.debug("Frame: Output processing done %ldms", sw.Time());
+                logger_frame.debug("Frame: Overlay data done %ldms", sw.Time());
+
+                auto send = GetSendRanges(totalChannels);
+                _frameStageTiming[(int)FRAMESTAGE::COMPOSE].Record(ElapsedUS(composeStart));
 
-                if (outputframe && _brightness < 100)
+                if (pipelined)
                 {
-                    if (_brightness != _lastBrightness)
-                    {
-                        _lastBrightness = _brightness;
-                        CreateBrightnessArray();
-                    }
+                    QueueOutputFrame(totalChannels, msec, send);
 
-                    uint8_t* pb = _buffer;
-                    for (int i = 0; i < totalChannels; ++i)
-                    {
-                        *pb = _brightnessArray[*pb];
-                        pb++;
-                    }
+                    logger_frame.debug("Frame: Handed to output thread %ldms", sw.Time());
                 }
-
-                logger_frame.debug("Frame: Brightness done %ldms", sw.Time());
-
-                auto vm = GetOptions()->GetVirtualMatrices();
-                for (auto it = vm->begin(); it != vm->end(); ++it)
+                else
                 {
-                    (*it)->Frame(_buffer, totalChannels);
-                }
+                    ProcessFrameOutput(_buffer, totalChannels);
 
-                logger_frame.debug("Frame: Virtual matrices done %ldms", sw.Time());
+                    logger_frame.debug("Frame: Output processing, brightness and virtual matrices done %ldms", sw.Time());
 
-                _listenerManager->ProcessFrame(_buffer, totalChannels);
+                    _listenerManager->ProcessFrame(_buffer, totalChannels);
 
-                logger_frame.debug("Frame: Listening done %ldms", sw.Time());
+                    logger_frame.debug("Frame: Listening done %ldms", sw.Time());
 
-                _outputManager->SetManyChannels(0, _buffer, totalChannels);
+                    auto sendStart = std::chrono::steady_clock::now();
+                    _outputManager->SetManyChannels(_buffer, send.GetRanges());
 
-                logger_frame.debug("Frame: Data set %ldms", sw.Time());
+                    logger_frame.debug("Frame: Data set %ldms", sw.Time());
 
-                _outputManager->EndFrame();
+                    _outputManager->EndFrame();
+                    _frameStageTiming[(int)FRAMESTAGE::SEND].Record(ElapsedUS(sendStart));
 
-                logger_frame.debug("Frame: Data sent %ldms", sw.Time());
+                    logger_frame.debug("Frame: Data sent %ldms", sw.Time());
+                }
             }
 
             if (done)
@@ -1044,6 +1223,10 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
         }
         else
         {
+            FinishOutputFrame();
+            // whatever is sent here the next frame composed needs to go out in full
+            _sendAllChannels = true;
+
             if (_scheduleOptions->IsSendOffWhenNotRunning())
             {
                 if (outputframe)
@@ -1094,32 +1277,10 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
                     frame->ManipulateBuffer(_buffer, totalChannels);
                 }
 
-                // apply any output processing
-                for (auto it = _outputProcessing.begin(); it != _outputProcessing.end(); ++it)
-                {
-                    (*it)->Frame(_buffer, totalChannels);
-                }
-
-                if (outputframe && _brightness < 100)
-                {
-                    if (_brightness != _lastBrightness)
-                    {
-                        _lastBrightness = _brightness;
-                        CreateBrightnessArray();
-                    }
-
-                    uint8_t* pb = _buffer;
-                    for (int i = 0; i < totalChannels; ++i)
-                    {
-                        *pb = _brightnessArray[*pb];
-                        pb++;
-                    }
-                }
-
-                auto vm = GetOptions()->GetVirtualMatrices();
-                for (auto it = vm->begin(); it != vm->end(); ++it)
+                // between output frames the buffer still holds the last frame sent so it is not processed again
+                if (outputframe)
                 {
-                    (*it)->Frame(_buffer, totalChannels);
+                    ProcessFrameOutput(_buffer, totalChannels);
                 }
 
                 _listenerManager->ProcessFrame(_buffer, totalChannels);
@@ -1160,35 +1321,9 @@ int ScheduleManager::Frame(bool outputframe, xScheduleFrame* frame)
 
                     frame->ManipulateBuffer(_buffer, totalChannels);
 
-                    // apply any output processing
-                    for (auto it2 = _outputProcessing.begin(); it2 != _outputProcessing.end(); ++it2)
-                    {
-                        (*it2)->Frame(_buffer, totalChannels);
-                    }
-
-                    if (outputframe && _brightness < 100)
-                    {
-                        if (_brightness != _lastBrightness)
-                        {
-                            _lastBrightness = _brightness;
-                            CreateBrightnessArray();
-                        }
-
-                        uint8_t* pb = _buffer;
-                        for (int i = 0; i < totalChannels; ++i)
-                        {
-                            *pb = _brightnessArray[*pb];
-                            pb++;
-                        }
-                    }
-
-                    for (auto it2 :*GetOptions()->GetVirtualMatrices())
-                    {
-                        it2->Frame(_buffer, totalChannels);
-                    }
-
                     if (outputframe)
                     {
+                        ProcessFrameOutput(_buffer, totalChannels);
                         _outputManager->SetManyChannels(0, _buffer, totalChannels);
                         _outputManager->EndFrame();
                     }
@@ -3793,7 +3928,7 @@ bool ScheduleManager::Query(const wxString& command, const wxString& parameters,
                 "\",\"reference\":\"" + reference +
                 "\",\"passwordset\":\"" + (_scheduleOptions->GetPassword() == ""? "false" : "true") +
                 "\",\"time\":\""+ wxDateTime::Now().Format("%Y-%m-%d %H:%M:%S") +
-                "\"," + GetPingStatus() +"}";
+                "\"," + GetFrameTimerStatus() + "," + GetFramePipelineStatus() + "," + GetPingStatus() +"}";
         }
         else
         {
@@ -3859,7 +3994,7 @@ bool ScheduleManager::Query(const wxString& command, const wxString& parameters,
                 "\",\"autooutputtolights\":\"" + (_manualOTL ? "false" : "true") +
                 "\",\"passwordset\":\"" + (_scheduleOptions->GetPassword() == "" ? "false" : "true") +
                 "\",\"outputtolights\":\"" + std::string(_outputManager->IsOutputting() ? "true" : "false") + 
-                "\"," + GetPingStatus() + "}";
+                "\"," + GetFrameTimerStatus() + "," + GetFramePipelineStatus() + "," + GetPingStatus() + "}";
             //static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
             //logger_base.info("%s", (const char*)data.c_str());
         }
@@ -3904,6 +4039,49 @@ void ScheduleManager::DisableRemoteOutputs()
     }
 }
 
+void ScheduleManager::SetFrameTimer(xLightsTimer* timer)
+{
+    _frameTimer = timer;
+    UpdateFrameTimerPolicy();
+}
+
+// The frame timer skips ticks it has missed unless the options ask for them to be caught up
+void ScheduleManager::UpdateFrameTimerPolicy()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (_frameTimer == nullptr || _scheduleOptions == nullptr) return;
+
+    auto policy = _scheduleOptions->IsCatchUpFrames() ? xLightsTimer::CATCHUP_POLICY::CATCHUP : xLightsTimer::CATCHUP_POLICY::SKIP;
+    if (policy != _frameTimer->GetCatchUpPolicy())
+    {
+        logger_base.info("Frame timer will %s missed frames.", policy == xLightsTimer::CATCHUP_POLICY::CATCHUP ? "catch up" : "skip");
+        _frameTimer->SetCatchUpPolicy(policy);
+        // the stats so far were gathered under the old policy
+        _frameTimer->ResetStats();
+    }
+}
+
+std::string ScheduleManager::GetFrameTimerStatus() const
+{
+    if (_frameTimer == nullptr) return "\"frametimer\":{}";
+
+    return "\"frametimer\":" + _frameTimer->GetStats().GetJSON();
+}
+
+std::string ScheduleManager::GetFramePipelineStatus() const
+{
+    bool pipelined = _scheduleOptions != nullptr && _scheduleOptions->IsPipelinedFrames();
+
+    return "\"framepipeline\":{\"pipelined\":\"" + std::string(pipelined ? "true" : "false") +
+        "\",\"compose\":" + _frameStageTiming[(int)FRAMESTAGE::COMPOSE].GetJSON() +
+        ",\"wait\":" + _frameStageTiming[(int)FRAMESTAGE::WAIT].GetJSON() +
+        ",\"process\":" + _frameStageTiming[(int)FRAMESTAGE::PROCESS].GetJSON() +
+        ",\"send\":" + _frameStageTiming[(int)FRAMESTAGE::SEND].GetJSON() +
+        ",\"sentchannels\":\"" + std::to_string(_sentChannels.load()) +
+        "\",\"batchsend\":" + _outputManager->GetBatch().GetStatusJSON() + "}";
+}
+
 std::string ScheduleManager::GetPingStatus()
 {
     std::string res = "\"pingstatus\":[";
@@ -4149,7 +4327,9 @@ void ScheduleManager::SetOutputToLights(xScheduleFrame* frame, bool otl, bool in
                     wxMessageBox("Warning: Lights output is already open in another process. This will cause issues.", "WARNING", 4 | wxCENTRE, frame);
                 }
                 DisableRemoteOutputs();
+                FinishOutputFrame();
                 bool success = _outputManager->StartOutput();
+                _sendAllChannels = true; // freshly opened outputs hold nothing we sent
 #ifdef __WXMSW__
                 ::SetPriorityClass(::GetCurrentProcess(), ABOVE_NORMAL_PRIORITY_CLASS);
 #endif
@@ -4167,6 +4347,7 @@ void ScheduleManager::SetOutputToLights(xScheduleFrame* frame, bool otl, bool in
         {
             if (IsOutputToLights())
             {
+                FinishOutputFrame();
                 _outputManager->StopOutput();
 #ifdef __WXMSW__
                 ::SetPriorityClass(::GetCurrentProcess(), NORMAL_PRIORITY_CLASS);
@@ -4193,7 +4374,9 @@ void ScheduleManager::ManualOutputToLightsClick(xScheduleFrame* frame)
             wxMessageBox("Warning: Lights output is already open in another process. This will cause issues.", "WARNING", 4 | wxCENTRE, frame);
         }
         DisableRemoteOutputs();
+        FinishOutputFrame();
         _outputManager->StartOutput();
+        _sendAllChannels = true; // freshly opened outputs hold nothing we sent
 #ifdef __WXMSW__
             ::SetPriorityClass(::GetCurrentProcess(), ABOVE_NORMAL_PRIORITY_CLASS);
 #endif
@@ -4203,6 +4386,7 @@ void ScheduleManager::ManualOutputToLightsClick(xScheduleFrame* frame)
     }
     else if (_manualOTL == 0)
     {
+        FinishOutputFrame();
         _outputManager->StopOutput();
 #ifdef __WXMSW__
         ::SetPriorityClass(::GetCurrentProcess(), NORMAL_PRIORITY_CLASS);
@@ -10,8 +10,12 @@
  * License: https://github.com/smeighan/xLights/blob/master/License.txt
  **************************************************************/
 
+#include <atomic>
+#include <condition_variable>
 #include <list>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <wx/wx.h>
 #include "Schedule.h"
 #include "CommandManager.h"
@@ -20,6 +24,8 @@
 #include "wxMIDI/src/wxMidi.h"
 #include "Blend.h"
 #include "SyncManager.h"
+#include "OutputProcessPlan.h"
+#include "ChannelRanges.h"
 
 class PlayListItemText;
 class ScheduleOptions;
@@ -31,6 +37,7 @@ class OutputProcess;
 class XyzzyBase;
 class PlayListItem;
 class xScheduleFrame;
+class xLightsTimer;
 class Pinger;
 class ListenerManager;
 
@@ -68,8 +75,30 @@ public:
     std::string _data;
 };
 
+// How long one stage of the frame takes
+struct FrameStageTiming
+{
+    std::atomic<unsigned long long> count;
+    std::atomic<long long> lastUS;
+    std::atomic<long long> maxUS;
+    std::atomic<long long> totalUS;
+
+    FrameStageTiming() : count(0), lastUS(0), maxUS(0), totalUS(0) {}
+    void Record(long long us);
+    std::string GetJSON() const;
+};
+
 class ScheduleManager
 {
+    enum class FRAMESTAGE
+    {
+        COMPOSE,  // playlists, backgrounds, events and overlays rendered into the frame
+        WAIT,     // waiting for the previous frame to be sent before handing this one over
+        PROCESS,  // output processing, brightness and virtual matrices
+        SEND,     // writing the outputs
+        COUNT
+    };
+
     int _mode = (int)SYNCMODE::STANDALONE;
     REMOTEMODE _remoteMode = REMOTEMODE::DISABLED;
     bool _testMode = false;
@@ -99,6 +128,7 @@ class ScheduleManager
     wxDatagramSocket* _artNetSyncMaster = nullptr;
     wxDatagramSocket* _fppSyncMasterUnicast = nullptr;
     std::list<OutputProcess*> _outputProcessing;
+    OutputProcessPlan _outputProcessPlan;
     ListenerManager* _listenerManager = nullptr;
     XyzzyBase* _xyzzy = nullptr;
     wxDateTime _lastXyzzyCommand;
@@ -106,9 +136,42 @@ class ScheduleManager
     bool _webRequestToggle = false;
     Pinger* _pinger = nullptr;
     std::unique_ptr<SyncManager> _syncManager = nullptr;
+    xLightsTimer* _frameTimer = nullptr;
+
+    // When frames are pipelined the composed frame is handed to the output thread which processes and
+    // sends it while the next frame is composed in _buffer. Only one frame is ever in flight.
+    uint8_t* _outputBuffer = nullptr;
+    std::thread _outputThread;
+    std::mutex _outputLock;
+    std::condition_variable _outputSignal;
+    bool _outputPending = false; // the output thread has a frame to send
+    bool _outputListen = false; // the last frame sent still needs to be shown to the listeners
+    bool _outputStop = false;
+    int _outputSuspended = 0; // while non zero frames are not handed to the output thread
+    long _outputChannels = 0;
+    long _outputMsec = 0;
+    ChannelRanges _outputRanges; // the channels the output thread needs to hand to the outputs
+    // Only the channels written this frame or the last one are handed to the outputs ... everything
+    // else is zero in both so the outputs already hold it. Anything which sends the whole buffer
+    // sets _sendAllChannels as the outputs may then hold anything.
+    ChannelRanges _frameRanges;
+    ChannelRanges _lastFrameRanges;
+    std::atomic_bool _sendAllChannels;
+    std::atomic<size_t> _sentChannels;
+    FrameStageTiming _frameStageTiming[(int)FRAMESTAGE::COUNT];
 
     void DisableRemoteOutputs();
     std::string GetPingStatus();
+    std::string GetFrameTimerStatus() const;
+    std::string GetFramePipelineStatus() const;
+    void ProcessFrameOutput(uint8_t* buffer, long totalChannels);
+    void ApplyOutputProcessing(uint8_t* buffer, long totalChannels);
+    void FrameVirtualMatrices(uint8_t* buffer, long totalChannels);
+    ChannelRanges GetSendRanges(long totalChannels);
+    void QueueOutputFrame(long totalChannels, long msec, ChannelRanges& ranges);
+    void FinishOutputFrame();
+    void StopOutputThread();
+    void OutputThreadEntry();
     std::string FormatTime(size_t timems);
     void CreateBrightnessArray();
     void ManageBackground();
@@ -184,7 +247,11 @@ class ScheduleManager
         bool PlayPlayList(PlayList* playlist, size_t& rate, bool loop = false, const std::string& step = "", bool forcelast = false, int loops = -1, bool random = false, int steploops = -1);
         bool IsSomethingPlaying() const { return GetRunningPlayList() != nullptr; }
         void OptionsChanged() { _changeCount++; };
-        void OutputProcessingChanged() { _changeCount++; };
+        // the output thread reads the output processes, virtual matrices, options and outputs so it is
+        // suspended while any of them are edited
+        void SuspendOutputThread();
+        void ResumeOutputThread();
+        void OutputProcessingChanged() { _changeCount++; _outputProcessPlan.Invalidate(); };
         bool Action(const wxString& label, PlayList* selplaylist, PlayListStep* selplayliststep, Schedule* selschedule, size_t& rate, wxString& msg);
         bool Action(const wxString& command, const wxString& parameters, const wxString& data, PlayList* selplaylist, PlayListStep* selplayliststep, Schedule* selschedule, size_t& rate, wxString& msg);
         bool Query(const wxString& command, const wxString& parameters, wxString& data, wxString& msg, const wxString& ip, const wxString& reference);
@@ -216,6 +283,9 @@ class ScheduleManager
         static std::string xScheduleShowDir();
         bool ShowDirectoriesMatch() const;
         int GetPPS() const;
+        void SetFrameTimer(xLightsTimer* timer);
+        void UpdateFrameTimerPolicy();
+        xLightsTimer* GetFrameTimer() const { return _frameTimer; }
         void StartListeners();
         int Sync(const std::string& filename, long ms);
         int DoSync(const std::string& filename, long ms);
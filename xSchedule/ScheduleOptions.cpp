@@ -56,6 +56,8 @@ ScheduleOptions::ScheduleOptions(OutputManager* outputManager, wxXmlNode* node,
     _remoteAllOff = node->GetAttribute("RemoteSustain", "FALSE") == "FALSE";
     _keepScreenOn = node->GetAttribute("KeepScreenOn", "FALSE") == "TRUE";
     _minimiseUIUpdates = node->GetAttribute("MinimiseUIUpdates", "FALSE") == "TRUE";
+    _pipelinedFrames = node->GetAttribute("PipelinedFrames", "FALSE") == "TRUE";
+    _catchUpFrames = node->GetAttribute("CatchUpFrames", "FALSE") == "TRUE";
     _retryOutputOpen = node->GetAttribute("RetryOutputOpen", "FALSE") == "TRUE";
     _suppressAudioOnRemotes = node->GetAttribute("SuppressAudioOnRemotes", "TRUE") == "TRUE";
     _sendBackgroundWhenNotRunning = node->GetAttribute("SendBackgroundWhenNotRunning", "FALSE") == "TRUE";
@@ -278,6 +280,8 @@ ScheduleOptions::ScheduleOptions()
     _remoteAllOff = true;
     _keepScreenOn = false;
     _minimiseUIUpdates = false;
+    _pipelinedFrames = false;
+    _catchUpFrames = false;
     _retryOutputOpen = false;
     _suppressAudioOnRemotes = true;
     _sendBackgroundWhenNotRunning = false;
@@ -366,6 +370,16 @@ wxXmlNode* ScheduleOptions::Save()
         res->AddAttribute("ParallelTransmission", "TRUE");
     }
 
+    if (IsPipelinedFrames())
+    {
+        res->AddAttribute("PipelinedFrames", "TRUE");
+    }
+
+    if (IsCatchUpFrames())
+    {
+        res->AddAttribute("CatchUpFrames", "TRUE");
+    }
+
     if (!IsRemoteAllOff())
     {
         res->AddAttribute("RemoteSustain", "TRUE");
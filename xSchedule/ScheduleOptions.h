@@ -204,6 +204,8 @@ class ScheduleOptions
     bool _lateStartingScheduleUsesTime;
     int _SMPTEMode;
     bool _minimiseUIUpdates = false;
+    bool _pipelinedFrames = false;
+    bool _catchUpFrames = false;
 
     public:
 
@@ -236,6 +238,8 @@ class ScheduleOptions
         void SetParallelTransmission(bool parallel) { if (_parallelTransmission != parallel) { _parallelTransmission = parallel; _changeCount++; } }
         void SetRemoteAllOff(bool remoteAllOff) { if (_remoteAllOff != remoteAllOff) { _remoteAllOff = remoteAllOff; _changeCount++; } }
         void SetMinimiseUIUpdates(bool minimiseUIUpdates) { if (_minimiseUIUpdates != minimiseUIUpdates) { _minimiseUIUpdates = minimiseUIUpdates; _changeCount++; } }
+        void SetPipelinedFrames(bool pipelinedFrames) { if (_pipelinedFrames != pipelinedFrames) { _pipelinedFrames = pipelinedFrames; _changeCount++; } }
+        void SetCatchUpFrames(bool catchUpFrames) { if (_catchUpFrames != catchUpFrames) { _catchUpFrames = catchUpFrames; _changeCount++; } }
         void SetKeepScreenOn(bool keepScreenOn) { if (_keepScreenOn != keepScreenOn) { _keepScreenOn = keepScreenOn; _changeCount++; } }
         void SetRetryOutputOpen(bool retryOpen) { if (_retryOutputOpen != retryOpen) { _retryOutputOpen = retryOpen; _changeCount++; } }
         void SetSMPTEMode(int mode) { if (_SMPTEMode != mode) { _SMPTEMode = mode; _changeCount++; } }
@@ -247,6 +251,8 @@ class ScheduleOptions
         bool IsRemoteAllOff() const { return _remoteAllOff; }
         bool IsKeepScreenOn() const { return _keepScreenOn; }
         bool IsMinimiseUIUpdates() const { return _minimiseUIUpdates; }
+        bool IsPipelinedFrames() const { return _pipelinedFrames; }
+        bool IsCatchUpFrames() const { return _catchUpFrames; }
         bool IsRetryOpen() const { return _retryOutputOpen; }
         int GetSMPTEMode() const { return _SMPTEMode; }
         bool IsSuppressAudioOnRemotes() const { return _suppressAudioOnRemotes; }
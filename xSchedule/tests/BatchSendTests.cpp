@@ -0,0 +1,145 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <wx/socket.h>
+#include <wx/stopwatch.h>
+
+#include "SelfTests.h"
+#include "../../xLights/outputs/IPOutput.h"
+
+#ifdef __LINUX__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <vector>
+
+#include <log4cpp/Category.hh>
+
+// sends batched packets to a loopback receiver, checks they all arrive intact and in order
+// and logs the send time against unbatched sends
+bool BatchSendSelfTest()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+#ifdef __LINUX__
+    // the receiver queue has to hold a whole batch so keep them small and drain it after each one
+    const int rounds = 40;
+    const int packetsPerRound = 50;
+    const size_t packetSize = 638; // an E1.31 packet
+
+    int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    if (receiver < 0)
+    {
+        logger_base.error("Batch self test could not create the receiver socket.");
+        return false;
+    }
+    sockaddr_in recvAddr;
+    memset(&recvAddr, 0x00, sizeof(recvAddr));
+    recvAddr.sin_family = AF_INET;
+    recvAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    recvAddr.sin_port = 0;
+    socklen_t recvAddrLen = sizeof(recvAddr);
+    timeval timeout = { 1, 0 };
+    if (bind(receiver, (sockaddr*)&recvAddr, sizeof(recvAddr)) != 0 ||
+        getsockname(receiver, (sockaddr*)&recvAddr, &recvAddrLen) != 0 ||
+        setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0)
+    {
+        logger_base.error("Batch self test could not bind the receiver socket.");
+        close(receiver);
+        return false;
+    }
+
+    wxIPV4address localaddr;
+    localaddr.AnyAddress();
+    wxDatagramSocket sender(localaddr, wxSOCKET_NOWAIT);
+    wxIPV4address remoteAddr;
+    remoteAddr.Hostname("127.0.0.1");
+    remoteAddr.Service(ntohs(recvAddr.sin_port));
+    if (!sender.IsOk())
+    {
+        logger_base.error("Batch self test could not create the sender socket.");
+        close(receiver);
+        return false;
+    }
+
+    IPOutputBatch batch;
+    bool ok = true;
+    std::vector<uint8_t> packet(packetSize);
+    std::vector<uint8_t> received(packetSize + 1);
+    long long us[2] = { 0, 0 };
+    uint32_t sequence = 0;
+    for (int batched = 0; batched < 2; batched++)
+    {
+        for (int r = 0; r < rounds && ok; r++)
+        {
+            uint32_t first = sequence;
+            wxStopWatch sw;
+            if (batched) batch.Begin();
+            for (int i = 0; i < packetsPerRound; i++)
+            {
+                // the sequence number goes in the first bytes and the rest is a pattern that depends on it
+                memcpy(packet.data(), &sequence, sizeof(sequence));
+                for (size_t j = sizeof(sequence); j < packetSize; j++)
+                {
+                    packet[j] = (uint8_t)(sequence * 31 + j);
+                }
+                // the batch copies the packet so reusing the buffer must not change what is sent
+                if (!batch.Add(&sender, remoteAddr, packet.data(), packetSize))
+                {
+                    sender.SendTo(remoteAddr, packet.data(), packetSize);
+                }
+                sequence++;
+            }
+            if (batched)
+            {
+                batch.Flush();
+                if (batch.GetLastPacketsSent() + batch.GetLastPacketsSentSingly() != (uint32_t)packetsPerRound || batch.GetLastPacketsDropped() != 0)
+                {
+                    logger_base.error("Batch self test sent %u, sent %u singly and dropped %u of %d packets.",
+                        batch.GetLastPacketsSent(), batch.GetLastPacketsSentSingly(), batch.GetLastPacketsDropped(), packetsPerRound);
+                    ok = false;
+                }
+            }
+            us[batched] += sw.TimeInMicro().GetValue();
+
+            for (uint32_t expected = first; expected < sequence && ok; expected++)
+            {
+                ssize_t len = recv(receiver, received.data(), received.size(), 0);
+                uint32_t got = 0;
+                if (len == (ssize_t)packetSize) memcpy(&got, received.data(), sizeof(got));
+                bool match = len == (ssize_t)packetSize && got == expected;
+                for (size_t j = sizeof(expected); match && j < packetSize; j++)
+                {
+                    match = received[j] == (uint8_t)(expected * 31 + j);
+                }
+                if (!match)
+                {
+                    logger_base.error("Batch self test %s send expected packet %u of %d bytes but received %ld bytes starting %u.",
+                        batched ? "batched" : "unbatched", expected, (int)packetSize, (long)len, got);
+                    ok = false;
+                }
+            }
+        }
+    }
+    close(receiver);
+
+    logger_base.info("Batch benchmark: %d packets of %d bytes unbatched %.1fus batched %.1fus per %d packets.",
+        rounds * packetsPerRound, (int)packetSize, (double)us[0] / rounds, (double)us[1] / rounds, packetsPerRound);
+    logger_base.info("Batch self test %s.", ok ? "passed" : "FAILED");
+    return ok;
+#else
+    logger_base.info("Batch self test skipped as batched sends are not supported on this platform.");
+    return true;
+#endif
+}
@@ -0,0 +1,140 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "SelfTests.h"
+#include "../Blend.h"
+#include "../../xLights/CPUFeatures.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <log4cpp/Category.hh>
+
+typedef void (*BLENDFUNCTION)(uint8_t* buffer, uint8_t* blendBuffer, size_t count);
+
+struct BlendKernel
+{
+    const char* name;
+    bool pixels; // count is in pixels rather than channels
+    BLENDFUNCTION kernel;
+};
+
+static const BlendKernel __blendKernels[] = {
+    { "OverwriteIfZero", false, OverwriteIfZero },
+    { "Mask", false, Mask },
+    { "Unmask", false, Unmask },
+    { "Average", false, Average },
+    { "Max", false, Maximum },
+    { "Min", false, Minimum },
+    { "Brightness", true, Brightness },
+    { "OverwriteIfBlack", true, OverwriteIfBlack },
+    { "OverwriteSkipBlack", true, OverwriteSkipBlack },
+    { "MaskPixel", true, MaskPixel },
+    { "UnmaskPixel", true, UnmaskPixel }
+};
+
+// random data with plenty of zero bytes and black pixels so every branch of the kernels is hit
+static void FillBlendTestData(std::mt19937& rng, std::vector<uint8_t>& data)
+{
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        int kind = rng() % 4;
+        for (size_t j = i; j < std::min(i + 3, data.size()); j++)
+        {
+            data[j] = kind == 0 ? 0 : (kind == 1 && rng() % 2 == 0) ? 0 : (uint8_t)rng();
+        }
+    }
+}
+
+// runs each kernel with the scalar code and at the given level and compares the results
+static bool CheckBlendKernels(SIMDLEVEL level)
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::mt19937 rng(0x5eed);
+    bool ok = true;
+    for (const auto& k : __blendKernels)
+    {
+        // only the first mismatch for each kernel is reported
+        bool kernelOk = true;
+        for (size_t count = 0; count < 300 && kernelOk; count++)
+        {
+            // offsets move the buffers relative to each other and to the SIMD block size
+            for (size_t offset = 0; offset < 5 && kernelOk; offset++)
+            {
+                size_t channels = k.pixels ? count * 3 : count;
+                std::vector<uint8_t> buffer(channels + offset);
+                std::vector<uint8_t> blendBuffer(channels + offset);
+                FillBlendTestData(rng, buffer);
+                FillBlendTestData(rng, blendBuffer);
+                std::vector<uint8_t> expected = buffer;
+
+                CPUFeatures::SetSIMD(SIMDLEVEL::SCALAR);
+                k.kernel(expected.data() + offset, blendBuffer.data(), count);
+                CPUFeatures::SetSIMD(level);
+                k.kernel(buffer.data() + offset, blendBuffer.data(), count);
+                if (buffer != expected)
+                {
+                    logger_base.error("Blend self test: %s (%s) does not match the scalar code for %d %s at offset %d.",
+                        k.name, CPUFeatures::GetSIMDName(level), (int)count, k.pixels ? "pixels" : "channels", (int)offset);
+                    kernelOk = false;
+                }
+            }
+        }
+        ok = ok && kernelOk;
+    }
+    return ok;
+}
+
+bool BlendSelfTest()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    // every SIMD level this machine supports is checked against the scalar code
+    bool ok = true;
+    SIMDLEVEL simd = CPUFeatures::GetSIMD();
+    for (int level = (int)CPUFeatures::GetSupportedSIMD(); level > (int)SIMDLEVEL::SCALAR; --level)
+    {
+        ok = CheckBlendKernels((SIMDLEVEL)level) && ok;
+    }
+    CPUFeatures::SetSIMD(simd);
+
+    // time a 170 universe frame through each kernel at each level
+    const size_t channels = 510 * 170;
+    const int frames = 200;
+    std::mt19937 rng(0x5eed);
+    std::vector<uint8_t> buffer(channels);
+    std::vector<uint8_t> blendBuffer(channels);
+    FillBlendTestData(rng, blendBuffer);
+    for (const auto& k : __blendKernels)
+    {
+        size_t count = k.pixels ? channels / 3 : channels;
+        std::string times;
+        for (int level = (int)CPUFeatures::GetSupportedSIMD(); level >= (int)SIMDLEVEL::SCALAR; --level)
+        {
+            CPUFeatures::SetSIMD((SIMDLEVEL)level);
+            FillBlendTestData(rng, buffer);
+            auto start = std::chrono::steady_clock::now();
+            for (int j = 0; j < frames; j++)
+            {
+                k.kernel(buffer.data(), blendBuffer.data(), count);
+            }
+            long long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            times += wxString::Format(" %s %.1fus", CPUFeatures::GetSIMDName((SIMDLEVEL)level), (double)us / frames).ToStdString();
+        }
+        logger_base.info("Blend benchmark: %s %d channels%s per frame.", k.name, (int)channels, times.c_str());
+    }
+    CPUFeatures::SetSIMD(simd);
+
+    logger_base.info("Blend self test %s.", ok ? "passed" : "FAILED");
+    return ok;
+}
@@ -0,0 +1,156 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include "SelfTests.h"
+#include "../OutputProcessPlan.h"
+#include "../OutputProcessColourOrder.h"
+#include "../OutputProcessDeadChannel.h"
+#include "../OutputProcessDim.h"
+#include "../OutputProcessDimWhite.h"
+#include "../OutputProcessGamma.h"
+#include "../OutputProcessRemap.h"
+#include "../OutputProcessReverse.h"
+#include "../OutputProcessSet.h"
+#include "../OutputProcessSustain.h"
+#include "../../xLights/outputs/OutputManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <log4cpp/Category.hh>
+
+// Builds the same random chain each time it is called with the same seed. Without barriers only
+// processes that fuse are used, with them the processes that run on their own are mixed in.
+static std::list<OutputProcess*> CreateTestChain(OutputManager* outputManager, unsigned seed, size_t size, int count, bool barriers)
+{
+    static const size_t orders[] = { 123, 132, 213, 231, 312, 321 };
+
+    std::mt19937 rng(seed);
+    std::list<OutputProcess*> chain;
+    for (int i = 0; i < count; i++)
+    {
+        size_t len = 300 + rng() % 30000;
+        size_t sc = 1 + rng() % (size - 10);
+        std::string startChannel = std::to_string(sc);
+        switch (rng() % (barriers ? 10 : 6))
+        {
+        case 0:
+        case 1:
+            chain.push_back(new OutputProcessDim(outputManager, startChannel, len, rng() % 101, ""));
+            break;
+        case 2:
+            chain.push_back(new OutputProcessGamma(outputManager, startChannel, len / 3, (rng() % 2) ? 2.2f : 0.0f, 1.5f, 2.0f, 2.5f, ""));
+            break;
+        case 3:
+            chain.push_back(new OutputProcessColourOrder(outputManager, startChannel, len / 3, orders[rng() % 6], ""));
+            break;
+        case 4:
+            chain.push_back(new OutputProcessSet(outputManager, startChannel, len % 500, rng() % 256, ""));
+            break;
+        case 5:
+        {
+            size_t to = 1 + rng() % (size - 10);
+            size_t channels = std::min(len, std::max(sc, to) - std::min(sc, to));
+            chain.push_back(new OutputProcessRemap(outputManager, startChannel, to, channels, ""));
+        }
+        break;
+        case 6:
+            chain.push_back(new OutputProcessDimWhite(outputManager, startChannel, len / 3, rng() % 100, ""));
+            break;
+        case 7:
+            chain.push_back(new OutputProcessSustain(outputManager, startChannel, len, ""));
+            break;
+        case 8:
+            chain.push_back(new OutputProcessReverse(outputManager, startChannel, len / 3, 0, ""));
+            break;
+        default:
+            chain.push_back(new OutputProcessDeadChannel(outputManager, startChannel, 2, ""));
+            break;
+        }
+    }
+    return chain;
+}
+
+bool OutputProcessPlanSelfTest()
+{
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    const size_t size = 600000;
+    const int processes = 60;
+    const int chains = 10;
+    const int frames = 20;
+
+    OutputManager outputManager;
+    bool ok = true;
+    for (int barriers = 0; barriers < 2; barriers++)
+    {
+        long long us[2] = { 0, 0 };
+        int mismatches = 0;
+        for (unsigned seed = 1; seed <= chains; seed++)
+        {
+            // sustain keeps state between frames so each side needs its own chain
+            auto sequential = CreateTestChain(&outputManager, seed, size, processes, barriers != 0);
+            auto planned = CreateTestChain(&outputManager, seed, size, processes, barriers != 0);
+            OutputProcessPlan plan;
+
+            std::mt19937 rng(seed * 7);
+            std::vector<uint8_t> expected(size);
+            std::vector<uint8_t> buffer(size);
+            for (int f = 0; f < frames; f++)
+            {
+                // plenty of zeros so sustain and dim white have something to do
+                for (auto& it : buffer)
+                {
+                    it = rng() % 4 == 0 ? 0 : (uint8_t)rng();
+                }
+                expected = buffer;
+
+                auto start = std::chrono::steady_clock::now();
+                for (const auto& it : sequential)
+                {
+                    it->Frame(expected.data(), size);
+                }
+                auto middle = std::chrono::steady_clock::now();
+                plan.Frame(planned, buffer.data(), size);
+                auto end = std::chrono::steady_clock::now();
+
+                // the first frame includes compiling the plan
+                if (f > 0)
+                {
+                    us[0] += std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count();
+                    us[1] += std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count();
+                }
+
+                if (buffer != expected)
+                {
+                    size_t ch = std::mismatch(buffer.begin(), buffer.end(), expected.begin()).first - buffer.begin();
+                    if (mismatches++ < 5)
+                    {
+                        logger_base.error("Output process plan self test: chain %u frame %d channel %d is %d but the processes give %d.",
+                            seed, f, (int)ch + 1, (int)buffer[ch], (int)expected[ch]);
+                    }
+                    ok = false;
+                }
+            }
+
+            for (auto& it : sequential) delete it;
+            for (auto& it : planned) delete it;
+        }
+
+        int timed = chains * (frames - 1);
+        logger_base.info("Output process plan benchmark: %d %s processes over %d channels sequential %.1fus plan %.1fus per frame.",
+            processes, barriers ? "mixed" : "fusable", (int)size, (double)us[0] / timed, (double)us[1] / timed);
+    }
+
+    logger_base.info("Output process plan self test %s.", ok ? "passed" : "FAILED");
+    return ok;
+}
@@ -0,0 +1,53 @@
+/***************************************************************
+ * This source files comes from the xLights project
+ * https://www.xlights.org
+ * https://github.com/smeighan/xLights
+ * See the github commit history for a record of contributing
+ * developers.
+ * Copyright claimed based on commit dates recorded in Github
+ * License: https://github.com/smeighan/xLights/blob/master/License.txt
+ **************************************************************/
+
+#include <wx/app.h>
+#include <wx/init.h>
+#include <wx/socket.h>
+
+#include <iostream>
+
+#include "SelfTests.h"
+
+#include <log4cpp/Category.hh>
+#include <log4cpp/OstreamAppender.hh>
+#include <log4cpp/PatternLayout.hh>
+
+// Runs the self tests, the main for the Linux_Test target. Results go to the console as well as the exit code.
+int main(int argc, char** argv)
+{
+    log4cpp::PatternLayout* layout = new log4cpp::PatternLayout();
+    layout->setConversionPattern("%d{%H:%M:%S,%l} %p %m%n");
+    log4cpp::Appender* appender = new log4cpp::OstreamAppender("console", &std::cout);
+    appender->setLayout(layout);
+    log4cpp::Category::getRoot().addAppender(appender);
+    log4cpp::Category::getRoot().setPriority(log4cpp::Priority::INFO);
+    static log4cpp::Category& logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    // the tests only need wxBase so dont let xScheduleApp start the gui
+    wxApp::SetInitializerFunction(nullptr);
+    wxInitializer initializer(argc, argv);
+    if (!initializer.IsOk())
+    {
+        logger_base.error("Self tests could not initialise wxWidgets.");
+        return 1;
+    }
+    wxSocketBase::Initialize();
+
+    bool ok = true;
+    ok = BlendSelfTest() && ok;
+    ok = OutputProcessPlanSelfTest() && ok;
+    ok = BatchSendSelfTest() && ok;
+
+    wxSocketBase::Shutdown();
+    logger_base.info("Self tests %s.", ok ? "passed" : "FAILED");
+    log4cpp::Category::shutdown();
+    return ok ? 0 : 1;
+}
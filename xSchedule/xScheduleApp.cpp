@@ -99,7 +99,12 @@
 #pragma comment(lib, "swscale.lib")
 #endif
 
+#ifdef XL_SELF_TESTS
+// the self tests provide main
+wxIMPLEMENT_APP_NO_MAIN(xScheduleApp);
+#else
 IMPLEMENT_APP(xScheduleApp)
+#endif
 
 std::string DecodeOS(wxOperatingSystemId o)  {
     switch (o) {
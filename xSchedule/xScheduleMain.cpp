@@ -949,6 +949,7 @@ void xScheduleFrame::LoadSchedule()
     }
 
     __schedule = new ScheduleManager(this, _showDir);
+    __schedule->SetFrameTimer(&_timer);
 
     _pinger = new Pinger(__schedule->GetListenerManager(), __schedule->GetOutputManager());
     __schedule->SetPinger(_pinger);
@@ -1529,39 +1530,50 @@ void xScheduleFrame::On_timerTrigger(wxTimerEvent& event)
     }
     lastms = now;
 
-    wxDateTime frameStart = wxDateTime::UNow();
+    // when the frame timer catches up the ticks it could not deliver while we were busy are run now
+    int ticks = 1 + _timer.TakeMissedTicks();
+    if (ticks > 1)
+    {
+        logger_frame.debug("Timer: Catching up %d missed ticks", ticks - 1);
+    }
+
+    int rate = 0;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        wxDateTime frameStart = wxDateTime::UNow();
 
-    int rate = __schedule->Frame(_timerOutputFrame, this);
+        rate = __schedule->Frame(_timerOutputFrame, this);
 
 #ifndef WEBOVERLOAD
-    if (last != wxDateTime::Now().GetSecond() && _timerOutputFrame)
+        if (last != wxDateTime::Now().GetSecond() && _timerOutputFrame)
 #endif
-    {
-        // This code must be commented out before release!!!
-        logger_frame.debug("    Check schedule");
-        last = wxDateTime::Now().GetSecond();
-        wxCommandEvent event2(EVT_SCHEDULECHANGED);
-        wxPostEvent(this, event2);
-    }
+        {
+            // This code must be commented out before release!!!
+            logger_frame.debug("    Check schedule");
+            last = wxDateTime::Now().GetSecond();
+            wxCommandEvent event2(EVT_SCHEDULECHANGED);
+            wxPostEvent(this, event2);
+        }
 
-    CorrectTimer(rate);
+        wxDateTime frameEnd = wxDateTime::UNow();
+        long ms = (frameEnd - frameStart).GetMilliseconds().ToLong();
 
-    wxDateTime frameEnd = wxDateTime::UNow();
-    long ms = (frameEnd - frameStart).GetMilliseconds().ToLong();
+        if (ms > _timer.GetInterval())
+        {
+            // we took too long so next frame has to be an output frame
+            _timerOutputFrame = true;
+            logger_frame.debug("Timer: Frame took too long %ld > %d so next frame forced to be output", ms, _timer.GetInterval());
+        }
+        else
+        {
+            // output only occurs on alternate timer events
+            _timerOutputFrame = !_timerOutputFrame;
+        }
 
-    if (ms > _timer.GetInterval())
-    {
-        // we took too long so next frame has to be an output frame
-        _timerOutputFrame = true;
-        logger_frame.debug("Timer: Frame took too long %ld > %d so next frame forced to be output", ms, _timer.GetInterval());
-    }
-    else
-    {
-        // output only occurs on alternate timer events
-        _timerOutputFrame = !_timerOutputFrame;
+        logger_frame.info("Timer: Frame time %ld", ms);
     }
 
-    logger_frame.info("Timer: Frame time %ld", ms);
+    CorrectTimer(rate);
 }
 
 void xScheduleFrame::UpdateSchedule()
@@ -1728,6 +1740,9 @@ void xScheduleFrame::ValidateWindow()
 
 void xScheduleFrame::OnMenuItem_OptionsSelected(wxCommandEvent& event)
 {
+    // the options and outputs are changed while the output thread may be using them
+    __schedule->SuspendOutputThread();
+
     OptionsDialog dlg(this, __schedule->GetCommandManager(), __schedule->GetOptions());
 
     int oldport = __schedule->GetOptions()->GetWebServerPort();
@@ -1755,11 +1770,14 @@ void xScheduleFrame::OnMenuItem_OptionsSelected(wxCommandEvent& event)
 
         VideoReader::SetHardwareAcceleratedVideo(__schedule->GetOptions()->IsHardwareAcceleratedVideo());
 
+        __schedule->UpdateFrameTimerPolicy();
         __schedule->OptionsChanged();
 
         CreateButtons();
     }
 
+    __schedule->ResumeOutputThread();
+
     AddIPs();
 
     UpdateUI();
@@ -1911,9 +1929,9 @@ std::string xScheduleFrame::GetWebPluginRequest(const std::string& request)
     return "";
 }
 
-void xScheduleFrame::ManipulateBuffer(uint8_t* buffer, size_t bufferSize)
+bool xScheduleFrame::ManipulateBuffer(uint8_t* buffer, size_t bufferSize)
 {
-    _pluginManager.ManipulateBuffer(buffer, bufferSize);
+    return _pluginManager.ManipulateBuffer(buffer, bufferSize);
 }
 
 void xScheduleFrame::PluginStateChanged()
@@ -3104,6 +3122,9 @@ void xScheduleFrame::EditSelectedItem(bool forceadvanced)
 
 void xScheduleFrame::OnMenu_OutputProcessingSelected(wxCommandEvent& event)
 {
+    // the dialog edits the output processes the output thread is using
+    __schedule->SuspendOutputThread();
+
     OutputProcessingDialog dlg(this, __schedule->GetOutputManager(), __schedule->GetOutputProcessing());
 
     if (dlg.ShowModal() == wxID_OK)
@@ -3111,6 +3132,8 @@ void xScheduleFrame::OnMenu_OutputProcessingSelected(wxCommandEvent& event)
         __schedule->OutputProcessingChanged();
     }
 
+    __schedule->ResumeOutputThread();
+
     UpdateUI();
 }
 
@@ -3218,7 +3241,20 @@ void xScheduleFrame::UpdateUI(bool force)
 
     if (!minimiseUIUpdates) {
 
-        StaticText_PacketsPerSec->SetLabel(wxString::Format("Packets/Sec: %d", __schedule->GetPPS()));
+        auto timerStats = _timer.GetStats();
+        if (timerStats.late > 0) {
+            StaticText_PacketsPerSec->SetLabel(wxString::Format("Packets/Sec: %d Late Frames: %llu", __schedule->GetPPS(), timerStats.late));
+        }
+        else {
+            StaticText_PacketsPerSec->SetLabel(wxString::Format("Packets/Sec: %d", __schedule->GetPPS()));
+        }
+
+        wxString timerTip = wxString::Format("Frame timer: %llu fired, %llu late, %llu skipped, %llu caught up, worst %.1fms late, worst %.1fms late to the frame\n",
+            timerStats.fired, timerStats.late, timerStats.skipped, timerStats.caughtUp, (double)timerStats.maxLateUS / 1000.0, (double)timerStats.maxDeliveredLateUS / 1000.0);
+        for (int i = 0; i < xLightsTimerStats::JITTER_BUCKETS; i++) {
+            timerTip += wxString::Format("\n%s: %llu fired, %llu reached the frame", xLightsTimerStats::GetJitterBucketName(i).c_str(), timerStats.jitter[i], timerStats.deliveredJitter[i]);
+        }
+        StaticText_PacketsPerSec->SetToolTip(timerTip);
 
         if (__schedule->GetWebRequestToggle()) {
             if (!_webIconDisplayed) {
@@ -3461,6 +3497,8 @@ void xScheduleFrame::OnMenuItem_VirtualMatricesSelected(wxCommandEvent& event)
         __schedule->SetOutputToLights(this, false, true);
     }
 
+    __schedule->SuspendOutputThread();
+
     auto vmatrices = __schedule->GetOptions()->GetVirtualMatrices();
     VirtualMatricesDialog dlg(this, __schedule->GetOutputManager(), vmatrices);
 
@@ -3470,6 +3508,8 @@ void xScheduleFrame::OnMenuItem_VirtualMatricesSelected(wxCommandEvent& event)
         __schedule->SetDirty();
     }
 
+    __schedule->ResumeOutputThread();
+
     _suspendOTL = false;
     if (ol)
     {